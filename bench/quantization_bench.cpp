@@ -0,0 +1,315 @@
+#include "filter/band.h"
+#include "filter/fpminimax.h"
+#include "filter/grid.h"
+#include "filter/pm.h"
+#include "filter/roots.h"
+#include "filter/util.h"
+#include "benchmark/benchmark.h"
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Benchmarks of the quantization pipeline on the A-E specifications used by
+// the quantization tests (and on larger degrees for the minimax part). Each
+// stage is timed separately, and the quantization benchmarks also report
+// the per-phase timings gathered by the library as counters. The results
+// are written as JSON unless another format is requested on the command
+// line.
+
+namespace {
+
+const mp_prec_t prec = 200ul;
+
+struct Spec {
+  std::string name;
+  std::vector<double> bands;      // band edges, as fractions of pi
+  std::vector<double> amplitudes; // one value per band
+  std::vector<double> weights;    // one value per band
+  std::size_t degree;
+  long bits;                      // fractional bits of the coefficients
+};
+
+const std::vector<double> twoBands{0.0, 0.4, 0.5, 1.0};
+const std::vector<double> threeBands{0.0, 0.24, 0.4, 0.68, 0.84, 1.0};
+const std::vector<double> narrowBands{0.02, 0.42, 0.52, 0.98};
+// sharper transitions keep the error of the larger designs well above the
+// double precision roundoff
+const std::vector<double> sharpTwoBands{0.0, 0.4, 0.41, 1.0};
+const std::vector<double> sharpThreeBands{0.0, 0.24, 0.25, 0.68, 0.69, 1.0};
+
+std::vector<Spec> quantizationSpecs() {
+  return {
+    {"A35_8", twoBands, {1.0, 0.0}, {1.0, 1.0}, 17u, 7},
+    {"A45_8", twoBands, {1.0, 0.0}, {1.0, 1.0}, 22u, 7},
+    {"A125_21", twoBands, {1.0, 0.0}, {1.0, 1.0}, 62u, 20},
+    {"B35_9", twoBands, {1.0, 0.0}, {1.0, 10.0}, 17u, 8},
+    {"B45_9", twoBands, {1.0, 0.0}, {1.0, 10.0}, 22u, 8},
+    {"B125_22", twoBands, {1.0, 0.0}, {1.0, 10.0}, 62u, 21},
+    {"C35_8", threeBands, {1.0, 0.0, 1.0}, {1.0, 1.0, 1.0}, 17u, 7},
+    {"C45_8", threeBands, {1.0, 0.0, 1.0}, {1.0, 1.0, 1.0}, 22u, 7},
+    {"C125_21", threeBands, {1.0, 0.0, 1.0}, {1.0, 1.0, 1.0}, 62u, 20},
+    {"D35_9", threeBands, {1.0, 0.0, 1.0}, {1.0, 10.0, 1.0}, 17u, 8},
+    {"D45_9", threeBands, {1.0, 0.0, 1.0}, {1.0, 10.0, 1.0}, 22u, 8},
+    {"D125_22", threeBands, {1.0, 0.0, 1.0}, {1.0, 10.0, 1.0}, 62u, 21},
+    {"E35_8", narrowBands, {1.0, 0.0}, {1.0, 1.0}, 17u, 7},
+    {"E45_8", narrowBands, {1.0, 0.0}, {1.0, 1.0}, 22u, 7},
+    {"E125_21", narrowBands, {1.0, 0.0}, {1.0, 1.0}, 62u, 20},
+  };
+}
+
+// larger designs, only used for the double precision minimax stages
+std::vector<Spec> largeSpecs() {
+  return {
+    {"LP_250", sharpTwoBands, {1.0, 0.0}, {1.0, 1.0}, 250u, 0},
+    {"BS_250", sharpThreeBands, {1.0, 0.0, 1.0}, {1.0, 1.0, 1.0}, 250u, 0},
+    {"LP_500", sharpTwoBands, {1.0, 0.0}, {1.0, 1.0}, 500u, 0},
+    {"BS_500", sharpThreeBands, {1.0, 0.0, 1.0}, {1.0, 1.0, 1.0}, 500u, 0},
+  };
+}
+
+void makeBands(std::vector<Band> &freqBands, std::vector<Band> &chebyBands,
+               Spec const &spec) {
+  mpfr::mpreal pi = mpfr::const_pi(prec);
+  freqBands.resize(spec.weights.size());
+  for (std::size_t i{0u}; i < freqBands.size(); ++i) {
+    freqBands[i].start = pi * spec.bands[2u * i];
+    freqBands[i].stop = pi * spec.bands[2u * i + 1u];
+    freqBands[i].space = BandSpace::FREQ;
+    setAmplitude(freqBands[i],
+                 constantResponse(mpfr::mpreal(spec.amplitudes[i])));
+    setWeight(freqBands[i], constantResponse(mpfr::mpreal(spec.weights[i])));
+  }
+  bandConversion(chebyBands, freqBands, ConversionDirection::FROMFREQ);
+}
+
+void makeBands(std::vector<BandD> &freqBands, std::vector<BandD> &chebyBands,
+               Spec const &spec) {
+  freqBands.resize(spec.weights.size());
+  for (std::size_t i{0u}; i < freqBands.size(); ++i) {
+    freqBands[i].start = M_PI * spec.bands[2u * i];
+    freqBands[i].stop = M_PI * spec.bands[2u * i + 1u];
+    freqBands[i].space = BandSpace::FREQ;
+    setAmplitude(freqBands[i], constantResponse(spec.amplitudes[i]));
+    setWeight(freqBands[i], constantResponse(spec.weights[i]));
+  }
+  bandConversion(chebyBands, freqBands, ConversionDirection::FROMFREQ);
+}
+
+// the initial reference of the exchange algorithm (the extrema counts of
+// freqBands and chebyBands are updated)
+template <typename T, typename B>
+void initialReference(std::vector<T> &x, std::vector<B> &freqBands,
+                      std::vector<B> &chebyBands, std::size_t degree) {
+  std::vector<T> omega(degree + 2u);
+  x.resize(degree + 2u);
+  initUniformExtremas(omega, freqBands);
+  applyCos(x, omega);
+  bandConversion(chebyBands, freqBands, ConversionDirection::FROMFREQ);
+}
+
+void initialReference(std::vector<mpfr::mpreal> &x,
+                      std::vector<Band> &freqBands,
+                      std::vector<Band> &chebyBands, std::size_t degree) {
+  std::vector<mpfr::mpreal> omega(degree + 2u);
+  x.resize(degree + 2u);
+  initUniformExtremas(omega, freqBands, prec);
+  applyCos(x, omega);
+  bandConversion(chebyBands, freqBands, ConversionDirection::FROMFREQ);
+}
+
+void benchExchangeDouble(benchmark::State &state, Spec spec) {
+  std::vector<BandD> freqBands, chebyBands;
+  std::vector<double> x0;
+  makeBands(freqBands, chebyBands, spec);
+  initialReference(x0, freqBands, chebyBands, spec.degree);
+  PMOutputD output;
+  for (auto _ : state) {
+    std::vector<double> x = x0;
+    std::vector<BandD> bands = chebyBands;
+    output = exchange(x, bands, 0.0001, 16);
+    benchmark::DoNotOptimize(output.delta);
+  }
+  state.counters["exchange_iterations"] = output.iter;
+  state.counters["delta"] = output.delta;
+}
+
+void benchExchangeMP(benchmark::State &state, Spec spec) {
+  std::vector<Band> freqBands, chebyBands;
+  std::vector<mpfr::mpreal> x0;
+  makeBands(freqBands, chebyBands, spec);
+  initialReference(x0, freqBands, chebyBands, spec.degree);
+  PMOutput output;
+  for (auto _ : state) {
+    std::vector<mpfr::mpreal> x = x0;
+    std::vector<Band> bands = chebyBands;
+    output = exchange(x, bands, 0.0001, 8, prec);
+    benchmark::DoNotOptimize(output.delta);
+  }
+  state.counters["exchange_iterations"] = output.iter;
+  state.counters["delta"] = output.delta.toDouble();
+}
+
+void benchFindEigenZeros(benchmark::State &state, Spec spec) {
+  std::vector<BandD> freqBands, chebyBands;
+  std::vector<double> x;
+  makeBands(freqBands, chebyBands, spec);
+  initialReference(x, freqBands, chebyBands, spec.degree);
+  PMOutputD output = exchange(x, chebyBands, 0.0001, 16);
+  std::vector<double> zeros;
+  for (auto _ : state) {
+    findEigenZeros(output.h, zeros, output.x, freqBands, chebyBands);
+    benchmark::DoNotOptimize(zeros.data());
+  }
+  state.counters["zeros"] = zeros.size();
+}
+
+void benchGenerateGrid(benchmark::State &state, Spec spec) {
+  std::vector<Band> freqBands, chebyBands;
+  makeBands(freqBands, chebyBands, spec);
+  Grid grid;
+  for (auto _ : state) {
+    generateGrid(grid, spec.degree, freqBands, 16u, prec);
+    benchmark::DoNotOptimize(grid.x.data());
+  }
+  state.counters["points"] = grid.size();
+}
+
+// the data passed to the quantization routines by the quantization tests
+// (the interpolation nodes are the extrema of the minimax error)
+struct QuantizationInput {
+  std::vector<Band> freqBands;
+  std::vector<mpfr::mpreal> a;
+  std::vector<mpfr::mpreal> fixedA;
+  std::vector<mpfr::mpreal> points;
+  std::vector<mpfr::mpreal> weights;
+};
+
+void prepareQuantization(QuantizationInput &input, Spec const &spec) {
+  std::vector<Band> chebyBands;
+  makeBands(input.freqBands, chebyBands, spec);
+  std::vector<BandD> freqBandsD, chebyBandsD;
+  std::vector<double> x;
+  makeBands(freqBandsD, chebyBandsD, spec);
+  initialReference(x, freqBandsD, chebyBandsD, spec.degree);
+  PMOutputD output = exchange(x, chebyBandsD, 0.0001, 16);
+
+  input.a.assign(output.h.begin(), output.h.end());
+  input.points.assign(output.x.begin(), output.x.end());
+  input.weights.resize(input.points.size());
+  for (std::size_t i{0u}; i < input.points.size(); ++i) {
+    mpfr::mpreal &p = input.points[i];
+    for (std::size_t j{0u}; j < chebyBands.size() - 1u; ++j) {
+      if (mpfr::abs(p - chebyBands[j].stop) < 1e-14)
+        p = chebyBands[j].stop;
+      if (mpfr::abs(p - chebyBands[j + 1u].start) < 1e-14)
+        p = chebyBands[j + 1u].start;
+    }
+    mpfr::mpreal D;
+    input.weights[i] = 1;
+    computeIdealResponseAndWeight(D, input.weights[i], p, chebyBands);
+  }
+}
+
+void benchQuantizationContext(benchmark::State &state, Spec spec) {
+  QuantizationInput input;
+  prepareQuantization(input, spec);
+  QuantizationStats stats;
+  for (auto _ : state) {
+    QuantizationContext context;
+    initQuantizationContext(context, input.a, input.fixedA, input.points,
+                            input.freqBands, input.weights, prec);
+    stats.merge(context.stats);
+  }
+  state.counters["grid_ms"] = benchmark::Counter(
+      stats.time(Phase::GRID_BUILD), benchmark::Counter::kAvgIterations);
+}
+
+// the reduction_ms counter of the two variants compares the embedding and
+// reduction of the second kernel target with its nearest plane rounding
+void runQuantization(benchmark::State &state, Spec const &spec,
+                     bool nearestPlane) {
+  QuantizationInput input;
+  prepareQuantization(input, spec);
+  QuantizationContext context;
+  initQuantizationContext(context, input.a, input.fixedA, input.points,
+                          input.freqBands, input.weights, prec);
+  context.reduction.nearestPlane = nearestPlane;
+  mpfr::mpreal scalingFactor = mpfr::mpreal(1, prec) << spec.bits;
+  QuantizationStats stats;
+  double error = 0.0;
+  for (auto _ : state) {
+    QuantizationResult result;
+    fpminimaxWithNeighborhoodSearchDiscrete(result, context, scalingFactor);
+    stats.merge(result.stats);
+    error = result.finalError;
+  }
+  auto average = [&](double value) {
+    return benchmark::Counter(value, benchmark::Counter::kAvgIterations);
+  };
+  state.counters["basis_ms"] = average(stats.time(Phase::BASIS_BUILD));
+  state.counters["reduction_ms"] = average(stats.time(Phase::REDUCTION));
+  state.counters["search_ms"] =
+      average(stats.time(Phase::NEIGHBORHOOD_SEARCH));
+  state.counters["candidates"] =
+      average(stats.counter(Counter::CANDIDATES));
+  state.counters["norm_evaluations"] =
+      average(stats.counter(Counter::NORM_EVALUATIONS));
+  state.counters["error"] = error;
+}
+
+void benchQuantization(benchmark::State &state, Spec spec) {
+  runQuantization(state, spec, false);
+}
+
+void benchQuantizationNearestPlane(benchmark::State &state, Spec spec) {
+  runQuantization(state, spec, true);
+}
+
+void registerBenchmarks() {
+  auto add = [](std::string const &name,
+                void (*function)(benchmark::State &, Spec), Spec const &spec) {
+    benchmark::RegisterBenchmark((name + "/" + spec.name).c_str(), function,
+                                 spec)
+        ->Unit(benchmark::kMillisecond);
+  };
+  std::vector<Spec> specs = quantizationSpecs();
+  for (auto &spec : specs) {
+    add("exchange_double", benchExchangeDouble, spec);
+    add("exchange_mpreal", benchExchangeMP, spec);
+    add("findEigenZeros", benchFindEigenZeros, spec);
+    add("generateGrid", benchGenerateGrid, spec);
+    add("quantization_context", benchQuantizationContext, spec);
+    add("quantization", benchQuantization, spec);
+    add("quantization_nearest_plane", benchQuantizationNearestPlane, spec);
+  }
+  for (auto &spec : largeSpecs()) {
+    add("exchange_double", benchExchangeDouble, spec);
+    add("findEigenZeros", benchFindEigenZeros, spec);
+    add("generateGrid", benchGenerateGrid, spec);
+  }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  mpfr::mpreal::set_default_prec(prec);
+
+  // JSON is the default output format
+  std::vector<char *> args(argv, argv + argc);
+  bool hasFormat = false;
+  for (int i = 1; i < argc; ++i)
+    if (std::strncmp(argv[i], "--benchmark_format", 18) == 0)
+      hasFormat = true;
+  std::string jsonFormat = "--benchmark_format=json";
+  if (!hasFormat)
+    args.insert(args.begin() + 1, &jsonFormat[0]);
+  int count = args.size();
+
+  benchmark::Initialize(&count, args.data());
+  if (benchmark::ReportUnrecognizedArguments(count, args.data()))
+    return 1;
+  registerBenchmarks();
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
@@ -15,6 +15,27 @@
 typedef Eigen::Matrix<mpfr::mpreal, Eigen::Dynamic, Eigen::Dynamic> MatrixXq;
 typedef Eigen::Matrix<mpfr::mpreal, Eigen::Dynamic, 1> VectorXq;
 
+/*! Selects the columns of a matrix in the order given by a QR
+ * factorization with column pivoting (i.e. the column of largest norm
+ * orthogonal to the ones already selected is taken at each step), which is
+ * how the approximate Fekete points are extracted from a weakly admissible
+ * mesh. The reflectors are applied to the trailing columns by blocks
+ * (matrix-matrix products instead of one rank-one update per step), the
+ * column norms are downdated and the column updates are done in parallel.
+ * The selection stops once the remaining columns are numerically zero.
+ * Instantiated for double, dd::ddreal and mpfr::mpreal (the MPFR version
+ * works in the default precision of the calling thread).
+ * @param[out] pivots the indices of the selected columns, in the order in
+ * which they were selected
+ * @param[in] A the matrix whose columns are selected
+ * @param[in] blockSize the number of reflectors applied at once
+ */
+template <typename T>
+void pivotedQRSelection(
+    std::vector<std::size_t> &pivots,
+    Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> const &A,
+    std::size_t blockSize = 32u);
+
 void generateAFPMatrix(
     MatrixXq &A, std::size_t degree, std::vector<mpfr::mpreal> &meshPoints,
     std::function<mpfr::mpreal(mpfr::mpreal)> &weightFunction);
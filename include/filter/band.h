@@ -21,6 +21,78 @@ enum BandSpace {
            1\right]\f$) */
 };
 
+/**
+ * The form of an ideal response or weight function on a band
+ */
+enum ResponseType {
+  FUNCTION,   /**< only given by the type-erased callback of the band */
+  CONSTANT,   /**< constant value \f$c_0\f$ */
+  LINEAR,     /**< linear interpolation between the values \f$c_2\f$ and
+                 \f$c_3\f$ taken at the frequencies \f$c_0\f$ and \f$c_1\f$ */
+  POLYNOMIAL  /**< polynomial \f$\sum_k c_k\omega^k\f$ in the frequency
+                 variable */
+};
+
+/**
+ * @brief Analytic description of an ideal response or weight function on a
+ * band
+ *
+ * The description is always given in terms of the frequency variable
+ * \f$\omega\in\left[0,\pi\right]\f$. When it is available, the evaluation
+ * routines use it directly instead of calling the corresponding callback of
+ * the band.
+ */
+template <typename T> struct ResponseModelT {
+  ResponseType type = FUNCTION; /**< the form of the function */
+  std::vector<T> coeffs;        /**< the parameters of the function */
+};
+
+/** analytic response description for the MPFR routines */
+typedef ResponseModelT<mpfr::mpreal> ResponseModel;
+
+/*! Analytic description of a constant function
+ * @param[in] value the value of the function
+ */
+template <typename T> ResponseModelT<T> constantResponse(T const &value) {
+  ResponseModelT<T> model;
+  model.type = CONSTANT;
+  model.coeffs = {value};
+  return model;
+}
+
+/*! Analytic description of a function which is linear in the frequency
+ * variable
+ * @param[in] start left frequency of the interval
+ * @param[in] stop right frequency of the interval
+ * @param[in] startValue value of the function at start
+ * @param[in] stopValue value of the function at stop
+ */
+template <typename T>
+ResponseModelT<T> linearResponse(T const &start, T const &stop,
+                                 T const &startValue, T const &stopValue) {
+  if (startValue == stopValue)
+    return constantResponse(startValue);
+  ResponseModelT<T> model;
+  model.type = LINEAR;
+  model.coeffs = {start, stop, startValue, stopValue};
+  return model;
+}
+
+/*! Analytic description of a function which is polynomial in the frequency
+ * variable
+ * @param[in] coeffs the coefficients of the polynomial, with respect to the
+ * monomial basis and in increasing order of degree
+ */
+template <typename T>
+ResponseModelT<T> polynomialResponse(std::vector<T> const &coeffs) {
+  if (coeffs.size() == 1u)
+    return constantResponse(coeffs[0]);
+  ResponseModelT<T> model;
+  model.type = POLYNOMIAL;
+  model.coeffs = coeffs;
+  return model;
+}
+
 /**
  * @brief A data type encapsulating information relevant to a frequency band
  *
@@ -36,17 +108,112 @@ struct Band {
   std::function<mpfr::mpreal(BandSpace, mpfr::mpreal)> weight;
   /**< weight function value on the band */
   std::size_t extremas; /**< number of interpolation points taken in the band */
+  ResponseModel amplitudeModel; /**< analytic form of the ideal amplitude */
+  ResponseModel weightModel;    /**< analytic form of the weight function */
 };
 
-struct BandD {
-	BandSpace space;
-	std::function<double(BandSpace, double)> amplitude;
-	double start;
-	double stop;
-	std::function<double(BandSpace, double)> weight;
-	std::size_t extremas;
+/**
+ * @brief Frequency band information used by the exchange algorithm
+ * implementations working with native floating-point types (double or
+ * dd::ddreal)
+ */
+template <typename T> struct BandT {
+  BandSpace space; /**< the space in which we are working */
+  std::function<T(BandSpace, T)> amplitude;
+  /**< the ideal amplitude for this band */
+  T start; /**< the left bound of the band */
+  T stop;  /**< the right bound of the band */
+  std::function<T(BandSpace, T)> weight;
+  /**< weight function value on the band */
+  std::size_t extremas; /**< number of interpolation points taken in the band */
+  ResponseModelT<T> amplitudeModel; /**< analytic form of the ideal amplitude */
+  ResponseModelT<T> weightModel;    /**< analytic form of the weight function */
 };
 
+/** band information for the double precision routines */
+typedef BandT<double> BandD;
+/** band information for the double-double precision routines */
+typedef BandT<dd::ddreal> BandDD;
+
+/*! Evaluates an analytic response description
+ * @param[out] value the value of the function at x
+ * @param[in] model the description of the function (it must not be of type
+ * FUNCTION)
+ * @param[in] space the space in which x is given
+ * @param[in] x the evaluation point
+ */
+void evaluateResponse(mpfr::mpreal &value, ResponseModel const &model,
+                      BandSpace space, mpfr::mpreal const &x);
+
+/*! Evaluates an analytic response description
+ * @param[out] value the value of the function at x
+ * @param[in] model the description of the function (it must not be of type
+ * FUNCTION)
+ * @param[in] space the space in which x is given
+ * @param[in] x the evaluation point
+ */
+template <typename T>
+inline void evaluateResponse(T &value, ResponseModelT<T> const &model,
+                             BandSpace space, T const &x) {
+    if (model.type == CONSTANT) {
+        value = model.coeffs[0];
+        return;
+    }
+    T omega = (space == BandSpace::CHEBY) ? acosl(x) : x;
+    std::vector<T> const &c = model.coeffs;
+    if (model.type == LINEAR) {
+        value = ((omega - c[0]) * c[3] - (omega - c[1]) * c[2]) / (c[1] - c[0]);
+    } else {
+        value = c.back();
+        for (std::size_t k = c.size() - 1u; k-- > 0u;)
+            value = value * omega + c[k];
+    }
+}
+
+/*! Sets the ideal amplitude of a band to an analytic function (the callback
+ * of the band is set to evaluate the same function)
+ * @param[out] band the band to update
+ * @param[in] model the description of the ideal amplitude
+ */
+void setAmplitude(Band &band, ResponseModel const &model);
+
+/*! Sets the weight function of a band to an analytic function (the callback
+ * of the band is set to evaluate the same function)
+ * @param[out] band the band to update
+ * @param[in] model the description of the weight function
+ */
+void setWeight(Band &band, ResponseModel const &model);
+
+/*! Sets the ideal amplitude of a band to an analytic function (the callback
+ * of the band is set to evaluate the same function)
+ * @param[out] band the band to update
+ * @param[in] model the description of the ideal amplitude
+ */
+template <typename T>
+void setAmplitude(BandT<T> &band, ResponseModelT<T> const &model) {
+    band.amplitudeModel = model;
+    band.amplitude = [model](BandSpace space, T x) -> T {
+        T value;
+        evaluateResponse(value, model, space, x);
+        return value;
+    };
+}
+
+/*! Sets the weight function of a band to an analytic function (the callback
+ * of the band is set to evaluate the same function)
+ * @param[out] band the band to update
+ * @param[in] model the description of the weight function
+ */
+template <typename T>
+void setWeight(BandT<T> &band, ResponseModelT<T> const &model) {
+    band.weightModel = model;
+    band.weight = [model](BandSpace space, T x) -> T {
+        T value;
+        evaluateResponse(value, model, space, x);
+        return value;
+    };
+}
+
 /**
  * Gives the direction in which the change of variable is performed
  */
@@ -65,7 +232,14 @@ enum ConversionDirection {
 void bandConversion(std::vector<Band> &out, std::vector<Band> &in,
                     ConversionDirection direction, mp_prec_t prec = 165ul);
 
-void bandConversion(std::vector<BandD> &out, std::vector<BandD> &in,
-        ConversionDirection direction);
+/*! Performs the change of variable on the set of bands of interest
+ * @param[out] out output frequency bands
+ * @param[in]  in input frequency bands
+ * @param[in]  direction the direction in which the change of variable is
+ * performed
+ */
+template <typename T>
+void bandConversion(std::vector<BandT<T>> &out, std::vector<BandT<T>> &in,
+                    ConversionDirection direction);
 
 #endif /* BAND_H_ */
@@ -77,6 +77,20 @@ void computeApprox(mpfr::mpreal &Pc, const mpfr::mpreal &xVal,
         std::vector<mpfr::mpreal> & w,
         mp_prec_t prec = 165ul);
 
+/*! Version of computeApprox using the scratch variables of a workspace. The
+ * computations are done in the precision of the workspace and the default
+ * MPFR precision is left untouched.
+ * @param[out] Pc the frequency response amplitude value at the current node
+ * @param[in] xVal the current frequency node where we do our computation
+ * @param[in] x the current reference set
+ * @param[in] C the frequency responses at the current reference set
+ * @param[in] w the current barycentric weights
+ * @param[in,out] ws the workspace holding the temporaries
+ */
+void computeApprox(mpfr::mpreal &Pc, const mpfr::mpreal &xVal,
+        std::vector<mpfr::mpreal> &x, std::vector<mpfr::mpreal> &C,
+        std::vector<mpfr::mpreal> & w, MPWorkspace &ws);
+
 /*! Computes the approximation error at a given node using the current set of
  * reference points
  * @param[out] error the requested error value
@@ -94,6 +108,25 @@ void computeError(mpfr::mpreal &error, const mpfr::mpreal &xVal,
         std::vector<Band> &bands,
         mp_prec_t prec = 165ul);
 
+/*! Version of computeError using the scratch variables of a workspace (it
+ * is meant to be called in loops, with one workspace per thread). The
+ * computations are done in the precision of the workspace, except for the
+ * evaluation of the band amplitude and weight functions, which use the
+ * default MPFR precision.
+ * @param[out] error the requested error value
+ * @param[in] xVal the current frequency node where we do our computation
+ * @param[in] delta the current reference error
+ * @param[in] x the current reference set
+ * @param[in] C the frequency response values at the x nodes
+ * @param[in] w the barycentric weights
+ * @param[in] bands frequency band information for the ideal filter
+ * @param[in,out] ws the workspace holding the temporaries
+ */
+void computeError(mpfr::mpreal &error, const mpfr::mpreal &xVal,
+        mpfr::mpreal &delta, std::vector<mpfr::mpreal> &x,
+        std::vector<mpfr::mpreal> &C, std::vector<mpfr::mpreal> &w,
+        std::vector<Band> &bands, MPWorkspace &ws);
+
 /*! The ideal frequency response and weight information at the given frequency
  * node (it can be in the \f$\left[-1,1\right]\f$ interval,
  * and not the initial \f$\left[0,\pi\right]\f$, the difference is made with
@@ -101,11 +134,15 @@ void computeError(mpfr::mpreal &error, const mpfr::mpreal &xVal,
  * @param[out] D ideal frequency response
  * @param[out] W weight value for the current point
  * @param[in] xVal the current frequency node where we do our computation
- * @param[in] bands frequency band information for the ideal filter
+ * @param[in] bands frequency band information for the ideal filter (the
+ * bands are sorted in increasing order)
  */
 void computeIdealResponseAndWeight(mpfr::mpreal &D, mpfr::mpreal &W,
         const mpfr::mpreal &xVal, std::vector<Band> &bands);
 
+// The routines below work with native floating-point types and are
+// instantiated for double and dd::ddreal
+
 /*! Procedure which computes the weights used in
  * the evaluation of the barycentric interpolation
  * formulas (see [Berrut&Trefethen2004] and [Pachon&Trefethen2009]
@@ -113,8 +150,9 @@ void computeIdealResponseAndWeight(mpfr::mpreal &D, mpfr::mpreal &W,
  * @param[out] w the computed weights
  * @param[in] x the interpolation points
  */
-void barycentricWeights(std::vector<double>& w,
-        std::vector<double>& x);
+template <typename T>
+void barycentricWeights(std::vector<T>& w,
+        std::vector<T>& x);
 
 /*! Determines the current reference error according to the
  * barycentric formula (internally it also computes the barycentric weights)
@@ -123,8 +161,9 @@ void barycentricWeights(std::vector<double>& w,
  * @param[in] bands information relating to the ideal frequency response of
  * the filter
  */
-void computeDelta(double &delta, std::vector<double>& x,
-        std::vector<BandD> &bands);
+template <typename T>
+void computeDelta(T &delta, std::vector<T>& x,
+        std::vector<BandT<T>> &bands);
 
 /*! Determines the current reference error according to the
  * barycentric formula
@@ -136,8 +175,9 @@ void computeDelta(double &delta, std::vector<double>& x,
  * the filter
  */
 
-void computeDelta(double &delta, std::vector<double>& w,
-        std::vector<double>& x, std::vector<BandD> &bands);
+template <typename T>
+void computeDelta(T &delta, std::vector<T>& w,
+        std::vector<T>& x, std::vector<BandT<T>> &bands);
 
 /*! Computes the filter response at the current reference set
  * @param[out] C the vector of frequency responses at the reference set
@@ -145,8 +185,9 @@ void computeDelta(double &delta, std::vector<double>& w,
  * @param[in] x the current reference vector
  * @param[in] bands frequency band information for the ideal filter
  */
-void computeC(std::vector<double> &C, double &delta,
-        std::vector<double> &x, std::vector<BandD> &bands);
+template <typename T>
+void computeC(std::vector<T> &C, T &delta,
+        std::vector<T> &x, std::vector<BandT<T>> &bands);
 
 /*! Computes the frequency response of the current filter
  * @param[out] Pc the frequency response amplitude value at the current node
@@ -157,9 +198,40 @@ void computeC(std::vector<double> &C, double &delta,
  * @param[in] C the frequency responses at the current reference set
  * @param[in] w the current barycentric weights
  */
-void computeApprox(double &Pc, const double &xVal,
-        std::vector<double> &x, std::vector<double> &C,
-        std::vector<double> & w);
+template <typename T>
+void computeApprox(T &Pc, const T &xVal,
+        std::vector<T> &x, std::vector<T> &C,
+        std::vector<T> & w);
+
+/*! Computes the frequency response of the current filter at a set of nodes
+ * (the sum over the reference set is vectorized in the double precision
+ * version, and the nodes which coincide with reference points are only
+ * detected after it)
+ * @param[out] Pc the frequency response amplitude values at the n nodes
+ * @param[in] xVal the n nodes where we do our computation (given in the
+ * \f$\left[-1,1\right]\f$ interval)
+ * @param[in] n the number of nodes
+ * @param[in] x the current reference set
+ * @param[in] C the frequency responses at the current reference set
+ * @param[in] w the current barycentric weights
+ */
+template <typename T>
+void computeApprox(T *Pc, const T *xVal, std::size_t n,
+        std::vector<T> &x, std::vector<T> &C,
+        std::vector<T> &w);
+
+/*! Computes the frequency response of the current filter at a set of nodes
+ * @param[out] Pc the frequency response amplitude values at the xVal nodes
+ * @param[in] xVal the nodes where we do our computation (given in the
+ * \f$\left[-1,1\right]\f$ interval)
+ * @param[in] x the current reference set
+ * @param[in] C the frequency responses at the current reference set
+ * @param[in] w the current barycentric weights
+ */
+template <typename T>
+void computeApprox(std::vector<T> &Pc, std::vector<T> const &xVal,
+        std::vector<T> &x, std::vector<T> &C,
+        std::vector<T> &w);
 
 /*! Computes the approximation error at a given node using the current set of
  * reference points
@@ -171,10 +243,44 @@ void computeApprox(double &Pc, const double &xVal,
  * @param[in] w the barycentric weights
  * @param[in] bands frequency band information for the ideal filter
  */
-void computeError(double &error, const double &xVal,
-        double &delta, std::vector<double> &x,
-        std::vector<double> &C, std::vector<double> &w,
-        std::vector<BandD> &bands);
+template <typename T>
+void computeError(T &error, const T &xVal,
+        T &delta, std::vector<T> &x,
+        std::vector<T> &C, std::vector<T> &w,
+        std::vector<BandT<T>> &bands);
+
+/*! Computes the approximation errors at a set of nodes using the current set
+ * of reference points
+ * @param[out] error the error values at the n nodes
+ * @param[in] xVal the n nodes where we do our computation
+ * @param[in] n the number of nodes
+ * @param[in] delta the current reference error
+ * @param[in] x the current reference set
+ * @param[in] C the frequency response values at the x nodes
+ * @param[in] w the barycentric weights
+ * @param[in] bands frequency band information for the ideal filter
+ */
+template <typename T>
+void computeError(T *error, const T *xVal, std::size_t n,
+        T &delta, std::vector<T> &x,
+        std::vector<T> &C, std::vector<T> &w,
+        std::vector<BandT<T>> &bands);
+
+/*! Computes the approximation errors at a set of nodes using the current set
+ * of reference points
+ * @param[out] error the error values at the xVal nodes
+ * @param[in] xVal the nodes where we do our computation
+ * @param[in] delta the current reference error
+ * @param[in] x the current reference set
+ * @param[in] C the frequency response values at the x nodes
+ * @param[in] w the barycentric weights
+ * @param[in] bands frequency band information for the ideal filter
+ */
+template <typename T>
+void computeError(std::vector<T> &error, std::vector<T> const &xVal,
+        T &delta, std::vector<T> &x,
+        std::vector<T> &C, std::vector<T> &w,
+        std::vector<BandT<T>> &bands);
 
 /*! The ideal frequency response and weight information at the given frequency
  * node (it can be in the \f$\left[-1,1\right]\f$ interval,
@@ -183,10 +289,12 @@ void computeError(double &error, const double &xVal,
  * @param[out] D ideal frequency response
  * @param[out] W weight value for the current point
  * @param[in] xVal the current frequency node where we do our computation
- * @param[in] bands frequency band information for the ideal filter
+ * @param[in] bands frequency band information for the ideal filter (the
+ * bands are sorted in increasing order)
  */
-void computeIdealResponseAndWeight(double &D, double &W,
-        const double &xVal, std::vector<BandD> &bands);
+template <typename T>
+void computeIdealResponseAndWeight(T &D, T &W,
+        const T &xVal, std::vector<BandT<T>> &bands);
 
 
 #endif // BARYCENTRIC_H
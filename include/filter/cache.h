@@ -0,0 +1,123 @@
+/**
+ * @file cache.h
+ * @brief Persistent on-disk store of minimax designs and quantization
+ * results
+ *
+ * The results are addressed by a key describing the specification they
+ * were computed for. Each entry is stored in its own file, named after the
+ * hash of its key, using a compact binary layout whose numeric arrays are
+ * 8-byte aligned, so that the files can be memory mapped and read without
+ * any parsing. The full key is stored together with the result, so a hash
+ * collision is detected as a cache miss.
+ */
+
+#ifndef CACHE_H_
+#define CACHE_H_
+
+#include "util.h"
+#include "pm.h"
+#include "fpminimax.h"
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Canonical description of the inputs of a computation
+ *
+ * The values are appended in a canonical binary form (MPFR values are
+ * encoded exactly, together with their precision), so two keys are equal
+ * if and only if they were built from the same sequence of values.
+ */
+class CacheKey
+{
+public:
+    CacheKey& add(std::string const& tag);
+    CacheKey& add(const char* tag) { return add(std::string(tag)); }
+    CacheKey& add(std::uint64_t value);
+    CacheKey& add(double value);
+    CacheKey& add(mpfr::mpreal const& value);
+    CacheKey& add(std::vector<double> const& values);
+    CacheKey& add(std::vector<mpfr::mpreal> const& values);
+
+    /*! The 64-bit FNV-1a hash of the key */
+    std::uint64_t hash() const;
+    /*! The canonical encoding of the key */
+    std::string const& bytes() const { return data; }
+private:
+    std::string data;
+};
+
+/*! Key of a minimax design computed with the double precision routines
+ * @param[in] f the band edges, given as fractions of \f$\pi\f$
+ * @param[in] a the ideal amplitudes at the band edges
+ * @param[in] w the band weights
+ * @param[in] degree the filter order (or degree of its amplitude)
+ */
+CacheKey designKey(std::vector<double> const& f,
+        std::vector<double> const& a,
+        std::vector<double> const& w,
+        std::size_t degree);
+
+/*! Key of a minimax design computed with the MPFR routines
+ * @param[in] f the band edges, given as fractions of \f$\pi\f$
+ * @param[in] a the ideal amplitudes at the band edges
+ * @param[in] w the band weights
+ * @param[in] degree the filter order (or degree of its amplitude)
+ * @param[in] prec the working precision of the computation
+ */
+CacheKey designKey(std::vector<mpfr::mpreal> const& f,
+        std::vector<mpfr::mpreal> const& a,
+        std::vector<mpfr::mpreal> const& w,
+        std::size_t degree,
+        mp_prec_t prec = 165ul);
+
+/*! Key of the quantization of a minimax design. Besides the design and
+ * the scaling factor, it contains the quantization method and all the
+ * options of the context which change the result (reduction strategy,
+ * search parameters, norm evaluation and fixed coefficients).
+ * @param[in] design the key of the design which is quantized
+ * @param[in] scalingFactor the scaling factor of the quantization
+ * @param[in] method the quantization strategy
+ * @param[in] context the quantization context of the design
+ */
+CacheKey quantizationKey(CacheKey const& design,
+        mpfr::mpreal const& scalingFactor,
+        QuantizationMethod method,
+        QuantizationContext const& context);
+
+/**
+ * @brief Content-addressed store of results, kept in a directory
+ *
+ * Entries are written to a temporary file which is then renamed, so that
+ * several processes (or threads) can share the same directory. Lookups
+ * fail (and return false) on missing, truncated or mismatching entries,
+ * in which case the output parameter is left untouched.
+ */
+class ResultCache
+{
+public:
+    /*! Opens a store (the directory is created if it does not exist)
+     * @param[in] directory the directory holding the entries
+     */
+    explicit ResultCache(std::string const& directory);
+
+    bool lookup(PMOutputD& output, CacheKey const& key) const;
+    bool lookup(PMOutput& output, CacheKey const& key) const;
+    bool lookup(QuantizationResult& result, CacheKey const& key) const;
+
+    /*! Stores a result (the timings of a QuantizationResult are not kept)
+     * @return true if the entry was written
+     */
+    bool store(CacheKey const& key, PMOutputD const& output) const;
+    bool store(CacheKey const& key, PMOutput const& output) const;
+    bool store(CacheKey const& key, QuantizationResult const& result) const;
+
+    /*! The directory holding the entries */
+    std::string const& directory() const { return root; }
+private:
+    std::string path(CacheKey const& key, std::uint32_t kind) const;
+    bool write(CacheKey const& key, std::uint32_t kind,
+            std::string const& payload) const;
+    std::string root;
+};
+
+#endif /* CACHE_H_ */
@@ -58,6 +58,19 @@ void evaluateClenshaw(mpfr::mpreal &result, std::vector<mpfr::mpreal> &p,
                         mpfr::mpreal &x,
                         mp_prec_t prec = 165ul);
 
+/*! Version of the above Clenshaw algorithm using the scratch variables of a
+ *  workspace. The computations are done in the precision of the workspace
+ *  and the default MPFR precision is left untouched.
+ *  @param[out] result reference to the variable that will contain the
+ *  evaluation of the CI at the specified point (parameter x)
+ *  @param[in] p a vector containing the coefficients of the CI
+ *  @param[in] x the point at which we want to compute the value
+ *  of the CI
+ *  @param[in,out] ws the workspace holding the temporaries
+ */
+void evaluateClenshaw(mpfr::mpreal &result, std::vector<mpfr::mpreal> &p,
+                        mpfr::mpreal &x, MPWorkspace &ws);
+
 /*! The Clenshaw algorithm which evaluates the value of a CI expressed
  *  using a basis consisting of Chebyshev polynomials of the second kind.
  *  The working interval is considered to be \f$\left[-1,1\right]\f$.
@@ -124,13 +137,18 @@ void derivativeCoefficients1stKind(std::vector<mpfr::mpreal>& derivC,
 void derivativeCoefficients2ndKind(std::vector<mpfr::mpreal>& derivC,
         std::vector<mpfr::mpreal>& c);
 
+// The routines below work with native floating-point types; apart from the
+// batched Clenshaw evaluations, which are specific to double, they are
+// instantiated for double and dd::ddreal
+
 /*! Computes the cosines of the elements of a vector
  * @param[in] in the vector to process
  * @param[out] out the vector containing the cosines of the elements from the
  * vector in
  */
-void applyCos(std::vector<double>& out,
-        std::vector<double> const& in);
+template <typename T>
+void applyCos(std::vector<T>& out,
+        std::vector<T> const& in);
 
 /*! Does a change of variable from the interval \f$\left[-1, 1\right]\f$ to the
  * interval \f$\left[a, b\right]\f$ on the elements of a given input vector
@@ -139,9 +157,10 @@ void applyCos(std::vector<double>& out,
  * @param[in] a left bound of the desired interval
  * @param[in] b right bound of the desired interval
  */
-void changeOfVariable(std::vector<double>& out,
-        std::vector<double> const& in,
-        double& a, double& b);
+template <typename T>
+void changeOfVariable(std::vector<T>& out,
+        std::vector<T> const& in,
+        T& a, T& b);
 
 /*! The Clenshaw algorithm which evaluates the value of a Chebyshev interpolant
  *  (CI) at a certain point
@@ -153,8 +172,9 @@ void changeOfVariable(std::vector<double>& out,
  *  @param[in] a left bound of the interval where the CI is considered
  *  @param[in] b right bound of the interval where the CI is considered
  */
-void evaluateClenshaw(double &result, std::vector<double> &p,
-                        double &x, double &a, double &b);
+template <typename T>
+void evaluateClenshaw(T &result, std::vector<T> &p,
+                        T &x, T &a, T &b);
 
 /*! The Clenshaw algorithm which evaluates the value of a CI implicitly
  *  considered on the \f$\left[-1,1\right]\f$ interval
@@ -164,8 +184,44 @@ void evaluateClenshaw(double &result, std::vector<double> &p,
  *  @param[in] x the point at which we want to compute the value
  *  of the CI
  */
-void evaluateClenshaw(double &result, std::vector<double> &p,
-                        double &x);
+template <typename T>
+void evaluateClenshaw(T &result, std::vector<T> &p,
+                        T &x);
+
+/*! Batched version of the Clenshaw algorithm for CIs considered on the
+ *  \f$\left[-1,1\right]\f$ interval, which evaluates a CI at n points.
+ *  Depending on the processor it runs on, the evaluation is done using
+ *  AVX-512 or AVX2 instructions (the results are identical to the ones
+ *  of the scalar evaluation).
+ *  @param[out] result pointer to the memory location that will contain the
+ *  n values of the CI
+ *  @param[in] x pointer to the n points at which we want to evaluate the CI
+ *  @param[in] n the number of points
+ *  @param[in] p a vector containing the coefficients of the CI
+ */
+void evaluateClenshaw(double *result, const double *x, std::size_t n,
+                        std::vector<double> &p);
+
+/*! Batched version of the Clenshaw algorithm which evaluates a CI at a set
+ *  of points
+ *  @param[out] result vector that will contain the values of the CI at the
+ *  points from x
+ *  @param[in] p a vector containing the coefficients of the CI
+ *  @param[in] x the points at which we want to evaluate the CI
+ */
+void evaluateClenshaw(std::vector<double> &result, std::vector<double> &p,
+                        std::vector<double> &x);
+
+/*! Batched version of the Clenshaw algorithm which evaluates several CIs
+ *  at the same set of points
+ *  @param[out] result result[k] will contain the values of the CI with
+ *  coefficients p[k] at the points from x
+ *  @param[in] p the coefficients of each CI
+ *  @param[in] x the points at which we want to evaluate the CIs
+ */
+void evaluateClenshaw(std::vector<std::vector<double>> &result,
+                        std::vector<std::vector<double>> &p,
+                        std::vector<double> &x);
 
 /*! The Clenshaw algorithm which evaluates the value of a CI expressed
  *  using a basis consisting of Chebyshev polynomials of the second kind.
@@ -176,8 +232,9 @@ void evaluateClenshaw(double &result, std::vector<double> &p,
  *  @param[in] x the point at which we want to compute the value
  *  of the CI
  */
-void evaluateClenshaw2ndKind(double &result, std::vector<double> &p,
-                        double &x);
+template <typename T>
+void evaluateClenshaw2ndKind(T &result, std::vector<T> &p,
+                        T &x);
 
 
 /*! Function that generates equidistant nodes inside the
@@ -186,14 +243,16 @@ void evaluateClenshaw2ndKind(double &result, std::vector<double> &p,
  * @param[out] v the vector that will contain the equi-distributed points
  * @param[in] n the number of points - 1 which will be computed
  */
-void generateEquidistantNodes(std::vector<double>& v, std::size_t n);
+template <typename T>
+void generateEquidistantNodes(std::vector<T>& v, std::size_t n);
 
 /*! Function that generates the Chebyshev nodes of the second kind
  * \f$\mu_k=\cos\left(\frac{k\pi}{n}\right), k=0,\ldots,n\f$.
  * @param[out] v the vector that will contain the Chebyshev nodes
  * @param[in] n the number of points - 1 which will be computed
  */
-void generateChebyshevPoints(std::vector<double>& v, std::size_t n);
+template <typename T>
+void generateChebyshevPoints(std::vector<T>& v, std::size_t n);
 
 
 /*! This function computes the values of the coefficients of the CI when
@@ -204,16 +263,18 @@ void generateChebyshevPoints(std::vector<double>& v, std::size_t n);
  * appropriate interval (in our case it will be \f$\left[0,\pi\right]\f$)
  * @param[in] n degree of the CI
  */
-void generateChebyshevCoefficients(std::vector<double>& c,
-                std::vector<double>& fv, std::size_t n);
+template <typename T>
+void generateChebyshevCoefficients(std::vector<T>& c,
+                std::vector<T>& fv, std::size_t n);
 
 /*! Function that generates the coefficients of the derivative of a given CI
  *  @param[out] derivC the vector of coefficients of the derivative of the CI
  *  @param[in] c the vector of coefficients of the CI whose derivative we
  *  want to compute
  */
-void derivativeCoefficients1stKind(std::vector<double>& derivC,
-                        std::vector<double>& c);
+template <typename T>
+void derivativeCoefficients1stKind(std::vector<T>& derivC,
+                        std::vector<T>& c);
 
 /*! Function that generates the coefficients of the derivative of a given
  *  CI, but expressed in the orthogonal basis of Chebyshev polynomials of
@@ -222,8 +283,9 @@ void derivativeCoefficients1stKind(std::vector<double>& derivC,
  *  @param[in] c the vector of coefficients of the CI whose derivative we
  *  want to compute
  */
-void derivativeCoefficients2ndKind(std::vector<double>& derivC,
-        std::vector<double>& c);
+template <typename T>
+void derivativeCoefficients2ndKind(std::vector<T>& derivC,
+        std::vector<T>& c);
 
 
 #endif /* CHEBY_H_ */
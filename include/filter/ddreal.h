@@ -0,0 +1,318 @@
+/**
+ * @file ddreal.h
+ * @brief Double-double floating-point type, used as an intermediate
+ * precision tier between double and mpfr::mpreal
+ *
+ * A value is represented as the unevaluated sum of two doubles
+ * \f$hi+lo\f$, with \f$|lo|\leq\frac{1}{2}ulp(hi)\f$, giving about 106 bits
+ * of precision (see [Hida&Li&Bailey2001] "Algorithms for Quad-Double
+ * Precision Floating Point Arithmetic" for the algorithms). The exponent
+ * range is the one of double.
+ */
+
+#ifndef DDREAL_H_
+#define DDREAL_H_
+
+#include <cmath>
+#include <complex>
+#include <limits>
+#include <ostream>
+#include <eigen3/Eigen/Core>
+
+namespace dd {
+
+/*! Sum of two doubles, together with its rounding error (requires
+ * \f$|a|\geq|b|\f$) */
+inline double quickTwoSum(double a, double b, double& err)
+{
+    double s = a + b;
+    err = b - (s - a);
+    return s;
+}
+
+/*! Sum of two doubles, together with its rounding error */
+inline double twoSum(double a, double b, double& err)
+{
+    double s = a + b;
+    double bb = s - a;
+    err = (a - (s - bb)) + (b - bb);
+    return s;
+}
+
+/*! Product of two doubles, together with its rounding error */
+inline double twoProd(double a, double b, double& err)
+{
+    double p = a * b;
+#ifdef FP_FAST_FMA
+    err = std::fma(a, b, -p);
+#else
+    // Dekker's splitting (only used when the target has no hardware fma,
+    // so the operations below cannot be contracted)
+    const double split = 134217729.0;       // 2^27 + 1
+    double t = split * a;
+    double ahi = t - (t - a);
+    double alo = a - ahi;
+    t = split * b;
+    double bhi = t - (t - b);
+    double blo = b - bhi;
+    err = ((ahi * bhi - p) + ahi * blo + alo * bhi) + alo * blo;
+#endif
+    return p;
+}
+
+/**
+ * @brief A double-double number
+ */
+class ddreal
+{
+public:
+    double hi;      /**< the leading component */
+    double lo;      /**< the trailing component */
+
+    ddreal() : hi(0.0), lo(0.0) {}
+    ddreal(double x) : hi(x), lo(0.0) {}
+    ddreal(double hi, double lo) : hi(hi), lo(lo) {}
+
+    /*! Rounds the value to double */
+    explicit operator double() const { return hi; }
+
+    ddreal& operator+=(ddreal const& b);
+    ddreal& operator-=(ddreal const& b);
+    ddreal& operator*=(ddreal const& b);
+    ddreal& operator/=(ddreal const& b);
+
+    static ddreal pi() { return ddreal(3.141592653589793, 1.2246467991473532e-16); }
+    static ddreal halfPi() { return ddreal(1.5707963267948966, 6.123233995736766e-17); }
+    static ddreal ln2() { return ddreal(0.6931471805599453, 2.3190468138462996e-17); }
+};
+
+inline ddreal operator-(ddreal const& a)
+{
+    return ddreal(-a.hi, -a.lo);
+}
+
+inline ddreal operator+(ddreal const& a, double b)
+{
+    double s2;
+    double s1 = twoSum(a.hi, b, s2);
+    if(!std::isfinite(s1))
+        return ddreal(s1);
+    s2 += a.lo;
+    s1 = quickTwoSum(s1, s2, s2);
+    return ddreal(s1, s2);
+}
+
+inline ddreal operator+(ddreal const& a, ddreal const& b)
+{
+    double s2, t2;
+    double s1 = twoSum(a.hi, b.hi, s2);
+    if(!std::isfinite(s1))
+        return ddreal(s1);
+    double t1 = twoSum(a.lo, b.lo, t2);
+    s2 += t1;
+    s1 = quickTwoSum(s1, s2, s2);
+    s2 += t2;
+    s1 = quickTwoSum(s1, s2, s2);
+    return ddreal(s1, s2);
+}
+
+inline ddreal operator+(double a, ddreal const& b) { return b + a; }
+inline ddreal operator-(ddreal const& a, double b) { return a + (-b); }
+inline ddreal operator-(ddreal const& a, ddreal const& b) { return a + (-b); }
+inline ddreal operator-(double a, ddreal const& b) { return (-b) + a; }
+
+inline ddreal operator*(ddreal const& a, double b)
+{
+    double p2;
+    double p1 = twoProd(a.hi, b, p2);
+    if(!std::isfinite(p1))
+        return ddreal(p1);
+    p2 += a.lo * b;
+    p1 = quickTwoSum(p1, p2, p2);
+    return ddreal(p1, p2);
+}
+
+inline ddreal operator*(ddreal const& a, ddreal const& b)
+{
+    double p2;
+    double p1 = twoProd(a.hi, b.hi, p2);
+    if(!std::isfinite(p1))
+        return ddreal(p1);
+    p2 += a.hi * b.lo + a.lo * b.hi;
+    p1 = quickTwoSum(p1, p2, p2);
+    return ddreal(p1, p2);
+}
+
+inline ddreal operator*(double a, ddreal const& b) { return b * a; }
+
+inline ddreal operator/(ddreal const& a, double b)
+{
+    double q1 = a.hi / b;
+    if(!std::isfinite(q1))
+        return ddreal(q1);
+    ddreal r = a - ddreal(b) * q1;
+    double q2 = r.hi / b;
+    r -= ddreal(b) * q2;
+    double q3 = r.hi / b;
+    q1 = quickTwoSum(q1, q2, q2);
+    return ddreal(q1, q2) + q3;
+}
+
+inline ddreal operator/(ddreal const& a, ddreal const& b)
+{
+    double q1 = a.hi / b.hi;
+    if(!std::isfinite(q1))
+        return ddreal(q1);
+    ddreal r = a - b * q1;
+    double q2 = r.hi / b.hi;
+    r -= b * q2;
+    double q3 = r.hi / b.hi;
+    q1 = quickTwoSum(q1, q2, q2);
+    return ddreal(q1, q2) + q3;
+}
+
+inline ddreal operator/(double a, ddreal const& b) { return ddreal(a) / b; }
+
+inline ddreal& ddreal::operator+=(ddreal const& b) { return *this = *this + b; }
+inline ddreal& ddreal::operator-=(ddreal const& b) { return *this = *this - b; }
+inline ddreal& ddreal::operator*=(ddreal const& b) { return *this = *this * b; }
+inline ddreal& ddreal::operator/=(ddreal const& b) { return *this = *this / b; }
+
+inline bool operator==(ddreal const& a, ddreal const& b)
+{
+    return a.hi == b.hi && a.lo == b.lo;
+}
+
+inline bool operator!=(ddreal const& a, ddreal const& b)
+{
+    return !(a == b);
+}
+
+inline bool operator<(ddreal const& a, ddreal const& b)
+{
+    return a.hi < b.hi || (a.hi == b.hi && a.lo < b.lo);
+}
+
+inline bool operator>(ddreal const& a, ddreal const& b) { return b < a; }
+
+inline bool operator<=(ddreal const& a, ddreal const& b)
+{
+    return a.hi < b.hi || (a.hi == b.hi && a.lo <= b.lo);
+}
+
+inline bool operator>=(ddreal const& a, ddreal const& b) { return b <= a; }
+
+inline bool signbit(ddreal const& x) { return std::signbit(x.hi); }
+inline bool isnan(ddreal const& x) { return std::isnan(x.hi); }
+inline bool isinf(ddreal const& x) { return std::isinf(x.hi); }
+inline bool isfinite(ddreal const& x) { return std::isfinite(x.hi); }
+
+inline ddreal fabs(ddreal const& x) { return std::signbit(x.hi) ? -x : x; }
+inline ddreal abs(ddreal const& x) { return fabs(x); }
+
+inline ddreal fmin(ddreal const& a, ddreal const& b)
+{
+    if(isnan(a))
+        return b;
+    return (b < a) ? b : a;
+}
+
+inline ddreal fmax(ddreal const& a, ddreal const& b)
+{
+    if(isnan(a))
+        return b;
+    return (a < b) ? b : a;
+}
+
+inline ddreal ldexp(ddreal const& x, int e)
+{
+    return ddreal(std::ldexp(x.hi, e), std::ldexp(x.lo, e));
+}
+
+inline long lrint(ddreal const& x) { return std::lrint(x.hi); }
+
+inline ddreal sqrt(ddreal const& x)
+{
+    if(x.hi <= 0.0)
+        return ddreal(std::sqrt(x.hi));
+    double q = std::sqrt(x.hi);
+    double e;
+    double q2 = twoProd(q, q, e);
+    ddreal r = x - ddreal(q2, e);
+    return ddreal(q) + r.hi * (0.5 / q);
+}
+
+ddreal exp(ddreal const& x);
+ddreal log(ddreal const& x);
+ddreal cos(ddreal const& x);
+ddreal sin(ddreal const& x);
+ddreal acos(ddreal const& x);
+
+/*! The double code paths call the long double versions of some of the
+ * elementary functions to gain a few more bits of accuracy. The double-double
+ * versions are already more accurate than those, so these overloads simply
+ * forward to them, which allows the same code to be instantiated for both
+ * types. */
+inline ddreal fabsl(ddreal const& x) { return fabs(x); }
+inline ddreal fminl(ddreal const& a, ddreal const& b) { return fmin(a, b); }
+inline ddreal cosl(ddreal const& x) { return cos(x); }
+inline ddreal sinl(ddreal const& x) { return sin(x); }
+inline ddreal acosl(ddreal const& x) { return acos(x); }
+
+std::ostream& operator<<(std::ostream& os, ddreal const& x);
+
+} // namespace dd
+
+namespace std {
+
+template <>
+class numeric_limits<dd::ddreal> : public numeric_limits<double>
+{
+public:
+    static const int digits = 106;
+    static const int digits10 = 31;
+    static const int max_digits10 = 33;
+
+    static dd::ddreal min() { return numeric_limits<double>::min(); }
+    static dd::ddreal max() { return numeric_limits<double>::max(); }
+    static dd::ddreal lowest() { return -numeric_limits<double>::max(); }
+    static dd::ddreal epsilon() { return 4.930380657631324e-32; }   // 2^-104
+    static dd::ddreal round_error() { return 0.5; }
+    static dd::ddreal infinity() { return numeric_limits<double>::infinity(); }
+    static dd::ddreal quiet_NaN() { return numeric_limits<double>::quiet_NaN(); }
+    static dd::ddreal signaling_NaN()
+    {
+        return numeric_limits<double>::signaling_NaN();
+    }
+    static dd::ddreal denorm_min() { return numeric_limits<double>::denorm_min(); }
+};
+
+} // namespace std
+
+namespace Eigen {
+
+template <>
+struct NumTraits<dd::ddreal> : GenericNumTraits<dd::ddreal>
+{
+    enum {
+        IsInteger = 0,
+        IsSigned = 1,
+        IsComplex = 0,
+        RequireInitialization = 0,
+        ReadCost = 2,
+        AddCost = 20,
+        MulCost = 12
+    };
+
+    typedef dd::ddreal Real;
+    typedef dd::ddreal NonInteger;
+    typedef dd::ddreal Literal;
+
+    static inline Real epsilon() { return std::numeric_limits<Real>::epsilon(); }
+    static inline Real dummy_precision() { return 1e-28; }
+    static inline int digits10() { return std::numeric_limits<Real>::digits10; }
+};
+
+} // namespace Eigen
+
+#endif /* DDREAL_H_ */
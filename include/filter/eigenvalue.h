@@ -68,6 +68,21 @@ void getRealValues(std::vector<mpfr::mpreal> &realValues,
         VectorXcq &complexValues,
         mpfr::mpreal &a, mpfr::mpreal &b);
 
+/*! Function that computes the real eigenvalues of a colleague matrix
+ * (as generated by generateColleagueMatrix1stKind or
+ * generateColleagueMatrix2ndKind) that are located inside an interval
+ * \f$[a,b]\f$. It gives the same values as determineEigenvalues followed by
+ * getRealValues, but it takes advantage of the structure of the matrix
+ * (its transpose is upper Hessenberg) and does not compute any eigenvectors.
+ * @param[out] realValues the real eigenvalues inside \f$[a,b]\f$, in
+ * increasing order
+ * @param[in] C the colleague matrix
+ * @param[in] a left side of the closed interval
+ * @param[in] b right side of the closed interval
+ */
+void determineRealEigenvalues(std::vector<mpfr::mpreal> &realValues,
+        MatrixXq &C, mpfr::mpreal &a, mpfr::mpreal &b);
+
 
 /** Eigen matrix container for double values */
 typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic> MatrixXd;
@@ -75,6 +90,20 @@ typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic> MatrixXd;
 typedef Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1> VectorXcd;
 
 
+/** Eigen matrix container for native floating-point values */
+template <typename T>
+using MatrixXT = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
+/** Eigen vector container for native floating-point values */
+template <typename T>
+using VectorXT = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+/** Eigen vector container for complex values with native floating-point
+ * components */
+template <typename T>
+using VectorXcT = Eigen::Matrix<std::complex<T>, Eigen::Dynamic, 1>;
+
+// The routines below work with native floating-point types and are
+// instantiated for double and dd::ddreal
+
 /*! Function that generates the colleague matrix for a Chebyshev interpolant
  * expressed using the basis of Chebyshev polynomials of the first kind
  * (WITH or WITHOUT balancing in the vein of [Parlett&Reinsch1969] "Balancing a Matrix for
@@ -83,8 +112,9 @@ typedef Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1> VectorXcd;
  * @param[in] a the coefficients of the Chebyshev interpolant
  * @param[in] withBalancing perform a balancing operation on the colleague matrix C
  */
-void generateColleagueMatrix1stKind(MatrixXd& C,
-        std::vector<double>& a, bool withBalancing = true);
+template <typename T>
+void generateColleagueMatrix1stKind(MatrixXT<T>& C,
+        std::vector<T>& a, bool withBalancing = true);
 
 /*! Function that generates the colleague matrix for a Chebyshev interpolant
  * expressed using the basis of Chebyshev polynomials of the second kind
@@ -93,16 +123,18 @@ void generateColleagueMatrix1stKind(MatrixXd& C,
  * @param[in] a the coefficients of the Chebyshev interpolant
  * @param[in] withBalancing perform a balancing operation on the colleague matrix C
  */
-void generateColleagueMatrix2ndKind(MatrixXd& C,
-        std::vector<double>& a, bool withBalancing = true);
+template <typename T>
+void generateColleagueMatrix2ndKind(MatrixXT<T>& C,
+        std::vector<T>& a, bool withBalancing = true);
 
 
 /*! Function that computes the eigenvalues of a given matrix
  * @param[out] eigenvalues the computed eigenvalues
  * @param[in] C the corresponding matrix
  */
-void determineEigenvalues(VectorXcd &eigenvalues,
-        MatrixXd &C);
+template <typename T>
+void determineEigenvalues(VectorXcT<T> &eigenvalues,
+        MatrixXT<T> &C);
 
 /*! Function that computes the real values located inside
  * an interval \f$[a,b]\f$ from a vector of complex values
@@ -111,9 +143,25 @@ void determineEigenvalues(VectorXcd &eigenvalues,
  * @param[in] a left side of the closed interval
  * @param[in] b right side of the closed interval
  */
-void getRealValues(std::vector<double> &realValues,
-        VectorXcd &complexValues,
-        double &a, double &b);
+template <typename T>
+void getRealValues(std::vector<T> &realValues,
+        VectorXcT<T> &complexValues,
+        T &a, T &b);
+
+/*! Function that computes the real eigenvalues of a colleague matrix
+ * that are located inside an interval \f$[a,b]\f$ (see the mpfr::mpreal
+ * version). The matrices of size 3, 4, 7, 8, 15 and 16 (i.e. those used by
+ * the root finding routines with the usual subinterval degrees) are handled
+ * with fixed-size Eigen types, without any dynamic allocation.
+ * @param[out] realValues the real eigenvalues inside \f$[a,b]\f$, in
+ * increasing order
+ * @param[in] C the colleague matrix
+ * @param[in] a left side of the closed interval
+ * @param[in] b right side of the closed interval
+ */
+template <typename T>
+void determineRealEigenvalues(std::vector<T> &realValues,
+        MatrixXT<T> &C, T &a, T &b);
 
 
 #endif
@@ -10,6 +10,269 @@
 
 #include "util.h"
 #include "roots.h"
+#include "grid.h"
+#include "instrumentation.h"
+#include <fplll.h>
+#include <gmpxx.h>
+
+/**
+ * @brief The lattice reduction algorithms available for the quantization.
+ */
+enum class ReductionMethod {
+    LLL_WRAPPER,    /**< fplll's wrapper LLL, which tries increasingly
+                      precise floating-point LLL variants */
+    LLL_PROVED,     /**< proved LLL with exact Gram-Schmidt bounds */
+    LLL_FAST,       /**< fast floating-point LLL (no correctness
+                      guarantee, but much faster for large degrees) */
+    LLL_HEURISTIC,  /**< heuristic floating-point LLL */
+    BKZ             /**< BKZ reduction, giving shorter SVP vectors at
+                      a higher cost */
+};
+
+/**
+ * @brief Parameters of the lattice reduction step.
+ */
+struct ReductionStrategy
+{
+    ReductionMethod method = ReductionMethod::LLL_WRAPPER;
+                                /**< the reduction algorithm */
+    double delta = 0.99;        /**< the Lovasz condition parameter */
+    double eta = 0.51;          /**< the size reduction parameter (LLL
+                                  variants only, BKZ ignores it) */
+    int blockSize = 8;          /**< the BKZ block size */
+    bool autoAbort = true;      /**< stop BKZ once the basis quality no
+                                  longer improves */
+    int maxLoops = 0;           /**< maximum number of BKZ tours (0 means
+                                  no limit) */
+    bool nearestPlane = false;  /**< solve the second target of the
+                                  minimax kernel with Babai's nearest
+                                  plane algorithm on the already reduced
+                                  basis instead of a second Kannan
+                                  embedding and reduction (faster, but the
+                                  quantized coefficients, and their error,
+                                  can change; the embedding is used anyway
+                                  when the basis rows are not linearly
+                                  independent) */
+};
+
+/**
+ * @brief Parameters of the branch-and-bound search performed around the
+ * LLL solutions by fpminimaxWithBranchAndBound.
+ *
+ * The candidates are the LLL solutions plus integer combinations
+ * \f$\sum_k c_k v_k\f$ of the first SVP vectors \f$v_k\f$ of the reduced
+ * basis, with \f$|c_k|\le\f$ radius.
+ */
+struct BranchAndBoundOptions
+{
+    std::size_t vectors = 9u;   /**< number of SVP vectors which are
+                                  combined */
+    int radius = 1;             /**< the largest absolute value of a
+                                  coordinate */
+    std::size_t maxNodes = 0u;  /**< the search stops after visiting this
+                                  many nodes (0 means no limit) */
+    double maxTime = 0.0;       /**< the search stops after this many ms
+                                  (0 means no limit) */
+};
+
+/**
+ * @brief Precomputed data shared by the quantization routines.
+ *
+ * Contains everything that only depends on the filter specification, the
+ * coefficients to quantize and the interpolation nodes. It can be reused
+ * by successive quantization calls which only differ in the scaling factor
+ * (i.e. the target word length).
+ */
+struct QuantizationContext
+{
+    std::vector<mpfr::mpreal> freeA;    /**< the coefficients to quantize */
+    std::vector<mpfr::mpreal> fixedA;   /**< coefficients which are already
+                                          fixed (appended to the free ones) */
+    std::vector<Band> freqBands;        /**< the frequency bands, given inside
+                                          \f$[0,\pi]\f$ */
+    std::vector<Band> chebyBands;       /**< the bands, given inside
+                                          \f$[-1,1]\f$ */
+    Grid grid;                          /**< the dense grid used for the
+                                          norm computations */
+    std::vector<mpfr::mpreal> weights;  /**< the weights associated to the
+                                          interpolation nodes */
+    std::vector<mpfr::mpreal> nodes;    /**< the interpolation nodes, given
+                                          inside \f$[0,\pi]\f$ */
+    std::vector<mpfr::mpreal> minimaxValues;    /**< the weighted values of the
+                                                  unquantized filter at the
+                                                  nodes */
+    std::vector<mpfr::mpreal> idealValues;      /**< the weighted values of the
+                                                  ideal response at the nodes */
+    std::vector<std::vector<mpfr::mpreal>> basisEntries;    /**< the lattice
+                                                          basis values
+                                                          \f$w_i\cos(j\omega_i)\f$
+                                                          stored at position
+                                                          [j][i] */
+    ReductionStrategy reduction;        /**< the lattice reduction
+                                          strategy */
+    BranchAndBoundOptions search;       /**< the parameters of the
+                                          branch-and-bound search */
+    bool adaptiveNorm = false;          /**< evaluate the norms with
+                                          computeAdaptiveNorm instead of a
+                                          scan of the whole grid */
+    AdaptiveNormOptions norm;           /**< the parameters of the adaptive
+                                          norm evaluations */
+    QuantizationStats stats;            /**< timings of the context
+                                          construction */
+    mp_prec_t prec;                     /**< MPFR working precision */
+};
+
+/*! Builds the quantization context of a filter
+ * @param[out] context the computed context
+ * @param[in] freeA the Chebyshev coefficients to quantize
+ * @param[in] fixedA coefficients which are already fixed
+ * @param[in] interpolationPoints the interpolation nodes, given inside
+ * \f$[-1,1]\f$
+ * @param[in] freqBands the frequency bands, given inside \f$[0,\pi]\f$
+ * @param[in] weights the weights associated to the interpolation nodes
+ * @param[in] prec MPFR working precision used to perform the computations
+ */
+void initQuantizationContext(QuantizationContext& context,
+        std::vector<mpfr::mpreal>& freeA,
+        std::vector<mpfr::mpreal>& fixedA,
+        std::vector<mpfr::mpreal>& interpolationPoints,
+        std::vector<Band>& freqBands,
+        std::vector<mpfr::mpreal>& weights,
+        mp_prec_t prec = 165ul);
+
+/**
+ * @brief The outcome of quantizing a filter for a given word length.
+ */
+struct QuantizationResult
+{
+    mpfr::mpreal scalingFactor;         /**< the scaling factor used for the
+                                          quantization */
+    long bits;                          /**< the corresponding number of
+                                          fractional bits, i.e.
+                                          \f$\log_2\f$ of the scaling factor */
+    double naiveError;                  /**< weighted error of the naive
+                                          rounding of the coefficients */
+    double lllError;                    /**< weighted error of the LLL
+                                          solution, before the neighborhood
+                                          search */
+    double finalError;                  /**< weighted error of the returned
+                                          coefficients */
+    std::vector<mpfr::mpreal> coefficients; /**< the quantized free
+                                              coefficients */
+    QuantizationStats stats;            /**< timings and event counts of
+                                          the quantization */
+};
+
+/**
+ * @brief The quantization strategies which can be used by quantizeSweep.
+ */
+enum class QuantizationMethod {
+    NEIGHBORHOOD,   /**< fpminimaxWithNeighborhoodSearchDiscrete */
+    MINIMAX,        /**< fpminimaxWithNeighborhoodSearchDiscreteMinimax */
+    RANDOM,         /**< fpminimaxWithNeighborhoodSearchDiscreteRand */
+    FULL,           /**< fpminimaxWithNeighborhoodSearchDiscreteFull */
+    BRANCH_AND_BOUND    /**< fpminimaxWithBranchAndBound */
+};
+
+/*! Quantizes the coefficients of a filter using a precomputed context
+ * @param[out] result the quantized coefficients together with the naive,
+ * LLL and final errors
+ * @param[in] context the quantization context of the filter
+ * @param[in] scalingFactor the scaling factor corresponding to the target
+ * word length
+ */
+void fpminimaxWithNeighborhoodSearchDiscrete(
+        QuantizationResult& result,
+        QuantizationContext& context,
+        mpfr::mpreal& scalingFactor);
+
+void fpminimaxWithNeighborhoodSearchDiscreteMinimax(
+        QuantizationResult& result,
+        QuantizationContext& context,
+        mpfr::mpreal& scalingFactor);
+
+void fpminimaxWithNeighborhoodSearchDiscreteRand(
+        QuantizationResult& result,
+        QuantizationContext& context,
+        mpfr::mpreal& scalingFactor);
+
+void fpminimaxWithNeighborhoodSearchDiscreteFull(
+        QuantizationResult& result,
+        QuantizationContext& context,
+        mpfr::mpreal& scalingFactor);
+
+/*! Quantizes the coefficients of a filter using a precomputed context,
+ * followed by a branch-and-bound search around the two LLL solutions
+ * (the parameters of the search are given by context.search). The
+ * subtrees of the search are explored in parallel, and a subtree is
+ * discarded as soon as a lower bound on the error of all its candidates,
+ * computed band by band from the tabulated responses of the SVP vectors
+ * which are not fixed yet, reaches the best error found so far.
+ * @param[out] result the quantized coefficients together with the naive,
+ * LLL and final errors (the number of visited nodes is reported in the
+ * statistics)
+ * @param[in] context the quantization context of the filter
+ * @param[in] scalingFactor the scaling factor corresponding to the target
+ * word length
+ */
+void fpminimaxWithBranchAndBound(
+        QuantizationResult& result,
+        QuantizationContext& context,
+        mpfr::mpreal& scalingFactor);
+
+/*! Quantizes a filter for several word lengths at once. The different
+ * scaling factors are processed concurrently and share the same context.
+ * @param[out] results the quantization results, in the order of the
+ * scaling factors
+ * @param[in] context the quantization context of the filter
+ * @param[in] scalingFactors the scaling factors to try
+ * @param[in] method the quantization strategy to use
+ */
+void quantizeSweep(std::vector<QuantizationResult>& results,
+        QuantizationContext& context,
+        std::vector<mpfr::mpreal>& scalingFactors,
+        QuantizationMethod method = QuantizationMethod::NEIGHBORHOOD);
+
+/**
+ * @brief A quantization to run as part of a batch.
+ */
+struct QuantizationJob
+{
+    QuantizationContext* context;       /**< the quantization context of the
+                                          filter (several jobs can share
+                                          the same context) */
+    mpfr::mpreal scalingFactor;         /**< the scaling factor corresponding
+                                          to the target word length */
+    QuantizationMethod method = QuantizationMethod::NEIGHBORHOOD;
+                                        /**< the quantization strategy */
+};
+
+/*! Runs a batch of quantizations, possibly of different filters, as tasks
+ * of a single pool of threads. The loops inside each quantization are
+ * split into tasks of the same pool, so that a batch made of a few large
+ * filters keeps all the threads busy as well.
+ * @param[out] results the quantization results, in the order of the jobs
+ * @param[in] jobs the quantizations to perform
+ * @param[in] threads the number of threads to use (0 means the OpenMP
+ * default)
+ */
+void quantizeBatch(std::vector<QuantizationResult>& results,
+        std::vector<QuantizationJob>& jobs,
+        std::size_t threads = 0u);
+
+/*! Babai's nearest plane algorithm: computes the coordinates, with respect
+ * to the rows of an LLL-reduced basis, of a lattice vector close to a target
+ * vector (its distance to the target is at most \f$2^{n/2}\f$ times the
+ * one of the closest vector)
+ * @param[out] coords the integer coordinates of the lattice vector
+ * @param[in] basis the LLL-reduced basis, one vector per row
+ * @param[in] t the target vector
+ * @return false if the rows of the basis are linearly dependent (one of
+ * the Gram-Schmidt norms is zero), in which case coords is left empty
+ */
+bool babaiNearestPlane(std::vector<mpz_class>& coords,
+        fplll::ZZ_mat<mpz_t>& basis,
+        std::vector<mpz_class>& t);
 
 void fpminimaxWithNeighborhoodSearchDiscrete(
         mpfr::mpreal& minError,
@@ -13,23 +13,286 @@
 #include "util.h"
 #include "cheby.h"
 #include "barycentric.h"
+#include <new>
 
-struct GridPoint
+/**
+ * @brief Minimal allocator returning memory aligned on Alignment bytes
+ *
+ * Used for the arrays processed by the vectorized kernels.
+ */
+template <typename T, std::size_t Alignment = 64u>
+struct AlignedAllocator
+{
+    typedef T value_type;
+    template <typename U> struct rebind {
+        typedef AlignedAllocator<U, Alignment> other;
+    };
+
+    AlignedAllocator() {}
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(std::size_t n)
+    {
+        void* ptr = nullptr;
+        if (n > 0u && posix_memalign(&ptr, Alignment, n * sizeof(T)) != 0)
+            throw std::bad_alloc();
+        return static_cast<T*>(ptr);
+    }
+    void deallocate(T* ptr, std::size_t) { free(ptr); }
+};
+
+template <typename T, typename U, std::size_t Alignment>
+bool operator==(const AlignedAllocator<T, Alignment>&,
+        const AlignedAllocator<U, Alignment>&) { return true; }
+
+template <typename T, typename U, std::size_t Alignment>
+bool operator!=(const AlignedAllocator<T, Alignment>&,
+        const AlignedAllocator<U, Alignment>&) { return false; }
+
+/** utility type for aligned double precision arrays */
+typedef std::vector<double, AlignedAllocator<double>> AlignedVectorD;
+
+/**
+ * @brief A discretization of the approximation domain
+ *
+ * The information about the grid points is stored as separate (aligned)
+ * arrays and the points of each band are stored contiguously.
+ */
+struct Grid
+{
+    AlignedVectorD omega;   /**< the grid points inside \f$[0,\pi]\f$*/
+    AlignedVectorD x;       /**< the grid points inside \f$[-1,1]\f$
+                              (i.e. \f$x_i=\cos(\omega_i)\f$)*/
+    AlignedVectorD D;       /**< the ideal response at each grid point */
+    AlignedVectorD W;       /**< the weight function value at each
+                              grid point */
+    std::vector<std::size_t> bandOffsets;   /**< the points of the k-th
+                                              frequency band are the ones with
+                                              indices in
+                                              [bandOffsets[k], bandOffsets[k+1]) */
+    std::vector<std::size_t> bandIndices;   /**< position of the k-th frequency
+                                              band inside the CHEBY space band
+                                              vector (bandConversion reverses
+                                              the order of the bands) */
+
+    /** the number of grid points */
+    std::size_t size() const { return x.size(); }
+};
+
+/**
+ * @brief Values of a set of polynomials tabulated on a grid
+ *
+ * The values are stored contiguously, one row per polynomial, so that
+ * linear combinations of the polynomials can be evaluated on the whole
+ * grid with simple vector operations.
+ */
+struct GridResponse
+{
+    std::size_t points;             /**< number of grid points */
+    std::size_t count;              /**< number of tabulated polynomials */
+    std::vector<double> values;     /**< the weighted values
+                                      \f$W(x_i)p_k(x_i)\f$ stored at
+                                      position \f$k\cdot\f$points\f$+i\f$ */
+};
+
+/**
+ * @brief A discretization of the approximation domain on the uniform
+ * lattice \f$\omega_k=k\pi/M\f$, \f$k=0,\dots,M\f$
+ *
+ * The values of a polynomial at all the lattice points are given by a
+ * discrete cosine transform of its Chebyshev coefficients, which is
+ * computed with an FFT. The band edges, which are usually not lattice
+ * points, are stored separately.
+ */
+struct SpectralGrid
 {
-    double omega;
-    double x;
-    double D;
-    double W;
+    std::size_t size;                   /**< the lattice size \f$M\f$ (a
+                                          power of two) */
+    Grid lattice;                       /**< the lattice points which lie
+                                          inside the frequency bands */
+    std::vector<std::size_t> indices;   /**< the index \f$k\f$ of each of
+                                          the lattice points */
+    Grid edges;                         /**< the band edges */
 };
 
-void generateGrid(std::vector<GridPoint>& grid, std::size_t degree,
+/**
+ * @brief Parameters of the adaptive norm evaluation (see
+ * computeAdaptiveNorm)
+ */
+struct AdaptiveNormOptions
+{
+    std::size_t stride = 4u;    /**< one grid point out of stride (plus the
+                                  band edges) is part of the coarse scan */
+    double threshold = 0.8;     /**< the coarse local maxima of a band which
+                                  are at least threshold times its largest
+                                  coarse value are refined */
+    bool peaks = true;          /**< locate the maxima between the grid
+                                  points */
+    bool certify = false;       /**< also scan the whole grid, so that the
+                                  result is never below the discrete norm */
+};
+
+/*! Generates a uniform discretization of the frequency bands of interest.
+ * Each point is computed from its index inside its band, and the points are
+ * filled in parallel in double precision (MPFR is only used for the band
+ * edges and for the band functions without an analytic description).
+ * The amplitude and weight callbacks of the FUNCTION bands are called
+ * concurrently by several threads, so they have to be thread-safe.
+ * @param[out] grid the computed grid
+ * @param[in] degree the degree of the polynomials that will be evaluated
+ * on the grid
+ * @param[in] freqBands the frequency bands, given inside \f$[0,\pi]\f$
+ * @param[in] density the number of points per \f$\pi/\f$degree interval
+ * @param[in] prec MPFR working precision used to perform the computations
+ */
+void generateGrid(Grid& grid, std::size_t degree,
+    std::vector<Band>& freqBands, std::size_t density = 16u,
+    mp_prec_t prec = 165ul);
+
+/*! Generates a discretization of the frequency bands of interest on a
+ * uniform lattice of \f$[0,\pi]\f$. As with generateGrid, the lattice
+ * points are filled in parallel, and the amplitude and weight callbacks of
+ * the FUNCTION bands have to be thread-safe.
+ * @param[out] grid the computed grid
+ * @param[in] degree the degree of the polynomials that will be evaluated
+ * on the grid
+ * @param[in] freqBands the frequency bands, given inside \f$[0,\pi]\f$
+ * @param[in] density the minimal number of lattice points per
+ * \f$\pi/\f$degree interval (the lattice size is the smallest power of two
+ * above degree \f$\cdot\f$ density)
+ * @param[in] prec MPFR working precision used to perform the computations
+ */
+void generateSpectralGrid(SpectralGrid& grid, std::size_t degree,
     std::vector<Band>& freqBands, std::size_t density = 16u,
     mp_prec_t prec = 165ul);
 
+/*! Computes the discrete norm of the weighted approximation error on a
+ * spectral grid, the polynomial being evaluated at the lattice points with
+ * an FFT of size \f$2M\f$ (i.e. in \f$O(M\log M)\f$ operations instead of
+ * the \f$O(M\cdot\f$degree\f$)\f$ ones of the Clenshaw evaluations)
+ * @param[out] normValue the discrete norm
+ * @param[out] bandNorms the per band discrete norms (in the order of the
+ * CHEBY space bands)
+ * @param[in] grid the spectral discretization of the approximation domain
+ * @param[in] a the Chebyshev coefficients of the polynomial to evaluate
+ * (there must be at most \f$M\f$ of them)
+ */
+void computeSpectralNorm(double& normValue,
+    std::vector<double>& bandNorms, SpectralGrid& grid,
+    std::vector<double>& a);
+
+/*! Batched version of computeSpectralNorm, which scores several
+ * polynomials in parallel
+ * @param[out] normValues the discrete norm of each polynomial
+ * @param[out] bandNorms the per band discrete norms of each polynomial
+ * @param[in] grid the spectral discretization of the approximation domain
+ * @param[in] a the Chebyshev coefficients of the polynomials to evaluate
+ */
+void computeSpectralNorms(std::vector<double>& normValues,
+    std::vector<std::vector<double>>& bandNorms, SpectralGrid& grid,
+    std::vector<std::vector<double>>& a);
 
+/*! Computes the discrete norm of the weighted approximation error on a grid
+ * @param[out] normValue the discrete norm
+ * @param[out] bandNorms the per band discrete norms (in the order of the
+ * CHEBY space bands)
+ * @param[in] grid the discretization of the approximation domain
+ * @param[in] a the Chebyshev coefficients of the polynomial to evaluate
+ */
 void computeDenseNorm(double& normValue,
-    std::vector<double>& bandNorms,
-    std::vector<Band>& chebyBands, std::vector<GridPoint>& grid,
+    std::vector<double>& bandNorms, Grid& grid,
     std::vector<double>& a);
 
+/*! Bounded version of the discrete norm computation, meant for candidate
+ * screening: the evaluation stops as soon as the weighted error at a grid
+ * point exceeds bound.
+ * @param[out] normValue the discrete norm (or an error value above bound)
+ * @param[out] bandNorms the per band discrete norms (only meaningful if the
+ * function returns true)
+ * @param[in] grid the discretization of the approximation domain
+ * @param[in] a the Chebyshev coefficients of the polynomial to evaluate
+ * @param[in] bound the error value above which the evaluation is abandoned
+ * @return true if the whole grid was processed (i.e. normValue <= bound)
+ */
+bool computeDenseNorm(double& normValue,
+    std::vector<double>& bandNorms, Grid& grid,
+    std::vector<double>& a, double bound);
+
+/*! Computes the norm of the weighted approximation error adaptively: the
+ * error is first evaluated on a coarse subset of the grid, then the grid
+ * maximum is searched for around the largest coarse local maxima (by
+ * parabolic interpolation and a local ascent on the grid). When
+ * options.peaks is set, a last parabolic step locates each maximum between
+ * the grid points, the ideal response and the weight being interpolated
+ * linearly in the frequency variable (which is exact for constant and
+ * linear responses). Only a fraction of the grid is evaluated, which makes
+ * it suited for the scoring of candidates.
+ * @param[out] normValue the norm
+ * @param[out] bandNorms the per band norms (in the order of the CHEBY space
+ * bands)
+ * @param[in] grid the discretization of the approximation domain
+ * @param[in] a the Chebyshev coefficients of the polynomial to evaluate
+ * @param[in] options the parameters of the evaluation
+ */
+void computeAdaptiveNorm(double& normValue,
+    std::vector<double>& bandNorms, Grid& grid,
+    std::vector<double>& a, AdaptiveNormOptions const& options);
+
+/*! Bounded version of the adaptive norm computation: the evaluation stops
+ * as soon as an error value above bound is found.
+ * @param[out] normValue the norm (or an error value above bound)
+ * @param[out] bandNorms the per band norms (only meaningful if the function
+ * returns true)
+ * @param[in] grid the discretization of the approximation domain
+ * @param[in] a the Chebyshev coefficients of the polynomial to evaluate
+ * @param[in] options the parameters of the evaluation
+ * @param[in] bound the error value above which the evaluation is abandoned
+ * @return true if the evaluation was completed (i.e. normValue <= bound)
+ */
+bool computeAdaptiveNorm(double& normValue,
+    std::vector<double>& bandNorms, Grid& grid,
+    std::vector<double>& a, AdaptiveNormOptions const& options,
+    double bound);
+
+/*! Computes the weighted error \f$W(x_i)(D(x_i)-p(x_i))\f$ at each point
+ * of a grid
+ * @param[out] error the error values
+ * @param[in] grid the discretization of the approximation domain
+ * @param[in] a the Chebyshev coefficients of \f$p\f$
+ */
+void computeGridError(std::vector<double>& error,
+    Grid& grid, std::vector<double>& a);
+
+/*! Tabulates the weighted values \f$W(x_i)p_k(x_i)\f$ of a set of
+ * polynomials on a grid
+ * @param[out] responses the tabulated values
+ * @param[in] grid the discretization of the approximation domain
+ * @param[in] a the Chebyshev coefficients of the \f$p_k\f$ polynomials
+ */
+void computeGridResponse(GridResponse& responses,
+    Grid& grid, std::vector<std::vector<double>>& a);
+
+/*! Computes the discrete norm of the error
+ * \f$e_i - c_1W(x_i)p_{k_1}(x_i) - c_2W(x_i)p_{k_2}(x_i)\f$
+ * corresponding to the polynomial \f$p + c_1p_{k_1} + c_2p_{k_2}\f$, without
+ * any polynomial evaluations. The computation stops as soon as the error
+ * goes above bound.
+ * @param[out] normValue the discrete norm (or an error value above bound)
+ * @param[in] error the weighted error of \f$p\f$ on the grid (see
+ * computeGridError)
+ * @param[in] responses the tabulated \f$p_k\f$ values (see
+ * computeGridResponse)
+ * @param[in] index1 the index \f$k_1\f$
+ * @param[in] factor1 the factor \f$c_1\f$
+ * @param[in] index2 the index \f$k_2\f$
+ * @param[in] factor2 the factor \f$c_2\f$
+ * @param[in] bound the error value above which the evaluation is abandoned
+ * @return true if the whole grid was processed (i.e. normValue <= bound)
+ */
+bool computeCombinationNorm(double& normValue,
+    std::vector<double>& error, GridResponse& responses,
+    std::size_t index1, double factor1,
+    std::size_t index2, double factor2, double bound);
+
 #endif  // GRID_H
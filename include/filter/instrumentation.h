@@ -0,0 +1,138 @@
+/**
+ * @file instrumentation.h
+ * @brief lightweight timers and counters used to profile the quantization
+ * routines
+ *
+ */
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <string>
+
+/**
+ * @brief The timed phases of the quantization routines.
+ */
+enum class Phase {
+    GRID_BUILD,             /**< construction of the dense grid */
+    BASIS_BUILD,            /**< construction of the lattice basis */
+    REDUCTION,              /**< lattice reduction and closest vector
+                              computations */
+    NEIGHBORHOOD_SEARCH,    /**< vicinity search around the LLL solution */
+    COUNT                   /**< number of phases */
+};
+
+/**
+ * @brief The event counters of the quantization routines.
+ */
+enum class Counter {
+    CANDIDATES,             /**< neighborhood candidates examined */
+    NORM_EVALUATIONS,       /**< full dense grid norm evaluations */
+    SEARCH_NODES,           /**< nodes visited by the branch-and-bound
+                              search */
+    COUNT                   /**< number of counters */
+};
+
+/**
+ * @brief Timings (in ms) and event counts gathered during a computation.
+ */
+struct QuantizationStats
+{
+    double times[(std::size_t)Phase::COUNT];            /**< time spent in
+                                                          each phase */
+    std::size_t counters[(std::size_t)Counter::COUNT];  /**< event counts */
+
+    QuantizationStats();
+    double& time(Phase phase);
+    double time(Phase phase) const;
+    std::size_t& counter(Counter counter);
+    std::size_t counter(Counter counter) const;
+    /*! Adds the timings and counts of another computation to these ones
+     * (useful when aggregating the statistics of a batch of jobs)
+     * @param[in] other the statistics to add
+     */
+    void merge(QuantizationStats const& other);
+};
+
+/**
+ * @brief Receiver for the instrumentation events. The events can be
+ * generated concurrently by several threads, so implementations have to be
+ * thread-safe.
+ */
+class InstrumentationSink
+{
+public:
+    virtual ~InstrumentationSink() {}
+    virtual void phase(Phase phase, double ms) {}
+    virtual void counter(Counter counter, std::size_t value) {}
+    virtual void message(std::string const& text) {}
+};
+
+/**
+ * @brief Sink writing all the events to an output stream (the writes are
+ * serialized).
+ */
+class StreamSink : public InstrumentationSink
+{
+public:
+    StreamSink(std::ostream& out);
+    void phase(Phase phase, double ms);
+    void counter(Counter counter, std::size_t value);
+    void message(std::string const& text);
+private:
+    void write(std::string const& text);
+    std::ostream& out;
+};
+
+/*! Sets the sink receiving the instrumentation events of the library
+ * @param[in] sink the new sink (nullptr, the default, discards all the
+ * events)
+ */
+void setInstrumentationSink(InstrumentationSink* sink);
+
+/*! Returns the current instrumentation sink (or nullptr if none is set) */
+InstrumentationSink* getInstrumentationSink();
+
+/*! Returns the name of a phase */
+const char* phaseName(Phase phase);
+
+/*! Returns the name of a counter */
+const char* counterName(Counter counter);
+
+/*! Accounts for the time spent in a phase
+ * @param[in] stats the statistics to update (can be nullptr)
+ * @param[in] phase the phase
+ * @param[in] ms the duration of the phase
+ */
+void recordPhase(QuantizationStats* stats, Phase phase, double ms);
+
+/*! Accounts for a number of events
+ * @param[in] stats the statistics to update (can be nullptr)
+ * @param[in] counter the event type
+ * @param[in] value the number of events
+ */
+void recordCount(QuantizationStats* stats, Counter counter,
+        std::size_t value = 1u);
+
+/*! Forwards a diagnostic message to the instrumentation sink */
+void recordMessage(std::string const& text);
+
+/**
+ * @brief Measures the lifetime of a scope and accounts for it as a phase.
+ * Nothing is measured if there is neither a statistics object nor a sink.
+ */
+class ScopedTimer
+{
+public:
+    ScopedTimer(QuantizationStats* stats, Phase phase);
+    ~ScopedTimer();
+private:
+    QuantizationStats* stats;
+    Phase phase;
+    bool active;
+    std::chrono::steady_clock::time_point start;
+};
+
+#endif
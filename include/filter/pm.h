@@ -134,6 +134,60 @@ PMOutput exchange(std::vector<mpfr::mpreal>& x,
         int Nmax = 8,
         mp_prec_t prec = 165ul);
 
+/*! Mixed-precision version of the exchange algorithm. Starting from the
+ * reference x, the iterations are first done in double precision until
+ * convergence, until the convergence parameter stops decreasing once it is
+ * small (i.e. the rounding errors of double precision dominate) or until an
+ * iteration fails.
+ * The resulting reference is then polished by the MPFR version of the
+ * exchange algorithm, which simply starts from x if no double precision
+ * iteration succeeded.
+ * @param[in] x the initial reference set
+ * @param[in] chebyBands band information for the filter to which the x reference corresponds to.
+ * The bands are given inside \f$[-1,1]\f$ (i.e. the CHEBY band space)
+ * @param[in] epsT convergence parameter threshold (i.e quantizes the number of significant digits
+ * of the minimax error that are accurate at the end of the final iteration)
+ * @param[in] Nmax the degree used by the CPR method on each subinterval
+ * @param[in] prec MPFR working precision used to perform the computations
+ * @return the same information as exchange (the iteration count includes the
+ * double precision iterations)
+ */
+PMOutput exchangeMixed(std::vector<mpfr::mpreal>& x,
+        std::vector<Band>& chebyBands,
+        mpfr::mpreal epsT = 0.01,
+        int Nmax = 8,
+        mp_prec_t prec = 165ul);
+
+/*! Version of the exchange algorithm which, once the convergence parameter
+ * is below switchQ, obtains the new reference by refining the current one
+ * with a few Newton steps on the derivative of the error (started at the
+ * previous extrema and kept between the neighboring ones), instead of
+ * locating all the extrema of the error with the CPR method on every
+ * subinterval. A full CPR iteration is still done every period iterations,
+ * whenever a Newton refinement fails (i.e. it leaves its interval or does
+ * not converge to a maximum of the absolute error) and to confirm the
+ * convergence of the algorithm.
+ * @param[in] x the initial reference set
+ * @param[in] chebyBands band information for the filter to which the x reference corresponds to.
+ * The bands are given inside \f$[-1,1]\f$ (i.e. the CHEBY band space)
+ * @param[in] epsT convergence parameter threshold (i.e quantizes the number of significant digits
+ * of the minimax error that are accurate at the end of the final iteration)
+ * @param[in] Nmax the degree used by the CPR method on each subinterval
+ * @param[in] switchQ the value of the convergence parameter below which the
+ * Newton refinements are used
+ * @param[in] period the maximal number of consecutive iterations between two
+ * full CPR iterations
+ * @param[in] prec MPFR working precision used to perform the computations
+ * @return the same information as exchange
+ */
+PMOutput exchangeNewton(std::vector<mpfr::mpreal>& x,
+        std::vector<Band>& chebyBands,
+        mpfr::mpreal epsT = 0.01,
+        int Nmax = 8,
+        mpfr::mpreal switchQ = 0.1,
+        std::size_t period = 4u,
+        mp_prec_t prec = 165ul);
+
 /*! Parks-McClellan routine for implementing type I and II FIR filters. This routine uses uniform
  * initialization.
  * @param[in] N \f$N+1\f$ denotes the number of coefficients of the final transfer function. For even n, the
@@ -154,7 +208,8 @@ PMOutput exchange(std::vector<mpfr::mpreal>& x,
  * inside the stopband. More examples, including code on how to use the reference scaling versions <tt>firpmRS</tt>,
  * are provided inside the test files.
  * @code
- * PMOutput output = firpm(200, {0.0, 0.4, 0.5, 1.0}, {1.0, 1.0, 0.0, 0.0}, {1.0, 10.0});
+ * std::vector<mpfr::mpreal> f{0.0, 0.4, 0.5, 1.0}, a{1.0, 1.0, 0.0, 0.0}, w{1.0, 10.0};
+ * PMOutput output = firpm(200, f, a, w);
  * @endcode
  */
 
@@ -242,8 +297,44 @@ PMOutput firpmRS(std::size_t N,
         mp_prec_t prec = 165ul);
 
 
+/**
+ * @brief The specification of a type I or II filter designed by firpmBatch.
+ */
+struct PMSpec
+{
+    std::size_t N;                  /**< \f$N+1\f$ is the number of
+                                      coefficients of the filter */
+    std::vector<mpfr::mpreal> f;    /**< the frequency ranges of the bands */
+    std::vector<mpfr::mpreal> a;    /**< the ideal amplitude at each point
+                                      of f */
+    std::vector<mpfr::mpreal> w;    /**< the weight of each band */
+    mpfr::mpreal epsT = 0.0001;     /**< convergence parameter threshold */
+    std::size_t depth = 0u;         /**< number of reference scaling levels
+                                      (0 means uniform initialization, see
+                                      firpmRS) */
+    int Nmax = 4;                   /**< the degree used by the CPR method on
+                                      each subinterval */
+    mp_prec_t prec = 165ul;         /**< MPFR working precision */
+};
+
+/*! Designs a batch of independent type I and II filters. Each design is a
+ * task of a single pool of threads, and the subinterval solves inside the
+ * designs are tasks of the same pool, so the batch keeps all the threads
+ * busy whether it contains one large design or many small ones.
+ * @param[out] outputs the designed filters, in the order of the
+ * specifications
+ * @param[in] specs the filter specifications
+ * @param[in] threads the number of threads to use (0 means the OpenMP
+ * default)
+ */
+void firpmBatch(std::vector<PMOutput>& outputs,
+        std::vector<PMSpec>const& specs,
+        std::size_t threads = 0u);
+
 /** utility type for storing interval endpoints */
-typedef std::pair<double, double> IntervalD;
+template <typename T>
+using IntervalT = std::pair<T, T>;
+typedef IntervalT<double> IntervalD;
 
 
 /** @enum RootSolver flag representing the
@@ -262,26 +353,65 @@ enum class RootSolver {
  * Utility object which contains useful information about the filter computed by the
  * Parks-McClellan algorithm
  */
-struct PMOutputD
+template <typename T>
+struct PMOutputT
 {
-    std::vector<double> h;    /**< the final filter coefficients*/
-    std::vector<double> x;    /**< the reference set used to
+    std::vector<T> h;    /**< the final filter coefficients*/
+    std::vector<T> x;    /**< the reference set used to
                                       generate the final filter (values are in \f$[-1,1]\f$
                                       and NOT \f$[0,\pi]\f$)*/
     std::size_t iter;               /**< number of iterations that were necessary to achieve
                                       convergence*/
-    double delta;             /**< the final reference error */
-    double Q;                 /**< convergence parameter value */
+    T delta;             /**< the final reference error */
+    T Q;                 /**< convergence parameter value */
 };
 
+/** result of the double precision Parks-McClellan routines */
+typedef PMOutputT<double> PMOutputD;
+/** result of the double-double precision Parks-McClellan routines */
+typedef PMOutputT<dd::ddreal> PMOutputDD;
+
+/**
+ * @brief The specification of a type I or II filter designed by firpmBatch.
+ */
+template <typename T>
+struct PMSpecT
+{
+    std::size_t N;      /**< \f$N+1\f$ is the number of coefficients of the
+                          filter */
+    std::vector<T> f;   /**< the frequency ranges of the bands */
+    std::vector<T> a;   /**< the ideal amplitude at each point of f */
+    std::vector<T> w;   /**< the weight of each band */
+    T epsT = 0.01;      /**< convergence parameter threshold */
+    std::size_t depth = 0u; /**< number of reference scaling levels (0 means
+                              uniform initialization, see firpmRS) */
+    int Nmax = 4;       /**< the degree used by the CPR method on each
+                          subinterval */
+    RootSolver root = RootSolver::UNIFORM;  /**< the initialization strategy
+                                              used at the lowest level of
+                                              reference scaling */
+};
+
+/** specification of a double precision design */
+typedef PMSpecT<double> PMSpecD;
+/** specification of a double-double precision design */
+typedef PMSpecT<dd::ddreal> PMSpecDD;
+
+// The routines below work with native floating-point types and are
+// instantiated for double and dd::ddreal. The double-double versions are
+// considerably faster than the MPFR-based ones, while remaining stable for
+// high degree and/or narrow band specifications where double
+// precision breaks down.
+
 /*! An implementation of the uniform initialization approach for starting the Parks-McClellan
  * algorithm
  * @param[out] omega the initial set of references to be computed
  * @param[in] B the frequency bands of interest (i.e. stopbands and passbands for example)
  */
 
-void initUniformExtremas(std::vector<double>& omega,
-        std::vector<BandD>& B);
+template <typename T>
+void initUniformExtremas(std::vector<T>& omega,
+        std::vector<BandT<T>>& B);
 
 /*! An implementation of the reference scaling approach mentioned in section 4 of the article.
  * @param[out] newX the reference set obtained from scaling the initial set x
@@ -298,10 +428,11 @@ void initUniformExtremas(std::vector<double>& omega,
  * @param[in] freqBands band information for the filter to which the x reference corresponds to.
  * The bands are given inside \f$[0,\pi]\f$ (i.e. the FREQ band space)
  */
-void referenceScaling(std::vector<double>& newX, std::vector<BandD>& newChebyBands,
-        std::vector<BandD>& newFreqBands, std::size_t newXSize,
-        std::vector<double>& x, std::vector<BandD>& chebyBands,
-        std::vector<BandD>& freqBands);
+template <typename T>
+void referenceScaling(std::vector<T>& newX, std::vector<BandT<T>>& newChebyBands,
+        std::vector<BandT<T>>& newFreqBands, std::size_t newXSize,
+        std::vector<T>& x, std::vector<BandT<T>>& chebyBands,
+        std::vector<BandT<T>>& freqBands);
 
 /*! An internal routine which implements the exchange algorithm for designing FIR filters
  * @param[in] x the initial reference set
@@ -352,9 +483,10 @@ void referenceScaling(std::vector<double>& newX, std::vector<BandD>& newChebyBan
  * @endcode
  */
 
-PMOutputD exchange(std::vector<double>& x,
-        std::vector<BandD>& chebyBands,
-        double epsT = 0.01,
+template <typename T>
+PMOutputT<T> exchange(std::vector<T>& x,
+        std::vector<BandT<T>>& chebyBands,
+        T epsT = 0.01,
         int Nmax = 4);
 
 /*! Parks-McClellan routine for implementing type I and II FIR filters. This routine uses uniform
@@ -376,15 +508,20 @@ PMOutputD exchange(std::vector<double>& x,
  * inside the stopband. More examples, including code on how to use the reference scaling versions <tt>firpmRS</tt>,
  * are provided inside the test files.
  * @code
- * PMOutputD output = firpm(200, {0.0, 0.4, 0.5, 1.0}, {1.0, 1.0, 0.0, 0.0}, {1.0, 10.0});
+ * std::vector<double> f{0.0, 0.4, 0.5, 1.0}, a{1.0, 1.0, 0.0, 0.0}, w{1.0, 10.0};
+ * PMOutputD output = firpm(200, f, a, w);
  * @endcode
+ * The band vectors have to be named (or built explicitly): a braced list
+ * could be converted to the vectors of every scalar type, so the call would
+ * be ambiguous.
  */
 
-PMOutputD firpm(std::size_t N,
-        std::vector<double>const& f,
-        std::vector<double>const& a,
-        std::vector<double>const& w,
-        double epsT = 0.01,
+template <typename T>
+PMOutputT<T> firpm(std::size_t N,
+        std::vector<T>const& f,
+        std::vector<T>const& a,
+        std::vector<T>const& w,
+        T epsT = 0.01,
         int Nmax = 4);
 
 
@@ -403,11 +540,12 @@ PMOutputD firpm(std::size_t N,
  * output contains the coefficients corresponding to the transfer function of the final filter
  * (in this case, for types I and II, the values are symmetrical to the middle coefficient(s))*/
 
-PMOutputD firpmRS(std::size_t N,
-        std::vector<double>const& f,
-        std::vector<double>const& a,
-        std::vector<double>const& w,
-        double epsT = 0.01,
+template <typename T>
+PMOutputT<T> firpmRS(std::size_t N,
+        std::vector<T>const& f,
+        std::vector<T>const& a,
+        std::vector<T>const& w,
+        T epsT = 0.01,
         std::size_t depth = 1u,
         int Nmax = 4,
         RootSolver root = RootSolver::UNIFORM);
@@ -427,13 +565,24 @@ PMOutputD firpmRS(std::size_t N,
  * (in this case, for types I and II, the values are symmetrical to the middle coefficient(s))
  */
 
-PMOutputD firpmAFP(std::size_t N,
-        std::vector<double>const& f,
-        std::vector<double>const& a,
-        std::vector<double>const& w,
-        double epsT = 0.01,
+template <typename T>
+PMOutputT<T> firpmAFP(std::size_t N,
+        std::vector<T>const& f,
+        std::vector<T>const& a,
+        std::vector<T>const& w,
+        T epsT = 0.01,
         int Nmax = 4);
 
+/*! Discards the initial references cached by the AFP-based routines
+ * (firpmAFP and firpmRS with RootSolver::AFP). The approximate Fekete
+ * points of a degree and a set of bands are computed once (the WAM and its
+ * pivoted QR factorization dominate the initialization cost for large
+ * degrees) and reused by the subsequent designs with the same band edges
+ * and weights, for as long as they are among the most recently computed
+ * ones.
+ */
+void clearAFPCache();
+
 
 /*! Parks-McClellan routine for implementing type III and IV FIR filters. This routine uses uniform
  * initialization.
@@ -450,12 +599,13 @@ PMOutputD firpmAFP(std::size_t N,
  * output contains the coefficients corresponding to the transfer function of the final filter
  * (in this case, for types III and IV, the values are antisymmetrical to the middle coefficient(s))*/
 
-PMOutputD firpm(std::size_t N,
-        std::vector<double>const& f,
-        std::vector<double>const& a,
-        std::vector<double>const& w,
+template <typename T>
+PMOutputT<T> firpm(std::size_t N,
+        std::vector<T>const& f,
+        std::vector<T>const& a,
+        std::vector<T>const& w,
         ftype type,
-        double epsT = 0.01,
+        T epsT = 0.01,
         int Nmax = 4);
 
 /*! Parks-McClellan routine for implementing type III and IV FIR filters. This routine uses reference scaling.
@@ -473,12 +623,13 @@ PMOutputD firpm(std::size_t N,
  * @return information pertaining to the polynomial computed at the last iteration. The h vector of the
  * output contains the coefficients corresponding to the transfer function of the final filter
  * (in this case, for types III and IV, the values are antisymmetrical to the middle coefficient(s))*/
-PMOutputD firpmRS(std::size_t N,
-        std::vector<double>const& f,
-        std::vector<double>const& a,
-        std::vector<double>const& w,
+template <typename T>
+PMOutputT<T> firpmRS(std::size_t N,
+        std::vector<T>const& f,
+        std::vector<T>const& a,
+        std::vector<T>const& w,
         ftype type,
-        double epsT = 0.01,
+        T epsT = 0.01,
         std::size_t depth = 1u,
         int Nmax = 4,
         RootSolver root = RootSolver::UNIFORM
@@ -499,14 +650,110 @@ PMOutputD firpmRS(std::size_t N,
  * output contains the coefficients corresponding to the transfer function of the final filter
  * (in this case, for types III and IV, the values are antisymmetrical to the middle coefficient(s))*/
 
-PMOutputD firpmAFP(std::size_t N,
-        std::vector<double>const& f,
-        std::vector<double>const& a,
-        std::vector<double>const& w,
+template <typename T>
+PMOutputT<T> firpmAFP(std::size_t N,
+        std::vector<T>const& f,
+        std::vector<T>const& a,
+        std::vector<T>const& w,
         ftype type,
-        double epsT = 0.01,
+        T epsT = 0.01,
         int Nmax = 4);
 
+/*! Non-template double and double-double versions of the routines above,
+ * which forward to the templates. Unlike the templates, they accept
+ * arguments that have to be converted to the scalar type (e.g. a double
+ * epsT with dd::ddreal bands).
+ */
+PMOutputD firpm(std::size_t N, std::vector<double>const& f,
+        std::vector<double>const& a, std::vector<double>const& w,
+        double epsT = 0.01, int Nmax = 4);
+PMOutputD firpmRS(std::size_t N, std::vector<double>const& f,
+        std::vector<double>const& a, std::vector<double>const& w,
+        double epsT = 0.01, std::size_t depth = 1u, int Nmax = 4,
+        RootSolver root = RootSolver::UNIFORM);
+PMOutputD firpmAFP(std::size_t N, std::vector<double>const& f,
+        std::vector<double>const& a, std::vector<double>const& w,
+        double epsT = 0.01, int Nmax = 4);
+PMOutputD firpm(std::size_t N, std::vector<double>const& f,
+        std::vector<double>const& a, std::vector<double>const& w,
+        ftype type, double epsT = 0.01, int Nmax = 4);
+PMOutputD firpmRS(std::size_t N, std::vector<double>const& f,
+        std::vector<double>const& a, std::vector<double>const& w,
+        ftype type, double epsT = 0.01, std::size_t depth = 1u,
+        int Nmax = 4, RootSolver root = RootSolver::UNIFORM);
+PMOutputD firpmAFP(std::size_t N, std::vector<double>const& f,
+        std::vector<double>const& a, std::vector<double>const& w,
+        ftype type, double epsT = 0.01, int Nmax = 4);
+
+PMOutputDD firpm(std::size_t N, std::vector<dd::ddreal>const& f,
+        std::vector<dd::ddreal>const& a, std::vector<dd::ddreal>const& w,
+        dd::ddreal epsT = 0.01, int Nmax = 4);
+PMOutputDD firpmRS(std::size_t N, std::vector<dd::ddreal>const& f,
+        std::vector<dd::ddreal>const& a, std::vector<dd::ddreal>const& w,
+        dd::ddreal epsT = 0.01, std::size_t depth = 1u, int Nmax = 4,
+        RootSolver root = RootSolver::UNIFORM);
+PMOutputDD firpmAFP(std::size_t N, std::vector<dd::ddreal>const& f,
+        std::vector<dd::ddreal>const& a, std::vector<dd::ddreal>const& w,
+        dd::ddreal epsT = 0.01, int Nmax = 4);
+PMOutputDD firpm(std::size_t N, std::vector<dd::ddreal>const& f,
+        std::vector<dd::ddreal>const& a, std::vector<dd::ddreal>const& w,
+        ftype type, dd::ddreal epsT = 0.01, int Nmax = 4);
+PMOutputDD firpmRS(std::size_t N, std::vector<dd::ddreal>const& f,
+        std::vector<dd::ddreal>const& a, std::vector<dd::ddreal>const& w,
+        ftype type, dd::ddreal epsT = 0.01, std::size_t depth = 1u,
+        int Nmax = 4, RootSolver root = RootSolver::UNIFORM);
+PMOutputDD firpmAFP(std::size_t N, std::vector<dd::ddreal>const& f,
+        std::vector<dd::ddreal>const& a, std::vector<dd::ddreal>const& w,
+        ftype type, dd::ddreal epsT = 0.01, int Nmax = 4);
+
+/*! Searches for the minimum order type I filter whose minimax error is at
+ * most a given target. The degree is first bracketed (by doubling or halving
+ * it) and then determined by bisection. Apart from the first design, each
+ * design is started from the reference of a design computed before, which
+ * usually takes only a few iterations: the doubling steps use reference
+ * scaling from the previous degree, while the halving steps and the
+ * bisection steps resample the reference of the previous degree,
+ * respectively of the nearest end of the bracket (which may be the larger
+ * one). A design whose warm started exchange does not converge is computed
+ * again from the uniform initialization.
+ * @param[in] f vector denoting the frequency ranges of each band of interest
+ * @param[in] a the ideal amplitude at each point of f
+ * @param[in] w the wight function value on each band
+ * @param[in] targetDelta the largest acceptable (weighted) minimax error
+ * @param[in] nStart the order from which the search starts
+ * @param[in] nMax the largest order to consider
+ * @param[in] epsT convergence parameter threshold (i.e quantizes the number of significant digits
+ * of the minimax error that are accurate at the end of the final iteration)
+ * @param[in] Nmax the degree used by the CPR method on each subinterval
+ * @return information pertaining to the filter of minimum order (its order is the size of h minus
+ * one). If the target cannot be met, the filter of order nMax is returned (and its delta is larger
+ * than targetDelta)
+ */
+
+template <typename T>
+PMOutputT<T> firpmMinOrder(std::vector<T>const& f,
+        std::vector<T>const& a,
+        std::vector<T>const& w,
+        T targetDelta,
+        std::size_t nStart = 32u,
+        std::size_t nMax = 2000u,
+        T epsT = 0.01,
+        int Nmax = 4);
+
+/*! Designs a batch of independent type I and II filters. Each design is a
+ * task of a single pool of threads, and the subinterval solves inside the
+ * designs are tasks of the same pool.
+ * @param[out] outputs the designed filters, in the order of the
+ * specifications
+ * @param[in] specs the filter specifications
+ * @param[in] threads the number of threads to use (0 means the OpenMP
+ * default)
+ */
+template <typename T>
+void firpmBatch(std::vector<PMOutputT<T>>& outputs,
+        std::vector<PMSpecT<T>>const& specs,
+        std::size_t threads = 0u);
+
 
 
 #endif
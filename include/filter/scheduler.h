@@ -0,0 +1,62 @@
+/**
+ * @file scheduler.h
+ * @brief Task-based execution of independent designs and of the
+ * subinterval work inside each of them
+ *
+ * All the parallel work of the library goes through the OpenMP task
+ * scheduler. A batch of designs is run as one task per design on a team
+ * of threads, and the loops over subintervals inside a design are split
+ * into tasks of the same team (instead of opening a nested parallel
+ * region). Idle threads therefore pick up subinterval solves of the large
+ * designs once the small ones are done, and the machine is never
+ * oversubscribed.
+ */
+
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+#include <cstddef>
+#include <functional>
+#include <omp.h>
+
+/*! Runs task(0), ..., task(count - 1) as OpenMP tasks and waits for all
+ * of them to complete
+ * @param[in] count the number of tasks
+ * @param[in] task the work to perform for a given index
+ * @param[in] threads the number of threads of the team executing the
+ * tasks (0 means the OpenMP default, i.e. omp_get_max_threads())
+ *
+ * When called from inside a parallel region, the tasks are added to the
+ * current team and the threads parameter is ignored.
+ */
+void runTasks(std::size_t count,
+        std::function<void(std::size_t)> const& task,
+        std::size_t threads = 0u);
+
+/*! Executes body(0), ..., body(count - 1) in parallel and returns once all
+ * the calls are done. Outside of any parallel region a team of threads is
+ * started (with dynamic scheduling), otherwise the iterations become tasks
+ * of the enclosing team, so that the routines used from runTasks share its
+ * threads. Since the iterations can be executed by any thread of the team,
+ * the body has to set up its own per-thread state (MPFR precision,
+ * workspaces).
+ * @param[in] count the number of iterations
+ * @param[in] body the work to perform for a given iteration
+ * @param[in] grain the number of consecutive iterations handled by a
+ * task (larger values amortize the scheduling of very cheap iterations)
+ */
+template <typename Body>
+void parallelTasks(std::size_t count, Body body, std::size_t grain = 1u)
+{
+    if (omp_get_level() > 0) {
+        #pragma omp taskloop grainsize(grain)
+        for (std::size_t i = 0u; i < count; ++i)
+            body(i);
+    } else {
+        #pragma omp parallel for schedule(dynamic, grain)
+        for (std::size_t i = 0u; i < count; ++i)
+            body(i);
+    }
+}
+
+#endif /* SCHEDULER_H_ */
@@ -11,6 +11,8 @@
 #define UTIL_H_
 
 #include "../mpreal.h"
+#include "ddreal.h"
+#include "workspace.h"
 #include <algorithm>
 #include <climits>
 #include <cmath>
@@ -26,4 +28,13 @@
 #include <utility>
 #include <vector>
 
+/*! The value of \f$\pi\f$ in the precision of the scalar type T */
+template <typename T> T constPi();
+
+template <> inline double constPi<double>() { return M_PI; }
+
+template <> inline dd::ddreal constPi<dd::ddreal>() {
+  return dd::ddreal::pi();
+}
+
 #endif /* UTIL_H_ */
@@ -0,0 +1,57 @@
+/**
+ * @file workspace.h
+ * @brief Scratch storage and precision handling for the MPFR routines
+ * which are called in the inner loops of the exchange algorithm
+ *
+ */
+
+#ifndef WORKSPACE_H_
+#define WORKSPACE_H_
+
+#include "../mpreal.h"
+
+/**
+ * @brief Sets the default MPFR precision for the lifetime of a scope and
+ * restores the previous one when the scope is exited (including on early
+ * returns).
+ *
+ * The default precision is local to each thread (MPFR has to be built
+ * with thread-local storage, see mpfr_buildopt_tls_p), so a guard only
+ * affects the calling thread and the library routines can be called
+ * concurrently. Parallel regions which create MPFR temporaries therefore
+ * set the precision again in each of their worker threads.
+ */
+class ScopedPrecision
+{
+public:
+    explicit ScopedPrecision(mp_prec_t prec);
+    ~ScopedPrecision();
+    ScopedPrecision(ScopedPrecision const&) = delete;
+    ScopedPrecision& operator=(ScopedPrecision const&) = delete;
+private:
+    mp_prec_t prevPrec;
+};
+
+/**
+ * @brief Preinitialized MPFR variables used as temporaries by the
+ * barycentric and Clenshaw evaluation routines. Reusing them across calls
+ * avoids an allocation for every temporary of every call, and the routines
+ * taking a workspace compute in its precision without changing the default
+ * precision. A workspace must not be shared by several threads.
+ */
+struct MPWorkspace
+{
+    mp_prec_t prec;         /**< precision of the scratch variables */
+    mpfr::mpreal num;       /**< numerator of the barycentric formula */
+    mpfr::mpreal denom;     /**< denominator of the barycentric formula */
+    mpfr::mpreal buff;      /**< general purpose buffer */
+    mpfr::mpreal D;         /**< ideal response buffer */
+    mpfr::mpreal W;         /**< weight function buffer */
+    mpfr::mpreal bn;        /**< Clenshaw recurrence terms */
+    mpfr::mpreal bn1;
+    mpfr::mpreal bn2;
+
+    explicit MPWorkspace(mp_prec_t prec = 165ul);
+};
+
+#endif /* WORKSPACE_H_ */
@@ -1,4 +1,158 @@
 #include "filter/afp.h"
+#include "filter/scheduler.h"
+
+// sets the MPFR precision of the threads executing the tasks of
+// pivotedQRSelection (nothing to do for the native types)
+template <typename T> struct TaskPrecision {
+  static mp_prec_t current() { return 0u; }
+  explicit TaskPrecision(mp_prec_t) {}
+};
+
+template <> struct TaskPrecision<mpfr::mpreal> {
+  static mp_prec_t current() { return mpfr::mpreal::get_default_prec(); }
+  explicit TaskPrecision(mp_prec_t prec) : guard(prec) {}
+  ScopedPrecision guard;
+};
+
+template <typename T>
+void pivotedQRSelection(
+    std::vector<std::size_t> &pivots,
+    Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> const &A,
+    std::size_t blockSize) {
+  using std::abs;
+  using std::sqrt;
+  typedef Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> Matrix;
+  std::size_t m = A.rows();
+  std::size_t n = A.cols();
+  std::size_t steps = std::min(m, n);
+  pivots.clear();
+  if (steps == 0u)
+    return;
+  if (blockSize == 0u)
+    blockSize = 1u;
+
+  Matrix R = A;
+  std::vector<std::size_t> perm(n);
+  std::vector<T> norms(n), refNorms(n);
+  for (std::size_t j = 0u; j < n; ++j) {
+    perm[j] = j;
+    norms[j] = refNorms[j] = R.col(j).norm();
+  }
+  // the columns whose norm is below rankTol are considered to be zero, and
+  // the norm of a column is recomputed when its downdate loses more than
+  // half of the significant digits
+  T eps = std::numeric_limits<T>::epsilon();
+  T recomputeTol = sqrt(eps);
+  T rankTol = eps * T(double(steps)) *
+              *std::max_element(norms.begin(), norms.end());
+
+  // the reflectors of a block are stored in V (zero above the diagonal,
+  // with unit diagonal) and, as long as they are not applied to the
+  // trailing columns, the current value of the matrix is R - V * F^T
+  mp_prec_t prec = TaskPrecision<T>::current();
+  std::size_t grain = std::max<std::size_t>(1u, 4096u / m);
+  Matrix V, F;
+  std::vector<T> z;
+  for (std::size_t k0 = 0u; k0 < steps; k0 += blockSize) {
+    std::size_t b = std::min(blockSize, steps - k0);
+    V.setZero(m, b);
+    F.setZero(n, b);
+    for (std::size_t jj = 0u; jj < b; ++jj) {
+      std::size_t c = k0 + jj;
+      std::size_t p = c;
+      for (std::size_t j = c + 1u; j < n; ++j)
+        if (norms[j] > norms[p])
+          p = j;
+      if (!(norms[p] > rankTol))
+        return;
+      if (p != c) {
+        R.col(c).swap(R.col(p));
+        F.row(c).swap(F.row(p));
+        std::swap(norms[c], norms[p]);
+        std::swap(refNorms[c], refNorms[p]);
+        std::swap(perm[c], perm[p]);
+      }
+      pivots.push_back(perm[c]);
+      if (c + 1u == steps)
+        return;
+
+      // bring the pivot column up to date and compute its reflector
+      R.col(c).tail(m - c).noalias() -=
+          V.block(c, 0, m - c, jj) * F.row(c).head(jj).transpose();
+      T alpha = R(c, c);
+      T sigma = R.col(c).tail(m - c).norm();
+      T beta = (alpha < 0) ? sigma : T(-sigma);
+      T tau = (beta - alpha) / beta;
+      V(c, jj) = 1;
+      V.col(jj).tail(m - c - 1u) = R.col(c).tail(m - c - 1u) / (alpha - beta);
+      R(c, c) = beta;
+
+      // F(j, jj) = tau * v^T (R - V F^T)(:, j) for the remaining columns
+      z.assign(jj, T(0));
+      for (std::size_t l = 0u; l < jj; ++l)
+        z[l] = V.col(l).tail(m - c).dot(V.col(jj).tail(m - c));
+      parallelTasks(n - c - 1u, [&](std::size_t i) {
+        TaskPrecision<T> guard(prec);
+        std::size_t j = c + 1u + i;
+        T value = V.col(jj).tail(m - c).dot(R.col(j).tail(m - c));
+        for (std::size_t l = 0u; l < jj; ++l)
+          value -= F(j, l) * z[l];
+        F(j, jj) = tau * value;
+        // row c of the column is now final
+        T rcj = R(c, j);
+        for (std::size_t l = 0u; l <= jj; ++l)
+          rcj -= V(c, l) * F(j, l);
+        R(c, j) = rcj;
+        // downdate the norm of the rest of the column, recomputing it when
+        // cancellation makes the downdate inaccurate
+        if (norms[j] != 0) {
+          T ratio = abs(rcj) / norms[j];
+          T remainder = (1 - ratio) * (1 + ratio);
+          if (remainder < 0)
+            remainder = 0;
+          T scaled = norms[j] / refNorms[j];
+          if (remainder * scaled * scaled <= recomputeTol) {
+            T sum = 0;
+            for (std::size_t r = c + 1u; r < m; ++r) {
+              T value = R(r, j);
+              for (std::size_t l = 0u; l <= jj; ++l)
+                value -= V(r, l) * F(j, l);
+              sum += value * value;
+            }
+            norms[j] = refNorms[j] = sqrt(sum);
+          } else {
+            norms[j] *= sqrt(remainder);
+          }
+        }
+      }, grain);
+    }
+    // apply the block of reflectors to the trailing submatrix
+    std::size_t r0 = k0 + b;
+    if (r0 < m && r0 < n) {
+      std::size_t cols = n - r0;
+      std::size_t chunks = (cols + 63u) / 64u;
+      parallelTasks(chunks, [&](std::size_t i) {
+        TaskPrecision<T> guard(prec);
+        std::size_t j0 = r0 + 64u * i;
+        std::size_t w = std::min<std::size_t>(64u, n - j0);
+        R.block(r0, j0, m - r0, w).noalias() -=
+            V.bottomRows(m - r0) * F.block(j0, 0, w, b).transpose();
+      });
+    }
+  }
+}
+
+template void pivotedQRSelection<double>(
+    std::vector<std::size_t> &,
+    Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic> const &, std::size_t);
+template void pivotedQRSelection<dd::ddreal>(
+    std::vector<std::size_t> &,
+    Eigen::Matrix<dd::ddreal, Eigen::Dynamic, Eigen::Dynamic> const &,
+    std::size_t);
+template void pivotedQRSelection<mpfr::mpreal>(
+    std::vector<std::size_t> &,
+    Eigen::Matrix<mpfr::mpreal, Eigen::Dynamic, Eigen::Dynamic> const &,
+    std::size_t);
 
 void generateAFPMatrix(
     MatrixXq &A, std::size_t degree, std::vector<mpfr::mpreal> &meshPoints,
@@ -19,13 +173,11 @@ void generateAFPMatrix(
 // approximate Fekete points
 void AFP(std::vector<mpfr::mpreal> &points, MatrixXq &A,
          std::vector<mpfr::mpreal> &meshPoints) {
-  VectorXq b = VectorXq::Ones(A.rows());
-  b(1) = 2;
-  VectorXq y = A.colPivHouseholderQr().solve(b);
+  std::vector<std::size_t> pivots;
+  pivotedQRSelection(pivots, A);
 
-  for (std::size_t i = 0u; i < y.rows(); ++i)
-    if (y(i) != 0.0)
-      points.push_back(meshPoints[i]);
+  for (auto &it : pivots)
+    points.push_back(meshPoints[it]);
   std::sort(points.begin(), points.end(),
             [](const mpfr::mpreal &lhs, const mpfr::mpreal &rhs) {
               return lhs < rhs;
@@ -37,8 +189,7 @@ void generateVandermondeMatrix(
     std::function<mpfr::mpreal(mpfr::mpreal)> &weightFunction,
     std::size_t degree, mp_prec_t prec) {
   using mpfr::mpreal;
-  mp_prec_t prevPrec = mpreal::get_default_prec();
-  mpreal::set_default_prec(prec);
+  ScopedPrecision guard(prec);
 
   for (std::size_t i = 0u; i < grid.size(); ++i) {
     Vm(i, 0) = 1.0;
@@ -51,22 +202,17 @@ void generateVandermondeMatrix(
   for (std::size_t j = 0u; j <= degree; ++j)
     for (std::size_t i = 0u; i < grid.size(); ++i)
       Vm(i, j) *= weightFunction(grid[i]);
-
-  mpreal::set_default_prec(prevPrec);
 }
 
 void linspace(std::vector<mpfr::mpreal> &points, mpfr::mpreal &a,
               mpfr::mpreal &b, std::size_t N, mp_prec_t prec) {
   using mpfr::mpreal;
-  mp_prec_t prevPrec = mpreal::get_default_prec();
-  mpreal::set_default_prec(prec);
+  ScopedPrecision guard(prec);
   mpfr::mpreal step = (b - a) / (N - 1u);
   points.push_back(a);
   for (std::size_t i = 1u; i <= N - 2u; ++i)
     points.push_back(a + step * i);
   points.push_back(b);
-
-  mpreal::set_default_prec(prevPrec);
 }
 
 void bandCount(std::vector<Band> &chebyBands, std::vector<mpfr::mpreal> &x) {
@@ -120,13 +266,11 @@ void generateAFPMatrix(
 // approximate Fekete points
 void AFP(std::vector<double> &points, MatrixXd &A,
          std::vector<double> &meshPoints) {
-  VectorXd b = VectorXd::Ones(A.rows());
-  b(1) = 2;
-  VectorXd y = A.colPivHouseholderQr().solve(b);
+  std::vector<std::size_t> pivots;
+  pivotedQRSelection(pivots, A);
 
-  for (std::size_t i = 0u; i < y.rows(); ++i)
-    if (y(i) != 0.0)
-      points.push_back(meshPoints[i]);
+  for (auto &it : pivots)
+    points.push_back(meshPoints[it]);
   std::sort(points.begin(), points.end(),
             [](const double &lhs, const double &rhs) {
               return lhs < rhs;
@@ -1,16 +1,53 @@
 #include "filter/band.h"
 
+void evaluateResponse(mpfr::mpreal &value, ResponseModel const &model,
+                      BandSpace space, mpfr::mpreal const &x) {
+  if (model.type == CONSTANT) {
+    value = model.coeffs[0];
+    return;
+  }
+  mpfr::mpreal omega = (space == BandSpace::CHEBY) ? mpfr::acos(x, MPFR_RNDN) : x;
+  std::vector<mpfr::mpreal> const &c = model.coeffs;
+  if (model.type == LINEAR) {
+    value = ((omega - c[0]) * c[3] - (omega - c[1]) * c[2]) / (c[1] - c[0]);
+  } else {
+    value = c.back();
+    for (std::size_t k = c.size() - 1u; k-- > 0u;)
+      value = value * omega + c[k];
+  }
+}
+
+void setAmplitude(Band &band, ResponseModel const &model) {
+  band.amplitudeModel = model;
+  band.amplitude = [model](BandSpace space,
+                           mpfr::mpreal x) -> mpfr::mpreal {
+    mpfr::mpreal value;
+    evaluateResponse(value, model, space, x);
+    return value;
+  };
+}
+
+void setWeight(Band &band, ResponseModel const &model) {
+  band.weightModel = model;
+  band.weight = [model](BandSpace space, mpfr::mpreal x) -> mpfr::mpreal {
+    mpfr::mpreal value;
+    evaluateResponse(value, model, space, x);
+    return value;
+  };
+}
+
 void bandConversion(std::vector<Band> &out, std::vector<Band> &in,
                     ConversionDirection direction, mp_prec_t prec) {
   using mpfr::mpreal;
-  mp_prec_t prevPrec = mpreal::get_default_prec();
-  mpreal::set_default_prec(prec);
+  ScopedPrecision guard(prec);
 
   out.resize(in.size());
   int n = in.size() - 1;
   for (std::size_t i = 0u; i < in.size(); ++i) {
     out[i].weight = in[n - i].weight;
     out[i].amplitude = in[n - i].amplitude;
+    out[i].weightModel = in[n - i].weightModel;
+    out[i].amplitudeModel = in[n - i].amplitudeModel;
     out[i].extremas = in[n - i].extremas;
     if (direction == ConversionDirection::FROMFREQ) {
       out[i].start = mpfr::cos(in[n - i].stop);
@@ -22,11 +59,10 @@ void bandConversion(std::vector<Band> &out, std::vector<Band> &in,
       out[i].space = BandSpace::FREQ;
     }
   }
-
-  mpreal::set_default_prec(prevPrec);
 }
 
-void bandConversion(std::vector<BandD> &out, std::vector<BandD> &in,
+template <typename T>
+void bandConversion(std::vector<BandT<T>> &out, std::vector<BandT<T>> &in,
                     ConversionDirection direction) {
     out.resize(in.size());
     int n = in.size() - 1;
@@ -34,6 +70,8 @@ void bandConversion(std::vector<BandD> &out, std::vector<BandD> &in,
     {
         out[i].weight    = in[n - i].weight;
         out[i].amplitude = in[n - i].amplitude;
+        out[i].weightModel    = in[n - i].weightModel;
+        out[i].amplitudeModel = in[n - i].amplitudeModel;
         out[i].extremas  = in[n - i].extremas;
         if (direction == ConversionDirection::FROMFREQ)
         {
@@ -47,3 +85,9 @@ void bandConversion(std::vector<BandD> &out, std::vector<BandD> &in,
         }
     }
 }
+
+template void bandConversion<double>(std::vector<BandD> &, std::vector<BandD> &,
+                                     ConversionDirection);
+template void bandConversion<dd::ddreal>(std::vector<BandDD> &,
+                                         std::vector<BandDD> &,
+                                         ConversionDirection);
@@ -3,8 +3,7 @@
 void barycentricWeights(std::vector<mpfr::mpreal> &w,
                         std::vector<mpfr::mpreal> &x, mp_prec_t prec) {
   using mpfr::mpreal;
-  mp_prec_t prevPrec = mpreal::get_default_prec();
-  mpreal::set_default_prec(prec);
+  ScopedPrecision guard(prec);
 
   std::size_t step = (x.size() - 2) / 15 + 1;
   mpreal one = 1u;
@@ -18,28 +17,33 @@ void barycentricWeights(std::vector<mpfr::mpreal> &w,
     }
     w[i] = one / denom;
   }
-
-  mpreal::set_default_prec(prevPrec);
 }
 
 void computeIdealResponseAndWeight(mpfr::mpreal &D, mpfr::mpreal &W,
                                    const mpfr::mpreal &xVal,
                                    std::vector<Band> &bands) {
-  for (auto &it : bands) {
-    if (xVal >= it.start && xVal <= it.stop) {
-
-      D = it.amplitude(it.space, xVal);
-      W = it.weight(it.space, xVal);
-      return;
-    }
-  }
+  // the bands are sorted, so the one containing xVal (if any) is the first
+  // band ending at or after it
+  auto it = std::lower_bound(
+      bands.begin(), bands.end(), xVal,
+      [](Band const &band, mpfr::mpreal const &x) { return band.stop < x; });
+  if (it == bands.end() || xVal < it->start)
+    return;
+
+  if (it->amplitudeModel.type != FUNCTION)
+    evaluateResponse(D, it->amplitudeModel, it->space, xVal);
+  else
+    D = it->amplitude(it->space, xVal);
+  if (it->weightModel.type != FUNCTION)
+    evaluateResponse(W, it->weightModel, it->space, xVal);
+  else
+    W = it->weight(it->space, xVal);
 }
 
 void computeDelta(mpfr::mpreal &delta, std::vector<mpfr::mpreal> &x,
                   std::vector<Band> &bands, mp_prec_t prec) {
   using mpfr::mpreal;
-  mp_prec_t prevPrec = mpreal::get_default_prec();
-  mpreal::set_default_prec(prec);
+  ScopedPrecision guard(prec);
 
   std::vector<mpfr::mpreal> w(x.size());
   barycentricWeights(w, x);
@@ -57,16 +61,13 @@ void computeDelta(mpfr::mpreal &delta, std::vector<mpfr::mpreal> &x,
   }
 
   delta = num / denom;
-
-  mpreal::set_default_prec(prevPrec);
 }
 
 void computeDelta(mpfr::mpreal &delta, std::vector<mpfr::mpreal> &w,
                   std::vector<mpfr::mpreal> &x, std::vector<Band> &bands,
                   mp_prec_t prec) {
   using mpfr::mpreal;
-  mp_prec_t prevPrec = mpreal::get_default_prec();
-  mpreal::set_default_prec(prec);
+  ScopedPrecision guard(prec);
 
   mpfr::mpreal num, denom, D, W, buffer;
   num = denom = D = W = 0;
@@ -80,15 +81,13 @@ void computeDelta(mpfr::mpreal &delta, std::vector<mpfr::mpreal> &w,
     denom += buffer;
   }
   delta = num / denom;
-  mpreal::set_default_prec(prevPrec);
 }
 
 void computeC(std::vector<mpfr::mpreal> &C, mpfr::mpreal &delta,
               std::vector<mpfr::mpreal> &omega, std::vector<Band> &bands,
               mp_prec_t prec) {
   using mpfr::mpreal;
-  mp_prec_t prevPrec = mpreal::get_default_prec();
-  mpreal::set_default_prec(prec);
+  ScopedPrecision guard(prec);
 
   mpfr::mpreal D, W;
   D = W = 0;
@@ -98,92 +97,132 @@ void computeC(std::vector<mpfr::mpreal> &C, mpfr::mpreal &delta,
       W = -W;
     C[i] = D + (delta / W);
   }
-  mpreal::set_default_prec(prevPrec);
 }
 
-void computeApprox(mpfr::mpreal &Pc, const mpfr::mpreal &omega,
+void computeApprox(mpfr::mpreal &Pc, const mpfr::mpreal &xVal,
                    std::vector<mpfr::mpreal> &x, std::vector<mpfr::mpreal> &C,
-                   std::vector<mpfr::mpreal> &w, mp_prec_t prec) {
+                   std::vector<mpfr::mpreal> &w, MPWorkspace &ws) {
   using mpfr::mpreal;
-  mp_prec_t prevPrec = mpreal::get_default_prec();
-  mpreal::set_default_prec(prec);
-
-  mpfr::mpreal num, denom;
-  mpfr::mpreal buff;
-  num = denom = 0;
-
-  Pc = omega;
-  std::size_t r = x.size();
-  for (std::size_t i = 0u; i < r; ++i) {
-    if (Pc == x[i]) {
+  mp_rnd_t rnd = mpreal::get_default_rnd();
+  ws.num = 0;
+  ws.denom = 0;
+  for (std::size_t i = 0u; i < x.size(); ++i) {
+    if (xVal == x[i]) {
       Pc = C[i];
-      mpreal::set_default_prec(prevPrec);
       return;
     }
-    buff = w[i] / (Pc - x[i]);
-    num = fma(buff, C[i], num);
-    denom += buff;
+    // buff = w[i] / (xVal - x[i]), computed in place
+    mpfr_sub(ws.buff.mpfr_ptr(), xVal.mpfr_srcptr(), x[i].mpfr_srcptr(), rnd);
+    mpfr_div(ws.buff.mpfr_ptr(), w[i].mpfr_srcptr(), ws.buff.mpfr_srcptr(),
+             rnd);
+    mpfr_fma(ws.num.mpfr_ptr(), ws.buff.mpfr_srcptr(), C[i].mpfr_srcptr(),
+             ws.num.mpfr_srcptr(), rnd);
+    ws.denom += ws.buff;
   }
-  Pc = num / denom;
-  mpreal::set_default_prec(prevPrec);
+  mpfr_div(ws.buff.mpfr_ptr(), ws.num.mpfr_srcptr(), ws.denom.mpfr_srcptr(),
+           rnd);
+  Pc = ws.buff;
+}
+
+void computeApprox(mpfr::mpreal &Pc, const mpfr::mpreal &omega,
+                   std::vector<mpfr::mpreal> &x, std::vector<mpfr::mpreal> &C,
+                   std::vector<mpfr::mpreal> &w, mp_prec_t prec) {
+  MPWorkspace ws(prec);
+  computeApprox(Pc, omega, x, C, w, ws);
 }
 
 void computeError(mpfr::mpreal &error, const mpfr::mpreal &xVal,
                   mpfr::mpreal &delta, std::vector<mpfr::mpreal> &x,
                   std::vector<mpfr::mpreal> &C, std::vector<mpfr::mpreal> &w,
-                  std::vector<Band> &bands, mp_prec_t prec) {
-  using mpfr::mpreal;
-  mp_prec_t prevPrec = mpreal::get_default_prec();
-  mpreal::set_default_prec(prec);
-
+                  std::vector<Band> &bands, MPWorkspace &ws) {
   for (std::size_t i = 0u; i < x.size(); ++i) {
     if (xVal == x[i]) {
       if (i % 2 == 0)
         error = delta;
       else
         error = -delta;
-      mpreal::set_default_prec(prevPrec);
       return;
     }
   }
 
-  mpfr::mpreal D, W;
-  D = W = 0;
-  computeIdealResponseAndWeight(D, W, xVal, bands);
-  computeApprox(error, xVal, x, C, w);
-  error -= D;
-  error *= W;
-  mpreal::set_default_prec(prevPrec);
+  ws.D = ws.W = 0;
+  computeIdealResponseAndWeight(ws.D, ws.W, xVal, bands);
+  computeApprox(error, xVal, x, C, w, ws);
+  error -= ws.D;
+  error *= ws.W;
 }
 
-void barycentricWeights(std::vector<double>& w,
-        std::vector<double>& x)
+void computeError(mpfr::mpreal &error, const mpfr::mpreal &xVal,
+                  mpfr::mpreal &delta, std::vector<mpfr::mpreal> &x,
+                  std::vector<mpfr::mpreal> &C, std::vector<mpfr::mpreal> &w,
+                  std::vector<Band> &bands, mp_prec_t prec) {
+  ScopedPrecision guard(prec);
+  MPWorkspace ws(prec);
+  computeError(error, xVal, delta, x, C, w, bands, ws);
+}
+
+// for large reference sets the products which make up the weights
+// overflow/underflow, so they are computed through logarithms
+template <typename T>
+static void largeBarycentricWeights(std::vector<T>& w,
+        std::vector<T>& x)
 {
-    if(x.size() > 500u)
+    for(std::size_t i = 0u; i < x.size(); ++i)
     {
-        for(std::size_t i = 0u; i < x.size(); ++i)
+        T one = 1;
+        T denom = 0.0;
+        T xi = x[i];
+        for(std::size_t j = 0u; j < x.size(); ++j)
         {
-            double one = 1;
-            double denom = 0.0;
-            double xi = x[i];
-            for(std::size_t j = 0u; j < x.size(); ++j)
-            {
-                if (j != i) {
-                    denom += log(((xi - x[j] > 0) ? (xi - x[j]) : (x[j] - xi)));
-                    one *= ((xi - x[j] > 0) ? 1 : -1);
-                }
+            if (j != i) {
+                denom += log(((xi - x[j] > 0) ? (xi - x[j]) : (x[j] - xi)));
+                one *= ((xi - x[j] > 0) ? 1 : -1);
             }
-            w[i] = one / exp(denom + log(2.0)* (x.size() - 1));
         }
+        w[i] = one / exp(denom + log(T(2))* (x.size() - 1));
+    }
+}
+
+// the double-double logarithms are expensive, so the products are instead
+// rescaled by powers of two as they are accumulated
+template <>
+void largeBarycentricWeights<dd::ddreal>(std::vector<dd::ddreal>& w,
+        std::vector<dd::ddreal>& x)
+{
+    for(std::size_t i = 0u; i < x.size(); ++i)
+    {
+        dd::ddreal denom = 1.0;
+        int exponent = 0;
+        dd::ddreal xi = x[i];
+        for(std::size_t j = 0u; j < x.size(); ++j)
+        {
+            if (j != i) {
+                denom *= ((xi - x[j]) * 2);
+                int e = std::ilogb(denom.hi);
+                denom = ldexp(denom, -e);
+                exponent += e;
+            }
+        }
+        w[i] = ldexp(1.0 / denom, -exponent);
+    }
+}
+
+template <typename T>
+void barycentricWeights(std::vector<T>& w,
+        std::vector<T>& x)
+{
+    if(x.size() > 500u)
+    {
+        largeBarycentricWeights(w, x);
     }
     else
     {
         std::size_t step = (x.size() - 2) / 15 + 1;
-        double one = 1u;
+        T one = 1u;
         for(std::size_t i = 0u; i < x.size(); ++i)
         {
-            double denom = 1.0;
-            double xi = x[i];
+            T denom = 1.0;
+            T xi = x[i];
             for(std::size_t j = 0u; j < step; ++j)
             {
                 for(std::size_t k = j; k < x.size(); k += step)
@@ -196,25 +235,35 @@ void barycentricWeights(std::vector<double>& w,
 }
 
 
-void computeIdealResponseAndWeight(double &D, double &W,
-        const double &xVal, std::vector<BandD> &bands)
+template <typename T>
+void computeIdealResponseAndWeight(T &D, T &W,
+        const T &xVal, std::vector<BandT<T>> &bands)
 {
-    for (auto &it : bands) {
-        if (xVal >= it.start && xVal <= it.stop) {
-            D = it.amplitude(it.space, xVal);
-            W = it.weight(it.space, xVal);
-            return;
-        }
-    }
+    // the bands are sorted, so the one containing xVal (if any) is the
+    // first band ending at or after it
+    auto it = std::lower_bound(bands.begin(), bands.end(), xVal,
+            [](BandT<T> const& band, T const& x) { return band.stop < x; });
+    if (it == bands.end() || xVal < it->start)
+        return;
+
+    if (it->amplitudeModel.type != FUNCTION)
+        evaluateResponse(D, it->amplitudeModel, it->space, xVal);
+    else
+        D = it->amplitude(it->space, xVal);
+    if (it->weightModel.type != FUNCTION)
+        evaluateResponse(W, it->weightModel, it->space, xVal);
+    else
+        W = it->weight(it->space, xVal);
 }
 
-void computeDelta(double &delta, std::vector<double>& x,
-        std::vector<BandD> &bands)
+template <typename T>
+void computeDelta(T &delta, std::vector<T>& x,
+        std::vector<BandT<T>> &bands)
 {
-    std::vector<double> w(x.size());
+    std::vector<T> w(x.size());
     barycentricWeights(w, x);
 
-    double num, denom, D, W, buffer;
+    T num, denom, D, W, buffer;
     num = denom = D = W = 0;
     for (std::size_t i = 0u; i < w.size(); ++i)
     {
@@ -230,10 +279,11 @@ void computeDelta(double &delta, std::vector<double>& x,
     delta = num / denom;
 }
 
-void computeDelta(double &delta, std::vector<double>& w,
-        std::vector<double>& x, std::vector<BandD> &bands)
+template <typename T>
+void computeDelta(T &delta, std::vector<T>& w,
+        std::vector<T>& x, std::vector<BandT<T>> &bands)
 {
-    double num, denom, D, W, buffer;
+    T num, denom, D, W, buffer;
     num = denom = D = W = 0;
     for (std::size_t i = 0u; i < w.size(); ++i)
     {
@@ -249,10 +299,11 @@ void computeDelta(double &delta, std::vector<double>& w,
 }
 
 
-void computeC(std::vector<double> &C, double &delta,
-        std::vector<double> &omega, std::vector<BandD> &bands)
+template <typename T>
+void computeC(std::vector<T> &C, T &delta,
+        std::vector<T> &omega, std::vector<BandT<T>> &bands)
 {
-    double D, W;
+    T D, W;
     D = W = 0;
     for (std::size_t i = 0u; i < omega.size(); ++i)
     {
@@ -263,49 +314,160 @@ void computeC(std::vector<double> &C, double &delta,
     }
 }
 
-void computeApprox(double &Pc, const double &omega,
-        std::vector<double> &x, std::vector<double> &C,
-        std::vector<double> &w)
+// sums of the barycentric formula at the point t (an exact coincidence of t
+// with one of the reference points gives a non-finite denominator)
+template <typename T>
+static inline void barycentricSums(T &num, T &denom, const T &t,
+        const T *x, const T *C, const T *w, std::size_t r)
 {
-    double num, denom;
-    double buff;
+    T buff;
     num = denom = 0;
-
-    Pc = omega;
-    std::size_t r = x.size();
     for (std::size_t i = 0u; i < r; ++i)
     {
-        if (Pc == x[i]) {
-            Pc = C[i];
-            return;
-        }
-        buff = w[i] / (Pc - x[i]);
+        buff = w[i] / (t - x[i]);
         num += buff * C[i];
         denom += buff;
     }
-    Pc = num / denom;
 }
 
-void computeError(double &error, const double &xVal,
-        double &delta, std::vector<double> &x,
-        std::vector<double> &C, std::vector<double> &w,
-        std::vector<BandD> &bands)
+static inline void barycentricSums(double &num, double &denom,
+        const double &t, const double *x, const double *C, const double *w,
+        std::size_t r)
 {
-    for (std::size_t i = 0u; i < x.size(); ++i)
+    double n = 0.0, d = 0.0;
+    #pragma omp simd reduction(+:n,d)
+    for (std::size_t i = 0u; i < r; ++i)
     {
-        if (xVal == x[i]) {
-            if (i % 2 == 0)
-                error = delta;
-            else
-                error = -delta;
-            return;
+        double buff = w[i] / (t - x[i]);
+        n += buff * C[i];
+        d += buff;
+    }
+    num = n;
+    denom = d;
+}
+
+// index of the reference point equal to t (or r if there is none)
+template <typename T>
+static inline std::size_t coincidentNode(const T &t, const T *x,
+        std::size_t r)
+{
+    std::size_t i = 0u;
+    while (i < r && x[i] != t)
+        ++i;
+    return i;
+}
+
+template <typename T>
+void computeApprox(T &Pc, const T &omega,
+        std::vector<T> &x, std::vector<T> &C,
+        std::vector<T> &w)
+{
+    computeApprox(&Pc, &omega, 1u, x, C, w);
+}
+
+template <typename T>
+void computeApprox(T *Pc, const T *xVal, std::size_t n,
+        std::vector<T> &x, std::vector<T> &C,
+        std::vector<T> &w)
+{
+    using std::isfinite;
+    T num, denom;
+    std::size_t r = x.size();
+    for (std::size_t k = 0u; k < n; ++k)
+    {
+        barycentricSums(num, denom, xVal[k], x.data(), C.data(), w.data(), r);
+        if (!isfinite(denom)) {
+            std::size_t i = coincidentNode(xVal[k], x.data(), r);
+            if (i < r) {
+                Pc[k] = C[i];
+                continue;
+            }
         }
+        Pc[k] = num / denom;
     }
+}
+
+template <typename T>
+void computeApprox(std::vector<T> &Pc, std::vector<T> const &xVal,
+        std::vector<T> &x, std::vector<T> &C,
+        std::vector<T> &w)
+{
+    Pc.resize(xVal.size());
+    computeApprox(Pc.data(), xVal.data(), xVal.size(), x, C, w);
+}
+
+template <typename T>
+void computeError(T &error, const T &xVal,
+        T &delta, std::vector<T> &x,
+        std::vector<T> &C, std::vector<T> &w,
+        std::vector<BandT<T>> &bands)
+{
+    computeError(&error, &xVal, 1u, delta, x, C, w, bands);
+}
 
-    double D, W;
+template <typename T>
+void computeError(T *error, const T *xVal, std::size_t n,
+        T &delta, std::vector<T> &x,
+        std::vector<T> &C, std::vector<T> &w,
+        std::vector<BandT<T>> &bands)
+{
+    using std::isfinite;
+    T num, denom, D, W;
     D = W = 0;
-    computeIdealResponseAndWeight(D, W, xVal, bands);
-    computeApprox(error, xVal, x, C, w);
-    error -= D;
-    error *= W;
+    std::size_t r = x.size();
+    for (std::size_t k = 0u; k < n; ++k)
+    {
+        barycentricSums(num, denom, xVal[k], x.data(), C.data(), w.data(), r);
+        if (!isfinite(denom)) {
+            std::size_t i = coincidentNode(xVal[k], x.data(), r);
+            if (i < r) {
+                error[k] = (i % 2 == 0) ? delta : -delta;
+                continue;
+            }
+        }
+        computeIdealResponseAndWeight(D, W, xVal[k], bands);
+        error[k] = (num / denom - D) * W;
+    }
 }
+
+template <typename T>
+void computeError(std::vector<T> &error, std::vector<T> const &xVal,
+        T &delta, std::vector<T> &x,
+        std::vector<T> &C, std::vector<T> &w,
+        std::vector<BandT<T>> &bands)
+{
+    error.resize(xVal.size());
+    computeError(error.data(), xVal.data(), xVal.size(), delta, x, C, w,
+            bands);
+}
+
+#define BARYCENTRIC_INSTANTIATE(T)                                           \
+  template void barycentricWeights<T>(std::vector<T> &, std::vector<T> &);   \
+  template void computeIdealResponseAndWeight<T>(T &, T &, const T &,        \
+                                                 std::vector<BandT<T>> &);   \
+  template void computeDelta<T>(T &, std::vector<T> &,                       \
+                                std::vector<BandT<T>> &);                    \
+  template void computeDelta<T>(T &, std::vector<T> &, std::vector<T> &,     \
+                                std::vector<BandT<T>> &);                    \
+  template void computeC<T>(std::vector<T> &, T &, std::vector<T> &,         \
+                            std::vector<BandT<T>> &);                        \
+  template void computeApprox<T>(T &, const T &, std::vector<T> &,           \
+                                 std::vector<T> &, std::vector<T> &);        \
+  template void computeApprox<T>(T *, const T *, std::size_t,                \
+                                 std::vector<T> &, std::vector<T> &,         \
+                                 std::vector<T> &);                          \
+  template void computeApprox<T>(std::vector<T> &, std::vector<T> const &,   \
+                                 std::vector<T> &, std::vector<T> &,         \
+                                 std::vector<T> &);                          \
+  template void computeError<T>(T &, const T &, T &, std::vector<T> &,       \
+                                std::vector<T> &, std::vector<T> &,          \
+                                std::vector<BandT<T>> &);                    \
+  template void computeError<T>(T *, const T *, std::size_t, T &,            \
+                                std::vector<T> &, std::vector<T> &,          \
+                                std::vector<T> &, std::vector<BandT<T>> &);  \
+  template void computeError<T>(std::vector<T> &, std::vector<T> const &,    \
+                                T &, std::vector<T> &, std::vector<T> &,     \
+                                std::vector<T> &, std::vector<BandT<T>> &);
+
+BARYCENTRIC_INSTANTIATE(double)
+BARYCENTRIC_INSTANTIATE(dd::ddreal)
@@ -0,0 +1,427 @@
+#include "filter/cache.h"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// layout of an entry: the header, the key (padded to a multiple of 8 bytes)
+// and the payload, in which all the fields are 8-byte aligned
+struct EntryHeader {
+  char magic[4];
+  std::uint32_t version;
+  std::uint32_t kind;
+  std::uint32_t reserved;
+  std::uint64_t keySize;
+  std::uint64_t payloadSize;
+};
+
+const char entryMagic[4] = {'F', 'Q', 'C', 'E'};
+const std::uint32_t formatVersion = 2u;
+
+enum EntryKind : std::uint32_t {
+  DOUBLE_DESIGN = 1u,
+  MP_DESIGN = 2u,
+  QUANTIZATION = 3u
+};
+
+// tags distinguishing the types of the values of a key
+enum KeyItem : char { TAG = 't', INTEGER = 'i', DOUBLE = 'd', MPREAL = 'm' };
+
+inline std::size_t padded(std::size_t size) { return (size + 7u) & ~7u; }
+
+inline void pad(std::string &out) {
+  out.append(padded(out.size()) - out.size(), '\0');
+}
+
+template <typename T> inline void put(std::string &out, T const &value) {
+  out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+void putDoubles(std::string &out, std::vector<double> const &values) {
+  put(out, (std::uint64_t)values.size());
+  out.append(reinterpret_cast<const char *>(values.data()),
+             values.size() * sizeof(double));
+}
+
+// MPFR values are stored exactly, using their precision, kind, exponent
+// and significand limbs (see the custom interface of MPFR); the limbs of
+// zeros, infinities and NaNs are not initialized by MPFR, so they are only
+// written for regular values
+void putMP(std::string &out, mpfr::mpreal const &value) {
+  mpfr_srcptr x = value.mpfr_srcptr();
+  mpfr_prec_t prec = mpfr_get_prec(x);
+  std::int64_t kind = mpfr_custom_get_kind(x);
+  std::int64_t exp = mpfr_regular_p(x) ? mpfr_custom_get_exp(x) : 0;
+  put(out, (std::int64_t)prec);
+  put(out, kind);
+  put(out, exp);
+  if (mpfr_regular_p(x)) {
+    const char *limbs = reinterpret_cast<const char *>(
+        mpfr_custom_get_significand(const_cast<mpfr_ptr>(x)));
+    out.append(limbs, mpfr_custom_get_size(prec));
+    pad(out);
+  }
+}
+
+void putMP(std::string &out, std::vector<mpfr::mpreal> const &values) {
+  put(out, (std::uint64_t)values.size());
+  for (auto &it : values)
+    putMP(out, it);
+}
+
+// bounds checked decoding of a payload
+class Reader {
+public:
+  Reader(const char *data, std::size_t size)
+      : data(data), size(size), pos(0u) {}
+
+  template <typename T> bool get(T &value) {
+    if (size - pos < sizeof(T))
+      return false;
+    std::memcpy(&value, data + pos, sizeof(T));
+    pos += sizeof(T);
+    return true;
+  }
+
+  bool getDoubles(std::vector<double> &values) {
+    std::uint64_t count;
+    if (!get(count) || (size - pos) / sizeof(double) < count)
+      return false;
+    values.resize(count);
+    std::memcpy(values.data(), data + pos, count * sizeof(double));
+    pos += count * sizeof(double);
+    return true;
+  }
+
+  bool getMP(mpfr::mpreal &value) {
+    std::int64_t prec, kind, exp;
+    if (!get(prec) || !get(kind) || !get(exp))
+      return false;
+    if (prec < MPFR_PREC_MIN || prec > MPFR_PREC_MAX ||
+        std::abs(kind) > MPFR_REGULAR_KIND)
+      return false;
+    mpfr_set_prec(value.mpfr_ptr(), prec);
+    if (std::abs(kind) != MPFR_REGULAR_KIND) {
+      // no significand is stored (nor read by MPFR) for these values
+      mp_limb_t limb = 0;
+      mpfr_t x;
+      mpfr_custom_init_set(x, (int)kind, 0, MPFR_PREC_MIN, &limb);
+      mpfr_set(value.mpfr_ptr(), x, MPFR_RNDN);
+      return true;
+    }
+    std::size_t limbSize = padded(mpfr_custom_get_size(prec));
+    if (size - pos < limbSize)
+      return false;
+    // the significand is read in place, since the payloads are aligned
+    mpfr_t x;
+    mpfr_custom_init_set(x, (int)kind, (mpfr_exp_t)exp, (mpfr_prec_t)prec,
+                         const_cast<char *>(data + pos));
+    pos += limbSize;
+    mpfr_set(value.mpfr_ptr(), x, MPFR_RNDN);
+    return true;
+  }
+
+  bool getMP(std::vector<mpfr::mpreal> &values) {
+    std::uint64_t count;
+    if (!get(count) || (size - pos) / (3u * sizeof(std::int64_t)) < count)
+      return false;
+    values.resize(count);
+    for (auto &it : values)
+      if (!getMP(it))
+        return false;
+    return true;
+  }
+
+  bool atEnd() const { return pos == size; }
+
+private:
+  const char *data;
+  std::size_t size;
+  std::size_t pos;
+};
+
+// read-only mapping of an entry file
+class MappedFile {
+public:
+  explicit MappedFile(std::string const &path) : data(nullptr), size(0u) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      return;
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+      void *mapping =
+          mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (mapping != MAP_FAILED) {
+        data = static_cast<const char *>(mapping);
+        size = info.st_size;
+      }
+    }
+    close(fd);
+  }
+  ~MappedFile() {
+    if (data)
+      munmap(const_cast<char *>(data), size);
+  }
+  MappedFile(MappedFile const &) = delete;
+  MappedFile &operator=(MappedFile const &) = delete;
+
+  const char *data;
+  std::size_t size;
+};
+
+// checks the header and the key of a mapped entry and gives the location
+// of its payload
+bool payloadOf(const char *&payload, std::size_t &payloadSize,
+               MappedFile const &file, CacheKey const &key,
+               std::uint32_t kind) {
+  EntryHeader header;
+  if (!file.data || file.size < sizeof(header))
+    return false;
+  std::memcpy(&header, file.data, sizeof(header));
+  std::string const &bytes = key.bytes();
+  if (std::memcmp(header.magic, entryMagic, sizeof(entryMagic)) != 0 ||
+      header.version != formatVersion || header.kind != kind ||
+      header.keySize != bytes.size())
+    return false;
+  std::size_t offset = sizeof(header) + padded(bytes.size());
+  if (file.size < offset || file.size - offset != header.payloadSize ||
+      std::memcmp(file.data + sizeof(header), bytes.data(), bytes.size()) != 0)
+    return false;
+  payload = file.data + offset;
+  payloadSize = header.payloadSize;
+  return true;
+}
+
+} // namespace
+
+CacheKey &CacheKey::add(std::string const &tag) {
+  data.push_back(KeyItem::TAG);
+  put(data, (std::uint64_t)tag.size());
+  data.append(tag);
+  return *this;
+}
+
+CacheKey &CacheKey::add(std::uint64_t value) {
+  data.push_back(KeyItem::INTEGER);
+  put(data, value);
+  return *this;
+}
+
+CacheKey &CacheKey::add(double value) {
+  data.push_back(KeyItem::DOUBLE);
+  put(data, value);
+  return *this;
+}
+
+CacheKey &CacheKey::add(mpfr::mpreal const &value) {
+  data.push_back(KeyItem::MPREAL);
+  putMP(data, value);
+  return *this;
+}
+
+CacheKey &CacheKey::add(std::vector<double> const &values) {
+  add((std::uint64_t)values.size());
+  for (auto &it : values)
+    add(it);
+  return *this;
+}
+
+CacheKey &CacheKey::add(std::vector<mpfr::mpreal> const &values) {
+  add((std::uint64_t)values.size());
+  for (auto &it : values)
+    add(it);
+  return *this;
+}
+
+std::uint64_t CacheKey::hash() const {
+  std::uint64_t h = 14695981039346656037ull;
+  for (unsigned char c : data) {
+    h ^= c;
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+CacheKey designKey(std::vector<double> const &f, std::vector<double> const &a,
+                   std::vector<double> const &w, std::size_t degree) {
+  CacheKey key;
+  key.add("double design").add(f).add(a).add(w).add((std::uint64_t)degree);
+  return key;
+}
+
+CacheKey designKey(std::vector<mpfr::mpreal> const &f,
+                   std::vector<mpfr::mpreal> const &a,
+                   std::vector<mpfr::mpreal> const &w, std::size_t degree,
+                   mp_prec_t prec) {
+  CacheKey key;
+  key.add("mpreal design").add(f).add(a).add(w).add((std::uint64_t)degree);
+  key.add((std::uint64_t)prec);
+  return key;
+}
+
+CacheKey quantizationKey(CacheKey const &design,
+                         mpfr::mpreal const &scalingFactor,
+                         QuantizationMethod method,
+                         QuantizationContext const &context) {
+  CacheKey key = design;
+  key.add("quantization").add(scalingFactor).add((std::uint64_t)method);
+  ReductionStrategy const &reduction = context.reduction;
+  key.add("reduction").add((std::uint64_t)reduction.method);
+  key.add(reduction.delta).add(reduction.eta);
+  key.add((std::uint64_t)(std::int64_t)reduction.blockSize);
+  key.add((std::uint64_t)reduction.autoAbort);
+  key.add((std::uint64_t)(std::int64_t)reduction.maxLoops);
+  key.add((std::uint64_t)reduction.nearestPlane);
+  BranchAndBoundOptions const &search = context.search;
+  key.add("search").add((std::uint64_t)search.vectors);
+  key.add((std::uint64_t)(std::int64_t)search.radius);
+  key.add((std::uint64_t)search.maxNodes).add(search.maxTime);
+  key.add("norm").add((std::uint64_t)context.adaptiveNorm);
+  if (context.adaptiveNorm) {
+    AdaptiveNormOptions const &norm = context.norm;
+    key.add((std::uint64_t)norm.stride).add(norm.threshold);
+    key.add((std::uint64_t)norm.peaks).add((std::uint64_t)norm.certify);
+  }
+  key.add("fixed").add(context.fixedA).add((std::uint64_t)context.prec);
+  return key;
+}
+
+ResultCache::ResultCache(std::string const &directory) : root(directory) {
+  // failures show up when storing entries
+  mkdir(root.c_str(), 0777);
+}
+
+std::string ResultCache::path(CacheKey const &key, std::uint32_t kind) const {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx-%u.fqc",
+                (unsigned long long)key.hash(), kind);
+  return root + "/" + name;
+}
+
+bool ResultCache::write(CacheKey const &key, std::uint32_t kind,
+                        std::string const &payload) const {
+  static std::atomic<unsigned long> counter{0ul};
+
+  EntryHeader header;
+  std::memcpy(header.magic, entryMagic, sizeof(entryMagic));
+  header.version = formatVersion;
+  header.kind = kind;
+  header.reserved = 0u;
+  header.keySize = key.bytes().size();
+  header.payloadSize = payload.size();
+  std::string entry;
+  entry.reserve(sizeof(header) + padded(key.bytes().size()) + payload.size());
+  put(entry, header);
+  entry.append(key.bytes());
+  pad(entry);
+  entry.append(payload);
+
+  // the entry only becomes visible once it is complete
+  std::string target = path(key, kind);
+  std::string temporary = target + ".tmp" + std::to_string(getpid()) + "_" +
+                          std::to_string(counter++);
+  std::FILE *file = std::fopen(temporary.c_str(), "wb");
+  if (!file)
+    return false;
+  bool written = std::fwrite(entry.data(), 1u, entry.size(), file) ==
+                 entry.size();
+  written = (std::fclose(file) == 0) && written;
+  if (!written || std::rename(temporary.c_str(), target.c_str()) != 0) {
+    std::remove(temporary.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool ResultCache::lookup(PMOutputD &output, CacheKey const &key) const {
+  MappedFile file(path(key, DOUBLE_DESIGN));
+  const char *payload;
+  std::size_t size;
+  if (!payloadOf(payload, size, file, key, DOUBLE_DESIGN))
+    return false;
+  Reader reader(payload, size);
+  PMOutputD entry;
+  std::uint64_t iter;
+  if (!reader.get(iter) || !reader.get(entry.delta) || !reader.get(entry.Q) ||
+      !reader.getDoubles(entry.h) || !reader.getDoubles(entry.x) ||
+      !reader.atEnd())
+    return false;
+  entry.iter = iter;
+  output = std::move(entry);
+  return true;
+}
+
+bool ResultCache::lookup(PMOutput &output, CacheKey const &key) const {
+  MappedFile file(path(key, MP_DESIGN));
+  const char *payload;
+  std::size_t size;
+  if (!payloadOf(payload, size, file, key, MP_DESIGN))
+    return false;
+  Reader reader(payload, size);
+  PMOutput entry;
+  std::uint64_t iter;
+  if (!reader.get(iter) || !reader.getMP(entry.delta) ||
+      !reader.getMP(entry.Q) || !reader.getMP(entry.h) ||
+      !reader.getMP(entry.x) || !reader.atEnd())
+    return false;
+  entry.iter = iter;
+  output = std::move(entry);
+  return true;
+}
+
+bool ResultCache::lookup(QuantizationResult &result,
+                         CacheKey const &key) const {
+  MappedFile file(path(key, QUANTIZATION));
+  const char *payload;
+  std::size_t size;
+  if (!payloadOf(payload, size, file, key, QUANTIZATION))
+    return false;
+  Reader reader(payload, size);
+  QuantizationResult entry;
+  std::int64_t bits;
+  if (!reader.getMP(entry.scalingFactor) || !reader.get(bits) ||
+      !reader.get(entry.naiveError) || !reader.get(entry.lllError) ||
+      !reader.get(entry.finalError) || !reader.getMP(entry.coefficients) ||
+      !reader.atEnd())
+    return false;
+  entry.bits = bits;
+  result = std::move(entry);
+  return true;
+}
+
+bool ResultCache::store(CacheKey const &key, PMOutputD const &output) const {
+  std::string payload;
+  put(payload, (std::uint64_t)output.iter);
+  put(payload, output.delta);
+  put(payload, output.Q);
+  putDoubles(payload, output.h);
+  putDoubles(payload, output.x);
+  return write(key, DOUBLE_DESIGN, payload);
+}
+
+bool ResultCache::store(CacheKey const &key, PMOutput const &output) const {
+  std::string payload;
+  put(payload, (std::uint64_t)output.iter);
+  putMP(payload, output.delta);
+  putMP(payload, output.Q);
+  putMP(payload, output.h);
+  putMP(payload, output.x);
+  return write(key, MP_DESIGN, payload);
+}
+
+bool ResultCache::store(CacheKey const &key,
+                        QuantizationResult const &result) const {
+  std::string payload;
+  putMP(payload, result.scalingFactor);
+  put(payload, (std::int64_t)result.bits);
+  put(payload, result.naiveError);
+  put(payload, result.lllError);
+  put(payload, result.finalError);
+  putMP(payload, result.coefficients);
+  return write(key, QUANTIZATION, payload);
+}
@@ -1,5 +1,10 @@
 #include "filter/cheby.h"
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CHEBY_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
 void applyCos(std::vector<mpfr::mpreal> &out,
               std::vector<mpfr::mpreal> const &in) {
   for (std::size_t i = 0u; i < in.size(); ++i)
@@ -18,8 +23,7 @@ void evaluateClenshaw(mpfr::mpreal &result, std::vector<mpfr::mpreal> &p,
                       mpfr::mpreal &x, mpfr::mpreal &a, mpfr::mpreal &b,
                       mp_prec_t prec) {
   using mpfr::mpreal;
-  mp_prec_t prevPrec = mpreal::get_default_prec();
-  mpreal::set_default_prec(prec);
+  ScopedPrecision guard(prec);
   mpreal bn1, bn2, bn;
   mpreal buffer;
 
@@ -42,36 +46,43 @@ void evaluateClenshaw(mpfr::mpreal &result, std::vector<mpfr::mpreal> &p,
   // set the value for the result (line 8 which outputs the value
   // of the CI at x)
   result = bn1 - buffer * bn2;
-  mpreal::set_default_prec(prevPrec);
 }
 
 void evaluateClenshaw(mpfr::mpreal &result, std::vector<mpfr::mpreal> &p,
-                      mpfr::mpreal &x, mp_prec_t prec) {
+                      mpfr::mpreal &x, MPWorkspace &ws) {
   using mpfr::mpreal;
-  mp_prec_t prevPrec = mpreal::get_default_prec();
-  mpreal::set_default_prec(prec);
-  mpreal bn1, bn2, bn;
+  mp_rnd_t rnd = mpreal::get_default_rnd();
 
   int n = (int)p.size() - 1;
-  bn2 = 0;
-  bn1 = p[n];
+  ws.bn2 = 0;
+  mpfr_set(ws.bn1.mpfr_ptr(), p[n].mpfr_srcptr(), rnd);
   for (int k = n - 1; k >= 1; --k) {
-    bn = x * 2;
-    bn = bn * bn1 - bn2 + p[k];
+    // bn = 2 * x * bn1 - bn2 + p[k], computed in place
+    mpfr_mul_2ui(ws.bn.mpfr_ptr(), x.mpfr_srcptr(), 1u, rnd);
+    mpfr_mul(ws.bn.mpfr_ptr(), ws.bn.mpfr_srcptr(), ws.bn1.mpfr_srcptr(), rnd);
+    mpfr_sub(ws.bn.mpfr_ptr(), ws.bn.mpfr_srcptr(), ws.bn2.mpfr_srcptr(), rnd);
+    mpfr_add(ws.bn.mpfr_ptr(), ws.bn.mpfr_srcptr(), p[k].mpfr_srcptr(), rnd);
     // update values
-    bn2 = bn1;
-    bn1 = bn;
+    mpfr_swap(ws.bn2.mpfr_ptr(), ws.bn1.mpfr_ptr());
+    mpfr_swap(ws.bn1.mpfr_ptr(), ws.bn.mpfr_ptr());
   }
 
-  result = x * bn1 - bn2 + p[0];
-  mpreal::set_default_prec(prevPrec);
+  mpfr_mul(ws.bn.mpfr_ptr(), x.mpfr_srcptr(), ws.bn1.mpfr_srcptr(), rnd);
+  mpfr_sub(ws.bn.mpfr_ptr(), ws.bn.mpfr_srcptr(), ws.bn2.mpfr_srcptr(), rnd);
+  mpfr_add(ws.bn.mpfr_ptr(), ws.bn.mpfr_srcptr(), p[0].mpfr_srcptr(), rnd);
+  result = ws.bn;
+}
+
+void evaluateClenshaw(mpfr::mpreal &result, std::vector<mpfr::mpreal> &p,
+                      mpfr::mpreal &x, mp_prec_t prec) {
+  MPWorkspace ws(prec);
+  evaluateClenshaw(result, p, x, ws);
 }
 
 void evaluateClenshaw2ndKind(mpfr::mpreal &result, std::vector<mpfr::mpreal> &p,
                              mpfr::mpreal &x, mp_prec_t prec) {
   using mpfr::mpreal;
-  mp_prec_t prevPrec = mpreal::get_default_prec();
-  mpreal::set_default_prec(prec);
+  ScopedPrecision guard(prec);
   mpreal bn1, bn2, bn;
 
   int n = (int)p.size() - 1;
@@ -86,14 +97,12 @@ void evaluateClenshaw2ndKind(mpfr::mpreal &result, std::vector<mpfr::mpreal> &p,
   }
 
   result = (x << 1) * bn1 - bn2 + p[0];
-  mpreal::set_default_prec(prevPrec);
 }
 
 void generateEquidistantNodes(std::vector<mpfr::mpreal> &v, std::size_t n,
                               mp_prec_t prec) {
   using mpfr::mpreal;
-  mp_prec_t prevPrec = mpreal::get_default_prec();
-  mpreal::set_default_prec(prec);
+  ScopedPrecision guard(prec);
   mpreal pi = mpfr::const_pi(prec);
 
   // store the points in the vector v as v[i] = i * pi / n
@@ -101,14 +110,12 @@ void generateEquidistantNodes(std::vector<mpfr::mpreal> &v, std::size_t n,
     v[i] = pi * i;
     v[i] /= n;
   }
-  mpreal::set_default_prec(prevPrec);
 }
 
 void generateChebyshevPoints(std::vector<mpfr::mpreal> &x, std::size_t n,
                              mp_prec_t prec) {
   using mpfr::mpreal;
-  mp_prec_t prevPrec = mpreal::get_default_prec();
-  mpreal::set_default_prec(prec);
+  ScopedPrecision guard(prec);
   mpreal pi = mpfr::const_pi(prec);
 
   // n is the number of points - 1
@@ -119,19 +126,18 @@ void generateChebyshevPoints(std::vector<mpfr::mpreal> &x, std::size_t n,
   } else {
     x.push_back(mpfr::mpreal(0));
   }
-  mpreal::set_default_prec(prevPrec);
 }
 
 void generateChebyshevCoefficients(std::vector<mpfr::mpreal> &c,
                                    std::vector<mpfr::mpreal> &fv, std::size_t n,
                                    mp_prec_t prec) {
   using mpfr::mpreal;
-  mp_prec_t prevPrec = mpreal::get_default_prec();
-  mpreal::set_default_prec(prec);
+  ScopedPrecision guard(prec);
   std::vector<mpreal> v(n + 1);
   generateEquidistantNodes(v, n, prec);
 
   mpreal buffer;
+  MPWorkspace ws(prec);
 
   // halve the first and last coefficients
   mpfr::mpreal oldValue1 = fv[0];
@@ -144,8 +150,8 @@ void generateChebyshevCoefficients(std::vector<mpfr::mpreal> &c,
                               // node cos(i * pi / n)
 
     evaluateClenshaw(c[i], fv, buffer,
-                     prec); // evaluate the current coefficient
-                            // using Clenshaw
+                     ws); // evaluate the current coefficient
+                          // using Clenshaw
     if (i == 0u || i == n) {
       c[i] /= n;
     } else {
@@ -155,8 +161,6 @@ void generateChebyshevCoefficients(std::vector<mpfr::mpreal> &c,
   }
   fv[0] = oldValue1;
   fv[n] = oldValue2;
-
-  mpreal::set_default_prec(prevPrec);
 }
 
 // function that generates the coefficients of the derivative of a given CI
@@ -181,26 +185,29 @@ void derivativeCoefficients2ndKind(std::vector<mpfr::mpreal> &derivC,
     derivC[i - 1] = c[i] * i;
 }
 
-void applyCos(std::vector<double>& out,
-        std::vector<double> const& in)
+template <typename T>
+void applyCos(std::vector<T>& out,
+        std::vector<T> const& in)
 {
     for (std::size_t i{0u}; i < in.size(); ++i)
         out[i] = cosl(in[i]);
 }
 
-void changeOfVariable(std::vector<double>& out,
-        std::vector<double> const& in,
-        double& a, double& b)
+template <typename T>
+void changeOfVariable(std::vector<T>& out,
+        std::vector<T> const& in,
+        T& a, T& b)
 {
     for (std::size_t i{0u}; i < in.size(); ++i)
         out[i] = (b + a) / 2 + in[i] * (b - a) / 2;
 }
 
-void evaluateClenshaw(double &result, std::vector<double> &p,
-        double &x, double &a, double &b)
+template <typename T>
+void evaluateClenshaw(T &result, std::vector<T> &p,
+        T &x, T &a, T &b)
 {
-    double bn1, bn2, bn;
-    double buffer;
+    T bn1, bn2, bn;
+    T buffer;
 
     bn1 = 0;
     bn2 = 0;
@@ -223,10 +230,11 @@ void evaluateClenshaw(double &result, std::vector<double> &p,
     result = bn1 - buffer * bn2;
 }
 
-void evaluateClenshaw(double &result, std::vector<double> &p,
-                            double &x)
+template <typename T>
+void evaluateClenshaw(T &result, std::vector<T> &p,
+                            T &x)
 {
-    double bn1, bn2, bn;
+    T bn1, bn2, bn;
 
     int n = (int)p.size() - 1;
     bn2 = 0;
@@ -242,10 +250,11 @@ void evaluateClenshaw(double &result, std::vector<double> &p,
     result = x * bn1 - bn2 + p[0];
 }
 
-void evaluateClenshaw2ndKind(double &result, std::vector<double> &p,
-                            double &x)
+template <typename T>
+void evaluateClenshaw2ndKind(T &result, std::vector<T> &p,
+                            T &x)
 {
-    double bn1, bn2, bn;
+    T bn1, bn2, bn;
 
     int n = (int)p.size() - 1;
     bn2 = 0;
@@ -262,23 +271,159 @@ void evaluateClenshaw2ndKind(double &result, std::vector<double> &p,
 }
 
 
-void generateEquidistantNodes(std::vector<double>& v, std::size_t n)
+// The batched Clenshaw kernels below perform the same sequence of
+// operations as the scalar evaluateClenshaw routine on each point (this file
+// is compiled without floating-point contraction, see src/CMakeLists.txt),
+// such that the choice of kernel does not influence the results.
+typedef void (*ClenshawKernel)(double *, const double *, std::size_t,
+                               const double *, std::size_t);
+
+static void clenshawScalar(double *result, const double *x, std::size_t n,
+                           const double *p, std::size_t size)
+{
+    int d = (int)size - 1;
+    for(std::size_t i{0u}; i < n; ++i) {
+        double bn1, bn2, bn;
+        double x2 = x[i] * 2;
+        bn2 = 0;
+        bn1 = p[d];
+        for(int k{d - 1}; k >= 1; --k) {
+            bn = x2 * bn1 - bn2 + p[k];
+            bn2 = bn1;
+            bn1 = bn;
+        }
+        result[i] = x[i] * bn1 - bn2 + p[0];
+    }
+}
+
+#ifdef CHEBY_X86_DISPATCH
+__attribute__((target("avx2")))
+static void clenshawAVX2(double *result, const double *x, std::size_t n,
+                         const double *p, std::size_t size)
+{
+    int d = (int)size - 1;
+    std::size_t i{0u};
+    // two independent 4-wide evaluations per iteration to hide the
+    // latency of the recurrence
+    for(; i + 8u <= n; i += 8u) {
+        __m256d xa = _mm256_loadu_pd(x + i);
+        __m256d xb = _mm256_loadu_pd(x + i + 4u);
+        __m256d x2a = _mm256_add_pd(xa, xa);
+        __m256d x2b = _mm256_add_pd(xb, xb);
+        __m256d bn1a = _mm256_set1_pd(p[d]);
+        __m256d bn1b = bn1a;
+        __m256d bn2a = _mm256_setzero_pd();
+        __m256d bn2b = bn2a;
+        for(int k{d - 1}; k >= 1; --k) {
+            __m256d pk = _mm256_set1_pd(p[k]);
+            __m256d bna = _mm256_add_pd(_mm256_sub_pd(
+                        _mm256_mul_pd(x2a, bn1a), bn2a), pk);
+            __m256d bnb = _mm256_add_pd(_mm256_sub_pd(
+                        _mm256_mul_pd(x2b, bn1b), bn2b), pk);
+            bn2a = bn1a;
+            bn2b = bn1b;
+            bn1a = bna;
+            bn1b = bnb;
+        }
+        __m256d p0 = _mm256_set1_pd(p[0]);
+        _mm256_storeu_pd(result + i, _mm256_add_pd(_mm256_sub_pd(
+                        _mm256_mul_pd(xa, bn1a), bn2a), p0));
+        _mm256_storeu_pd(result + i + 4u, _mm256_add_pd(_mm256_sub_pd(
+                        _mm256_mul_pd(xb, bn1b), bn2b), p0));
+    }
+    clenshawScalar(result + i, x + i, n - i, p, size);
+}
+
+__attribute__((target("avx512f")))
+static void clenshawAVX512(double *result, const double *x, std::size_t n,
+                           const double *p, std::size_t size)
+{
+    int d = (int)size - 1;
+    std::size_t i{0u};
+    for(; i + 16u <= n; i += 16u) {
+        __m512d xa = _mm512_loadu_pd(x + i);
+        __m512d xb = _mm512_loadu_pd(x + i + 8u);
+        __m512d x2a = _mm512_add_pd(xa, xa);
+        __m512d x2b = _mm512_add_pd(xb, xb);
+        __m512d bn1a = _mm512_set1_pd(p[d]);
+        __m512d bn1b = bn1a;
+        __m512d bn2a = _mm512_setzero_pd();
+        __m512d bn2b = bn2a;
+        for(int k{d - 1}; k >= 1; --k) {
+            __m512d pk = _mm512_set1_pd(p[k]);
+            __m512d bna = _mm512_add_pd(_mm512_sub_pd(
+                        _mm512_mul_pd(x2a, bn1a), bn2a), pk);
+            __m512d bnb = _mm512_add_pd(_mm512_sub_pd(
+                        _mm512_mul_pd(x2b, bn1b), bn2b), pk);
+            bn2a = bn1a;
+            bn2b = bn1b;
+            bn1a = bna;
+            bn1b = bnb;
+        }
+        __m512d p0 = _mm512_set1_pd(p[0]);
+        _mm512_storeu_pd(result + i, _mm512_add_pd(_mm512_sub_pd(
+                        _mm512_mul_pd(xa, bn1a), bn2a), p0));
+        _mm512_storeu_pd(result + i + 8u, _mm512_add_pd(_mm512_sub_pd(
+                        _mm512_mul_pd(xb, bn1b), bn2b), p0));
+    }
+    clenshawAVX2(result + i, x + i, n - i, p, size);
+}
+#endif
+
+static ClenshawKernel selectClenshawKernel()
+{
+#ifdef CHEBY_X86_DISPATCH
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f"))
+        return clenshawAVX512;
+    if(__builtin_cpu_supports("avx2"))
+        return clenshawAVX2;
+#endif
+    return clenshawScalar;
+}
+
+void evaluateClenshaw(double *result, const double *x, std::size_t n,
+                        std::vector<double> &p)
+{
+    static const ClenshawKernel kernel = selectClenshawKernel();
+    kernel(result, x, n, p.data(), p.size());
+}
+
+void evaluateClenshaw(std::vector<double> &result, std::vector<double> &p,
+                        std::vector<double> &x)
+{
+    result.resize(x.size());
+    evaluateClenshaw(result.data(), x.data(), x.size(), p);
+}
+
+void evaluateClenshaw(std::vector<std::vector<double>> &result,
+                        std::vector<std::vector<double>> &p,
+                        std::vector<double> &x)
+{
+    result.resize(p.size());
+    for(std::size_t k{0u}; k < p.size(); ++k)
+        evaluateClenshaw(result[k], p[k], x);
+}
+
+template <typename T>
+void generateEquidistantNodes(std::vector<T>& v, std::size_t n)
 {
     // store the points in the vector v as v[i] = i * pi / n
     for(std::size_t i{0u}; i <= n; ++i) {
-        v[i] = M_PI * i;
+        v[i] = constPi<T>() * i;
         v[i] /= n;
     }
 }
 
-void generateChebyshevPoints(std::vector<double>& x, std::size_t n)
+template <typename T>
+void generateChebyshevPoints(std::vector<T>& x, std::size_t n)
 {
     // n is the number of points - 1
     x.reserve(n + 1u);
     if(n > 0u)
     {
         for(int k = n; k >= -n; k -= 2)
-            x.push_back(sin(M_PI * k / (n * 2)));
+            x.push_back(sin(constPi<T>() * k / (n * 2)));
     }
     else
     {
@@ -288,17 +433,18 @@ void generateChebyshevPoints(std::vector<double>& x, std::size_t n)
 
 // this function computes the values of the coefficients of the CI when
 // Chebyshev nodes of the second kind are used
-void generateChebyshevCoefficients(std::vector<double>& c,
-        std::vector<double>& fv, std::size_t n)
+template <typename T>
+void generateChebyshevCoefficients(std::vector<T>& c,
+        std::vector<T>& fv, std::size_t n)
 {
-    std::vector<double> v(n + 1);
+    std::vector<T> v(n + 1);
     generateEquidistantNodes(v, n);
 
-    double buffer;
+    T buffer;
 
     // halve the first and last coefficients
-    double oldValue1 = fv[0];
-    double oldValue2 = fv[n];
+    T oldValue1 = fv[0];
+    T oldValue2 = fv[n];
     fv[0] /= 2;
     fv[n] /= 2;
 
@@ -321,8 +467,9 @@ void generateChebyshevCoefficients(std::vector<double>& c,
 }
 
 // function that generates the coefficients of the derivative of a given CI
-void derivativeCoefficients1stKind(std::vector<double>& derivC,
-                                        std::vector<double>& c)
+template <typename T>
+void derivativeCoefficients1stKind(std::vector<T>& derivC,
+                                        std::vector<T>& c)
 {
     int n = c.size() - 2;
     derivC[n] = c[n + 1] * (2 * (n + 1));
@@ -335,10 +482,30 @@ void derivativeCoefficients1stKind(std::vector<double>& derivC,
 }
 
 // use the formula (T_n(x))' = n * U_{n-1}(x)
-void derivativeCoefficients2ndKind(std::vector<double>& derivC,
-        std::vector<double>& c)
+template <typename T>
+void derivativeCoefficients2ndKind(std::vector<T>& derivC,
+        std::vector<T>& c)
 {
     std::size_t n = c.size() - 1;
     for(std::size_t i{n}; i > 0u; --i)
         derivC[i - 1] = c[i] * i;
-}
\ No newline at end of file
+}
+
+#define CHEBY_INSTANTIATE(T)                                                  \
+    template void applyCos<T>(std::vector<T>&, std::vector<T> const&);       \
+    template void changeOfVariable<T>(std::vector<T>&,                       \
+            std::vector<T> const&, T&, T&);                                  \
+    template void evaluateClenshaw<T>(T&, std::vector<T>&, T&, T&, T&);      \
+    template void evaluateClenshaw<T>(T&, std::vector<T>&, T&);              \
+    template void evaluateClenshaw2ndKind<T>(T&, std::vector<T>&, T&);       \
+    template void generateEquidistantNodes<T>(std::vector<T>&, std::size_t); \
+    template void generateChebyshevPoints<T>(std::vector<T>&, std::size_t);  \
+    template void generateChebyshevCoefficients<T>(std::vector<T>&,          \
+            std::vector<T>&, std::size_t);                                   \
+    template void derivativeCoefficients1stKind<T>(std::vector<T>&,          \
+            std::vector<T>&);                                                \
+    template void derivativeCoefficients2ndKind<T>(std::vector<T>&,          \
+            std::vector<T>&);
+
+CHEBY_INSTANTIATE(double)
+CHEBY_INSTANTIATE(dd::ddreal)
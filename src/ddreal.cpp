@@ -0,0 +1,122 @@
+#include "filter/ddreal.h"
+#include <iomanip>
+
+namespace dd {
+
+namespace {
+
+// Taylor expansions of sin and cos around 0, for |x| <= pi/4
+void sinCosTaylor(ddreal& s, ddreal& c, ddreal const& x)
+{
+    const double threshold = 1e-33;
+    ddreal x2 = x * x;
+    ddreal term = x;
+    s = x;
+    for(int k = 2; std::fabs(term.hi) > threshold; k += 2)
+    {
+        term = -(term * x2) / double(k * (k + 1));
+        s += term;
+    }
+    term = 1.0;
+    c = 1.0;
+    for(int k = 1; std::fabs(term.hi) > threshold; k += 2)
+    {
+        term = -(term * x2) / double(k * (k + 1));
+        c += term;
+    }
+}
+
+// reduces x modulo pi/2 and evaluates sin and cos at the result
+void sinCos(ddreal& s, ddreal& c, ddreal const& x)
+{
+    double k = std::nearbyint(x.hi / ddreal::halfPi().hi);
+    ddreal r = x - ddreal::halfPi() * k;
+    ddreal sr, cr;
+    sinCosTaylor(sr, cr, r);
+    switch((long)std::fmod(k, 4.0) & 3)
+    {
+        case 0: s = sr; c = cr; break;
+        case 1: s = cr; c = -sr; break;
+        case 2: s = -sr; c = -cr; break;
+        default: s = -cr; c = sr; break;
+    }
+}
+
+} // namespace
+
+ddreal exp(ddreal const& x)
+{
+    if(x.hi > 709.78)
+        return std::numeric_limits<double>::infinity();
+    if(x.hi < -745.2)
+        return 0.0;
+    if(!std::isfinite(x.hi))
+        return x;
+
+    // x = k * ln(2) + r, and exp(r) = (exp(r / 512))^512
+    double k = std::nearbyint(x.hi / ddreal::ln2().hi);
+    ddreal r = ldexp(x - ddreal::ln2() * k, -9);
+
+    // expm1 of the reduced argument
+    ddreal term = r;
+    ddreal s = r;
+    for(int i = 2; std::fabs(term.hi) > 1e-33; ++i)
+    {
+        term = term * r / double(i);
+        s += term;
+    }
+    for(int i = 0; i < 9; ++i)
+        s = s * 2.0 + s * s;
+    return ldexp(s + 1.0, (int)k);
+}
+
+ddreal log(ddreal const& x)
+{
+    if(!(x.hi > 0.0) || !std::isfinite(x.hi))
+        return std::log(x.hi);
+    // one Newton step on exp(y) = x starting from the double logarithm
+    ddreal y = std::log(x.hi);
+    return y + x * exp(-y) - 1.0;
+}
+
+ddreal cos(ddreal const& x)
+{
+    ddreal s, c;
+    sinCos(s, c, x);
+    return c;
+}
+
+ddreal sin(ddreal const& x)
+{
+    ddreal s, c;
+    sinCos(s, c, x);
+    return s;
+}
+
+ddreal acos(ddreal const& x)
+{
+    if(x.hi > 1.0 || x.hi < -1.0)
+        return std::numeric_limits<double>::quiet_NaN();
+    if(x == 1.0)
+        return 0.0;
+    if(x == -1.0)
+        return ddreal::pi();
+    // Newton iterations on cos(y) = x starting from the double arccosine
+    ddreal y = std::acos(x.hi);
+    for(int i = 0; i < 2; ++i)
+    {
+        ddreal s, c;
+        sinCos(s, c, y);
+        if(s.hi == 0.0)
+            break;
+        y += (c - x) / s;
+    }
+    return y;
+}
+
+std::ostream& operator<<(std::ostream& os, ddreal const& x)
+{
+    return os << (static_cast<long double>(x.hi) + x.lo);
+}
+
+} // namespace dd
@@ -1,6 +1,62 @@
 #include "filter/eigenvalue.h"
 #include <algorithm>
 
+namespace {
+
+// The transpose of a colleague matrix (balanced or not) is upper Hessenberg,
+// so the QR iterations of the real Schur decomposition can be started on it
+// directly, skipping the Hessenberg reduction. Only the quasi-triangular
+// factor is needed: neither the Schur vectors nor the eigenvectors are
+// computed. The selection of the real eigenvalues in [a,b] mirrors the one
+// of Eigen::EigenSolver followed by getRealValues.
+template <typename T, int N>
+bool colleagueRealEigenvalues(std::vector<T> &realValues,
+                              Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> &C,
+                              T &a, T &b, T const &threshold) {
+  using std::abs;
+  using std::sqrt;
+  typedef Eigen::Matrix<T, N, N> MatrixNT;
+  Eigen::Index n = C.rows();
+  MatrixNT H = C.transpose();
+  Eigen::RealSchur<MatrixNT> schur(n);
+  schur.computeFromHessenberg(H, MatrixNT::Identity(n, n), false);
+  if (schur.info() != Eigen::Success)
+    return false;
+
+  MatrixNT const &S = schur.matrixT();
+  auto addValue = [&](T const &value) {
+    if (a <= value && b >= value)
+      realValues.push_back(value);
+  };
+  Eigen::Index i = 0;
+  while (i < n) {
+    if (i == n - 1 || S(i + 1, i) == T(0)) {
+      addValue(S(i, i));
+      ++i;
+    } else {
+      // 2x2 block, whose eigenvalues are (close to being) complex
+      // conjugates
+      T p = T(0.5) * (S(i, i) - S(i + 1, i + 1));
+      T t0 = S(i + 1, i);
+      T t1 = S(i, i + 1);
+      T maxval = std::max(abs(p), std::max(abs(t0), abs(t1)));
+      t0 /= maxval;
+      t1 /= maxval;
+      T p0 = p / maxval;
+      T z = maxval * sqrt(abs(p0 * p0 + t0 * t1));
+      if (z < threshold) {
+        addValue(S(i + 1, i + 1) + p);
+        addValue(S(i + 1, i + 1) + p);
+      }
+      i += 2;
+    }
+  }
+  std::sort(realValues.begin(), realValues.end());
+  return true;
+}
+
+} // namespace
+
 void balance(MatrixXq &A) {
   std::size_t n = A.rows();
 
@@ -54,8 +110,7 @@ void balance(MatrixXq &A) {
 void generateColleagueMatrix1stKind(MatrixXq &C, std::vector<mpfr::mpreal> &a,
                                     bool withBalancing, mp_prec_t prec) {
   using mpfr::mpreal;
-  mpfr_prec_t prevPrec = mpreal::get_default_prec();
-  mpreal::set_default_prec(prec);
+  ScopedPrecision guard(prec);
   std::vector<mpfr::mpreal> c = a;
 
   std::size_t n = a.size() - 1;
@@ -82,14 +137,26 @@ void generateColleagueMatrix1stKind(MatrixXq &C, std::vector<mpfr::mpreal> &a,
 
   if (withBalancing)
     balance(C);
-  mpreal::set_default_prec(prevPrec);
 }
 
 void determineEigenvalues(VectorXcq &eigenvalues, MatrixXq &C) {
-  Eigen::EigenSolver<MatrixXq> es(C);
+  Eigen::EigenSolver<MatrixXq> es(C, false);
   eigenvalues = es.eigenvalues();
 }
 
+void determineRealEigenvalues(std::vector<mpfr::mpreal> &realValues,
+                              MatrixXq &C, mpfr::mpreal &a, mpfr::mpreal &b) {
+  using mpfr::mpreal;
+  mpreal threshold = 10;
+  mpfr_pow_si(threshold.mpfr_ptr(), threshold.mpfr_srcptr(), -20, GMP_RNDN);
+  if (!colleagueRealEigenvalues<mpreal, Eigen::Dynamic>(realValues, C, a, b,
+                                                       threshold)) {
+    VectorXcq eigenvalues;
+    determineEigenvalues(eigenvalues, C);
+    getRealValues(realValues, eigenvalues, a, b);
+  }
+}
+
 void getRealValues(std::vector<mpfr::mpreal> &roots, VectorXcq &eigenValues,
                    mpfr::mpreal &a, mpfr::mpreal &b) {
   using mpfr::mpreal;
@@ -109,8 +176,7 @@ void getRealValues(std::vector<mpfr::mpreal> &roots, VectorXcq &eigenValues,
 void generateColleagueMatrix2ndKind(MatrixXq &C, std::vector<mpfr::mpreal> &a,
                                     bool withBalancing, mp_prec_t prec) {
   using mpfr::mpreal;
-  mpfr_prec_t prevPrec = mpreal::get_default_prec();
-  mpreal::set_default_prec(prec);
+  ScopedPrecision guard(prec);
   std::vector<mpfr::mpreal> c = a;
 
   std::size_t n = a.size() - 1;
@@ -137,19 +203,20 @@ void generateColleagueMatrix2ndKind(MatrixXq &C, std::vector<mpfr::mpreal> &a,
 
   if (withBalancing)
     balance(C);
-  mpreal::set_default_prec(prevPrec);
 }
 
 
-void balance(MatrixXd& A)
+template <typename T>
+void balance(MatrixXT<T>& A)
 {
+    using std::isfinite;
     std::size_t n = A.rows();
 
-    double rNorm;      // row norm
-    double cNorm;      // column norm
+    T rNorm;      // row norm
+    T cNorm;      // column norm
     bool converged = false;
 
-    double g, f, s;
+    T g, f, s;
     while(!converged)
     {
         converged = true;
@@ -171,7 +238,7 @@ void balance(MatrixXd& A)
             s = cNorm + rNorm;
 
 
-            while(std::isfinite(cNorm) && cNorm < g)
+            while(isfinite(cNorm) && cNorm < g)
             {
                 f *= 2.0;
                 cNorm *= 4.0;
@@ -179,7 +246,7 @@ void balance(MatrixXd& A)
 
             g = rNorm * 2.0;
 
-            while(std::isfinite(cNorm) && cNorm > g)
+            while(isfinite(cNorm) && cNorm > g)
             {
                 f /= 2.0;
                 cNorm /= 4.0;
@@ -200,10 +267,11 @@ void balance(MatrixXd& A)
 }
 
 
-void generateColleagueMatrix1stKind(MatrixXd& C,
-        std::vector<double>& a, bool withBalancing)
+template <typename T>
+void generateColleagueMatrix1stKind(MatrixXT<T>& C,
+        std::vector<T>& a, bool withBalancing)
 {
-    std::vector<double> c = a;
+    std::vector<T> c = a;
 
     std::size_t n = a.size() - 1;
     // construct the initial matrix
@@ -213,7 +281,7 @@ void generateColleagueMatrix1stKind(MatrixXd& C,
             C(i, j) = 0;
 
 
-    double denom = -1;
+    T denom = -1;
     denom /= c[n];
     denom /= 2;
     for(std::size_t i = 0u; i < a.size() - 1; ++i)
@@ -233,10 +301,11 @@ void generateColleagueMatrix1stKind(MatrixXd& C,
         balance(C);
 }
 
-void generateColleagueMatrix2ndKind(MatrixXd& C,
-        std::vector<double>& a, bool withBalancing)
+template <typename T>
+void generateColleagueMatrix2ndKind(MatrixXT<T>& C,
+        std::vector<T>& a, bool withBalancing)
 {
-    std::vector<double> c = a;
+    std::vector<T> c = a;
 
     std::size_t n = a.size() - 1;
     // construct the initial matrix
@@ -246,7 +315,7 @@ void generateColleagueMatrix2ndKind(MatrixXd& C,
             C(i, j) = 0;
 
 
-    double denom = -1;
+    T denom = -1;
     denom /= c[n];
     denom /= 2;
     for(std::size_t i = 0u; i < a.size() - 1; ++i)
@@ -266,23 +335,58 @@ void generateColleagueMatrix2ndKind(MatrixXd& C,
         balance(C);
 }
 
-void determineEigenvalues(VectorXcd &eigenvalues,
-        MatrixXd &C)
+template <typename T>
+void determineEigenvalues(VectorXcT<T> &eigenvalues,
+        MatrixXT<T> &C)
 {
-    Eigen::EigenSolver<MatrixXd> es(C);
+    Eigen::EigenSolver<MatrixXT<T>> es(C, false);
     eigenvalues = es.eigenvalues();
 }
 
 
-void getRealValues(std::vector<double> &realValues,
-        VectorXcd &complexValues,
-        double &a, double &b)
+template <typename T>
+void determineRealEigenvalues(std::vector<T> &realValues,
+        MatrixXT<T> &C, T &a, T &b)
+{
+    // the usual subinterval sizes get fixed-size matrices, which live on
+    // the stack
+    T threshold = 1e-20;
+    bool success;
+    switch(C.rows())
+    {
+        case 3: success = colleagueRealEigenvalues<T, 3>(realValues,
+                        C, a, b, threshold); break;
+        case 4: success = colleagueRealEigenvalues<T, 4>(realValues,
+                        C, a, b, threshold); break;
+        case 7: success = colleagueRealEigenvalues<T, 7>(realValues,
+                        C, a, b, threshold); break;
+        case 8: success = colleagueRealEigenvalues<T, 8>(realValues,
+                        C, a, b, threshold); break;
+        case 15: success = colleagueRealEigenvalues<T, 15>(realValues,
+                        C, a, b, threshold); break;
+        case 16: success = colleagueRealEigenvalues<T, 16>(realValues,
+                        C, a, b, threshold); break;
+        default: success = colleagueRealEigenvalues<T, Eigen::Dynamic>(
+                        realValues, C, a, b, threshold);
+    }
+    if(!success)
+    {
+        VectorXcT<T> eigenvalues;
+        determineEigenvalues(eigenvalues, C);
+        getRealValues(realValues, eigenvalues, a, b);
+    }
+}
+
+template <typename T>
+void getRealValues(std::vector<T> &realValues,
+        VectorXcT<T> &complexValues,
+        T &a, T &b)
 {
-    double threshold = 10;
+    T threshold = 10;
     threshold = pow(10, -20);
     for (int i = 0; i < complexValues.size(); ++i)
     {
-        double imagValue = fabs(complexValues(i).imag());
+        T imagValue = fabs(complexValues(i).imag());
         if(imagValue < threshold) {
             if(a <= complexValues(i).real() && b >= complexValues(i).real()) {
                 realValues.push_back(complexValues(i).real());
@@ -290,4 +394,17 @@ void getRealValues(std::vector<double> &realValues,
         }
     }
     std::sort(realValues.begin(), realValues.end());
-}
\ No newline at end of file
+}
+
+#define EIGENVALUE_INSTANTIATE(T)                                             \
+    template void generateColleagueMatrix1stKind<T>(MatrixXT<T>&,            \
+            std::vector<T>&, bool);                                          \
+    template void generateColleagueMatrix2ndKind<T>(MatrixXT<T>&,            \
+            std::vector<T>&, bool);                                          \
+    template void determineEigenvalues<T>(VectorXcT<T>&, MatrixXT<T>&);      \
+    template void determineRealEigenvalues<T>(std::vector<T>&, MatrixXT<T>&, \
+            T&, T&);                                                         \
+    template void getRealValues<T>(std::vector<T>&, VectorXcT<T>&, T&, T&);
+
+EIGENVALUE_INSTANTIATE(double)
+EIGENVALUE_INSTANTIATE(dd::ddreal)
@@ -1,8 +1,10 @@
 #include "filter/fpminimax.h"
 #include "filter/conv.h"
 #include "filter/grid.h"
+#include "filter/instrumentation.h"
 #include "filter/plotting.h"
 #include "filter/roots.h"
+#include "filter/scheduler.h"
 #include <chrono>
 #include <cstdlib>
 #include <fplll.h>
@@ -10,6 +12,7 @@
 #include <gmpxx.h>
 #include <sstream>
 #include <iomanip>
+#include <limits>
 #include <random>
 
 typedef Eigen::Matrix<mpfr::mpreal, Eigen::Dynamic, Eigen::Dynamic> MatrixXq;
@@ -78,170 +81,112 @@ void gsOrthogonalization(std::vector<std::vector<mpfr::mpreal>> &v) {
   }
 }
 
+typedef std::pair<mpz_class, mp_exp_t> MantissaExponent;
+
+// decomposes the scaled basis entries basisEntries[j][i] / scalingFactor
+// (with the extra factor 2 of the j > 0 rows folded in the exponent) and
+// updates the smallest exponent seen so far
+void decomposeBasisEntries(
+    std::vector<std::vector<MantissaExponent>> &decomps, mp_exp_t &minExp,
+    std::vector<std::vector<mpfr::mpreal>> &basisEntries,
+    mpfr::mpreal &scalingFactor, std::size_t n) {
+  mpfr::mpreal powBuffer;
+  decomps.resize(n);
+  for (std::size_t j = 0u; j < n; ++j) {
+    decomps[j].resize(basisEntries[j].size());
+    for (std::size_t i = 0u; i < basisEntries[j].size(); ++i) {
+      powBuffer = basisEntries[j][i] / scalingFactor;
+      decomps[j][i] = mpfrDecomp(powBuffer);
+      if (j > 0u)
+        decomps[j][i].second += 1u;
+      if (decomps[j][i].second < minExp)
+        minExp = decomps[j][i].second;
+    }
+  }
+}
+
+void decomposeTarget(std::vector<MantissaExponent> &decomps, mp_exp_t &minExp,
+                     std::vector<mpfr::mpreal> &iT) {
+  decomps.resize(iT.size());
+  for (std::size_t i = 0u; i < iT.size(); ++i) {
+    decomps[i] = mpfrDecomp(iT[i]);
+    if (decomps[i].second < minExp)
+      minExp = decomps[i].second;
+  }
+}
+
+// value = mantissa * 2^(exponent - minExp)
+void scaleToInteger(mpz_t value, MantissaExponent &decomp, mp_exp_t minExp) {
+  mpz_mul_2exp(value, decomp.first.get_mpz_t(),
+               (mp_bitcnt_t)(decomp.second - minExp));
+}
+
+// basisEntries[j][i] contains the value weights[i] * cos(j * nodes[i]) (see
+// QuantizationContext) and the target vector iT is already weighted
 void createFIRBasisType1(fplll::ZZ_mat<mpz_t> &basis,
-                         std::vector<mpfr::mpreal> &nodes,
+                         std::vector<std::vector<mpfr::mpreal>> &basisEntries,
                          std::vector<mpfr::mpreal> &iT,
                          std::vector<mpz_class> &nT,
-                         std::vector<mpfr::mpreal> &weights,
                          mpfr::mpreal &scalingFactor, std::size_t n,
                          mp_prec_t prec) {
   using mpfr::mpreal;
-  mp_prec_t prevPrec = mpreal::get_default_prec();
-  mpreal::set_default_prec(prec);
+  ScopedPrecision guard(prec);
 
   // store the min value for an exponent used to represent
   // in mantissa-exponent form the lattice basis and the
   // vector T to be approximated using the LLL approach
   mp_exp_t minExp = 0;
-  // determine the scaling factor for the basis vectors and
-  // the unknown vector to be approximated by T
-  mpreal powBuffer;
-
-  for (std::size_t i = 0u; i < nodes.size(); ++i) {
-    iT[i] *= weights[i];
-    for (std::size_t j = 0u; j < n; ++j) {
-      powBuffer = weights[i] * mpfr::cos(nodes[i] * j) / scalingFactor;
-      std::pair<mpz_class, mp_exp_t> decomp = mpfrDecomp(powBuffer);
-      if (j > 0u)
-        decomp.second += 1u;
-      else
-        decomp.second += 0u;
-      if (decomp.second < minExp)
-        minExp = decomp.second;
-    }
-  }
-
-  mpfr::mpreal resultBuffer;
-  for (auto &i : iT) {
-    std::pair<mpz_class, mp_exp_t> decomp = mpfrDecomp(i);
-    if (decomp.second < minExp)
-      minExp = decomp.second;
-  }
+  std::vector<std::vector<MantissaExponent>> basisDecomps;
+  std::vector<MantissaExponent> targetDecomps;
+  decomposeBasisEntries(basisDecomps, minExp, basisEntries, scalingFactor, n);
+  decomposeTarget(targetDecomps, minExp, iT);
 
   // scale the basis and vector T
-  basis.resize(n, nodes.size());
-  mpz_t intBuffer;
-  mpz_init(intBuffer);
+  std::size_t nodeCount = basisEntries[0].size();
+  basis.resize(n, nodeCount);
   for (std::size_t i = 0u; i < n; ++i)
-    for (std::size_t j = 0u; j < nodes.size(); ++j) {
-      powBuffer = weights[j] * mpfr::cos(nodes[j] * i) / scalingFactor;
-      std::pair<mpz_class, mp_exp_t> decomp = mpfrDecomp(powBuffer);
-      mp_exp_t nexp = decomp.second - minExp;
-      if (i > 0u)
-        nexp += 1u;
-      else
-        nexp += 0u;
-      mpz_ui_pow_ui(intBuffer, 2u, (unsigned int)nexp);
-      mpz_mul(intBuffer, intBuffer, decomp.first.get_mpz_t());
-      mpz_set(basis(i, j).getData(), intBuffer);
-    }
+    for (std::size_t j = 0u; j < nodeCount; ++j)
+      scaleToInteger(basis(i, j).getData(), basisDecomps[i][j], minExp);
 
-  nT.clear();
-  for (std::size_t i = 0u; i < iT.size(); ++i) {
-    std::pair<mpz_class, mp_exp_t> decomp = mpfrDecomp(iT[i]);
-    mp_exp_t nexp = decomp.second - minExp;
-    mpz_ui_pow_ui(intBuffer, 2u, (unsigned int)nexp);
-    mpz_mul(intBuffer, intBuffer, decomp.first.get_mpz_t());
-    nT.push_back(mpz_class(intBuffer));
-  }
-
-  // clean-up
-  mpz_clear(intBuffer);
-
-  mpreal::set_default_prec(prevPrec);
+  nT.resize(iT.size());
+  for (std::size_t i = 0u; i < iT.size(); ++i)
+    scaleToInteger(nT[i].get_mpz_t(), targetDecomps[i], minExp);
 }
 
 
 void createFIRBasisType1V2(fplll::ZZ_mat<mpz_t> &basis,
-                         std::vector<mpfr::mpreal> &nodes,
+                         std::vector<std::vector<mpfr::mpreal>> &basisEntries,
                          std::vector<mpfr::mpreal> &iT1,
                          std::vector<mpz_class> &nT1,
                          std::vector<mpfr::mpreal> &iT2,
                          std::vector<mpz_class> &nT2,
-                         std::vector<mpfr::mpreal> &weights,
                          mpfr::mpreal &scalingFactor, std::size_t n,
                          mp_prec_t prec) {
   using mpfr::mpreal;
-  mp_prec_t prevPrec = mpreal::get_default_prec();
-  mpreal::set_default_prec(prec);
+  ScopedPrecision guard(prec);
 
-  // store the min value for an exponent used to represent
-  // in mantissa-exponent form the lattice basis and the
-  // vector T to be approximated using the LLL approach
+  // the two targets share the scaling of the lattice basis
   mp_exp_t minExp = 0;
-  // determine the scaling factor for the basis vectors and
-  // the unknown vector to be approximated by T
-  mpreal powBuffer;
-
-  for (std::size_t i = 0u; i < nodes.size(); ++i) {
-    iT1[i] *= weights[i];
-    iT2[i] *= weights[i];
-    for (std::size_t j = 0u; j < n; ++j) {
-      powBuffer = weights[i] * mpfr::cos(nodes[i] * j) / scalingFactor;
-      std::pair<mpz_class, mp_exp_t> decomp = mpfrDecomp(powBuffer);
-      if (j > 0u)
-        decomp.second += 1u;
-      else
-        decomp.second += 0u;
-      if (decomp.second < minExp)
-        minExp = decomp.second;
-    }
-  }
-
-  mpfr::mpreal resultBuffer;
-  for (auto &i : iT1) {
-    std::pair<mpz_class, mp_exp_t> decomp = mpfrDecomp(i);
-    if (decomp.second < minExp)
-      minExp = decomp.second;
-  }
-
-  for (auto &i : iT2) {
-    std::pair<mpz_class, mp_exp_t> decomp = mpfrDecomp(i);
-    if (decomp.second < minExp)
-      minExp = decomp.second;
-  }
-
-
-  // scale the basis and vector T
-  basis.resize(n, nodes.size());
-  mpz_t intBuffer;
-  mpz_init(intBuffer);
+  std::vector<std::vector<MantissaExponent>> basisDecomps;
+  std::vector<MantissaExponent> targetDecomps1;
+  std::vector<MantissaExponent> targetDecomps2;
+  decomposeBasisEntries(basisDecomps, minExp, basisEntries, scalingFactor, n);
+  decomposeTarget(targetDecomps1, minExp, iT1);
+  decomposeTarget(targetDecomps2, minExp, iT2);
+
+  // scale the basis and vectors T1 and T2
+  std::size_t nodeCount = basisEntries[0].size();
+  basis.resize(n, nodeCount);
   for (std::size_t i = 0u; i < n; ++i)
-    for (std::size_t j = 0u; j < nodes.size(); ++j) {
-      powBuffer = weights[j] * mpfr::cos(nodes[j] * i) / scalingFactor;
-      std::pair<mpz_class, mp_exp_t> decomp = mpfrDecomp(powBuffer);
-      mp_exp_t nexp = decomp.second - minExp;
-      if (i > 0u)
-        nexp += 1u;
-      else
-        nexp += 0u;
-      mpz_ui_pow_ui(intBuffer, 2u, (unsigned int)nexp);
-      mpz_mul(intBuffer, intBuffer, decomp.first.get_mpz_t());
-      mpz_set(basis(i, j).getData(), intBuffer);
-    }
+    for (std::size_t j = 0u; j < nodeCount; ++j)
+      scaleToInteger(basis(i, j).getData(), basisDecomps[i][j], minExp);
 
-  nT1.clear();
-  nT2.clear();
+  nT1.resize(iT1.size());
+  nT2.resize(iT2.size());
   for (std::size_t i = 0u; i < iT1.size(); ++i) {
-    std::pair<mpz_class, mp_exp_t> decomp = mpfrDecomp(iT1[i]);
-    mp_exp_t nexp = decomp.second - minExp;
-    mpz_ui_pow_ui(intBuffer, 2u, (unsigned int)nexp);
-    mpz_mul(intBuffer, intBuffer, decomp.first.get_mpz_t());
-    nT1.push_back(mpz_class(intBuffer));
-
-
-    decomp = mpfrDecomp(iT2[i]);
-    nexp = decomp.second - minExp;
-    mpz_ui_pow_ui(intBuffer, 2u, (unsigned int)nexp);
-    mpz_mul(intBuffer, intBuffer, decomp.first.get_mpz_t());
-    nT2.push_back(mpz_class(intBuffer));
-
+    scaleToInteger(nT1[i].get_mpz_t(), targetDecomps1[i], minExp);
+    scaleToInteger(nT2[i].get_mpz_t(), targetDecomps2[i], minExp);
   }
-
-  // clean-up
-  mpz_clear(intBuffer);
-
-  mpreal::set_default_prec(prevPrec);
 }
 
 
@@ -304,27 +249,236 @@ void applyKannanEmbedding(fplll::ZZ_mat<mpz_t> &basis,
   mpz_clear(w);
 }
 
+void initQuantizationContext(QuantizationContext &context,
+                             std::vector<mpfr::mpreal> &freeA,
+                             std::vector<mpfr::mpreal> &fixedA,
+                             std::vector<mpfr::mpreal> &interpolationPoints,
+                             std::vector<Band> &freqBands,
+                             std::vector<mpfr::mpreal> &weights,
+                             mp_prec_t prec) {
+  using mpfr::mpreal;
+  ScopedPrecision guard(prec);
+
+  context.prec = prec;
+  context.freeA = freeA;
+  context.fixedA = fixedA;
+  context.freqBands = freqBands;
+  context.weights = weights;
+
+  {
+    ScopedTimer timer(&context.stats, Phase::GRID_BUILD);
+    generateGrid(context.grid, freeA.size(), freqBands, 16u, prec);
+  }
+  bandConversion(context.chebyBands, freqBands, ConversionDirection::FROMFREQ,
+                 prec);
+
+  std::size_t nodeCount = interpolationPoints.size();
+  context.nodes.resize(nodeCount);
+  context.minimaxValues.resize(nodeCount);
+  context.idealValues.resize(nodeCount);
+  for (std::size_t i = 0u; i < nodeCount; ++i) {
+    mpreal &v = context.nodes[i];
+    v = mpfr::acos(interpolationPoints[i]);
+    evaluateClenshaw(context.minimaxValues[i], freeA, interpolationPoints[i],
+                     prec);
+    // nodes which are numerically on a band edge are moved on it
+    for (std::size_t j{0u}; j < freqBands.size(); ++j) {
+      if (mpfr::abs(v - freqBands[j].stop) < 1e-14)
+        v = freqBands[j].stop;
+      if (mpfr::abs(v - freqBands[j].start) < 1e-14)
+        v = freqBands[j].start;
+    }
+    mpreal buffer;
+    computeIdealResponseAndWeight(context.idealValues[i], buffer, v,
+                                  freqBands);
+    context.minimaxValues[i] *= weights[i];
+    context.idealValues[i] *= weights[i];
+  }
+
+  // the cos(j * nodes[i]) values are generated with the Chebyshev
+  // recurrence, using a few guard bits to absorb the error growth
+  context.basisEntries.resize(freeA.size());
+  for (std::size_t j = 0u; j < freeA.size(); ++j)
+    context.basisEntries[j].resize(nodeCount);
+  mp_prec_t guardPrec = prec + 32ul;
+  for (std::size_t i = 0u; i < nodeCount; ++i) {
+    mpreal c1 = context.nodes[i];
+    c1.setPrecision(guardPrec);
+    c1 = mpfr::cos(c1);
+    mpreal cPrev(1, guardPrec);
+    mpreal cCurr(c1);
+    mpreal cNext(0, guardPrec);
+    for (std::size_t j = 0u; j < freeA.size(); ++j) {
+      if (j == 0u) {
+        context.basisEntries[j][i] = weights[i];
+        continue;
+      }
+      if (j > 1u) {
+        cNext = 2 * c1 * cCurr - cPrev;
+        cPrev = cCurr;
+        cCurr = cNext;
+      }
+      mpreal cj = cCurr;
+      cj.setPrecision(prec);
+      context.basisEntries[j][i] = weights[i] * cj;
+    }
+  }
+}
+
+// rounds the free coefficients to the fixed-point format given by
+// scalingFactor (the fixed coefficients are appended at the end)
+void roundCoefficients(std::vector<mpfr::mpreal> &roundedA,
+                       QuantizationContext &context,
+                       mpfr::mpreal &scalingFactor) {
+  roundedA = context.freeA;
+  for (std::size_t i = 0u; i < roundedA.size(); ++i) {
+    if (i > 0u) {
+      roundedA[i] *= scalingFactor;
+      roundedA[i] >>= 1;
+    } else {
+      roundedA[i] *= scalingFactor;
+      roundedA[i] >>= 0;
+    }
+    roundedA[i] = roundedA[i].toLong(GMP_RNDN);
+    if (i > 0u) {
+      roundedA[i] /= scalingFactor;
+      roundedA[i] <<= 1;
+    } else {
+      roundedA[i] /= scalingFactor;
+      roundedA[i] <<= 0;
+    }
+  }
+
+  for (std::size_t i = 0u; i < context.fixedA.size(); ++i)
+    roundedA.push_back(context.fixedA[i]);
+}
+
+// reduce the lattice basis using the given strategy; the transformation
+// matrix is stored inside u
+int reduceBasis(fplll::ZZ_mat<mpz_t> &basis, fplll::ZZ_mat<mpz_t> &u,
+                ReductionStrategy const &strategy) {
+  fplll::LLLMethod lllMethod;
+  switch (strategy.method) {
+  case ReductionMethod::BKZ: {
+    fplll::BKZParam param;
+    param.b = &basis;
+    param.u = &u;
+    param.blockSize = std::min(strategy.blockSize, basis.GetNumRows());
+    param.delta = strategy.delta;
+    param.flags = fplll::BKZ_DEFAULT;
+    if (strategy.autoAbort)
+      param.flags |= fplll::BKZ_AUTO_ABORT;
+    if (strategy.maxLoops > 0) {
+      param.flags |= fplll::BKZ_MAX_LOOPS;
+      param.maxLoops = strategy.maxLoops;
+    }
+    return fplll::bkzReduction(&basis, &u, param);
+  }
+  case ReductionMethod::LLL_PROVED:
+    lllMethod = fplll::LM_PROVED;
+    break;
+  case ReductionMethod::LLL_FAST:
+    lllMethod = fplll::LM_FAST;
+    break;
+  case ReductionMethod::LLL_HEURISTIC:
+    lllMethod = fplll::LM_HEURISTIC;
+    break;
+  default:
+    lllMethod = fplll::LM_WRAPPER;
+    break;
+  }
+  return fplll::lllReduction(basis, u, strategy.delta, strategy.eta,
+                             lllMethod);
+}
+
+bool babaiNearestPlane(std::vector<mpz_class> &coords,
+                       fplll::ZZ_mat<mpz_t> &basis,
+                       std::vector<mpz_class> &t) {
+  using mpfr::mpreal;
+
+  int rows = basis.GetNumRows();
+  int cols = basis.GetNumCols();
+
+  // the Gram-Schmidt data has to be exact enough to correctly round the
+  // projections of integers of this size
+  std::size_t bits = 0u;
+  for (int i = 0; i < rows; ++i)
+    for (int j = 0; j < cols; ++j)
+      bits = std::max(bits, mpz_sizeinbase(basis(i, j).getData(), 2));
+  for (auto &it : t)
+    bits = std::max(bits, mpz_sizeinbase(it.get_mpz_t(), 2));
+  ScopedPrecision guard((mp_prec_t)(2u * bits + 4u * rows + 64u));
+
+  std::vector<std::vector<mpreal>> b;
+  extractBasisVectors(b, basis, rows, cols);
+  std::vector<std::vector<mpreal>> bStar = b;
+  std::vector<mpreal> bNorms(rows);
+
+  mpreal mu;
+  for (int i = 0; i < rows; ++i) {
+    for (int k = 0; k < i; ++k) {
+      mu = 0;
+      for (int j = 0; j < cols; ++j)
+        mu += bStar[i][j] * bStar[k][j];
+      mu /= bNorms[k];
+      for (int j = 0; j < cols; ++j)
+        bStar[i][j] -= mu * bStar[k][j];
+    }
+    bNorms[i] = 0;
+    for (int j = 0; j < cols; ++j)
+      bNorms[i] += bStar[i][j] * bStar[i][j];
+    if (mpfr::iszero(bNorms[i])) {
+      coords.clear();
+      return false;
+    }
+  }
+
+  std::vector<mpreal> r(cols);
+  for (int j = 0; j < cols; ++j)
+    r[j] = t[j].get_mpz_t();
+
+  coords.resize(rows);
+  mpz_t c;
+  mpz_init(c);
+  for (int i = rows - 1; i >= 0; --i) {
+    mu = 0;
+    for (int j = 0; j < cols; ++j)
+      mu += r[j] * bStar[i][j];
+    mu /= bNorms[i];
+    mpfr_get_z(c, mu.mpfr_srcptr(), GMP_RNDN);
+    coords[i] = mpz_class(c);
+    mu = c;
+    for (int j = 0; j < cols; ++j)
+      r[j] -= mu * b[i][j];
+  }
+  mpz_clear(c);
+  return true;
+}
+
 // TODO
 void fpminimaxKernel(std::vector<double> &lllCoeffs,
-                     std::vector<double> &roundedCoeffs,
-                     std::vector<mpfr::mpreal> &nodes,
                      std::vector<std::vector<double>> &svpCoeffs,
-                     std::vector<mpfr::mpreal> &iT, mpfr::mpreal &scalingFactor,
-                     std::vector<mpfr::mpreal> &weights, std::size_t n,
-                     mp_prec_t prec) {
+                     std::vector<mpfr::mpreal> &iT,
+                     std::vector<std::vector<mpfr::mpreal>> &basisEntries,
+                     mpfr::mpreal &scalingFactor, std::size_t n,
+                     ReductionStrategy const &strategy,
+                     QuantizationStats &stats, mp_prec_t prec) {
   using mpfr::mpreal;
-  mp_prec_t prevPrec = mpreal::get_default_prec();
-  mpreal::set_default_prec(prec);
+  ScopedPrecision guard(prec);
 
   std::vector<mpz_class> nT(iT.size());
   fplll::ZZ_mat<mpz_t> basis;
-  createFIRBasisType1(basis, nodes, iT, nT, weights, scalingFactor, n, prec);
-  applyKannanEmbedding(basis, nT);
+  {
+    ScopedTimer timer(&stats, Phase::BASIS_BUILD);
+    createFIRBasisType1(basis, basisEntries, iT, nT, scalingFactor, n, prec);
+    applyKannanEmbedding(basis, nT);
+  }
   fplll::ZZ_mat<mpz_t> u(basis.GetNumRows(), basis.GetNumCols());
 
-  fplll::lllReduction(basis, u, 0.99, 0.51);
-  // Uncomment the next line and comment the next one for BKZ or HKZ reduction
-  //fplll::bkzReduction(basis, u, 8u);
+  {
+    ScopedTimer timer(&stats, Phase::REDUCTION);
+    reduceBasis(basis, u, strategy);
+  }
 
   std::vector<mpz_class> intLLLCoeffs;
   std::vector<std::vector<mpz_class>> intSVPCoeffs(n);
@@ -354,7 +508,7 @@ void fpminimaxKernel(std::vector<double> &lllCoeffs,
     }
     break;
   default:
-    std::cout << "Failed to generate the polynomial approximation\n";
+    recordMessage("Failed to generate the polynomial approximation");
     break;
   }
   mpz_clear(coeffAux);
@@ -375,38 +529,40 @@ void fpminimaxKernel(std::vector<double> &lllCoeffs,
         svpCoeffs[j].push_back(buffer * 1);
     }
   }
-
-  mpreal::set_default_prec(prevPrec);
 }
 
 
 
 void fpminimaxKernelV2(std::vector<double> &lllCoeffs1,
                      std::vector<double> &lllCoeffs2,
-                     std::vector<double> &roundedCoeffs,
-                     std::vector<mpfr::mpreal> &nodes,
                      std::vector<std::vector<double>> &svpCoeffs,
                      std::vector<mpfr::mpreal> &iT1,
                      std::vector<mpfr::mpreal> &iT2,
-                     mpfr::mpreal &scalingFactor,
-                     std::vector<mpfr::mpreal> &weights, std::size_t n,
-                     mp_prec_t prec) {
+                     std::vector<std::vector<mpfr::mpreal>> &basisEntries,
+                     mpfr::mpreal &scalingFactor, std::size_t n,
+                     ReductionStrategy const &strategy,
+                     QuantizationStats &stats, mp_prec_t prec) {
   using mpfr::mpreal;
-  mp_prec_t prevPrec = mpreal::get_default_prec();
-  mpreal::set_default_prec(prec);
+  ScopedPrecision guard(prec);
 
   std::vector<mpz_class> nT1(iT1.size());
   std::vector<mpz_class> nT2(iT2.size());
 
   fplll::ZZ_mat<mpz_t> basis;
   fplll::ZZ_mat<mpz_t> origBasis;
-  createFIRBasisType1V2(basis, nodes, iT1, nT1, iT2, nT2, weights, scalingFactor, n, prec);
-  applyKannanEmbedding(basis, nT1);
+  {
+    ScopedTimer timer(&stats, Phase::BASIS_BUILD);
+    createFIRBasisType1V2(basis, basisEntries, iT1, nT1, iT2, nT2,
+                          scalingFactor, n, prec);
+    applyKannanEmbedding(basis, nT1);
+  }
   fplll::ZZ_mat<mpz_t> u(basis.GetNumRows(), basis.GetNumCols());
 
 
-  fplll::lllReduction(basis, u, 0.99, 0.51);
-  //fplll::bkzReduction(basis, u, 8u);
+  {
+    ScopedTimer timer(&stats, Phase::REDUCTION);
+    reduceBasis(basis, u, strategy);
+  }
 
   mpz_t maxValue;
   mpz_t iter;
@@ -439,7 +595,6 @@ void fpminimaxKernelV2(std::vector<double> &lllCoeffs1,
     for (int i{0}; i < u.GetNumCols() - 1; ++i) {
       mpz_neg(coeffAux, u.Get(u.GetNumRows() - 1, i).GetData());
       intLLLCoeffs1.push_back(mpz_class(coeffAux));
-      //std::cout << mpz_class(coeffAux) << std::endl;
       for (int j{0}; j < (int)n; ++j) {
         mpz_set(coeffAux, u.Get(j, i).GetData());
         intSVPCoeffs[j].push_back(mpz_class(coeffAux));
@@ -450,7 +605,6 @@ void fpminimaxKernelV2(std::vector<double> &lllCoeffs1,
     for (int i = 0; i < u.GetNumCols() - 1; ++i) {
       intLLLCoeffs1.push_back(mpz_class(u.Get(u.GetNumRows() - 1, i).GetData()));
 
-      //std::cout << mpz_class(coeffAux) << std::endl;
       for (int j = 0; j < (int)n; ++j) {
         mpz_set(coeffAux, u.Get(j, i).GetData());
         intSVPCoeffs[j].push_back(mpz_class(coeffAux));
@@ -459,7 +613,7 @@ void fpminimaxKernelV2(std::vector<double> &lllCoeffs1,
     }
     break;
   default:
-    std::cout << "Failed to generate the polynomial approximation\n";
+    recordMessage("Failed to generate the polynomial approximation");
     break;
   }
 
@@ -487,31 +641,38 @@ void fpminimaxKernelV2(std::vector<double> &lllCoeffs1,
       for(std::size_t j{0u}; j < basis2.GetNumCols(); ++j)
         mpz_set(basis2(i, j).getData(), basis(i, j).getData());
 
-  std::vector<mpz_class> intLLLCoeffs2;
-
-  applyKannanEmbedding(basis2, nT2);
-  fplll::ZZ_mat<mpz_t> u2(basis2.GetNumRows(), basis2.GetNumCols());
-
-  fplll::lllReduction(basis2, u2, 0.99, 0.51);
-  //fplll::bkzReduction(basis2, u2, 8u);
-
-
-  int xdp2 =
-      (int)mpz_get_si(u2.Get(u2.GetNumRows() - 1, u2.GetNumCols() - 1).GetData());
-
+  // the second target is embedded and the basis reduced again, unless the
+  // strategy asks for a nearest plane rounding on basis2 (which is usually
+  // reduced already, but whose rows can be dependent)
+  std::vector<mpz_class> coords2;
+  {
+    ScopedTimer timer(&stats, Phase::REDUCTION);
+    if (!strategy.nearestPlane || !babaiNearestPlane(coords2, basis2, nT2)) {
+      int dim2 = basis2.GetNumRows();
+      applyKannanEmbedding(basis2, nT2);
+      fplll::ZZ_mat<mpz_t> u2(basis2.GetNumRows(), basis2.GetNumCols());
+      reduceBasis(basis2, u2, strategy);
+      int xdp2 = (int)mpz_get_si(
+          u2.Get(u2.GetNumRows() - 1, u2.GetNumCols() - 1).GetData());
+      for (int j{0}; j < dim2; ++j) {
+        mpz_set(coeffAux, u2.Get(u2.GetNumRows() - 1, j).GetData());
+        if (xdp2 == 1)
+          mpz_neg(coeffAux, coeffAux);
+        coords2.push_back(mpz_class(coeffAux));
+      }
+    }
+  }
 
+  std::vector<mpz_class> intLLLCoeffs2;
   mpz_t coeffBuffer;
   mpz_init(coeffBuffer);
   for(std::size_t i{0u}; i < intLLLCoeffs1.size(); ++i)
   {
     mpz_set_ui(coeffBuffer, 0u);
-    for(std::size_t j{0u}; j < intLLLCoeffs1.size(); ++j) {
-        mpz_addmul(coeffBuffer, u2.Get(u2.GetNumRows() - 1u, j).GetData(), u.Get(j, i).GetData());
+    for(std::size_t j{0u}; j < coords2.size(); ++j) {
+        mpz_addmul(coeffBuffer, coords2[j].get_mpz_t(), u.Get(j, i).GetData());
     }
-    if(xdp2 == 1)
-        mpz_neg(coeffBuffer, coeffBuffer);
-        intLLLCoeffs2.push_back(mpz_class(coeffBuffer));
-    //std::cout << mpz_class(coeffBuffer) << std::endl;
+    intLLLCoeffs2.push_back(mpz_class(coeffBuffer));
   }
   for (std::size_t i = 0u; i < intLLLCoeffs2.size(); ++i) {
     mpreal newCoeff;
@@ -524,7 +685,6 @@ void fpminimaxKernelV2(std::vector<double> &lllCoeffs1,
 
   mpz_clear(coeffAux);
   mpz_clear(coeffBuffer);
-  mpreal::set_default_prec(prevPrec);
 }
 
 
@@ -532,62 +692,373 @@ void fpminimaxKernelV2(std::vector<double> &lllCoeffs1,
 
 
 
-void fpminimaxWithNeighborhoodSearchDiscrete(
-    mpfr::mpreal &minError, std::vector<mpfr::mpreal> &lllFreeA,
-    std::vector<mpfr::mpreal> &freeA, std::vector<mpfr::mpreal> &fixedA,
-    std::vector<mpfr::mpreal> &interpolationPoints,
-    std::vector<Band> &freqBands, std::vector<mpfr::mpreal> &weights,
-    mpfr::mpreal &scalingFactor, mp_prec_t prec) {
-  using namespace mpfr;
-  mpreal::set_default_prec(prec);
-
-  std::vector<GridPoint> grid;
-  generateGrid(grid, freeA.size(), freqBands, 16u, prec);
-
-  std::vector<Band> chebyBands;
-  bandConversion(chebyBands, freqBands, ConversionDirection::FROMFREQ, prec);
-
-  std::vector<mpfr::mpreal> v(interpolationPoints.size());
-  std::vector<mpfr::mpreal> fv(interpolationPoints.size());
-  std::vector<mpfr::mpreal> idealV(interpolationPoints.size());
-  for (std::size_t i = 0u; i < interpolationPoints.size(); ++i) {
-    v[i] = mpfr::acos(interpolationPoints[i]);
-    evaluateClenshaw(fv[i], freeA, interpolationPoints[i], prec);
-    mpfr::mpreal buffer;
-    for(std::size_t j{0u}; j < freqBands.size(); ++j) {
-        if (mpfr::abs(v[i] - freqBands[j].stop) < 1e-14)
-            v[i] = freqBands[j].stop;
-        if (mpfr::abs(v[i] - freqBands[j].start) < 1e-14)
-            v[i] = freqBands[j].start;
+// computes the norm of a on the grid of the context (adaptively if the
+// context asks for it), accounting for it in the statistics
+void countedNorm(QuantizationStats &stats, double &norm,
+                 std::vector<double> &bandNorms, QuantizationContext &context,
+                 std::vector<double> &a) {
+  recordCount(&stats, Counter::NORM_EVALUATIONS);
+  if (context.adaptiveNorm)
+    computeAdaptiveNorm(norm, bandNorms, context.grid, a, context.norm);
+  else
+    computeDenseNorm(norm, bandNorms, context.grid, a);
+}
+
+// a vicinity search move: the candidate coefficients are given by
+// a + direction1 * svp[index1] + direction2 * svp[index2]
+struct NeighborhoodMove {
+  std::size_t index1;
+  std::size_t index2;
+  int direction1;
+  int direction2;
+};
+
+// enumerate all the moves with index1 < index1Count, index1 < index2 <
+// index2Count and directions in {-1, 0, 1}
+void generateNeighborhoodMoves(std::vector<NeighborhoodMove> &moves,
+                               std::size_t index1Count,
+                               std::size_t index2Count) {
+  moves.clear();
+  index1Count = std::min(index1Count, index2Count);
+  for (std::size_t index1 = 0u; index1 < index1Count; ++index1)
+    for (std::size_t index2 = index1 + 1u; index2 < index2Count; ++index2)
+      for (int direction1 = -1; direction1 < 2; ++direction1)
+        for (int direction2 = -1; direction2 < 2; ++direction2)
+          moves.push_back({index1, index2, direction1, direction2});
+}
+
+void applyNeighborhoodMove(std::vector<double> &candidateA,
+                           std::vector<double> &baseA,
+                           std::vector<std::vector<double>> &svpVectors,
+                           NeighborhoodMove &move) {
+  std::vector<double> &svp1 = svpVectors[move.index1];
+  std::vector<double> &svp2 = svpVectors[move.index2];
+  for (std::size_t i{0u}; i < svp1.size(); ++i)
+    candidateA[i] = baseA[i] + svp1[i] * move.direction1 +
+                    svp2[i] * move.direction2;
+}
+
+// number of consecutive moves evaluated by a task of neighborhoodSearch
+static const std::size_t neighborhoodChunkSize = 16u;
+
+// Evaluates the candidates described by moves around baseA (whose trailing
+// entries, if any, are the fixed coefficients) and stores the best one inside
+// bestA if its discrete norm is strictly smaller than the value of bestNorm
+// on entry. Since the candidates are linear combinations of baseA and of the
+// SVP vectors, the error of baseA and the responses of the SVP vectors are
+// tabulated once on the grid (svpResponses is computed by the caller with
+// computeGridResponse) and each candidate is then scored without any
+// polynomial evaluation. The candidate space is split into chunks which are
+// evaluated in parallel with parallelTasks (so a search done inside
+// quantizeBatch or quantizeSweep uses the threads of their pool) and the
+// evaluation of a candidate is abandoned as soon as its error goes above
+// the best norm found so far. In case of ties the first move in the list is
+// kept.
+bool neighborhoodSearch(double &bestNorm, std::vector<double> &bestA,
+                        std::vector<double> &bestBandNorms,
+                        std::vector<double> &baseA,
+                        std::vector<std::vector<double>> &svpVectors,
+                        GridResponse &svpResponses,
+                        std::vector<NeighborhoodMove> &moves,
+                        std::vector<Band> &chebyBands,
+                        QuantizationContext &context,
+                        QuantizationStats &stats) {
+  Grid &grid = context.grid;
+  recordCount(&stats, Counter::CANDIDATES, moves.size());
+  std::vector<double> baseError;
+  computeGridError(baseError, grid, baseA);
+
+  // the moves are split into chunks evaluated by parallelTasks (i.e. by
+  // the threads of the enclosing batch or sweep, if any), each chunk
+  // keeping its best candidate; the bound used to abandon the evaluations
+  // is shared between the chunks
+  const double initialNorm = bestNorm;
+  double bound = bestNorm;
+  std::size_t chunks =
+      (moves.size() + neighborhoodChunkSize - 1u) / neighborhoodChunkSize;
+  std::vector<double> chunkNorms(chunks, initialNorm);
+  std::vector<std::size_t> chunkIndices(chunks, moves.size());
+
+  parallelTasks(chunks, [&](std::size_t chunk) {
+    double localNorm = initialNorm;
+    std::size_t localIndex = moves.size();
+    std::size_t last =
+        std::min(moves.size(), (chunk + 1u) * neighborhoodChunkSize);
+    for (std::size_t k = chunk * neighborhoodChunkSize; k < last; ++k) {
+      double currentBound;
+#pragma omp atomic read
+      currentBound = bound;
+      double bufferNorm;
+      if (!computeCombinationNorm(bufferNorm, baseError, svpResponses,
+                                  moves[k].index1, moves[k].direction1,
+                                  moves[k].index2, moves[k].direction2,
+                                  currentBound))
+        continue;
+      if (bufferNorm < localNorm) {
+        localNorm = bufferNorm;
+        localIndex = k;
+      }
+      if (bufferNorm < currentBound) {
+#pragma omp critical(neighborhoodBound)
+        {
+          if (bufferNorm < bound) {
+#pragma omp atomic write
+            bound = bufferNorm;
+          }
+        }
+      }
+    }
+    chunkNorms[chunk] = localNorm;
+    chunkIndices[chunk] = localIndex;
+  });
+
+  // the chunks are reduced in order, so the first of the best moves is kept
+  double globalNorm = initialNorm;
+  std::size_t globalIndex = moves.size();
+  for (std::size_t chunk = 0u; chunk < chunks; ++chunk)
+    if (chunkIndices[chunk] < moves.size() && chunkNorms[chunk] < globalNorm) {
+      globalNorm = chunkNorms[chunk];
+      globalIndex = chunkIndices[chunk];
     }
 
-    computeIdealResponseAndWeight(idealV[i], buffer, v[i],
-            freqBands);
+  if (globalIndex == moves.size())
+    return false;
+
+  // the final value is computed directly from the coefficients, since the
+  // tabulated error can differ from it in the last bits
+  std::vector<double> candidateA = baseA;
+  applyNeighborhoodMove(candidateA, baseA, svpVectors, moves[globalIndex]);
+  std::vector<double> candidateBandNorms(chebyBands.size());
+  double candidateNorm;
+  countedNorm(stats, candidateNorm, candidateBandNorms, context, candidateA);
+  if (candidateNorm >= bestNorm)
+    return false;
+
+  bestNorm = candidateNorm;
+  bestA = candidateA;
+  bestBandNorms = candidateBandNorms;
+  return true;
+}
+
+// the state shared by the tasks of a branch-and-bound search
+struct BranchAndBound {
+  Grid *grid;
+  GridResponse *responses;
+  std::size_t count;        // number of SVP vectors which are combined
+  int radius;
+  // slack[d][i] bounds the weighted response at the i-th grid point of any
+  // combination of the SVP vectors d, d + 1, ..., count - 1
+  std::vector<std::vector<double>> slack;
+  std::size_t maxNodes;
+  bool timed;
+  std::chrono::steady_clock::time_point deadline;
+  double incumbent;         // the best tabulated norm found so far
+  std::vector<int> best;    // and its coordinates
+  bool found;
+  std::size_t nodes;
+  bool stopped;
+};
+
+// the coordinate values are tried in the order 0, -1, 1, -2, 2, ...
+static int branchValue(int step) {
+  return (step % 2) ? -(step + 1) / 2 : step / 2;
+}
+
+// Computes, band by band, the norm of the error of the current candidate
+// and a lower bound of the norm for all the candidates of its subtree. The
+// computation is abandoned (and false returned) as soon as the bound
+// reaches the incumbent; since the bound is below the error at every
+// point, the norm is then at least the incumbent as well.
+static bool boundNode(double &norm, BranchAndBound &bb, const double *error,
+                      std::size_t depth, double incumbent) {
+  const double *slack = bb.slack[depth].data();
+  std::vector<std::size_t> &offsets = bb.grid->bandOffsets;
+  norm = 0;
+  for (std::size_t k = 0u; k + 1u < offsets.size(); ++k) {
+    double bandMax = 0;
+    double bandBound = 0;
+    for (std::size_t i = offsets[k]; i < offsets[k + 1u]; ++i) {
+      double value = fabs(error[i]);
+      bandMax = std::max(bandMax, value);
+      bandBound = std::max(bandBound, value - slack[i]);
+    }
+    norm = std::max(norm, bandMax);
+    if (bandBound >= incumbent)
+      return false;
   }
+  return true;
+}
 
-  std::vector<double> freeADouble(freeA.size());
-  std::vector<mpfr::mpreal> roundedA = freeA;
-  for (std::size_t i = 0u; i < freeA.size(); ++i) {
-    freeADouble[i] = freeA[i].toDouble();
-    if (i > 0u) {
-      roundedA[i] *= scalingFactor;
-      roundedA[i] >>= 1;
-    } else {
-      roundedA[i] *= scalingFactor;
-      roundedA[i] >>= 0;
+// Depth-first exploration of the subtree of the candidate whose first depth
+// coordinates are given by coords (the other ones being zero). errors holds
+// one buffer per level for the weighted errors of the children. A candidate
+// is only evaluated at the node where its last nonzero coordinate is set.
+static void branch(BranchAndBound &bb, std::vector<int> &coords,
+                   std::vector<std::vector<double>> &errors,
+                   const double *error, std::size_t depth, bool evaluate) {
+  bool stopped;
+#pragma omp atomic read
+  stopped = bb.stopped;
+  if (stopped)
+    return;
+  std::size_t nodes;
+#pragma omp atomic capture
+  nodes = ++bb.nodes;
+  if ((bb.maxNodes && nodes > bb.maxNodes) ||
+      (bb.timed && nodes % 256u == 0u &&
+       std::chrono::steady_clock::now() > bb.deadline)) {
+#pragma omp atomic write
+    bb.stopped = true;
+    return;
+  }
+
+  double incumbent;
+#pragma omp atomic read
+  incumbent = bb.incumbent;
+  double norm;
+  bool keep = boundNode(norm, bb, error, depth, incumbent);
+  if (evaluate && norm < incumbent) {
+#pragma omp critical(branchAndBoundIncumbent)
+    {
+      if (norm < bb.incumbent) {
+#pragma omp atomic write
+        bb.incumbent = norm;
+        bb.best = coords;
+        bb.found = true;
+      }
     }
-    roundedA[i] = roundedA[i].toLong(GMP_RNDN);
-    if (i > 0u) {
-      roundedA[i] /= scalingFactor;
-      roundedA[i] <<= 1;
+  }
+  if (!keep || depth == bb.count)
+    return;
+
+  std::size_t points = bb.responses->points;
+  const double *r = bb.responses->values.data() + depth * points;
+  double *child = errors[depth + 1u].data();
+  for (int step = 0; step <= 2 * bb.radius; ++step) {
+    int value = branchValue(step);
+    coords[depth] = value;
+    if (value == 0) {
+      branch(bb, coords, errors, error, depth + 1u, false);
     } else {
-      roundedA[i] /= scalingFactor;
-      roundedA[i] <<= 0;
+      for (std::size_t i = 0u; i < points; ++i)
+        child[i] = error[i] - value * r[i];
+      branch(bb, coords, errors, child, depth + 1u, true);
     }
   }
+  coords[depth] = 0;
+}
 
-  for (std::size_t i = 0u; i < fixedA.size(); ++i)
-    roundedA.push_back(fixedA[i]);
+// Searches the best candidate baseA + sum c_k * svpVectors[k], with
+// k < options.vectors and |c_k| <= options.radius, by branch-and-bound over
+// the coordinates c_k. The candidates are scored from the tabulated
+// responses of the SVP vectors (svpResponses, see computeGridResponse), the
+// first two coordinates are used to split the tree into independent tasks
+// and all the tasks share the incumbent, which starts at bestNorm. The
+// search stops early once the node or time budget is exhausted. If a
+// candidate with a discrete norm strictly smaller than bestNorm is found,
+// it is stored inside bestA and true is returned.
+bool branchAndBoundSearch(double &bestNorm, std::vector<double> &bestA,
+                          std::vector<double> &bestBandNorms,
+                          std::vector<double> &baseA,
+                          std::vector<std::vector<double>> &svpVectors,
+                          GridResponse &svpResponses,
+                          BranchAndBoundOptions const &options,
+                          std::vector<Band> &chebyBands,
+                          QuantizationContext &context,
+                          QuantizationStats &stats) {
+  Grid &grid = context.grid;
+  std::size_t points = svpResponses.points;
+  BranchAndBound bb;
+  bb.grid = &grid;
+  bb.responses = &svpResponses;
+  bb.count = std::min(options.vectors, svpResponses.count);
+  bb.radius = std::max(options.radius, 0);
+  bb.maxNodes = options.maxNodes;
+  bb.timed = options.maxTime > 0.0;
+  bb.deadline = std::chrono::steady_clock::now() +
+                std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    std::chrono::duration<double, std::milli>(options.maxTime));
+  bb.incumbent = bestNorm;
+  bb.found = false;
+  bb.nodes = 0u;
+  bb.stopped = false;
+  if (bb.count == 0u || bb.radius == 0)
+    return false;
+
+  bb.slack.assign(bb.count + 1u, std::vector<double>(points, 0.0));
+  for (std::size_t d = bb.count; d-- > 0u;) {
+    const double *r = svpResponses.values.data() + d * points;
+    for (std::size_t i = 0u; i < points; ++i)
+      bb.slack[d][i] = bb.slack[d + 1u][i] + bb.radius * fabs(r[i]);
+  }
+
+  std::vector<double> baseError;
+  computeGridError(baseError, grid, baseA);
+
+  std::size_t prefix = std::min(bb.count, (std::size_t)2u);
+  std::size_t width = 2u * bb.radius + 1u;
+  std::size_t taskCount = 1u;
+  for (std::size_t d = 0u; d < prefix; ++d)
+    taskCount *= width;
+  parallelTasks(taskCount, [&](std::size_t task) {
+    std::vector<int> coords(bb.count, 0);
+    std::vector<std::vector<double>> errors(bb.count + 1u,
+                                            std::vector<double>(points));
+    std::vector<double> &error = errors[prefix];
+    error = baseError;
+    bool evaluate = false;
+    for (std::size_t d = 0u; d < prefix; ++d, task /= width) {
+      coords[d] = branchValue(task % width);
+      if (coords[d] == 0)
+        continue;
+      evaluate = true;
+      const double *r = svpResponses.values.data() + d * points;
+      for (std::size_t i = 0u; i < points; ++i)
+        error[i] -= coords[d] * r[i];
+    }
+    branch(bb, coords, errors, error.data(), prefix, evaluate);
+  });
+  recordCount(&stats, Counter::SEARCH_NODES, bb.nodes);
+  if (bb.stopped)
+    recordMessage("branch-and-bound search stopped by its budget");
+  if (!bb.found)
+    return false;
+
+  // the final value is computed directly from the coefficients, since the
+  // tabulated error can differ from it in the last bits
+  std::vector<double> candidateA = baseA;
+  for (std::size_t k = 0u; k < bb.count; ++k)
+    for (std::size_t i = 0u; i < svpVectors[k].size(); ++i)
+      candidateA[i] += bb.best[k] * svpVectors[k][i];
+  std::vector<double> candidateBandNorms(chebyBands.size());
+  double candidateNorm;
+  countedNorm(stats, candidateNorm, candidateBandNorms, context, candidateA);
+  if (candidateNorm >= bestNorm)
+    return false;
+
+  bestNorm = candidateNorm;
+  bestA = candidateA;
+  bestBandNorms = candidateBandNorms;
+  return true;
+}
+
+void fpminimaxWithNeighborhoodSearchDiscrete(
+    QuantizationResult &result, QuantizationContext &context,
+    mpfr::mpreal &scalingFactor) {
+  using namespace mpfr;
+  mp_prec_t prec = context.prec;
+  ScopedPrecision guard(prec);
+
+  std::vector<mpfr::mpreal> &freeA = context.freeA;
+  std::vector<mpfr::mpreal> &fixedA = context.fixedA;
+  std::vector<Band> &chebyBands = context.chebyBands;
+  Grid &grid = context.grid;
+  std::vector<mpfr::mpreal> &lllFreeA = result.coefficients;
+  result.scalingFactor = scalingFactor;
+  result.bits = mpfr::round(mpfr::log2(scalingFactor)).toLong();
+
+  std::vector<mpfr::mpreal> roundedA;
+  roundCoefficients(roundedA, context, scalingFactor);
 
   std::vector<double> doubleA(roundedA.size());
   for (std::size_t i = 0u; i < roundedA.size(); ++i)
@@ -596,19 +1067,16 @@ void fpminimaxWithNeighborhoodSearchDiscrete(
 
   double naiveNorm;
   std::vector<double> bandNorms(chebyBands.size());
-  computeDenseNorm(naiveNorm, bandNorms, chebyBands, grid, doubleA);
-  std::cout << "Naive rounding error\t= " << naiveNorm << std::endl;
+  countedNorm(result.stats, naiveNorm, bandNorms, context, doubleA);
+  result.naiveError = naiveNorm;
 
   std::vector<std::vector<double>> svpVectors(freeA.size());
   std::vector<std::vector<mpfr::mpreal>> mpSVPVectors(freeA.size());
   std::vector<double> lllA1(freeA.size());
   std::vector<double> lllA2(freeA.size());
-  auto start = std::chrono::steady_clock::now();
-  fpminimaxKernelV2(lllA1, lllA2, freeADouble, v, svpVectors, fv, idealV, scalingFactor, weights,
-                  freeA.size(), prec);
-  auto stop = std::chrono::steady_clock::now();
-  auto diff = stop - start;
-  std::cout << "\nReduction = " << std::chrono::duration<double,std::milli>(diff).count() << " ms\n";
+  fpminimaxKernelV2(lllA1, lllA2, svpVectors, context.minimaxValues,
+                    context.idealValues, context.basisEntries, scalingFactor,
+                    freeA.size(), context.reduction, result.stats, prec);
 
   for (std::size_t i = 0u; i < svpVectors.size(); ++i) {
     mpSVPVectors[i].resize(svpVectors[i].size());
@@ -629,13 +1097,11 @@ void fpminimaxWithNeighborhoodSearchDiscrete(
   for (std::size_t i = 0u; i < fixedA.size(); ++i)
     mpLLLA1.push_back(fixedA[i]);
 
-  start = std::chrono::steady_clock::now();
+  auto start = std::chrono::steady_clock::now();
 
   double lllNorm;
-  computeDenseNorm(lllNorm, bandNorms, chebyBands, grid, lllA1);
-  std::cout << "LLL initial error\t= " << lllNorm << std::endl;
-  for (std::size_t k{0u}; k < bandNorms.size(); ++k)
-    std::cout << "Band " << k << " error = " << bandNorms[k] << std::endl;
+  countedNorm(result.stats, lllNorm, bandNorms, context, lllA1);
+  result.lllError = lllNorm;
 
 
   double lllBestNorm;
@@ -647,31 +1113,21 @@ void fpminimaxWithNeighborhoodSearchDiscrete(
   for (std::size_t i = 0u; i < lllA1.size(); ++i)
     mpFinalA1[i] = lllA1[i];
   std::vector<mpfr::mpreal> initialLLL1 = mpLLLA1;
-  std::vector<double> searchBandNorms(chebyBands.size());
 
+  std::vector<NeighborhoodMove> moves;
+  generateNeighborhoodMoves(moves, 9u, svpVectors.size());
+  GridResponse svpResponses;
+  computeGridResponse(svpResponses, grid, svpVectors);
 
-  for (std::size_t index1 = 0u; index1 < 9; ++index1)
-    for (std::size_t index2 = index1 + 1u; index2 < mpLLLA1.size(); ++index2)
-      for (int direction1 = -1; direction1 < 2; ++direction1)
-        for (int direction2 = -1; direction2 < 2; ++direction2)
-        {
-          for (std::size_t i{0u}; i < freeA.size(); ++i) {
-            double vA = lllA1[i] + svpVectors[index1][i] * direction1 +
-                        svpVectors[index2][i] *
-                            direction2;
-            mpBufferA[i] = vA;
-            doubleA[i] = vA;
-          }
-          double bufferNorm;
-          computeDenseNorm(bufferNorm, searchBandNorms, chebyBands, grid, doubleA);
-
-          if (bufferNorm < lllNorm) {
-            lllNorm = bufferNorm;
-            bandNorms = searchBandNorms;
-            mpFinalA1 = mpBufferA;
-          }
-        }
-
+  std::vector<double> baseA = doubleA;
+  for (std::size_t i = 0u; i < lllA1.size(); ++i)
+    baseA[i] = lllA1[i];
+  std::vector<double> searchA;
+  if (neighborhoodSearch(lllNorm, searchA, bandNorms, baseA, svpVectors,
+                         svpResponses, moves, chebyBands, context,
+                         result.stats))
+    for (std::size_t i = 0u; i < lllA1.size(); ++i)
+      mpFinalA1[i] = searchA[i];
 
 
   lllFreeA.resize(freeA.size());
@@ -711,11 +1167,11 @@ void fpminimaxWithNeighborhoodSearchDiscrete(
     doubleA[i] = mpLLLA1[i].toDouble();
 
   double lllNorm1;
-  computeDenseNorm(lllNorm1, bandNorms, chebyBands, grid, doubleA);
-  std::cout << "LLL final error\t= " << lllNorm << std::endl;
-  stop = std::chrono::steady_clock::now();
-  diff = stop - start;
-  std::cout << "\nVicinity search = " << std::chrono::duration<double,std::milli>(diff).count() << " ms\n";
+  countedNorm(result.stats, lllNorm1, bandNorms, context, doubleA);
+  auto stop = std::chrono::steady_clock::now();
+  auto diff = stop - start;
+  recordPhase(&result.stats, Phase::NEIGHBORHOOD_SEARCH,
+              std::chrono::duration<double, std::milli>(diff).count());
 
 
   // using ideal
@@ -731,10 +1187,8 @@ void fpminimaxWithNeighborhoodSearchDiscrete(
 
   start = std::chrono::steady_clock::now();
 
-  computeDenseNorm(lllNorm, bandNorms, chebyBands, grid, lllA2);
-  std::cout << "LLL initial error\t= " << lllNorm << std::endl;
-  for (std::size_t k{0u}; k < bandNorms.size(); ++k)
-    std::cout << "Band " << k << " error = " << bandNorms[k] << std::endl;
+  countedNorm(result.stats, lllNorm, bandNorms, context, lllA2);
+  result.lllError = std::min(result.lllError, lllNorm);
 
 
   std::vector<mpfr::mpreal> mpFinalA2;
@@ -745,32 +1199,13 @@ void fpminimaxWithNeighborhoodSearchDiscrete(
     mpFinalA2[i] = lllA2[i];
   std::vector<mpfr::mpreal> initialLLL2 = mpLLLA2;
 
-
-
-  for (std::size_t index1 = 0u; index1 < 9; ++index1)
-    for (std::size_t index2 = index1 + 1u; index2 < mpLLLA1.size(); ++index2)
-
-      for (int direction1 = -1; direction1 < 2; ++direction1)
-        for (int direction2 = -1; direction2 < 2; ++direction2)
-
-        {
-          for (std::size_t i{0u}; i < freeA.size(); ++i) {
-            double vA = lllA2[i] + svpVectors[index1][i] * direction1 +
-                        svpVectors[index2][i] *
-                            direction2;
-            mpBufferA[i] = vA;
-            doubleA[i] = vA;
-          }
-          double bufferNorm;
-          computeDenseNorm(bufferNorm, searchBandNorms, chebyBands, grid, doubleA);
-
-          if (bufferNorm < lllNorm) {
-            lllNorm = bufferNorm;
-            bandNorms = searchBandNorms;
-            mpFinalA2 = mpBufferA;
-          }
-        }
-
+  for (std::size_t i = 0u; i < lllA2.size(); ++i)
+    baseA[i] = lllA2[i];
+  if (neighborhoodSearch(lllNorm, searchA, bandNorms, baseA, svpVectors,
+                         svpResponses, moves, chebyBands, context,
+                         result.stats))
+    for (std::size_t i = 0u; i < lllA2.size(); ++i)
+      mpFinalA2[i] = searchA[i];
 
 
 
@@ -803,7 +1238,8 @@ void fpminimaxWithNeighborhoodSearchDiscrete(
   }
   stop = std::chrono::steady_clock::now();
   diff = stop - start;
-  std::cout << "\nVicinity search = " << std::chrono::duration<double,std::milli>(diff).count() << " ms\n";
+  recordPhase(&result.stats, Phase::NEIGHBORHOOD_SEARCH,
+              std::chrono::duration<double, std::milli>(diff).count());
 
 
   double bestNorm = lllNorm1;
@@ -813,8 +1249,7 @@ void fpminimaxWithNeighborhoodSearchDiscrete(
     doubleA[i] = mpLLLA2[i].toDouble();
 
   double lllNorm2;
-  computeDenseNorm(lllNorm2, bandNorms, chebyBands, grid, doubleA);
-  std::cout << "LLL final error\t= " << lllNorm << std::endl;
+  countedNorm(result.stats, lllNorm2, bandNorms, context, doubleA);
 
   if(lllNorm2 < lllNorm1)
   {
@@ -825,66 +1260,91 @@ void fpminimaxWithNeighborhoodSearchDiscrete(
       for (std::size_t i = 0u; i < freeA.size(); ++i)
         lllFreeA[i] = mpFinalA2[i];
   }
+  result.finalError = bestNorm;
 
 }
 
 
-void fpminimaxWithNeighborhoodSearchDiscreteRand(
-    mpfr::mpreal &minError, std::vector<mpfr::mpreal> &lllFreeA,
-    std::vector<mpfr::mpreal> &freeA, std::vector<mpfr::mpreal> &fixedA,
-    std::vector<mpfr::mpreal> &interpolationPoints,
-    std::vector<Band> &freqBands, std::vector<mpfr::mpreal> &weights,
-    mpfr::mpreal &scalingFactor, mp_prec_t prec) {
+void fpminimaxWithBranchAndBound(QuantizationResult &result,
+                                 QuantizationContext &context,
+                                 mpfr::mpreal &scalingFactor) {
   using namespace mpfr;
-  mpreal::set_default_prec(prec);
-
-  std::vector<GridPoint> grid;
-  generateGrid(grid, freeA.size(), freqBands, 16u, prec);
-
-  std::vector<Band> chebyBands;
-  bandConversion(chebyBands, freqBands, ConversionDirection::FROMFREQ, prec);
-
-  std::vector<mpfr::mpreal> v(interpolationPoints.size());
-  std::vector<mpfr::mpreal> fv(interpolationPoints.size());
-  std::vector<mpfr::mpreal> idealV(interpolationPoints.size());
-  for (std::size_t i = 0u; i < interpolationPoints.size(); ++i) {
-    v[i] = mpfr::acos(interpolationPoints[i]);
-    evaluateClenshaw(fv[i], freeA, interpolationPoints[i], prec);
-    mpfr::mpreal buffer;
-    for(std::size_t j{0u}; j < freqBands.size(); ++j) {
-        if (mpfr::abs(v[i] - freqBands[j].stop) < 1e-14)
-            v[i] = freqBands[j].stop;
-        if (mpfr::abs(v[i] - freqBands[j].start) < 1e-14)
-            v[i] = freqBands[j].start;
-    }
+  mp_prec_t prec = context.prec;
+  ScopedPrecision guard(prec);
 
-    computeIdealResponseAndWeight(idealV[i], buffer, v[i],
-            freqBands);
-  }
+  std::vector<mpfr::mpreal> &freeA = context.freeA;
+  std::vector<Band> &chebyBands = context.chebyBands;
+  Grid &grid = context.grid;
+  result.scalingFactor = scalingFactor;
+  result.bits = mpfr::round(mpfr::log2(scalingFactor)).toLong();
 
-  std::vector<double> freeADouble(freeA.size());
-  std::vector<mpfr::mpreal> roundedA = freeA;
-  for (std::size_t i = 0u; i < freeA.size(); ++i) {
-    freeADouble[i] = freeA[i].toDouble();
-    if (i > 0u) {
-      roundedA[i] *= scalingFactor;
-      roundedA[i] >>= 1;
-    } else {
-      roundedA[i] *= scalingFactor;
-      roundedA[i] >>= 0;
-    }
-    roundedA[i] = roundedA[i].toLong(GMP_RNDN);
-    if (i > 0u) {
-      roundedA[i] /= scalingFactor;
-      roundedA[i] <<= 1;
-    } else {
-      roundedA[i] /= scalingFactor;
-      roundedA[i] <<= 0;
+  std::vector<mpfr::mpreal> roundedA;
+  roundCoefficients(roundedA, context, scalingFactor);
+
+  std::vector<double> doubleA(roundedA.size());
+  for (std::size_t i = 0u; i < roundedA.size(); ++i)
+    doubleA[i] = roundedA[i].toDouble();
+
+  double naiveNorm;
+  std::vector<double> bandNorms(chebyBands.size());
+  countedNorm(result.stats, naiveNorm, bandNorms, context, doubleA);
+  result.naiveError = naiveNorm;
+
+  std::vector<std::vector<double>> svpVectors(freeA.size());
+  std::vector<double> lllA1(freeA.size());
+  std::vector<double> lllA2(freeA.size());
+  fpminimaxKernelV2(lllA1, lllA2, svpVectors, context.minimaxValues,
+                    context.idealValues, context.basisEntries, scalingFactor,
+                    freeA.size(), context.reduction, result.stats, prec);
+
+  ScopedTimer timer(&result.stats, Phase::NEIGHBORHOOD_SEARCH);
+  GridResponse svpResponses;
+  computeGridResponse(svpResponses, grid, svpVectors);
+
+  // the search is done around the solutions of both targets, the second
+  // one starting from the best error found around the first one
+  double bestNorm = std::numeric_limits<double>::infinity();
+  std::vector<double> bestA;
+  result.lllError = bestNorm;
+  for (std::vector<double> *lllA : {&lllA1, &lllA2}) {
+    std::vector<double> baseA = doubleA;
+    for (std::size_t i = 0u; i < lllA->size(); ++i)
+      baseA[i] = (*lllA)[i];
+    double lllNorm;
+    countedNorm(result.stats, lllNorm, bandNorms, context, baseA);
+    result.lllError = std::min(result.lllError, lllNorm);
+    if (lllNorm < bestNorm) {
+      bestNorm = lllNorm;
+      bestA = baseA;
     }
+    branchAndBoundSearch(bestNorm, bestA, bandNorms, baseA, svpVectors,
+                         svpResponses, context.search, chebyBands, context,
+                         result.stats);
   }
 
-  for (std::size_t i = 0u; i < fixedA.size(); ++i)
-    roundedA.push_back(fixedA[i]);
+  result.coefficients.resize(freeA.size());
+  for (std::size_t i = 0u; i < freeA.size(); ++i)
+    result.coefficients[i] = bestA[i];
+  result.finalError = bestNorm;
+}
+
+void fpminimaxWithNeighborhoodSearchDiscreteRand(
+    QuantizationResult &result, QuantizationContext &context,
+    mpfr::mpreal &scalingFactor) {
+  using namespace mpfr;
+  mp_prec_t prec = context.prec;
+  ScopedPrecision guard(prec);
+
+  std::vector<mpfr::mpreal> &freeA = context.freeA;
+  std::vector<mpfr::mpreal> &fixedA = context.fixedA;
+  std::vector<Band> &chebyBands = context.chebyBands;
+  Grid &grid = context.grid;
+  std::vector<mpfr::mpreal> &lllFreeA = result.coefficients;
+  result.scalingFactor = scalingFactor;
+  result.bits = mpfr::round(mpfr::log2(scalingFactor)).toLong();
+
+  std::vector<mpfr::mpreal> roundedA;
+  roundCoefficients(roundedA, context, scalingFactor);
 
   std::vector<double> doubleA(roundedA.size());
   for (std::size_t i = 0u; i < roundedA.size(); ++i)
@@ -893,19 +1353,16 @@ void fpminimaxWithNeighborhoodSearchDiscreteRand(
 
   double naiveNorm;
   std::vector<double> bandNorms(chebyBands.size());
-  computeDenseNorm(naiveNorm, bandNorms, chebyBands, grid, doubleA);
-  std::cout << "Naive rounding error\t= " << naiveNorm << std::endl;
+  countedNorm(result.stats, naiveNorm, bandNorms, context, doubleA);
+  result.naiveError = naiveNorm;
 
   std::vector<std::vector<double>> svpVectors(freeA.size());
   std::vector<std::vector<mpfr::mpreal>> mpSVPVectors(freeA.size());
   std::vector<double> lllA1(freeA.size());
   std::vector<double> lllA2(freeA.size());
-  auto start = std::chrono::steady_clock::now();
-  fpminimaxKernelV2(lllA1, lllA2, freeADouble, v, svpVectors, fv, idealV, scalingFactor, weights,
-                  freeA.size(), prec);
-  auto stop = std::chrono::steady_clock::now();
-  auto diff = stop - start;
-  std::cout << "\nReduction = " << std::chrono::duration<double,std::milli>(diff).count() << " ms\n";
+  fpminimaxKernelV2(lllA1, lllA2, svpVectors, context.minimaxValues,
+                    context.idealValues, context.basisEntries, scalingFactor,
+                    freeA.size(), context.reduction, result.stats, prec);
 
   for (std::size_t i = 0u; i < svpVectors.size(); ++i) {
     mpSVPVectors[i].resize(svpVectors[i].size());
@@ -924,13 +1381,11 @@ void fpminimaxWithNeighborhoodSearchDiscreteRand(
 
   for (std::size_t i = 0u; i < fixedA.size(); ++i)
     mpLLLA1.push_back(fixedA[i]);
-  start = std::chrono::steady_clock::now();
+  auto start = std::chrono::steady_clock::now();
 
   double lllNorm;
-  computeDenseNorm(lllNorm, bandNorms, chebyBands, grid, lllA1);
-  std::cout << "LLL initial error\t= " << lllNorm << std::endl;
-  for (std::size_t k{0u}; k < bandNorms.size(); ++k)
-    std::cout << "Band " << k << " error = " << bandNorms[k] << std::endl;
+  countedNorm(result.stats, lllNorm, bandNorms, context, lllA1);
+  result.lllError = lllNorm;
 
 
   double lllBestNorm;
@@ -942,57 +1397,41 @@ void fpminimaxWithNeighborhoodSearchDiscreteRand(
   for (std::size_t i = 0u; i < lllA1.size(); ++i)
     mpFinalA1[i] = lllA1[i];
   std::vector<mpfr::mpreal> initialLLL1 = mpLLLA1;
-  std::vector<double> searchBandNorms(chebyBands.size());
 
   start = std::chrono::steady_clock::now();
-  stop = std::chrono::steady_clock::now();
-  diff = stop - start;
+  auto stop = std::chrono::steady_clock::now();
+  auto diff = stop - start;
 
   std::random_device r;
 
   std::default_random_engine e(r());
   std::uniform_int_distribution<int> ud1(0, 3);
-  std::uniform_int_distribution<int> ud2(0, mpLLLA1.size()-1);
+  std::uniform_int_distribution<int> ud2(0, svpVectors.size()-1);
   std::uniform_int_distribution<int> ud3(-1,1);
 
 
+  std::vector<NeighborhoodMove> moves(1024u);
+  GridResponse svpResponses;
+  computeGridResponse(svpResponses, grid, svpVectors);
+  std::vector<double> baseA = doubleA;
+  std::vector<double> searchA;
+  for (std::size_t i = 0u; i < lllA1.size(); ++i)
+    baseA[i] = lllA1[i];
+
   while(std::chrono::duration<double,std::milli>(diff).count() < 60000.0)
   {
-    std::size_t index1 = ud1(e);
-    std::size_t index2 = ud2(e);
-
-    int direction1 = ud3(e);
-    int direction2 = ud3(e);
-
-
-          for (std::size_t i{0u}; i < freeA.size(); ++i) {
-            double vA = lllA1[i] + svpVectors[index1][i] * direction1 +
-                        svpVectors[index2][i] *
-                            direction2;
-            mpBufferA[i] = vA;
-            doubleA[i] = vA;
-          }
-          double bufferNorm;
-          computeDenseNorm(bufferNorm, searchBandNorms, chebyBands, grid, doubleA);
-
-          if (bufferNorm < lllNorm) {
-            lllNorm = bufferNorm;
-            bandNorms = searchBandNorms;
-            std::cout << "Index1 = " << index1 << " Direction1 = " << direction1
-                      << std::endl;
-            std::cout << "Index2 = " << index2 << " Direction2 = " << direction2
-                      << std::endl;
-
-            std::cout << "LLL search norm\t= " << bufferNorm << std::endl;
-            for (std::size_t k{0u}; k < bandNorms.size(); ++k)
-              std::cout << "Band " << k << " error = " << bandNorms[k] << std::endl;
-
-            mpFinalA1 = mpBufferA;
-          }
-        stop = std::chrono::steady_clock::now();
-        diff = stop - start;
+    for (auto &move : moves)
+      move = {(std::size_t)ud1(e), (std::size_t)ud2(e), ud3(e), ud3(e)};
 
+    if (neighborhoodSearch(lllNorm, searchA, bandNorms, baseA, svpVectors,
+                           svpResponses, moves, chebyBands, context,
+                           result.stats)) {
 
+      for (std::size_t i = 0u; i < lllA1.size(); ++i)
+        mpFinalA1[i] = searchA[i];
+    }
+    stop = std::chrono::steady_clock::now();
+    diff = stop - start;
   }
 
 
@@ -1034,11 +1473,11 @@ void fpminimaxWithNeighborhoodSearchDiscreteRand(
     doubleA[i] = mpLLLA1[i].toDouble();
 
   double lllNorm1;
-  computeDenseNorm(lllNorm1, bandNorms, chebyBands, grid, doubleA);
-  std::cout << "LLL final error\t= " << lllNorm << std::endl;
+  countedNorm(result.stats, lllNorm1, bandNorms, context, doubleA);
   stop = std::chrono::steady_clock::now();
   diff = stop - start;
-  std::cout << "\nVicinity search = " << std::chrono::duration<double,std::milli>(diff).count() << " ms\n";
+  recordPhase(&result.stats, Phase::NEIGHBORHOOD_SEARCH,
+              std::chrono::duration<double, std::milli>(diff).count());
 
 
   // using ideal
@@ -1053,10 +1492,8 @@ void fpminimaxWithNeighborhoodSearchDiscreteRand(
     mpLLLA2.push_back(fixedA[i]);
   start = std::chrono::steady_clock::now();
 
-  computeDenseNorm(lllNorm, bandNorms, chebyBands, grid, lllA2);
-  std::cout << "LLL initial error\t= " << lllNorm << std::endl;
-  for (std::size_t k{0u}; k < bandNorms.size(); ++k)
-    std::cout << "Band " << k << " error = " << bandNorms[k] << std::endl;
+  countedNorm(result.stats, lllNorm, bandNorms, context, lllA2);
+  result.lllError = std::min(result.lllError, lllNorm);
 
 
   std::vector<mpfr::mpreal> mpFinalA2;
@@ -1072,42 +1509,23 @@ void fpminimaxWithNeighborhoodSearchDiscreteRand(
   stop = std::chrono::steady_clock::now();
   diff = stop - start;
 
+  for (std::size_t i = 0u; i < lllA2.size(); ++i)
+    baseA[i] = lllA2[i];
+
   while(std::chrono::duration<double,std::milli>(diff).count() < 60000)
   {
-    std::size_t index1 = ud1(e);
-    std::size_t index2 = ud2(e);
-
-    int direction1 = ud3(e);
-    int direction2 = ud3(e);
-
-          for (std::size_t i{0u}; i < freeA.size(); ++i) {
-            double vA = lllA2[i] + svpVectors[index1][i] * direction1 +
-                        svpVectors[index2][i] *
-                            direction2;
-            mpBufferA[i] = vA;
-            doubleA[i] = vA;
-          }
-          double bufferNorm;
-          computeDenseNorm(bufferNorm, searchBandNorms, chebyBands, grid, doubleA);
-
-          if (bufferNorm < lllNorm) {
-            lllNorm = bufferNorm;
-            bandNorms = searchBandNorms;
-            std::cout << "Index1 = " << index1 << " Direction1 = " << direction1
-                      << std::endl;
-            std::cout << "Index2 = " << index2 << " Direction2 = " << direction2
-                      << std::endl;
-
-            std::cout << "LLL search norm\t= " << bufferNorm << std::endl;
-            for (std::size_t k{0u}; k < bandNorms.size(); ++k)
-              std::cout << "Band " << k << " error = " << bandNorms[k] << std::endl;
-
-            mpFinalA2 = mpBufferA;
-          }
-        stop = std::chrono::steady_clock::now();
-        diff = stop - start;
+    for (auto &move : moves)
+      move = {(std::size_t)ud1(e), (std::size_t)ud2(e), ud3(e), ud3(e)};
 
+    if (neighborhoodSearch(lllNorm, searchA, bandNorms, baseA, svpVectors,
+                           svpResponses, moves, chebyBands, context,
+                           result.stats)) {
 
+      for (std::size_t i = 0u; i < lllA2.size(); ++i)
+        mpFinalA2[i] = searchA[i];
+    }
+    stop = std::chrono::steady_clock::now();
+    diff = stop - start;
   }
 
 
@@ -1141,7 +1559,8 @@ void fpminimaxWithNeighborhoodSearchDiscreteRand(
   }
   stop = std::chrono::steady_clock::now();
   diff = stop - start;
-  std::cout << "\nVicinity search = " << std::chrono::duration<double,std::milli>(diff).count() << " ms\n";
+  recordPhase(&result.stats, Phase::NEIGHBORHOOD_SEARCH,
+              std::chrono::duration<double, std::milli>(diff).count());
 
 
 
@@ -1152,8 +1571,7 @@ void fpminimaxWithNeighborhoodSearchDiscreteRand(
     doubleA[i] = mpLLLA2[i].toDouble();
 
   double lllNorm2;
-  computeDenseNorm(lllNorm2, bandNorms, chebyBands, grid, doubleA);
-  std::cout << "LLL final error\t= " << lllNorm << std::endl;
+  countedNorm(result.stats, lllNorm2, bandNorms, context, doubleA);
 
   if(lllNorm2 < lllNorm1)
   {
@@ -1164,6 +1582,7 @@ void fpminimaxWithNeighborhoodSearchDiscreteRand(
       for (std::size_t i = 0u; i < freeA.size(); ++i)
         lllFreeA[i] = mpFinalA2[i];
   }
+  result.finalError = bestNorm;
 }
 
 
@@ -1173,53 +1592,22 @@ void fpminimaxWithNeighborhoodSearchDiscreteRand(
 
 
 void fpminimaxWithNeighborhoodSearchDiscreteFull(
-    mpfr::mpreal &minError, std::vector<mpfr::mpreal> &lllFreeA,
-    std::vector<mpfr::mpreal> &freeA, std::vector<mpfr::mpreal> &fixedA,
-    std::vector<mpfr::mpreal> &interpolationPoints,
-    std::vector<Band> &freqBands, std::vector<mpfr::mpreal> &weights,
-    mpfr::mpreal &scalingFactor, mp_prec_t prec) {
+    QuantizationResult &result, QuantizationContext &context,
+    mpfr::mpreal &scalingFactor) {
   using namespace mpfr;
-  mpreal::set_default_prec(prec);
-
-  std::vector<GridPoint> grid;
-  generateGrid(grid, freeA.size(), freqBands, 16u, prec);
-
-  std::vector<Band> chebyBands;
-  bandConversion(chebyBands, freqBands, ConversionDirection::FROMFREQ, prec);
-
-  std::vector<mpfr::mpreal> v(interpolationPoints.size());
-  std::vector<mpfr::mpreal> fv(interpolationPoints.size());
-  for (std::size_t i = 0u; i < interpolationPoints.size(); ++i) {
-    v[i] = mpfr::acos(interpolationPoints[i]);
-    evaluateClenshaw(fv[i], freeA, interpolationPoints[i], prec);
-    mpfr::mpreal buffer;
-    computeIdealResponseAndWeight(fv[i], buffer, v[i],
-            freqBands);
-  }
+  mp_prec_t prec = context.prec;
+  ScopedPrecision guard(prec);
 
-  std::vector<double> freeADouble(freeA.size());
-  std::vector<mpfr::mpreal> roundedA = freeA;
-  for (std::size_t i = 0u; i < freeA.size(); ++i) {
-    freeADouble[i] = freeA[i].toDouble();
-    if (i > 0u) {
-      roundedA[i] *= scalingFactor;
-      roundedA[i] >>= 1;
-    } else {
-      roundedA[i] *= scalingFactor;
-      roundedA[i] >>= 0;
-    }
-    roundedA[i] = roundedA[i].toLong(GMP_RNDN);
-    if (i > 0u) {
-      roundedA[i] /= scalingFactor;
-      roundedA[i] <<= 1;
-    } else {
-      roundedA[i] /= scalingFactor;
-      roundedA[i] <<= 0;
-    }
-  }
+  std::vector<mpfr::mpreal> &freeA = context.freeA;
+  std::vector<mpfr::mpreal> &fixedA = context.fixedA;
+  std::vector<Band> &chebyBands = context.chebyBands;
+  Grid &grid = context.grid;
+  std::vector<mpfr::mpreal> &lllFreeA = result.coefficients;
+  result.scalingFactor = scalingFactor;
+  result.bits = mpfr::round(mpfr::log2(scalingFactor)).toLong();
 
-  for (std::size_t i = 0u; i < fixedA.size(); ++i)
-    roundedA.push_back(fixedA[i]);
+  std::vector<mpfr::mpreal> roundedA;
+  roundCoefficients(roundedA, context, scalingFactor);
 
   std::vector<double> doubleA(roundedA.size());
   for (std::size_t i = 0u; i < roundedA.size(); ++i)
@@ -1228,19 +1616,16 @@ void fpminimaxWithNeighborhoodSearchDiscreteFull(
 
   double naiveNorm;
   std::vector<double> bandNorms(chebyBands.size());
-  computeDenseNorm(naiveNorm, bandNorms, chebyBands, grid, doubleA);
-  std::cout << "Naive rounding error\t= " << naiveNorm << std::endl;
+  countedNorm(result.stats, naiveNorm, bandNorms, context, doubleA);
+  result.naiveError = naiveNorm;
 
   std::vector<std::vector<double>> svpVectors(freeA.size());
   std::vector<std::vector<mpfr::mpreal>> mpSVPVectors(freeA.size());
   std::vector<double> lllA(freeA.size());
 
-  auto start = std::chrono::steady_clock::now();
-  fpminimaxKernel(lllA, freeADouble, v, svpVectors, fv, scalingFactor, weights,
-                  freeA.size(), prec);
-  auto stop = std::chrono::steady_clock::now();
-  auto diff = stop - start;
-  std::cout << "\nReduction = " << std::chrono::duration<double,std::milli>(diff).count() << " ms\n";
+  fpminimaxKernel(lllA, svpVectors, context.idealValues, context.basisEntries,
+                  scalingFactor, freeA.size(), context.reduction,
+                  result.stats, prec);
 
 
   std::vector<mpfr::mpreal> mpLLLA(freeA.size());
@@ -1261,10 +1646,8 @@ void fpminimaxWithNeighborhoodSearchDiscreteFull(
 
 
   double lllNorm;
-  computeDenseNorm(lllNorm, bandNorms, chebyBands, grid, lllA);
-  std::cout << "LLL initial error\t= " << lllNorm << std::endl;
-  for (std::size_t k{0u}; k < bandNorms.size(); ++k)
-    std::cout << "Band " << k << " error = " << bandNorms[k] << std::endl;
+  countedNorm(result.stats, lllNorm, bandNorms, context, lllA);
+  result.lllError = lllNorm;
 
 
   double lllBestNorm;
@@ -1281,33 +1664,24 @@ void fpminimaxWithNeighborhoodSearchDiscreteFull(
 
 
 
-  start = std::chrono::steady_clock::now();
-
-
-  for (std::size_t index1 = 0u; index1 < 9; ++index1)
-    for (std::size_t index2 = index1 + 1u; index2 < mpLLLA.size(); ++index2)
+  auto start = std::chrono::steady_clock::now();
 
-      for (int direction1 = -1; direction1 < 2; ++direction1)
-        for (int direction2 = -1; direction2 < 2; ++direction2)
 
-        {
-          for (std::size_t i{0u}; i < freeA.size(); ++i) {
-            double vA = lllA[i] + svpVectors[index1][i] * direction1 +
-                        svpVectors[index2][i] *
-                            direction2;
-            mpBufferA[i] = vA;
-            doubleA[i] = vA;
-          }
-          double bufferNorm;
-          computeDenseNorm(bufferNorm, searchBandNorms, chebyBands, grid, doubleA);
+  std::vector<NeighborhoodMove> moves;
+  generateNeighborhoodMoves(moves, 9u, svpVectors.size());
+  GridResponse svpResponses;
+  computeGridResponse(svpResponses, grid, svpVectors);
 
-          if (bufferNorm < lllNorm) {
-            lllNorm = bufferNorm;
-            bandNorms = searchBandNorms;
+  std::vector<double> baseA = doubleA;
+  for (std::size_t i = 0u; i < lllA.size(); ++i)
+    baseA[i] = lllA[i];
+  std::vector<double> searchA;
+  if (neighborhoodSearch(lllNorm, searchA, bandNorms, baseA, svpVectors,
+                         svpResponses, moves, chebyBands, context,
+                         result.stats))
+    for (std::size_t i = 0u; i < lllA.size(); ++i)
+      mpFinalA[i] = searchA[i];
 
-            mpFinalA = mpBufferA;
-          }
-        }
 
 
   lllFreeA.resize(freeA.size());
@@ -1341,9 +1715,10 @@ void fpminimaxWithNeighborhoodSearchDiscreteFull(
     }
     finalBuffer = finalBuffer.toLong(GMP_RNDN);
   }
-  stop = std::chrono::steady_clock::now();
-  diff = stop - start;
-  std::cout << "\nVicinity search = " << std::chrono::duration<double,std::milli>(diff).count() << " ms\n";
+  auto stop = std::chrono::steady_clock::now();
+  auto diff = stop - start;
+  recordPhase(&result.stats, Phase::NEIGHBORHOOD_SEARCH,
+              std::chrono::duration<double, std::milli>(diff).count());
 
 
 
@@ -1351,8 +1726,7 @@ void fpminimaxWithNeighborhoodSearchDiscreteFull(
   	doubleA[i] = mpLLLA[i].toDouble();
 
 
-  computeDenseNorm(lllNorm, bandNorms, chebyBands, grid, doubleA);
-  std::cout << "LLL final error\t= " << lllNorm << std::endl;
+  countedNorm(result.stats, lllNorm, bandNorms, context, doubleA);
 
   mpfr::mpreal buffInit = 1u;
   buffInit /= scalingFactor;
@@ -1370,12 +1744,12 @@ void fpminimaxWithNeighborhoodSearchDiscreteFull(
         else
             buffA[i] -= buffRest.toDouble();
           double bufferNorm;
-          computeDenseNorm(bufferNorm, searchBandNorms, chebyBands, grid, buffA);
+          countedNorm(result.stats, bufferNorm, searchBandNorms, context,
+                      buffA);
           if(bufferNorm < bestNorm)
           {
               bestA = buffA;
               bestNorm = bufferNorm;
-              std::cout << "New error = " << bufferNorm << std::endl;
           }
 
 
@@ -1386,12 +1760,12 @@ void fpminimaxWithNeighborhoodSearchDiscreteFull(
             buffA[i] += buffRest.toDouble();
 
 
-          computeDenseNorm(bufferNorm, searchBandNorms, chebyBands, grid, buffA);
+          countedNorm(result.stats, bufferNorm, searchBandNorms, context,
+                      buffA);
           if(bufferNorm < bestNorm)
           {
               bestA = buffA;
               bestNorm = bufferNorm;
-              std::cout << "New error = " << bufferNorm << std::endl;
           }
 
        }
@@ -1408,12 +1782,12 @@ void fpminimaxWithNeighborhoodSearchDiscreteFull(
             buffA[i] -= buffRest.toDouble();
         buffA[j] -= buffRest.toDouble();
           double bufferNorm;
-          computeDenseNorm(bufferNorm, searchBandNorms, chebyBands, grid, buffA);
+          countedNorm(result.stats, bufferNorm, searchBandNorms, context,
+                      buffA);
           if(bufferNorm < bestNorm)
           {
               bestA = buffA;
               bestNorm = bufferNorm;
-              std::cout << "New error = " << bufferNorm << std::endl;
           }
 
 
@@ -1424,12 +1798,12 @@ void fpminimaxWithNeighborhoodSearchDiscreteFull(
             buffA[i] -= buffRest.toDouble();
         buffA[j] += buffRest.toDouble();
 
-          computeDenseNorm(bufferNorm, searchBandNorms, chebyBands, grid, buffA);
+          countedNorm(result.stats, bufferNorm, searchBandNorms, context,
+                      buffA);
           if(bufferNorm < bestNorm)
           {
               bestA = buffA;
               bestNorm = bufferNorm;
-              std::cout << "New error = " << bufferNorm << std::endl;
           }
 
 
@@ -1440,12 +1814,12 @@ void fpminimaxWithNeighborhoodSearchDiscreteFull(
             buffA[i] += buffRest.toDouble();
         buffA[j] -= buffRest.toDouble();
 
-          computeDenseNorm(bufferNorm, searchBandNorms, chebyBands, grid, buffA);
+          countedNorm(result.stats, bufferNorm, searchBandNorms, context,
+                      buffA);
           if(bufferNorm < bestNorm)
           {
               bestA = buffA;
               bestNorm = bufferNorm;
-              std::cout << "New error = " << bufferNorm << std::endl;
           }
 
 
@@ -1457,93 +1831,56 @@ void fpminimaxWithNeighborhoodSearchDiscreteFull(
         buffA[j] += buffRest.toDouble();
 
 
-          computeDenseNorm(bufferNorm, searchBandNorms, chebyBands, grid, buffA);
+          countedNorm(result.stats, bufferNorm, searchBandNorms, context,
+                      buffA);
           if(bufferNorm < bestNorm)
           {
               bestA = buffA;
               bestNorm = bufferNorm;
-              std::cout << "New error = " << bufferNorm << std::endl;
           }
 
        }
 
+  result.finalError = lllNorm;
 
 }
 
 
 void fpminimaxWithNeighborhoodSearchDiscreteMinimax(
-    mpfr::mpreal &minError, std::vector<mpfr::mpreal> &lllFreeA,
-    std::vector<mpfr::mpreal> &freeA, std::vector<mpfr::mpreal> &fixedA,
-    std::vector<mpfr::mpreal> &interpolationPoints,
-    std::vector<Band> &freqBands, std::vector<mpfr::mpreal> &weights,
-    mpfr::mpreal &scalingFactor, mp_prec_t prec) {
+    QuantizationResult &result, QuantizationContext &context,
+    mpfr::mpreal &scalingFactor) {
   using namespace mpfr;
-  mpreal::set_default_prec(prec);
-
-  std::vector<GridPoint> grid;
-  generateGrid(grid, freeA.size(), freqBands, 16u, prec);
-
-  std::vector<Band> chebyBands;
-  bandConversion(chebyBands, freqBands, ConversionDirection::FROMFREQ, prec);
-
-  std::vector<mpfr::mpreal> v(interpolationPoints.size());
-  std::vector<mpfr::mpreal> fv(interpolationPoints.size());
-  std::vector<mpfr::mpreal> idealV(interpolationPoints.size());
-  for (std::size_t i = 0u; i < interpolationPoints.size(); ++i) {
-    v[i] = mpfr::acos(interpolationPoints[i]);
-    for(std::size_t j{0u}; j < freqBands.size(); ++j) {
-        if (mpfr::abs(v[i] - freqBands[j].stop) < 1e-14)
-            v[i] = freqBands[j].stop;
-        if (mpfr::abs(v[i] - freqBands[j].start) < 1e-14)
-            v[i] = freqBands[j].start;
-    }
+  mp_prec_t prec = context.prec;
+  ScopedPrecision guard(prec);
 
-    evaluateClenshaw(fv[i], freeA, interpolationPoints[i], prec);
-  }
+  std::vector<mpfr::mpreal> &freeA = context.freeA;
+  std::vector<mpfr::mpreal> &fixedA = context.fixedA;
+  std::vector<Band> &chebyBands = context.chebyBands;
+  Grid &grid = context.grid;
+  std::vector<mpfr::mpreal> &lllFreeA = result.coefficients;
+  result.scalingFactor = scalingFactor;
+  result.bits = mpfr::round(mpfr::log2(scalingFactor)).toLong();
 
-  std::vector<double> freeADouble(freeA.size());
-  std::vector<mpfr::mpreal> roundedA = freeA;
-  for (std::size_t i = 0u; i < freeA.size(); ++i) {
-    freeADouble[i] = freeA[i].toDouble();
-    if (i > 0u) {
-      roundedA[i] *= scalingFactor;
-      roundedA[i] >>= 1;
-    } else {
-      roundedA[i] *= scalingFactor;
-      roundedA[i] >>= 0;
-    }
-    roundedA[i] = roundedA[i].toLong(GMP_RNDN);
-    if (i > 0u) {
-      roundedA[i] /= scalingFactor;
-      roundedA[i] <<= 1;
-    } else {
-      roundedA[i] /= scalingFactor;
-      roundedA[i] <<= 0;
-    }
-  }
-
-  for (std::size_t i = 0u; i < fixedA.size(); ++i)
-    roundedA.push_back(fixedA[i]);
+  std::vector<mpfr::mpreal> roundedA;
+  roundCoefficients(roundedA, context, scalingFactor);
 
   std::vector<double> doubleA(roundedA.size());
   for (std::size_t i = 0u; i < roundedA.size(); ++i)
     doubleA[i] = roundedA[i].toDouble();
 
+
   double naiveNorm;
   std::vector<double> bandNorms(chebyBands.size());
-  computeDenseNorm(naiveNorm, bandNorms, chebyBands, grid, doubleA);
-  std::cout << "Naive rounding error\t= " << naiveNorm << std::endl;
+  countedNorm(result.stats, naiveNorm, bandNorms, context, doubleA);
+  result.naiveError = naiveNorm;
 
   std::vector<std::vector<double>> svpVectors(freeA.size());
   std::vector<std::vector<mpfr::mpreal>> mpSVPVectors(freeA.size());
   std::vector<double> lllA(freeA.size());
 
-  auto start = std::chrono::steady_clock::now();
-  fpminimaxKernel(lllA, freeADouble, v, svpVectors, fv, scalingFactor, weights,
-                  freeA.size(), prec);
-  auto stop = std::chrono::steady_clock::now();
-  auto diff = stop - start;
-  std::cout << "\nReduction = " << std::chrono::duration<double,std::milli>(diff).count() << " ms\n";
+  fpminimaxKernel(lllA, svpVectors, context.minimaxValues, context.basisEntries,
+                  scalingFactor, freeA.size(), context.reduction,
+                  result.stats, prec);
 
 
   std::vector<mpfr::mpreal> mpLLLA(freeA.size());
@@ -1563,10 +1900,8 @@ void fpminimaxWithNeighborhoodSearchDiscreteMinimax(
 
 
   double lllNorm;
-  computeDenseNorm(lllNorm, bandNorms, chebyBands, grid, lllA);
-  std::cout << "LLL initial error\t= " << lllNorm << std::endl;
-  for (std::size_t k{0u}; k < bandNorms.size(); ++k)
-    std::cout << "Band " << k << " error = " << bandNorms[k] << std::endl;
+  countedNorm(result.stats, lllNorm, bandNorms, context, lllA);
+  result.lllError = lllNorm;
 
   double lllBestNorm;
   std::vector<mpfr::mpreal> mpBufferA(lllA.size() + fixedA.size());
@@ -1577,36 +1912,28 @@ void fpminimaxWithNeighborhoodSearchDiscreteMinimax(
   for (std::size_t i = 0u; i < lllA.size(); ++i)
     mpFinalA[i] = lllA[i];
   std::vector<mpfr::mpreal> initialLLL = mpLLLA;
-  std::vector<double> searchBandNorms(chebyBands.size());
-
 
 
 
-  start = std::chrono::steady_clock::now();
 
+  auto start = std::chrono::steady_clock::now();
 
-  for (std::size_t index1 = 0u; index1 < 9; ++index1)
-    for (std::size_t index2 = index1 + 1u; index2 < mpLLLA.size(); ++index2)
 
-      for (int direction1 = -1; direction1 < 2; ++direction1)
-        for (int direction2 = -1; direction2 < 2; ++direction2)
-        {
-          for (std::size_t i{0u}; i < freeA.size(); ++i) {
-            double vA = lllA[i] + svpVectors[index1][i] * direction1 +
-                        svpVectors[index2][i] * direction2;
-            mpBufferA[i] = vA;
-            doubleA[i] = vA;
-          }
-          double bufferNorm;
-          computeDenseNorm(bufferNorm, searchBandNorms, chebyBands, grid, doubleA);
+  std::vector<NeighborhoodMove> moves;
+  generateNeighborhoodMoves(moves, 9u, svpVectors.size());
+  GridResponse svpResponses;
+  computeGridResponse(svpResponses, grid, svpVectors);
 
-          if (bufferNorm < lllNorm) {
-            lllNorm = bufferNorm;
-            bandNorms = searchBandNorms;
+  std::vector<double> baseA = doubleA;
+  for (std::size_t i = 0u; i < lllA.size(); ++i)
+    baseA[i] = lllA[i];
+  std::vector<double> searchA;
+  if (neighborhoodSearch(lllNorm, searchA, bandNorms, baseA, svpVectors,
+                         svpResponses, moves, chebyBands, context,
+                         result.stats))
+    for (std::size_t i = 0u; i < lllA.size(); ++i)
+      mpFinalA[i] = searchA[i];
 
-            mpFinalA = mpBufferA;
-          }
-        }
 
 
 
@@ -1631,14 +1958,121 @@ void fpminimaxWithNeighborhoodSearchDiscreteMinimax(
     }
     finalBuffer = finalBuffer.toLong(GMP_RNDN);
   }
-  stop = std::chrono::steady_clock::now();
-  diff = stop - start;
-  std::cout << "\nVicinity search = " << std::chrono::duration<double,std::milli>(diff).count() << " ms\n";
+  auto stop = std::chrono::steady_clock::now();
+  auto diff = stop - start;
+  recordPhase(&result.stats, Phase::NEIGHBORHOOD_SEARCH,
+              std::chrono::duration<double, std::milli>(diff).count());
 
 
   for(std::size_t i{0u}; i < mpLLLA.size(); ++i)
     doubleA[i] = mpLLLA[i].toDouble();
 
-  computeDenseNorm(lllNorm, bandNorms, chebyBands, grid, doubleA);
-  std::cout << "LLL final error\t= " << lllNorm << std::endl;
+  countedNorm(result.stats, lllNorm, bandNorms, context, doubleA);
+  result.finalError = lllNorm;
+}
+
+void fpminimaxWithNeighborhoodSearchDiscrete(
+    mpfr::mpreal &minError, std::vector<mpfr::mpreal> &lllFreeA,
+    std::vector<mpfr::mpreal> &freeA, std::vector<mpfr::mpreal> &fixedA,
+    std::vector<mpfr::mpreal> &interpolationPoints,
+    std::vector<Band> &freqBands, std::vector<mpfr::mpreal> &weights,
+    mpfr::mpreal &scalingFactor, mp_prec_t prec) {
+  QuantizationContext context;
+  initQuantizationContext(context, freeA, fixedA, interpolationPoints,
+                          freqBands, weights, prec);
+  QuantizationResult result;
+  fpminimaxWithNeighborhoodSearchDiscrete(result, context, scalingFactor);
+  lllFreeA = result.coefficients;
+  minError = result.finalError;
+}
+
+void fpminimaxWithNeighborhoodSearchDiscreteRand(
+    mpfr::mpreal &minError, std::vector<mpfr::mpreal> &lllFreeA,
+    std::vector<mpfr::mpreal> &freeA, std::vector<mpfr::mpreal> &fixedA,
+    std::vector<mpfr::mpreal> &interpolationPoints,
+    std::vector<Band> &freqBands, std::vector<mpfr::mpreal> &weights,
+    mpfr::mpreal &scalingFactor, mp_prec_t prec) {
+  QuantizationContext context;
+  initQuantizationContext(context, freeA, fixedA, interpolationPoints,
+                          freqBands, weights, prec);
+  QuantizationResult result;
+  fpminimaxWithNeighborhoodSearchDiscreteRand(result, context, scalingFactor);
+  lllFreeA = result.coefficients;
+  minError = result.finalError;
+}
+
+void fpminimaxWithNeighborhoodSearchDiscreteFull(
+    mpfr::mpreal &minError, std::vector<mpfr::mpreal> &lllFreeA,
+    std::vector<mpfr::mpreal> &freeA, std::vector<mpfr::mpreal> &fixedA,
+    std::vector<mpfr::mpreal> &interpolationPoints,
+    std::vector<Band> &freqBands, std::vector<mpfr::mpreal> &weights,
+    mpfr::mpreal &scalingFactor, mp_prec_t prec) {
+  QuantizationContext context;
+  initQuantizationContext(context, freeA, fixedA, interpolationPoints,
+                          freqBands, weights, prec);
+  QuantizationResult result;
+  fpminimaxWithNeighborhoodSearchDiscreteFull(result, context, scalingFactor);
+  lllFreeA = result.coefficients;
+  minError = result.finalError;
+}
+
+void fpminimaxWithNeighborhoodSearchDiscreteMinimax(
+    mpfr::mpreal &minError, std::vector<mpfr::mpreal> &lllFreeA,
+    std::vector<mpfr::mpreal> &freeA, std::vector<mpfr::mpreal> &fixedA,
+    std::vector<mpfr::mpreal> &interpolationPoints,
+    std::vector<Band> &freqBands, std::vector<mpfr::mpreal> &weights,
+    mpfr::mpreal &scalingFactor, mp_prec_t prec) {
+  QuantizationContext context;
+  initQuantizationContext(context, freeA, fixedA, interpolationPoints,
+                          freqBands, weights, prec);
+  QuantizationResult result;
+  fpminimaxWithNeighborhoodSearchDiscreteMinimax(result, context, scalingFactor);
+  lllFreeA = result.coefficients;
+  minError = result.finalError;
+}
+
+// runs a single quantization with the requested strategy
+static void quantize(QuantizationResult &result, QuantizationContext &context,
+                     mpfr::mpreal const &scalingFactor,
+                     QuantizationMethod method) {
+  ScopedPrecision guard(context.prec);
+  mpfr::mpreal factor = scalingFactor;
+  switch (method) {
+  case QuantizationMethod::NEIGHBORHOOD:
+    fpminimaxWithNeighborhoodSearchDiscrete(result, context, factor);
+    break;
+  case QuantizationMethod::MINIMAX:
+    fpminimaxWithNeighborhoodSearchDiscreteMinimax(result, context, factor);
+    break;
+  case QuantizationMethod::RANDOM:
+    fpminimaxWithNeighborhoodSearchDiscreteRand(result, context, factor);
+    break;
+  case QuantizationMethod::FULL:
+    fpminimaxWithNeighborhoodSearchDiscreteFull(result, context, factor);
+    break;
+  case QuantizationMethod::BRANCH_AND_BOUND:
+    fpminimaxWithBranchAndBound(result, context, factor);
+    break;
+  }
+}
+
+void quantizeSweep(std::vector<QuantizationResult> &results,
+                   QuantizationContext &context,
+                   std::vector<mpfr::mpreal> &scalingFactors,
+                   QuantizationMethod method) {
+  results.resize(scalingFactors.size());
+  // the context is only read by the quantization routines, so each word
+  // length can be processed independently
+  parallelTasks(scalingFactors.size(), [&](std::size_t i) {
+    quantize(results[i], context, scalingFactors[i], method);
+  });
+}
+
+void quantizeBatch(std::vector<QuantizationResult> &results,
+                   std::vector<QuantizationJob> &jobs, std::size_t threads) {
+  results.resize(jobs.size());
+  runTasks(jobs.size(), [&](std::size_t i) {
+    quantize(results[i], *jobs[i].context, jobs[i].scalingFactor,
+             jobs[i].method);
+  }, threads);
 }
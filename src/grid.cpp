@@ -1,77 +1,499 @@
 #include "filter/grid.h"
+#include "filter/scheduler.h"
+#include <complex>
+#include <eigen3/unsupported/Eigen/FFT>
+#include <limits>
 
-void generateGrid(std::vector<GridPoint> &grid, std::size_t degree,
+static ResponseModelT<double> toDoubleModel(ResponseModel const &model) {
+  ResponseModelT<double> out;
+  out.type = model.type;
+  for (auto &it : model.coeffs)
+    out.coeffs.push_back(it.toDouble());
+  return out;
+}
+
+// number of grid points handled by a task of fillGridValues
+static const std::size_t fillBlockSize = 512u;
+
+// computes the x, D and W values of the points of a grid (the omega values
+// and the band offsets being already set, the k-th band of the grid being
+// freqBands[k]); the points are processed in parallel and in double
+// precision, MPFR being only used to evaluate the band callbacks which do
+// not have an analytic description
+static void fillGridValues(Grid &grid, std::vector<Band> &freqBands,
+                           mp_prec_t prec) {
+  std::vector<ResponseModelT<double>> amplitudes(freqBands.size());
+  std::vector<ResponseModelT<double>> weights(freqBands.size());
+  for (std::size_t i = 0u; i < freqBands.size(); ++i) {
+    amplitudes[i] = toDoubleModel(freqBands[i].amplitudeModel);
+    weights[i] = toDoubleModel(freqBands[i].weightModel);
+  }
+
+  std::size_t blocks = (grid.size() + fillBlockSize - 1u) / fillBlockSize;
+  parallelTasks(blocks, [&](std::size_t block) {
+    ScopedPrecision guard(prec);
+    std::size_t first = block * fillBlockSize;
+    std::size_t last = std::min(first + fillBlockSize, grid.size());
+    std::size_t band =
+        std::upper_bound(grid.bandOffsets.begin(), grid.bandOffsets.end(),
+                         first) -
+        grid.bandOffsets.begin() - 1u;
+    for (std::size_t i = first; i < last; ++i) {
+      while (i >= grid.bandOffsets[band + 1u])
+        ++band;
+      Band &b = freqBands[band];
+      grid.x[i] = std::cos(grid.omega[i]);
+      double t = (b.space == BandSpace::CHEBY) ? grid.x[i] : grid.omega[i];
+      if (b.amplitudeModel.type != FUNCTION)
+        evaluateResponse(grid.D[i], amplitudes[band], b.space, t);
+      else
+        grid.D[i] = b.amplitude(b.space, mpfr::mpreal(t)).toDouble();
+      if (b.weightModel.type != FUNCTION)
+        evaluateResponse(grid.W[i], weights[band], b.space, t);
+      else
+        grid.W[i] = b.weight(b.space, mpfr::mpreal(t)).toDouble();
+    }
+  });
+}
+
+static void resizeGrid(Grid &grid, std::size_t size) {
+  grid.omega.resize(size);
+  grid.x.resize(size);
+  grid.D.resize(size);
+  grid.W.resize(size);
+}
+
+void generateGrid(Grid &grid, std::size_t degree,
                   std::vector<Band> &freqBands, std::size_t density,
                   mp_prec_t prec) {
   using mpfr::mpreal;
-  mpfr_prec_t prevPrec = mpreal::get_default_prec();
-  mpreal::set_default_prec(prec);
-
-  mpfr::mpreal increment = mpfr::const_pi();
-  increment /= (degree * density);
-  int bandIndex = 0;
-  GridPoint buffer;
-  mpfr::mpreal omega, x, D, W;
-  while (bandIndex < freqBands.size()) {
-    omega = freqBands[bandIndex].start;
+  ScopedPrecision guard(prec);
+
+  grid.bandOffsets.clear();
+  grid.bandIndices.clear();
+
+  // the points of a band are start + k * increment, as long as they do not
+  // go past the end of the band, followed by the band end
+  mpreal pi = mpfr::const_pi();
+  double increment = (pi / (degree * density)).toDouble();
+  std::vector<double> starts(freqBands.size());
+  std::vector<std::size_t> counts(freqBands.size());
+  std::size_t size = 0u;
+  for (std::size_t i = 0u; i < freqBands.size(); ++i) {
+    starts[i] = freqBands[i].start.toDouble();
+    double width = (freqBands[i].stop - starts[i]).toDouble();
+    std::size_t k = (width > 0.0) ? (std::size_t)(width / increment) : 0u;
+    while (std::fma(k + 1u, increment, starts[i]) <= freqBands[i].stop)
+      ++k;
+    while (k > 0u && std::fma(k, increment, starts[i]) > freqBands[i].stop)
+      --k;
+    counts[i] = k + 2u;
+    grid.bandOffsets.push_back(size);
+    grid.bandIndices.push_back(freqBands.size() - 1u - i);
+    size += counts[i];
+  }
+  grid.bandOffsets.push_back(size);
+  resizeGrid(grid, size);
+
+  for (std::size_t i = 0u; i < freqBands.size(); ++i) {
+    double *omega = grid.omega.data() + grid.bandOffsets[i];
+    for (std::size_t k = 0u; k + 1u < counts[i]; ++k)
+      omega[k] = std::fma(k, increment, starts[i]);
+    omega[counts[i] - 1u] = freqBands[i].stop.toDouble();
+  }
+  fillGridValues(grid, freqBands, prec);
+
+  // the band edges are evaluated with MPFR
+  mpreal omega, x, D, W;
+  auto setPoint = [&](std::size_t i) {
     x = mpfr::cos(omega);
     computeIdealResponseAndWeight(D, W, omega, freqBands);
-    buffer.omega = omega.toDouble();
-    buffer.x = x.toDouble();
-    buffer.D = D.toDouble();
-    buffer.W = W.toDouble();
-    grid.push_back(buffer);
-    while (grid.back().omega <= freqBands[bandIndex].stop) {
-      omega += increment;
+    grid.x[i] = x.toDouble();
+    grid.D[i] = D.toDouble();
+    grid.W[i] = W.toDouble();
+  };
+  for (std::size_t i = 0u; i < freqBands.size(); ++i) {
+    omega = freqBands[i].start;
+    setPoint(grid.bandOffsets[i]);
+    omega = freqBands[i].stop;
+    setPoint(grid.bandOffsets[i + 1u] - 1u);
+  }
+}
+
+void generateSpectralGrid(SpectralGrid &grid, std::size_t degree,
+                          std::vector<Band> &freqBands, std::size_t density,
+                          mp_prec_t prec) {
+  using mpfr::mpreal;
+  ScopedPrecision guard(prec);
+
+  grid.size = 1u;
+  while (grid.size < degree * density)
+    grid.size *= 2u;
+  grid.indices.clear();
+  for (Grid *g : {&grid.lattice, &grid.edges}) {
+    g->omega.clear();
+    g->x.clear();
+    g->D.clear();
+    g->W.clear();
+    g->bandOffsets.clear();
+    g->bandIndices.clear();
+  }
+
+  // the lattice points of each band are the k * pi / M values with
+  // first <= k <= last
+  mpreal pi = mpfr::const_pi();
+  double step = (pi / grid.size).toDouble();
+  for (std::size_t bandIndex = 0u; bandIndex < freqBands.size(); ++bandIndex) {
+    // (the x values of the lattice points are only computed at the end)
+    grid.lattice.bandOffsets.push_back(grid.lattice.omega.size());
+    grid.edges.bandOffsets.push_back(grid.edges.size());
+    for (Grid *g : {&grid.lattice, &grid.edges})
+      g->bandIndices.push_back(freqBands.size() - 1u - bandIndex);
+    mpreal first = mpfr::ceil(freqBands[bandIndex].start * grid.size / pi);
+    mpreal last = mpfr::floor(freqBands[bandIndex].stop * grid.size / pi);
+    for (std::size_t k = first.toULong();
+         k <= last.toULong() && k <= grid.size; ++k) {
+      grid.lattice.omega.push_back(k * step);
+      grid.indices.push_back(k);
+    }
+
+    mpreal omega, x, D, W;
+    for (int edge = 0; edge < 2; ++edge) {
+      omega = edge ? freqBands[bandIndex].stop : freqBands[bandIndex].start;
       x = mpfr::cos(omega);
       computeIdealResponseAndWeight(D, W, omega, freqBands);
-      buffer.omega = omega.toDouble();
-      buffer.x = x.toDouble();
-      buffer.D = D.toDouble();
-      buffer.W = W.toDouble();
-      grid.push_back(buffer);
+      grid.edges.omega.push_back(omega.toDouble());
+      grid.edges.x.push_back(x.toDouble());
+      grid.edges.D.push_back(D.toDouble());
+      grid.edges.W.push_back(W.toDouble());
     }
-    omega = freqBands[bandIndex].stop;
-    x = mpfr::cos(omega);
-    grid[grid.size() - 1].omega = omega.toDouble();
-    grid[grid.size() - 1].x = x.toDouble();
-    computeIdealResponseAndWeight(D, W, omega, freqBands);
-    grid[grid.size() - 1u].D = D.toDouble();
-    grid[grid.size() - 1u].W = W.toDouble();
-    ++bandIndex;
   }
-
-  mpreal::set_default_prec(prevPrec);
+  resizeGrid(grid.lattice, grid.lattice.omega.size());
+  grid.lattice.bandOffsets.push_back(grid.lattice.size());
+  grid.edges.bandOffsets.push_back(grid.edges.size());
+  fillGridValues(grid.lattice, freqBands, prec);
 }
 
+// size of the point blocks processed by the batched Clenshaw kernels
+static const std::size_t gridBlockSize = 256u;
 
-void getError(double &error, GridPoint &p,
-              std::vector<double> &a) {
-  evaluateClenshaw(error, a, p.x);
-  //std::cout << p.x << "\t" << error << std::endl;
-  error = p.W * (p.D - error);
+// computes the weighted errors at the n <= gridBlockSize grid points
+// starting at index start
+static inline void getErrors(double *error, Grid &grid, std::size_t start,
+                             std::size_t n, std::vector<double> &a) {
+  evaluateClenshaw(error, grid.x.data() + start, n, a);
+  const double *D = grid.D.data() + start;
+  const double *W = grid.W.data() + start;
+  for (std::size_t i = 0u; i < n; ++i)
+    error[i] = W[i] * (D[i] - error[i]);
 }
 
 void computeDenseNorm(double &normValue,
-                      std::vector<double> &bandNorms,
-                      std::vector<Band> &chebyBands,
-                      std::vector<GridPoint> &grid,
+                      std::vector<double> &bandNorms, Grid &grid,
                       std::vector<double> &a) {
 
+  computeDenseNorm(normValue, bandNorms, grid, a,
+                   std::numeric_limits<double>::infinity());
+}
+
+bool computeDenseNorm(double &normValue,
+                      std::vector<double> &bandNorms, Grid &grid,
+                      std::vector<double> &a, double bound) {
+
   normValue = 0;
-  double currentError;
+  alignas(64) double errors[gridBlockSize];
   for (auto &it : bandNorms)
     it = 0;
-  for (std::size_t i = 0u; i < grid.size(); ++i) {
-    getError(currentError, grid[i], a);
-    currentError = fabs(currentError);
-    if (currentError > normValue)
-      normValue = currentError;
-    for (std::size_t j = 0u; j < chebyBands.size(); ++j) {
-      if (grid[i].x >= chebyBands[j].start.toDouble(GMP_RNDD)
-        && grid[i].x <= chebyBands[j].stop.toDouble(GMP_RNDU))
-        if (bandNorms[j] < currentError)
-          bandNorms[j] = currentError;
+  for (std::size_t k = 0u; k < grid.bandIndices.size(); ++k) {
+    double bandMax = 0;
+    for (std::size_t start = grid.bandOffsets[k];
+         start < grid.bandOffsets[k + 1u]; start += gridBlockSize) {
+      std::size_t n = std::min(gridBlockSize, grid.bandOffsets[k + 1u] - start);
+      getErrors(errors, grid, start, n, a);
+      double blockMax = 0;
+      for (std::size_t i = 0u; i < n; ++i)
+        blockMax = std::max(blockMax, fabs(errors[i]));
+      bandMax = std::max(bandMax, blockMax);
+      if (bandMax > bound) {
+        normValue = bandMax;
+        return false;
+      }
     }
+    bandNorms[grid.bandIndices[k]] = bandMax;
+    normValue = std::max(normValue, bandMax);
+  }
+  return true;
+}
+
+// abscissa of the vertex of the parabola going through (x0, y0), (x1, y1)
+// and (x2, y2), restricted to the [x0, x2] interval
+static double parabolicVertex(double x0, double y0, double x1, double y1,
+                              double x2, double y2) {
+  double p = (x1 - x0) * (y1 - y2);
+  double q = (x1 - x2) * (y1 - y0);
+  if (p == q)
+    return x1;
+  double v = x1 - 0.5 * ((x1 - x0) * p - (x1 - x2) * q) / (p - q);
+  return std::min(std::max(v, x0), x2);
+}
+
+// absolute value of the weighted error at omega, which lies between the grid
+// points first and first + 1 (the ideal response and the weight are
+// interpolated linearly between them)
+static double segmentError(Grid &grid, std::size_t first, double omega,
+                           std::vector<double> &a) {
+  double width = grid.omega[first + 1u] - grid.omega[first];
+  double t = (width > 0) ? (omega - grid.omega[first]) / width : 0;
+  double D = grid.D[first] + t * (grid.D[first + 1u] - grid.D[first]);
+  double W = grid.W[first] + t * (grid.W[first + 1u] - grid.W[first]);
+  double x = cos(omega);
+  double p;
+  evaluateClenshaw(&p, &x, 1u, a);
+  return fabs(W * (D - p));
+}
+
+void computeAdaptiveNorm(double &normValue, std::vector<double> &bandNorms,
+                         Grid &grid, std::vector<double> &a,
+                         AdaptiveNormOptions const &options) {
+  computeAdaptiveNorm(normValue, bandNorms, grid, a, options,
+                      std::numeric_limits<double>::infinity());
+}
+
+bool computeAdaptiveNorm(double &normValue, std::vector<double> &bandNorms,
+                         Grid &grid, std::vector<double> &a,
+                         AdaptiveNormOptions const &options, double bound) {
+  std::size_t stride = std::max(options.stride, (std::size_t)1u);
+  auto gridError = [&](std::size_t j) {
+    double error;
+    getErrors(&error, grid, j, 1u, a);
+    return fabs(error);
+  };
+
+  normValue = 0;
+  for (auto &it : bandNorms)
+    it = 0;
+  std::vector<std::size_t> indices;
+  AlignedVectorD x, values;
+  for (std::size_t k = 0u; k < grid.bandIndices.size(); ++k) {
+    std::size_t lo = grid.bandOffsets[k];
+    std::size_t hi = grid.bandOffsets[k + 1u];
+
+    // coarse scan (the band edges are always part of it)
+    indices.clear();
+    for (std::size_t i = lo; i < hi; i += stride)
+      indices.push_back(i);
+    if (indices.back() != hi - 1u)
+      indices.push_back(hi - 1u);
+    std::size_t m = indices.size();
+    x.resize(m);
+    values.resize(m);
+    for (std::size_t c = 0u; c < m; ++c)
+      x[c] = grid.x[indices[c]];
+    evaluateClenshaw(values.data(), x.data(), m, a);
+    double coarseMax = 0;
+    for (std::size_t c = 0u; c < m; ++c) {
+      std::size_t i = indices[c];
+      values[c] = fabs(grid.W[i] * (grid.D[i] - values[c]));
+      coarseMax = std::max(coarseMax, values[c]);
+    }
+    if (coarseMax > bound) {
+      normValue = coarseMax;
+      return false;
+    }
+
+    double bandMax = coarseMax;
+    for (std::size_t c = 0u; c < m; ++c) {
+      if ((c > 0u && values[c] < values[c - 1u]) ||
+          (c + 1u < m && values[c] < values[c + 1u]) ||
+          values[c] < options.threshold * coarseMax)
+        continue;
+      // the grid maximum lies between the neighboring coarse points: the
+      // search starts at the vertex of the parabola going through the
+      // three coarse values and goes uphill on the grid
+      std::size_t left = indices[(c > 0u) ? c - 1u : c];
+      std::size_t right = indices[(c + 1u < m) ? c + 1u : c];
+      std::size_t j = indices[c];
+      double value = values[c];
+      if (c > 0u && c + 1u < m) {
+        j = (std::size_t)(parabolicVertex(left, values[c - 1u], j, value,
+                                          right, values[c + 1u]) + 0.5);
+        if (j != indices[c])
+          value = gridError(j);
+      }
+      bool moved = false;
+      while (j > left) {
+        double previous = gridError(j - 1u);
+        if (previous <= value)
+          break;
+        --j;
+        value = previous;
+        moved = true;
+      }
+      while (!moved && j < right) {
+        double next = gridError(j + 1u);
+        if (next <= value)
+          break;
+        ++j;
+        value = next;
+      }
+
+      if (options.peaks && j > lo && j + 1u < hi) {
+        double previous = gridError(j - 1u);
+        double next = gridError(j + 1u);
+        double omega = parabolicVertex(grid.omega[j - 1u], previous,
+                                       grid.omega[j], value,
+                                       grid.omega[j + 1u], next);
+        std::size_t first = (omega < grid.omega[j]) ? j - 1u : j;
+        value = std::max(value, segmentError(grid, first, omega, a));
+      }
+      bandMax = std::max(bandMax, value);
+      if (bandMax > bound) {
+        normValue = bandMax;
+        return false;
+      }
+    }
+    bandNorms[grid.bandIndices[k]] = bandMax;
+    normValue = std::max(normValue, bandMax);
+  }
+
+  if (options.certify) {
+    double denseNorm;
+    std::vector<double> denseBandNorms(bandNorms.size());
+    if (!computeDenseNorm(denseNorm, denseBandNorms, grid, a, bound)) {
+      normValue = denseNorm;
+      return false;
+    }
+    for (std::size_t k = 0u; k < bandNorms.size(); ++k)
+      bandNorms[k] = std::max(bandNorms[k], denseBandNorms[k]);
+    normValue = std::max(normValue, denseNorm);
+  }
+  return true;
+}
+
+// values of the polynomial with Chebyshev coefficients a at the lattice
+// points cos(k * pi / size), k = 0, ..., size: this is a type I DCT, computed
+// with a real FFT of the even extension of a (of length 2 * size)
+static void latticeValues(std::vector<double> &values, std::vector<double> &a,
+                          std::size_t size, Eigen::FFT<double> &fft,
+                          std::vector<double> &extension,
+                          std::vector<std::complex<double>> &spectrum) {
+  extension.assign(2u * size, 0.0);
+  extension[0] = a[0];
+  for (std::size_t j = 1u; j < a.size(); ++j) {
+    extension[j] = a[j];
+    extension[2u * size - j] = a[j];
+  }
+  fft.fwd(spectrum, extension);
+  values.resize(size + 1u);
+  for (std::size_t k = 0u; k <= size; ++k)
+    values[k] = 0.5 * (spectrum[k].real() + a[0]);
+}
+
+// the buffers used by the spectral norm computations (one set per thread)
+struct SpectralWorkspace {
+  Eigen::FFT<double> fft;
+  std::vector<double> values;
+  std::vector<double> extension;
+  std::vector<std::complex<double>> spectrum;
+};
+
+static void spectralNorm(double &normValue, std::vector<double> &bandNorms,
+                         SpectralGrid &grid, std::vector<double> &a,
+                         SpectralWorkspace &workspace) {
+  latticeValues(workspace.values, a, grid.size, workspace.fft,
+                workspace.extension, workspace.spectrum);
+  // the band edges are evaluated directly
+  computeDenseNorm(normValue, bandNorms, grid.edges, a);
+  Grid &lattice = grid.lattice;
+  const double *values = workspace.values.data();
+  for (std::size_t k = 0u; k < lattice.bandIndices.size(); ++k) {
+    double bandMax = bandNorms[lattice.bandIndices[k]];
+    for (std::size_t i = lattice.bandOffsets[k];
+         i < lattice.bandOffsets[k + 1u]; ++i) {
+      double error = lattice.W[i] * (lattice.D[i] - values[grid.indices[i]]);
+      bandMax = std::max(bandMax, fabs(error));
+    }
+    bandNorms[lattice.bandIndices[k]] = bandMax;
+    normValue = std::max(normValue, bandMax);
+  }
+}
+
+void computeSpectralNorm(double &normValue, std::vector<double> &bandNorms,
+                         SpectralGrid &grid, std::vector<double> &a) {
+  SpectralWorkspace workspace;
+  spectralNorm(normValue, bandNorms, grid, a, workspace);
+}
+
+// number of polynomials scored by a task of computeSpectralNorms (the FFT
+// plan is set up once per task)
+static const std::size_t spectralBlockSize = 32u;
+
+void computeSpectralNorms(std::vector<double> &normValues,
+                          std::vector<std::vector<double>> &bandNorms,
+                          SpectralGrid &grid,
+                          std::vector<std::vector<double>> &a) {
+  normValues.resize(a.size());
+  bandNorms.resize(a.size());
+  std::size_t blockCount =
+      (a.size() + spectralBlockSize - 1u) / spectralBlockSize;
+  parallelTasks(blockCount, [&](std::size_t block) {
+    SpectralWorkspace workspace;
+    std::size_t stop = std::min(a.size(), (block + 1u) * spectralBlockSize);
+    for (std::size_t i = block * spectralBlockSize; i < stop; ++i) {
+      bandNorms[i].resize(grid.edges.bandIndices.size());
+      spectralNorm(normValues[i], bandNorms[i], grid, a[i], workspace);
+    }
+  });
+}
+
+void computeGridError(std::vector<double> &error, Grid &grid,
+                      std::vector<double> &a) {
+  error.resize(grid.size());
+  std::size_t blockCount = (grid.size() + gridBlockSize - 1u) / gridBlockSize;
+  parallelTasks(blockCount, [&](std::size_t block) {
+    std::size_t start = block * gridBlockSize;
+    getErrors(error.data() + start, grid, start,
+              std::min(gridBlockSize, grid.size() - start), a);
+  });
+}
+
+void computeGridResponse(GridResponse &responses, Grid &grid,
+                         std::vector<std::vector<double>> &a) {
+  responses.points = grid.size();
+  responses.count = a.size();
+  responses.values.resize(responses.points * responses.count);
+  parallelTasks(a.size(), [&](std::size_t k) {
+    double *row = responses.values.data() + k * responses.points;
+    evaluateClenshaw(row, grid.x.data(), grid.size(), a[k]);
+    for (std::size_t i = 0u; i < grid.size(); ++i)
+      row[i] *= grid.W[i];
+  });
+}
+
+bool computeCombinationNorm(double &normValue,
+                            std::vector<double> &error,
+                            GridResponse &responses,
+                            std::size_t index1, double factor1,
+                            std::size_t index2, double factor2,
+                            double bound) {
+  const double *e = error.data();
+  const double *r1 = responses.values.data() + index1 * responses.points;
+  const double *r2 = responses.values.data() + index2 * responses.points;
+
+  // the early exit test is done once per block so that the inner
+  // loop remains vectorizable
+  const std::size_t blockSize = 64u;
+  normValue = 0;
+  for (std::size_t start = 0u; start < responses.points; start += blockSize) {
+    std::size_t stop = std::min(start + blockSize, responses.points);
+    double blockMax = 0;
+    for (std::size_t i = start; i < stop; ++i)
+      blockMax = std::max(blockMax,
+                          fabs(e[i] - factor1 * r1[i] - factor2 * r2[i]));
+    if (blockMax > normValue)
+      normValue = blockMax;
+    if (normValue > bound)
+      return false;
   }
+  return true;
 }
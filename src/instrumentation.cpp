@@ -0,0 +1,130 @@
+#include "filter/instrumentation.h"
+#include <atomic>
+#include <mutex>
+#include <sstream>
+
+namespace {
+std::atomic<InstrumentationSink *> currentSink(nullptr);
+std::mutex streamMutex;
+}
+
+QuantizationStats::QuantizationStats() {
+  for (std::size_t i = 0u; i < (std::size_t)Phase::COUNT; ++i)
+    times[i] = 0.0;
+  for (std::size_t i = 0u; i < (std::size_t)Counter::COUNT; ++i)
+    counters[i] = 0u;
+}
+
+double &QuantizationStats::time(Phase phase) {
+  return times[(std::size_t)phase];
+}
+
+double QuantizationStats::time(Phase phase) const {
+  return times[(std::size_t)phase];
+}
+
+std::size_t &QuantizationStats::counter(Counter counter) {
+  return counters[(std::size_t)counter];
+}
+
+std::size_t QuantizationStats::counter(Counter counter) const {
+  return counters[(std::size_t)counter];
+}
+
+void QuantizationStats::merge(QuantizationStats const &other) {
+  for (std::size_t i = 0u; i < (std::size_t)Phase::COUNT; ++i)
+    times[i] += other.times[i];
+  for (std::size_t i = 0u; i < (std::size_t)Counter::COUNT; ++i)
+    counters[i] += other.counters[i];
+}
+
+StreamSink::StreamSink(std::ostream &out) : out(out) {}
+
+void StreamSink::phase(Phase phase, double ms) {
+  std::ostringstream buffer;
+  buffer << phaseName(phase) << " = " << ms << " ms\n";
+  write(buffer.str());
+}
+
+void StreamSink::counter(Counter counter, std::size_t value) {
+  std::ostringstream buffer;
+  buffer << counterName(counter) << " += " << value << "\n";
+  write(buffer.str());
+}
+
+void StreamSink::message(std::string const &text) { write(text + "\n"); }
+
+void StreamSink::write(std::string const &text) {
+  std::lock_guard<std::mutex> lock(streamMutex);
+  out << text;
+}
+
+void setInstrumentationSink(InstrumentationSink *sink) { currentSink = sink; }
+
+InstrumentationSink *getInstrumentationSink() { return currentSink; }
+
+const char *phaseName(Phase phase) {
+  switch (phase) {
+  case Phase::GRID_BUILD:
+    return "Grid build";
+  case Phase::BASIS_BUILD:
+    return "Basis build";
+  case Phase::REDUCTION:
+    return "Reduction";
+  case Phase::NEIGHBORHOOD_SEARCH:
+    return "Vicinity search";
+  default:
+    return "Unknown phase";
+  }
+}
+
+const char *counterName(Counter counter) {
+  switch (counter) {
+  case Counter::CANDIDATES:
+    return "Candidates";
+  case Counter::NORM_EVALUATIONS:
+    return "Norm evaluations";
+  case Counter::SEARCH_NODES:
+    return "Search nodes";
+  default:
+    return "Unknown counter";
+  }
+}
+
+void recordPhase(QuantizationStats *stats, Phase phase, double ms) {
+  if (stats)
+    stats->time(phase) += ms;
+  InstrumentationSink *sink = currentSink;
+  if (sink)
+    sink->phase(phase, ms);
+}
+
+void recordCount(QuantizationStats *stats, Counter counter,
+                 std::size_t value) {
+  if (stats)
+    stats->counter(counter) += value;
+  InstrumentationSink *sink = currentSink;
+  if (sink)
+    sink->counter(counter, value);
+}
+
+void recordMessage(std::string const &text) {
+  InstrumentationSink *sink = currentSink;
+  if (sink)
+    sink->message(text);
+}
+
+ScopedTimer::ScopedTimer(QuantizationStats *stats, Phase phase)
+    : stats(stats), phase(phase),
+      active(stats != nullptr || currentSink != nullptr) {
+  if (active)
+    start = std::chrono::steady_clock::now();
+}
+
+ScopedTimer::~ScopedTimer() {
+  if (active)
+    recordPhase(stats, phase,
+                std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - start)
+                    .count());
+}
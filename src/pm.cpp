@@ -1,14 +1,22 @@
 #include "filter/pm.h"
+#include "filter/afp.h"
 #include "filter/band.h"
 #include "filter/barycentric.h"
+#include "filter/scheduler.h"
 #include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
 #include <set>
 
+// number of consecutive subinterval boundaries whose errors are computed
+// by the same task of findEigenExtrema
+static const std::size_t boundaryBlockSize = 16u;
+
 void initUniformExtremas(std::vector<mpfr::mpreal> &omega, std::vector<Band> &B,
                          mp_prec_t prec) {
   using mpfr::mpreal;
-  mpfr_prec_t prevPrec = mpreal::get_default_prec();
-  mpreal::set_default_prec(prec);
+  ScopedPrecision guard(prec);
 
   if (omega.size() <= B.size()) {
 
@@ -90,8 +98,6 @@ void initUniformExtremas(std::vector<mpfr::mpreal> &omega, std::vector<Band> &B,
       startIndex += B[i].extremas;
     }
   }
-
-  mpreal::set_default_prec(prevPrec);
 }
 
 void referenceScaling(std::vector<mpfr::mpreal> &newX,
@@ -101,8 +107,7 @@ void referenceScaling(std::vector<mpfr::mpreal> &newX,
                       std::vector<Band> &chebyBands,
                       std::vector<Band> &freqBands, mp_prec_t prec) {
   using mpfr::mpreal;
-  mpfr_prec_t prevPrec = mpreal::get_default_prec();
-  mpreal::set_default_prec(prec);
+  ScopedPrecision guard(prec);
 
   std::vector<std::size_t> newDistribution(chebyBands.size());
   for (std::size_t i{0u}; i < chebyBands.size(); ++i)
@@ -220,15 +225,13 @@ void referenceScaling(std::vector<mpfr::mpreal> &newX,
     newFreqBands[freqBands.size() - 1u - i].extremas = newDistribution[i];
     newChebyBands[i].extremas = newDistribution[i];
   }
-  mpreal::set_default_prec(prevPrec);
 }
 
 void splitInterval(std::vector<Interval> &subIntervals,
                    std::vector<Band> &chebyBands, std::vector<mpfr::mpreal> &x,
                    mp_prec_t prec) {
   using mpfr::mpreal;
-  mpfr_prec_t prevPrec = mpreal::get_default_prec();
-  mpreal::set_default_prec(prec);
+  ScopedPrecision guard(prec);
 
   // for(std::size_t i = 0u; i < chebyBands.size(); ++i)
   //    std::cout << "Band " << i << " with extremas " << chebyBands[i].extremas
@@ -263,7 +266,6 @@ void splitInterval(std::vector<Interval> &subIntervals,
       bandOffset += chebyBands[i].extremas;
     }
   }
-  mpreal::set_default_prec(prevPrec);
 }
 
 void findEigenExtrema(mpfr::mpreal &convergenceOrder, mpfr::mpreal &delta,
@@ -271,8 +273,7 @@ void findEigenExtrema(mpfr::mpreal &convergenceOrder, mpfr::mpreal &delta,
                       std::vector<mpfr::mpreal> &x,
                       std::vector<Band> &chebyBands, int Nmax, mp_prec_t prec) {
   using mpfr::mpreal;
-  mpfr_prec_t prevPrec = mpreal::get_default_prec();
-  mpreal::set_default_prec(prec);
+  ScopedPrecision guard(prec);
 
   // 1.   Split the initial [-1, 1] interval in subintervals
   //      in order that we can use a reasonable size matrix
@@ -304,62 +305,97 @@ void findEigenExtrema(mpfr::mpreal &convergenceOrder, mpfr::mpreal &delta,
   generateEquidistantNodes(chebyNodes, Nmax, prec);
   applyCos(chebyNodes, chebyNodes);
 
-  std::vector<std::pair<mpfr::mpreal, mpfr::mpreal>> potentialExtrema;
-  std::vector<mpfr::mpreal> pEx;
+  // the error values at the subinterval boundaries are shared by the
+  // neighbouring subintervals, the band edge tests and the candidate
+  // extrema pass, so they are computed only once
+  std::vector<mpfr::mpreal> boundaries;
+  std::vector<std::size_t> boundaryIndex(2u * subIntervals.size());
+  for (std::size_t i = 0u; i < subIntervals.size(); ++i) {
+    if (boundaries.empty() || boundaries.back() != subIntervals[i].first)
+      boundaries.push_back(subIntervals[i].first);
+    boundaryIndex[2u * i] = boundaries.size() - 1u;
+    boundaries.push_back(subIntervals[i].second);
+    boundaryIndex[2u * i + 1u] = boundaries.size() - 1u;
+  }
+  std::vector<mpfr::mpreal> boundaryErrors(boundaries.size());
+  // the error evaluations are split in blocks of consecutive boundaries,
+  // each one with its own workspace (the default precision is also set in
+  // each task, since the band functions use it)
+  std::size_t blockCount = (boundaries.size() + boundaryBlockSize - 1u) /
+                           boundaryBlockSize;
+  parallelTasks(blockCount, [&](std::size_t block) {
+    ScopedPrecision threadGuard(prec);
+    MPWorkspace ws(prec);
+    std::size_t end =
+        std::min(boundaries.size(), (block + 1u) * boundaryBlockSize);
+    for (std::size_t i = block * boundaryBlockSize; i < end; ++i)
+      computeError(boundaryErrors[i], boundaries[i], delta, x, C, w,
+                   chebyBands, ws);
+  });
+  MPWorkspace edgeWs(prec);
+  auto edgeError = [&](mpfr::mpreal &value, mpfr::mpreal &t) {
+    auto it = std::find(boundaries.begin(), boundaries.end(), t);
+    if (it != boundaries.end())
+      value = boundaryErrors[it - boundaries.begin()];
+    else
+      computeError(value, t, delta, x, C, w, chebyBands, edgeWs);
+  };
+
+  auto lessThan = [](const std::pair<mpfr::mpreal, mpfr::mpreal> &lhs,
+                     const std::pair<mpfr::mpreal, mpfr::mpreal> &rhs) {
+    return lhs.first < rhs.first;
+  };
+
+  // the band edge candidates (in increasing order)
+  std::vector<std::pair<mpfr::mpreal, mpfr::mpreal>> edgeExtrema;
   mpfr::mpreal extremaErrorValueLeft;
   mpfr::mpreal extremaErrorValueRight;
   mpfr::mpreal extremaErrorValue;
-  computeError(extremaErrorValue, chebyBands[0].start, delta, x, C, w,
-               chebyBands);
+  edgeError(extremaErrorValue, chebyBands[0].start);
   if(mpfr::abs(extremaErrorValue) >= mpfr::abs(delta))
-    potentialExtrema.push_back(
+    edgeExtrema.push_back(
         std::make_pair(chebyBands[0].start, extremaErrorValue));
 
   for (std::size_t i = 0u; i < chebyBands.size() - 1; ++i) {
-    computeError(extremaErrorValueLeft, chebyBands[i].stop, delta, x, C, w,
-                 chebyBands, prec);
-    computeError(extremaErrorValueRight, chebyBands[i + 1].start, delta, x, C,
-                 w, chebyBands, prec);
+    edgeError(extremaErrorValueLeft, chebyBands[i].stop);
+    edgeError(extremaErrorValueRight, chebyBands[i + 1].start);
     int sgnLeft = mpfr::sgn(extremaErrorValueLeft);
     int sgnRight = mpfr::sgn(extremaErrorValueRight);
     if (sgnLeft * sgnRight < 0) {
       if(mpfr::abs(extremaErrorValueLeft) >= mpfr::abs(delta))
-      potentialExtrema.push_back(
+      edgeExtrema.push_back(
           std::make_pair(chebyBands[i].stop, extremaErrorValueLeft));
       if(mpfr::abs(extremaErrorValueRight) >= mpfr::abs(delta))
-      potentialExtrema.push_back(
+      edgeExtrema.push_back(
           std::make_pair(chebyBands[i + 1].start, extremaErrorValueRight));
     } else {
       mpfr::mpreal abs1 = mpfr::abs(extremaErrorValueLeft);
       mpfr::mpreal abs2 = mpfr::abs(extremaErrorValueRight);
       if (abs1 > abs2)
       if(mpfr::abs(extremaErrorValueLeft) >= mpfr::abs(delta))
-        potentialExtrema.push_back(
+        edgeExtrema.push_back(
             std::make_pair(chebyBands[i].stop, extremaErrorValueLeft));
       else
         if(mpfr::abs(extremaErrorValueRight) >= mpfr::abs(delta))
-        potentialExtrema.push_back(
+        edgeExtrema.push_back(
             std::make_pair(chebyBands[i + 1].start, extremaErrorValueRight));
     }
   }
-  computeError(extremaErrorValue, chebyBands[chebyBands.size() - 1].stop, delta,
-               x, C, w, chebyBands, prec);
+  edgeError(extremaErrorValue, chebyBands[chebyBands.size() - 1].stop);
   if(mpfr::abs(extremaErrorValue) >= mpfr::abs(delta))
 
-  potentialExtrema.push_back(std::make_pair(
+  edgeExtrema.push_back(std::make_pair(
       chebyBands[chebyBands.size() - 1].stop, extremaErrorValue));
-  // TODO (optimization): compute the error values at the
-  // boundaries of the subintervals in order to optimize
-  // the number of error evaluations needed per subinterval
-  // (i.e. since the error value at the interval extremities
-  // is used on average two times, we can pre-compute
-  // them for an average saving of one error evaluation
-  // per interval)
 
-  std::vector<std::vector<mpfr::mpreal>> pExs(subIntervals.size());
+  // the candidates of each subinterval (its boundaries and the local extrema
+  // of the error inside it) are evaluated in parallel and stored in their own
+  // slot, in increasing order
+  std::vector<std::vector<std::pair<mpfr::mpreal, mpfr::mpreal>>> candidates(
+      subIntervals.size());
 
-#pragma omp parallel for
-  for (std::size_t i = 0u; i < subIntervals.size(); ++i) {
+  parallelTasks(subIntervals.size(), [&](std::size_t i) {
+    ScopedPrecision threadGuard(prec);
+    MPWorkspace ws(prec);
 
     // find the Chebyshev nodes scaled to the current subinterval
     std::vector<mpfr::mpreal> siCN(Nmax + 1u);
@@ -368,9 +404,15 @@ void findEigenExtrema(mpfr::mpreal &convergenceOrder, mpfr::mpreal &delta,
 
     // compute the Chebyshev interpolation function values on the
     // current subinterval
+    // (the end nodes usually coincide with the subinterval boundaries)
     std::vector<mpfr::mpreal> fx(Nmax + 1u);
     for (std::size_t j = 0u; j < fx.size(); ++j) {
-      computeError(fx[j], siCN[j], delta, x, C, w, chebyBands, prec);
+      if (j == 0u && siCN[j] == subIntervals[i].second)
+        fx[j] = boundaryErrors[boundaryIndex[2u * i + 1u]];
+      else if (j == fx.size() - 1u && siCN[j] == subIntervals[i].first)
+        fx[j] = boundaryErrors[boundaryIndex[2u * i]];
+      else
+        computeError(fx[j], siCN[j], delta, x, C, w, chebyBands, ws);
     }
 
     // compute the values of the CI coefficients and those of its
@@ -386,37 +428,48 @@ void findEigenExtrema(mpfr::mpreal &convergenceOrder, mpfr::mpreal &delta,
     generateColleagueMatrix2ndKind(Cm, derivCoeffs, true, prec);
 
     std::vector<mpfr::mpreal> eigenRoots;
-    VectorXcq roots;
-    determineEigenvalues(roots, Cm);
-    getRealValues(eigenRoots, roots, a, b);
+    determineRealEigenvalues(eigenRoots, Cm, a, b);
     changeOfVariable(eigenRoots, eigenRoots, subIntervals[i].first,
                      subIntervals[i].second);
-    for (std::size_t j = 0u; j < eigenRoots.size(); ++j)
-      pExs[i].push_back(eigenRoots[j]);
-    pExs[i].push_back(subIntervals[i].first);
-    pExs[i].push_back(subIntervals[i].second);
-  }
-  for (std::size_t i = 0u; i < pExs.size(); ++i)
-    for (std::size_t j = 0u; j < pExs[i].size(); ++j)
-      pEx.push_back(pExs[i][j]);
-
-  std::size_t startingOffset = potentialExtrema.size();
-  //potentialExtrema.resize(potentialExtrema.size() + pEx.size());
-//#pragma omp parallel for
-  for (std::size_t i = 0u; i < pEx.size(); ++i) {
-    mpfr::mpreal valBuffer;
-    computeError(valBuffer, pEx[i], delta, x, C, w, chebyBands, prec);
-    //potentialExtrema[startingOffset + i] = std::make_pair(pEx[i], valBuffer);
-    if(mpfr::abs(valBuffer) >= mpfr::abs(delta))
-       potentialExtrema.push_back(std::make_pair(pEx[i], valBuffer));
-  }
 
-  // sort list of potential extrema in increasing order
-  std::sort(potentialExtrema.begin(), potentialExtrema.end(),
-            [](const std::pair<mpfr::mpreal, mpfr::mpreal> &lhs,
-               const std::pair<mpfr::mpreal, mpfr::mpreal> &rhs) {
-              return lhs.first < rhs.first;
-            });
+    std::vector<std::pair<mpfr::mpreal, mpfr::mpreal>> &slot = candidates[i];
+    slot.reserve(eigenRoots.size() + 2u);
+    std::size_t k = boundaryIndex[2u * i];
+    if (mpfr::abs(boundaryErrors[k]) >= mpfr::abs(delta))
+      slot.push_back(std::make_pair(boundaries[k], boundaryErrors[k]));
+    mpfr::mpreal valBuffer;
+    for (std::size_t j = 0u; j < eigenRoots.size(); ++j) {
+      computeError(valBuffer, eigenRoots[j], delta, x, C, w, chebyBands, ws);
+      if (mpfr::abs(valBuffer) >= mpfr::abs(delta))
+        slot.push_back(std::make_pair(eigenRoots[j], valBuffer));
+    }
+    k = boundaryIndex[2u * i + 1u];
+    if (mpfr::abs(boundaryErrors[k]) >= mpfr::abs(delta))
+      slot.push_back(std::make_pair(boundaries[k], boundaryErrors[k]));
+  });
+
+  // the subintervals are consecutive, so concatenating the slots gives an
+  // ordered list, which is then merged with the band edge candidates
+  std::size_t candidateCount = 0u;
+  for (std::size_t i = 0u; i < candidates.size(); ++i)
+    candidateCount += candidates[i].size();
+  std::vector<std::pair<mpfr::mpreal, mpfr::mpreal>> intervalExtrema;
+  intervalExtrema.reserve(candidateCount);
+  for (std::size_t i = 0u; i < candidates.size(); ++i)
+    std::move(candidates[i].begin(), candidates[i].end(),
+              std::back_inserter(intervalExtrema));
+  std::vector<std::pair<mpfr::mpreal, mpfr::mpreal>> potentialExtrema(
+      edgeExtrema.size() + intervalExtrema.size());
+  std::merge(std::make_move_iterator(edgeExtrema.begin()),
+             std::make_move_iterator(edgeExtrema.end()),
+             std::make_move_iterator(intervalExtrema.begin()),
+             std::make_move_iterator(intervalExtrema.end()),
+             potentialExtrema.begin(), lessThan);
+  // the change of variable can round a local extremum just outside of its
+  // subinterval, in which case the list has to be fully sorted
+  if (!std::is_sorted(potentialExtrema.begin(), potentialExtrema.end(),
+                      lessThan))
+    std::sort(potentialExtrema.begin(), potentialExtrema.end(), lessThan);
 
   eigenExtrema.clear();
   std::size_t extremaIt = 0u;
@@ -450,7 +503,6 @@ void findEigenExtrema(mpfr::mpreal &convergenceOrder, mpfr::mpreal &delta,
     std::cerr << "TRIGGER: Not enough alternating extrema!\n"
               << "POSSIBLE CAUSE: Nmax too small\n";
     convergenceOrder = 2.0;
-    mpreal::set_default_prec(prevPrec);
     return;
   } else if (alternatingExtrema.size() > x.size()) {
     std::size_t remSuperfluous = alternatingExtrema.size() - x.size();
@@ -547,7 +599,31 @@ void findEigenExtrema(mpfr::mpreal &convergenceOrder, mpfr::mpreal &delta,
     }
   }
 
-  mpreal::set_default_prec(prevPrec);
+}
+
+// computes the Chebyshev coefficients of the polynomial interpolating the
+// final reference of the exchange algorithm (output.delta is made positive)
+static void computeFinalCoefficients(PMOutput &output,
+                                     std::vector<Band> &chebyBands,
+                                     std::size_t degree, mp_prec_t prec) {
+  output.h.resize(degree + 1u);
+  std::vector<mpfr::mpreal> finalC(output.x.size());
+  std::vector<mpfr::mpreal> finalAlpha(output.x.size());
+  barycentricWeights(finalAlpha, output.x, prec);
+  mpfr::mpreal finalDelta = output.delta;
+  output.delta = mpfr::abs(output.delta);
+  //std::cout << "MINIMAX delta = " << output.delta << std::endl;
+  computeC(finalC, finalDelta, output.x, chebyBands, prec);
+  std::vector<mpfr::mpreal> finalChebyNodes(degree + 1);
+  generateEquidistantNodes(finalChebyNodes, degree, prec);
+  applyCos(finalChebyNodes, finalChebyNodes);
+  std::vector<mpfr::mpreal> fv(degree + 1);
+
+  MPWorkspace ws(prec);
+  for (std::size_t i = 0u; i < fv.size(); ++i)
+    computeApprox(fv[i], finalChebyNodes[i], output.x, finalC, finalAlpha, ws);
+
+  generateChebyshevCoefficients(output.h, fv, degree, prec);
 }
 
 // TODO: remember that this routine assumes that the information
@@ -557,8 +633,7 @@ void findEigenExtrema(mpfr::mpreal &convergenceOrder, mpfr::mpreal &delta,
 PMOutput exchange(std::vector<mpfr::mpreal> &x, std::vector<Band> &chebyBands,
                   mpfr::mpreal eps, int Nmax, mp_prec_t prec) {
   using mpfr::mpreal;
-  mpfr_prec_t prevPrec = mpreal::get_default_prec();
-  mpreal::set_default_prec(prec);
+  ScopedPrecision guard(prec);
 
   PMOutput output;
 
@@ -594,29 +669,257 @@ PMOutput exchange(std::vector<mpfr::mpreal> &x, std::vector<Band> &chebyBands,
               << "POSSIBLE CAUSES: poor starting reference and/or "
               << "a too small value for Nmax.\n";
 
-  for (std::size_t i = 0u; i < chebyBands.size(); ++i)
-    //std::cout << "Band " << i << " has " << chebyBands[i].extremas << std::endl;
+  computeFinalCoefficients(output, chebyBands, degree, prec);
+  return output;
+}
 
-  output.h.resize(degree + 1u);
-  std::vector<mpfr::mpreal> finalC(output.x.size());
-  std::vector<mpfr::mpreal> finalAlpha(output.x.size());
-  barycentricWeights(finalAlpha, output.x, prec);
-  mpfr::mpreal finalDelta = output.delta;
-  output.delta = mpfr::abs(output.delta);
-  //std::cout << "MINIMAX delta = " << output.delta << std::endl;
-  computeC(finalC, finalDelta, output.x, chebyBands, prec);
-  std::vector<mpfr::mpreal> finalChebyNodes(degree + 1);
-  generateEquidistantNodes(finalChebyNodes, degree, prec);
-  applyCos(finalChebyNodes, finalChebyNodes);
-  std::vector<mpfr::mpreal> fv(degree + 1);
+// computes the value p and the first two derivatives dp and d2p at t of the
+// barycentric interpolant of the values C at the nodes x (with weights w);
+// when t is the node x[node], the formulas of the differentiation matrices
+// are used, otherwise node has to be x.size()
+static void barycentricDerivatives(mpfr::mpreal &p, mpfr::mpreal &dp,
+                                   mpfr::mpreal &d2p, mpfr::mpreal const &t,
+                                   std::size_t node,
+                                   std::vector<mpfr::mpreal> &x,
+                                   std::vector<mpfr::mpreal> &C,
+                                   std::vector<mpfr::mpreal> &w) {
+  mpfr::mpreal diff, d, sum;
+  if (node < x.size()) {
+    // D_ij = (w_j / w_i) / (x_i - x_j), D_ii = -sum_{j != i} D_ij and
+    // D2_ij = 2 D_ij (D_ii - 1 / (x_i - x_j))
+    mpfr::mpreal dii = 0;
+    for (std::size_t j = 0u; j < x.size(); ++j)
+      if (j != node)
+        dii -= w[j] / (w[node] * (x[node] - x[j]));
+    p = C[node];
+    dp = d2p = 0;
+    for (std::size_t j = 0u; j < x.size(); ++j) {
+      if (j == node)
+        continue;
+      diff = x[node] - x[j];
+      d = w[j] / (w[node] * diff);
+      dp += d * (C[j] - C[node]);
+      d2p += 2 * d * (dii - 1 / diff) * (C[j] - C[node]);
+    }
+    return;
+  }
 
-  for (std::size_t i = 0u; i < fv.size(); ++i)
-    computeApprox(fv[i], finalChebyNodes[i], output.x, finalC, finalAlpha,
-                  prec);
+  // p^(k)(t) / k! = sum_j w_j p[t,...,t,x_j] / (t - x_j) / sum_j w_j / (t - x_j)
+  mpfr::mpreal num = 0;
+  sum = 0;
+  for (std::size_t j = 0u; j < x.size(); ++j) {
+    d = w[j] / (t - x[j]);
+    num += d * C[j];
+    sum += d;
+  }
+  p = num / sum;
+  dp = d2p = 0;
+  for (std::size_t j = 0u; j < x.size(); ++j) {
+    diff = t - x[j];
+    dp += w[j] * (p - C[j]) / (diff * diff);
+  }
+  dp /= sum;
+  for (std::size_t j = 0u; j < x.size(); ++j) {
+    diff = t - x[j];
+    d2p += w[j] * (dp - (p - C[j]) / diff) / (diff * diff);
+  }
+  d2p *= 2;
+  d2p /= sum;
+}
 
-  generateChebyshevCoefficients(output.h, fv, degree, prec);
-  mpreal::set_default_prec(prevPrec);
+// evaluates the ideal response and the weight function of a band
+static void bandResponse(mpfr::mpreal &D, mpfr::mpreal &W, Band &band,
+                         mpfr::mpreal const &t) {
+  if (band.amplitudeModel.type != FUNCTION)
+    evaluateResponse(D, band.amplitudeModel, band.space, t);
+  else
+    D = band.amplitude(band.space, t);
+  if (band.weightModel.type != FUNCTION)
+    evaluateResponse(W, band.weightModel, band.space, t);
+  else
+    W = band.weight(band.space, t);
+}
 
+// computes the values and the first two derivatives at t of the ideal
+// response (D) and of the weight function (W) of a band; the derivatives are
+// zero for constant functions and are otherwise approximated with central
+// differences of step h (the stencil is kept inside the band)
+static void bandDerivatives(mpfr::mpreal D[3], mpfr::mpreal W[3], Band &band,
+                            mpfr::mpreal const &t, mpfr::mpreal const &h) {
+  bandResponse(D[0], W[0], band, t);
+  D[1] = D[2] = W[1] = W[2] = 0;
+  if (band.amplitudeModel.type == CONSTANT && band.weightModel.type == CONSTANT)
+    return;
+  if (band.stop - band.start <= 2 * h)
+    return;
+  mpfr::mpreal c = mpfr::min(mpfr::max(t, band.start + h), band.stop - h);
+  mpfr::mpreal Dl, Wl, Dc, Wc, Dr, Wr;
+  bandResponse(Dl, Wl, band, c - h);
+  bandResponse(Dc, Wc, band, c);
+  bandResponse(Dr, Wr, band, c + h);
+  D[1] = (Dr - Dl) / (2 * h);
+  W[1] = (Wr - Wl) / (2 * h);
+  D[2] = (Dr - 2 * Dc + Dl) / (h * h);
+  W[2] = (Wr - 2 * Wc + Wl) / (h * h);
+}
+
+// maximum number of Newton steps used to refine an extremum
+static const std::size_t newtonSteps = 8u;
+
+// One iteration of the exchange algorithm in which the new reference is
+// obtained by refining each point of the current one (i.e. each extremum of
+// the previous iteration) with Newton's method applied to the derivative of
+// the error, instead of locating all the extrema of the error with
+// eigenvalue solvers. The points located on the band edges are kept. Each
+// Newton iteration is confined between the midpoints to the neighboring
+// reference points (and to its band), so the new reference keeps the
+// alternation of the current one. It returns false, in which case the
+// reference has to be computed with findEigenExtrema, if an iteration leaves
+// its interval, converges to a minimum of the absolute error or does not
+// converge.
+static bool refineExtrema(mpfr::mpreal &convergenceOrder, mpfr::mpreal &delta,
+                          std::vector<mpfr::mpreal> &newX,
+                          std::vector<mpfr::mpreal> &x,
+                          std::vector<Band> &chebyBands, mp_prec_t prec) {
+  using mpfr::mpreal;
+  ScopedPrecision guard(prec);
+
+  std::vector<mpreal> w(x.size());
+  barycentricWeights(w, x, prec);
+  computeDelta(delta, w, x, chebyBands, prec);
+  std::vector<mpreal> C(x.size());
+  computeC(C, delta, x, chebyBands, prec);
+
+  // the band of each reference point
+  std::vector<std::size_t> bandOf(x.size());
+  std::size_t offset = 0u;
+  for (std::size_t b = 0u; b < chebyBands.size(); ++b)
+    for (std::size_t j = 0u; j < chebyBands[b].extremas && offset < x.size();
+         ++j)
+      bandOf[offset++] = b;
+  if (offset != x.size())
+    return false;
+
+  mpreal tol = mpfr::ldexp(mpreal(1), -(mp_exp_t)(prec / 2u));
+  mpreal h = mpfr::ldexp(mpreal(1), -(mp_exp_t)(prec / 4u));
+  newX.resize(x.size());
+  std::vector<mpreal> errors(x.size());
+  bool failed = false;
+  parallelTasks(x.size(), [&](std::size_t i) {
+    ScopedPrecision threadGuard(prec);
+    MPWorkspace ws(prec);
+    Band &band = chebyBands[bandOf[i]];
+    newX[i] = x[i];
+    if (x[i] == band.start || x[i] == band.stop) {
+      computeError(errors[i], newX[i], delta, x, C, w, chebyBands, ws);
+      return;
+    }
+    mpreal lo = band.start;
+    if (i > 0u)
+      lo = mpfr::max(lo, (x[i - 1u] + x[i]) / 2);
+    mpreal hi = band.stop;
+    if (i + 1u < x.size())
+      hi = mpfr::min(hi, (x[i] + x[i + 1u]) / 2);
+    // the sign of the error at x[i]
+    int sign = (i % 2u == 0u) ? mpfr::sgn(delta) : -mpfr::sgn(delta);
+
+    mpreal &t = newX[i];
+    std::size_t node = i;
+    mpreal p, dp, d2p, e1, e2, step;
+    mpreal D[3], W[3];
+    bool converged = false;
+    for (std::size_t k = 0u; k < newtonSteps && !converged; ++k) {
+      barycentricDerivatives(p, dp, d2p, t, node, x, C, w);
+      bandDerivatives(D, W, band, t, h);
+      // e = W (p - D)
+      e1 = W[1] * (p - D[0]) + W[0] * (dp - D[1]);
+      e2 = W[2] * (p - D[0]) + 2 * W[1] * (dp - D[1]) + W[0] * (d2p - D[2]);
+      if (mpfr::sgn(e2) * sign >= 0)
+        break;
+      step = e1 / e2;
+      converged = mpfr::abs(step) <= tol * (hi - lo);
+      if (step == 0)
+        break;
+      t -= step;
+      node = x.size();
+      if (t <= lo || t >= hi)
+        break;
+    }
+    if (converged && t > lo && t < hi) {
+      computeError(errors[i], t, delta, x, C, w, chebyBands, ws);
+      if (mpfr::sgn(errors[i]) == sign)
+        return;
+    }
+#pragma omp atomic write
+    failed = true;
+  });
+  if (failed)
+    return false;
+
+  mpreal minError = mpfr::abs(errors[0]);
+  mpreal maxError = minError;
+  for (std::size_t i = 1u; i < errors.size(); ++i) {
+    minError = mpfr::min(minError, mpfr::abs(errors[i]));
+    maxError = mpfr::max(maxError, mpfr::abs(errors[i]));
+  }
+  convergenceOrder = (maxError - minError) / maxError;
+  return true;
+}
+
+PMOutput exchangeNewton(std::vector<mpfr::mpreal> &x,
+                        std::vector<Band> &chebyBands, mpfr::mpreal eps,
+                        int Nmax, mpfr::mpreal switchQ, std::size_t period,
+                        mp_prec_t prec) {
+  using mpfr::mpreal;
+  ScopedPrecision guard(prec);
+
+  PMOutput output;
+
+  std::size_t degree = x.size() - 2u;
+  std::sort(x.begin(), x.end(),
+            [](const mpfr::mpreal &lhs, const mpfr::mpreal &rhs) {
+              return lhs < rhs;
+            });
+  std::vector<mpfr::mpreal> startX{x};
+
+  // once the convergence parameter is below switchQ, the reference is
+  // refined with Newton's method, a full localization of the extrema being
+  // done at least once every period iterations, whenever a refinement fails
+  // and to confirm the convergence (a refinement cannot detect the new
+  // extrema of the error)
+  output.Q = 1;
+  output.iter = 0u;
+  std::size_t refinements = 0u;
+  do {
+    ++output.iter;
+    if (output.Q < switchQ && output.Q > eps && refinements + 1u < period &&
+        refineExtrema(output.Q, output.delta, output.x, startX, chebyBands,
+                      prec)) {
+      ++refinements;
+    } else {
+      findEigenExtrema(output.Q, output.delta, output.x, startX, chebyBands,
+                       Nmax, prec);
+      refinements = 0u;
+    }
+    startX = output.x;
+    if (output.Q > 1.0)
+      break;
+
+  } while ((output.Q > eps || refinements > 0u) && output.iter <= 100u);
+
+  if (isnan(output.delta) || isnan(output.Q))
+    std::cerr << "The exchange algorithm did not converge.\n"
+              << "TRIGGER: numerical instability\n"
+              << "POSSIBLE CAUSES: poor starting reference and/or "
+              << "a too small value for Nmax.\n";
+
+  if (output.iter > 101u)
+    std::cerr << "The exchange algorithm did not converge.\n"
+              << "TRIGGER: exceeded iteration threshold of 100\n"
+              << "POSSIBLE CAUSES: poor starting reference and/or "
+              << "a too small value for Nmax.\n";
+
+  computeFinalCoefficients(output, chebyBands, degree, prec);
   return output;
 }
 
@@ -626,8 +929,7 @@ PMOutput firpm(std::size_t n, std::vector<mpfr::mpreal> const &f,
                std::vector<mpfr::mpreal> const &w, mpfr::mpreal eps, int Nmax,
                mp_prec_t prec) {
   using mpfr::mpreal;
-  mpfr_prec_t prevPrec = mpreal::get_default_prec();
-  mpreal::set_default_prec(prec);
+  ScopedPrecision guard(prec);
   mpfr::mpreal pi = mpfr::const_pi(prec);
 
   std::vector<mpfr::mpreal> h;
@@ -698,7 +1000,6 @@ PMOutput firpm(std::size_t n, std::vector<mpfr::mpreal> const &f,
         h[degree + 1 - i] = h[degree + i] =
             (output.h[i - 1] + output.h[i]) / 4u;
       output.h = h;
-      mpreal::set_default_prec(prevPrec);
       return output;
     }
   }
@@ -711,19 +1012,10 @@ PMOutput firpm(std::size_t n, std::vector<mpfr::mpreal> const &f,
     freqBands[i].start = pi * f[2u * i];
     freqBands[i].stop = pi * f[2u * i + 1u];
     freqBands[i].space = BandSpace::FREQ;
-    freqBands[i].amplitude = [=](BandSpace bSpace,
-                                 mpfr::mpreal x) -> mpfr::mpreal {
-      if (a[2u * i] != a[2u * i + 1u]) {
-        if (bSpace == BandSpace::CHEBY)
-          x = mpfr::acos(x, MPFR_RNDN);
-        return ((x - freqBands[i].start) * a[2u * i + 1u] -
-                (x - freqBands[i].stop) * a[2u * i]) /
-               (freqBands[i].stop - freqBands[i].start);
-      }
-      return a[2u * i];
-    };
-    freqBands[i].weight = [=](BandSpace bSpace,
-                              mpfr::mpreal x) -> mpfr::mpreal { return w[i]; };
+    setAmplitude(freqBands[i],
+                 linearResponse(freqBands[i].start, freqBands[i].stop,
+                                a[2u * i], a[2u * i + 1u]));
+    setWeight(freqBands[i], constantResponse(w[i]));
   }
 
   std::vector<mpfr::mpreal> omega(degree + 2u);
@@ -744,7 +1036,6 @@ PMOutput firpm(std::size_t n, std::vector<mpfr::mpreal> const &f,
   for (std::size_t i{0u}; i < degree; ++i)
     h[i] = h[n - i] = output.h[degree - i] / 2u;
   output.h = h;
-  mpreal::set_default_prec(prevPrec);
   return output;
 }
 
@@ -753,8 +1044,7 @@ PMOutput firpmRS(std::size_t n, std::vector<mpfr::mpreal> const &f,
                  std::vector<mpfr::mpreal> const &w, mpfr::mpreal eps,
                  std::size_t depth, int Nmax, mp_prec_t prec) {
   using mpfr::mpreal;
-  mpfr_prec_t prevPrec = mpreal::get_default_prec();
-  mpreal::set_default_prec(prec);
+  ScopedPrecision guard(prec);
   mpfr::mpreal pi = mpfr::const_pi(prec);
 
   if (depth == 0u)
@@ -841,7 +1131,6 @@ PMOutput firpmRS(std::size_t n, std::vector<mpfr::mpreal> const &f,
         h[degree + 1 - i] = h[degree + i] =
             (output.h[i - 1] + output.h[i]) / 4u;
       output.h = h;
-      mpreal::set_default_prec(prevPrec);
       return output;
     }
   }
@@ -854,19 +1143,10 @@ PMOutput firpmRS(std::size_t n, std::vector<mpfr::mpreal> const &f,
     freqBands[i].start = pi * f[2u * i];
     freqBands[i].stop = pi * f[2u * i + 1u];
     freqBands[i].space = BandSpace::FREQ;
-    freqBands[i].amplitude = [=](BandSpace bSpace,
-                                 mpfr::mpreal x) -> mpfr::mpreal {
-      if (a[2u * i] != a[2u * i + 1u]) {
-        if (bSpace == BandSpace::CHEBY)
-          x = mpfr::acos(x);
-        return ((x - freqBands[i].start) * a[2u * i + 1u] -
-                (x - freqBands[i].stop) * a[2u * i]) /
-               (freqBands[i].stop - freqBands[i].start);
-      }
-      return a[2u * i];
-    };
-    freqBands[i].weight = [=](BandSpace bSpace,
-                              mpfr::mpreal x) -> mpfr::mpreal { return w[i]; };
+    setAmplitude(freqBands[i],
+                 linearResponse(freqBands[i].start, freqBands[i].stop,
+                                a[2u * i], a[2u * i + 1u]));
+    setWeight(freqBands[i], constantResponse(w[i]));
   }
 
   std::vector<std::size_t> scaledDegrees(depth + 1u);
@@ -894,7 +1174,6 @@ PMOutput firpmRS(std::size_t n, std::vector<mpfr::mpreal> const &f,
   for (std::size_t i{0u}; i < degree; ++i)
     h[i] = h[n - i] = output.h[degree - i] / 2u;
   output.h = h;
-  mpreal::set_default_prec(prevPrec);
   return output;
 }
 
@@ -904,8 +1183,7 @@ PMOutput firpm(std::size_t n, std::vector<mpfr::mpreal> const &f,
                std::vector<mpfr::mpreal> const &w, ftype type, mpfr::mpreal eps,
                int Nmax, mp_prec_t prec) {
   using mpfr::mpreal;
-  mpfr_prec_t prevPrec = mpreal::get_default_prec();
-  mpreal::set_default_prec(prec);
+  ScopedPrecision guard(prec);
   mpfr::mpreal pi = mpfr::const_pi(prec);
 
   PMOutput output;
@@ -968,18 +1246,9 @@ PMOutput firpm(std::size_t n, std::vector<mpfr::mpreal> const &f,
           }
 
         };
-        freqBands[i].amplitude = [freqBands, a, i](
-            BandSpace bSpace, mpfr::mpreal x) -> mpfr::mpreal {
-          if (a[2u * i] != a[2u * i + 1u]) {
-            if (bSpace == BandSpace::CHEBY)
-              x = mpfr::acos(x);
-            return ((x - freqBands[i].start) * a[2u * i + 1u] -
-                    (x - freqBands[i].stop) * a[2u * i]) /
-                   (freqBands[i].stop - freqBands[i].start);
-          }
-          return a[2u * i];
-
-        };
+        setAmplitude(freqBands[i],
+                     linearResponse(freqBands[i].start, freqBands[i].stop,
+                                    a[2u * i], a[2u * i + 1u]));
       }
 
     } else { // Type IV
@@ -1022,18 +1291,9 @@ PMOutput firpm(std::size_t n, std::vector<mpfr::mpreal> const &f,
           }
 
         };
-        freqBands[i].amplitude = [freqBands, a, i](
-            BandSpace bSpace, mpfr::mpreal x) -> mpfr::mpreal {
-          if (a[2u * i] != a[2u * i + 1u]) {
-            if (bSpace == BandSpace::CHEBY)
-              x = mpfr::acos(x);
-            return ((x - freqBands[i].start) * a[2u * i + 1u] -
-                    (x - freqBands[i].stop) * a[2u * i]) /
-                   (freqBands[i].stop - freqBands[i].start);
-          }
-          return a[2u * i];
-
-        };
+        setAmplitude(freqBands[i],
+                     linearResponse(freqBands[i].start, freqBands[i].stop,
+                                    a[2u * i], a[2u * i + 1u]));
       }
     }
 
@@ -1190,7 +1450,6 @@ PMOutput firpm(std::size_t n, std::vector<mpfr::mpreal> const &f,
   } break;
   }
   output.h = h;
-  mpreal::set_default_prec(prevPrec);
   return output;
 }
 
@@ -1200,8 +1459,7 @@ PMOutput firpmRS(std::size_t n, std::vector<mpfr::mpreal> const &f,
                  mpfr::mpreal eps, std::size_t depth, int Nmax,
                  mp_prec_t prec) {
   using mpfr::mpreal;
-  mpfr_prec_t prevPrec = mpreal::get_default_prec();
-  mpreal::set_default_prec(prec);
+  ScopedPrecision guard(prec);
   mpfr::mpreal pi = mpfr::const_pi(prec);
 
   if (depth == 0u)
@@ -1266,18 +1524,9 @@ PMOutput firpmRS(std::size_t n, std::vector<mpfr::mpreal> const &f,
           }
 
         };
-        freqBands[i].amplitude = [freqBands, a, i](
-            BandSpace bSpace, mpfr::mpreal x) -> mpfr::mpreal {
-          if (a[2u * i] != a[2u * i + 1u]) {
-            if (bSpace == BandSpace::CHEBY)
-              x = mpfr::acos(x);
-            return ((x - freqBands[i].start) * a[2u * i + 1u] -
-                    (x - freqBands[i].stop) * a[2u * i]) /
-                   (freqBands[i].stop - freqBands[i].start);
-          }
-          return a[2u * i];
-
-        };
+        setAmplitude(freqBands[i],
+                     linearResponse(freqBands[i].start, freqBands[i].stop,
+                                    a[2u * i], a[2u * i + 1u]));
       }
 
     } else { // Type IV
@@ -1320,18 +1569,9 @@ PMOutput firpmRS(std::size_t n, std::vector<mpfr::mpreal> const &f,
           }
 
         };
-        freqBands[i].amplitude = [freqBands, a, i](
-            BandSpace bSpace, mpfr::mpreal x) -> mpfr::mpreal {
-          if (a[2u * i] != a[2u * i + 1u]) {
-            if (bSpace == BandSpace::CHEBY)
-              x = mpfr::acos(x);
-            return ((x - freqBands[i].start) * a[2u * i + 1u] -
-                    (x - freqBands[i].stop) * a[2u * i]) /
-                   (freqBands[i].stop - freqBands[i].start);
-          }
-          return a[2u * i];
-
-        };
+        setAmplitude(freqBands[i],
+                     linearResponse(freqBands[i].start, freqBands[i].stop,
+                                    a[2u * i], a[2u * i + 1u]));
       }
     }
 
@@ -1513,23 +1753,29 @@ PMOutput firpmRS(std::size_t n, std::vector<mpfr::mpreal> const &f,
   } break;
   }
   output.h = h;
-  mpreal::set_default_prec(prevPrec);
   return output;
 }
 
+void firpmBatch(std::vector<PMOutput> &outputs,
+                std::vector<PMSpec> const &specs, std::size_t threads) {
+  outputs.resize(specs.size());
+  runTasks(specs.size(), [&](std::size_t i) {
+    PMSpec const &spec = specs[i];
+    outputs[i] = firpmRS(spec.N, spec.f, spec.a, spec.w, spec.epsT,
+                         spec.depth, spec.Nmax, spec.prec);
+  }, threads);
+}
 
-typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic> MatrixXd;
-typedef Eigen::Matrix<double, Eigen::Dynamic, 1> VectorXd;
-typedef Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1> VectorXcd;
 
-void generateVandermondeMatrix(MatrixXd& A, std::size_t degree, std::vector<double>& meshPoints,
-        std::function<double(double)>& weightFunction)
+template <typename T>
+void generateVandermondeMatrix(MatrixXT<T>& A, std::size_t degree, std::vector<T>& meshPoints,
+        std::function<T(T)>& weightFunction)
 {
 
     A.resize(degree + 1u, meshPoints.size());
     for(std::size_t i = 0u; i < meshPoints.size(); ++i)
     {
-        double pointWeight = weightFunction(meshPoints[i]);
+        T pointWeight = weightFunction(meshPoints[i]);
         A(0u, i) = 1;
         A(1u, i) = meshPoints[i];
         for(std::size_t j = 2u; j <= degree; ++j)
@@ -1540,25 +1786,24 @@ void generateVandermondeMatrix(MatrixXd& A, std::size_t degree, std::vector<doub
 }
 
 // approximate Fekete points
-void AFPPM(std::vector<double>& points, MatrixXd& A, std::vector<double>& meshPoints)
+template <typename T>
+void AFPPM(std::vector<T>& points, MatrixXT<T>& A, std::vector<T>& meshPoints)
 {
-    VectorXd b = VectorXd::Ones(A.rows());
-    b(0) = 2;
-    VectorXd y = A.colPivHouseholderQr().solve(b);
-
+    std::vector<std::size_t> pivots;
+    pivotedQRSelection(pivots, A);
 
-    for(std::size_t i = 0u; i < y.rows(); ++i)
-        if(y(i) != 0.0)
-            points.push_back(meshPoints[i]);
+    for(auto& it : pivots)
+        points.push_back(meshPoints[it]);
     std::sort(points.begin(), points.end(),
-            [](const double& lhs,
-               const double& rhs) {
+            [](const T& lhs,
+               const T& rhs) {
                 return lhs < rhs;
             });
 
 }
 
-void bandCountPM(std::vector<BandD>& chebyBands, std::vector<double>& x)
+template <typename T>
+void bandCountPM(std::vector<BandT<T>>& chebyBands, std::vector<T>& x)
 {
     for(auto& it : chebyBands)
         it.extremas = 0u;
@@ -1573,16 +1818,17 @@ void bandCountPM(std::vector<BandD>& chebyBands, std::vector<double>& x)
 
 
 
-void generateWAM(std::vector<double>& wam, std::vector<BandD>& chebyBands, std::size_t degree)
+template <typename T>
+void generateWAM(std::vector<T>& wam, std::vector<BandT<T>>& chebyBands, std::size_t degree)
 {
-    std::vector<double> chebyNodes(degree + 2u);
+    std::vector<T> chebyNodes(degree + 2u);
     generateEquidistantNodes(chebyNodes, degree + 1u);
     applyCos(chebyNodes, chebyNodes);
     for(std::size_t i = 0u; i < chebyBands.size(); ++i)
     {
         if(chebyBands[i].start != chebyBands[i].stop)
         {
-            std::vector<double> bufferNodes(degree + 2u);
+            std::vector<T> bufferNodes(degree + 2u);
             changeOfVariable(bufferNodes, chebyNodes,
                     chebyBands[i].start, chebyBands[i].stop);
             for(auto& it : bufferNodes)
@@ -1594,12 +1840,111 @@ void generateWAM(std::vector<double>& wam, std::vector<BandD>& chebyBands, std::
 }
 
 
-void initUniformExtremas(std::vector<double>& omega,
-        std::vector<BandD>& B)
+// the AFP references computed by afpReference, keyed by the degree and by
+// the band edges and weights (a few entries are kept, the oldest one being
+// discarded first)
+template <typename T>
+struct AFPCache
+{
+    static std::mutex mutex;
+    static std::map<std::string, std::vector<T>> entries;
+    static std::vector<std::string> order;
+};
+
+template <typename T> std::mutex AFPCache<T>::mutex;
+template <typename T>
+std::map<std::string, std::vector<T>> AFPCache<T>::entries;
+template <typename T> std::vector<std::string> AFPCache<T>::order;
+
+static const std::size_t afpCacheCapacity = 32u;
+
+template <typename T>
+static void appendKey(std::string& key, T const& value)
+{
+    key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// computes the AFP reference of a degree and a set of bands (given inside
+// [-1,1]), i.e. the points of the WAM selected by the pivoted QR
+// factorization of the weighted Vandermonde matrix; the references of
+// bands whose weights are given by analytic descriptions are cached, so
+// that the sweeps over the filter order or over the word length factor
+// each band layout only once
+template <typename T>
+void afpReference(std::vector<T>& afpX, std::vector<BandT<T>>& chebyBands,
+        std::size_t degree)
+{
+    bool cacheable = true;
+    std::string key;
+    appendKey(key, degree);
+    for(auto& it : chebyBands)
+    {
+        appendKey(key, it.start);
+        appendKey(key, it.stop);
+        appendKey(key, it.weightModel.type);
+        for(auto& c : it.weightModel.coeffs)
+            appendKey(key, c);
+        if(it.weightModel.type == FUNCTION)
+            cacheable = false;
+    }
+    if(cacheable)
+    {
+        std::lock_guard<std::mutex> lock(AFPCache<T>::mutex);
+        auto entry = AFPCache<T>::entries.find(key);
+        if(entry != AFPCache<T>::entries.end())
+        {
+            afpX = entry->second;
+            return;
+        }
+    }
+
+    std::function<T(T)> weightFunction = [=](T x) -> T
+    {
+        for(std::size_t i = 0u; i < chebyBands.size(); ++i)
+            if(chebyBands[i].start <= x && x <= chebyBands[i].stop)
+                return chebyBands[i].weight(BandSpace::CHEBY, x);
+    };
+    std::vector<T> wam;
+    generateWAM(wam, chebyBands, degree);
+    MatrixXT<T> A;
+    generateVandermondeMatrix(A, degree + 1u, wam, weightFunction);
+    afpX.clear();
+    AFPPM(afpX, A, wam);
+
+    if(cacheable)
+    {
+        std::lock_guard<std::mutex> lock(AFPCache<T>::mutex);
+        if(AFPCache<T>::entries.emplace(key, afpX).second)
+        {
+            AFPCache<T>::order.push_back(key);
+            if(AFPCache<T>::order.size() > afpCacheCapacity)
+            {
+                AFPCache<T>::entries.erase(AFPCache<T>::order.front());
+                AFPCache<T>::order.erase(AFPCache<T>::order.begin());
+            }
+        }
+    }
+}
+
+void clearAFPCache()
+{
+    {
+        std::lock_guard<std::mutex> lock(AFPCache<double>::mutex);
+        AFPCache<double>::entries.clear();
+        AFPCache<double>::order.clear();
+    }
+    std::lock_guard<std::mutex> lock(AFPCache<dd::ddreal>::mutex);
+    AFPCache<dd::ddreal>::entries.clear();
+    AFPCache<dd::ddreal>::order.clear();
+}
+
+template <typename T>
+void initUniformExtremas(std::vector<T>& omega,
+        std::vector<BandT<T>>& B)
 {
-    double avgDistance = 0;
+    T avgDistance = 0;
 
-    std::vector<double> bandwidths(B.size());
+    std::vector<T> bandwidths(B.size());
     std::vector<std::size_t> nonPointBands;
     for(std::size_t i = 0; i < B.size(); ++i) {
         bandwidths[i] = B[i].stop - B[i].start;
@@ -1620,7 +1965,7 @@ void initUniformExtremas(std::vector<double>& omega,
     avgDistance /= (omega.size() - B.size());
 
     B[nonPointBands[nonPointBands.size() - 1u]].extremas = omega.size() - (B.size() - nonPointBands.size());
-    double buffer;
+    T buffer;
     buffer = bandwidths[nonPointBands[0]] / avgDistance;
     buffer += 0.5;
 
@@ -1649,10 +1994,11 @@ void initUniformExtremas(std::vector<double>& omega,
         }
 }
 
-void referenceScaling(std::vector<double>& newX, std::vector<BandD>& newChebyBands,
-        std::vector<BandD>& newFreqBands, std::size_t newXSize,
-        std::vector<double>& x, std::vector<BandD>& chebyBands,
-        std::vector<BandD>& freqBands)
+template <typename T>
+void referenceScaling(std::vector<T>& newX, std::vector<BandT<T>>& newChebyBands,
+        std::vector<BandT<T>>& newFreqBands, std::size_t newXSize,
+        std::vector<T>& x, std::vector<BandT<T>>& chebyBands,
+        std::vector<BandT<T>>& freqBands)
 {
         std::vector<std::size_t> newDistribution(chebyBands.size());
         for(std::size_t i{0u}; i < chebyBands.size(); ++i)
@@ -1693,7 +2039,7 @@ void referenceScaling(std::vector<double>& newX, std::vector<BandD>& newChebyBan
                     if(threeInt > 0)
                     {
                         newX.push_back(x[offset] + (x[offset + 1] - x[offset]) / 3);
-                        double secondValue = x[offset] + (x[offset + 1] - x[offset]) / 3
+                        T secondValue = x[offset] + (x[offset + 1] - x[offset]) / 3
                             + (x[offset + 1] - x[offset]) / 3;
                         newX.push_back(secondValue);
                         threeInt--;
@@ -1717,7 +2063,7 @@ void referenceScaling(std::vector<double>& newX, std::vector<BandD>& newChebyBan
                         newX.push_back(x[offset + chebyBands[i].extremas - 2u] +
                                 (x[offset + chebyBands[i].extremas - 1u] -
                                  x[offset + chebyBands[i].extremas - 2u]) / 3);
-                        double secondValue = x[offset + chebyBands[i].extremas - 2u] +
+                        T secondValue = x[offset + chebyBands[i].extremas - 2u] +
                             (x[offset + chebyBands[i].extremas - 1u] -
                              x[offset + chebyBands[i].extremas - 2u]) / 3 +
                             (x[offset + chebyBands[i].extremas - 1u] -
@@ -1769,16 +2115,17 @@ void referenceScaling(std::vector<double>& newX, std::vector<BandD>& newChebyBan
 
 
 
-void splitInterval(std::vector<IntervalD>& subIntervals,
-        std::vector<BandD>& chebyBands,
-        std::vector<double> &x)
+template <typename T>
+void splitInterval(std::vector<IntervalT<T>>& subIntervals,
+        std::vector<BandT<T>>& chebyBands,
+        std::vector<T> &x)
 {
     std::size_t bandOffset = 0u;
     for(std::size_t i = 0u; i < chebyBands.size(); ++i)
     {
         if(bandOffset < x.size())
         {
-            double middleValA, middleValB;
+            T middleValA, middleValB;
             if (x[bandOffset] > chebyBands[i].start
                 && x[bandOffset] < chebyBands[i].stop)
             {
@@ -1806,17 +2153,19 @@ void splitInterval(std::vector<IntervalD>& subIntervals,
     }
 }
 
-void findEigenExtrema(double& convergenceOrder,
-        double& delta, std::vector<double>& eigenExtrema,
-        std::vector<double>& x, std::vector<BandD>& chebyBands,
+template <typename T>
+void findEigenExtrema(T& convergenceOrder,
+        T& delta, std::vector<T>& eigenExtrema,
+        std::vector<T>& x, std::vector<BandT<T>>& chebyBands,
         int Nmax)
 {
+    using std::signbit;
     // 1.   Split the initial [-1, 1] interval in subintervals
     //      in order that we can use a reasonable size matrix
     //      eigenvalue solver on the subintervals
-    std::vector<IntervalD> subIntervals;
-    double a = -1;
-    double b = 1;
+    std::vector<IntervalT<T>> subIntervals;
+    T a = -1;
+    T b = 1;
 
     splitInterval(subIntervals, chebyBands, x);
 
@@ -1826,147 +2175,184 @@ void findEigenExtrema(double& convergenceOrder,
     // 2.   Compute the barycentric variables (i.e. weights)
     //      needed for the current iteration
 
-    std::vector<double> w(x.size());
+    std::vector<T> w(x.size());
     barycentricWeights(w, x);
 
 
     computeDelta(delta, w, x, chebyBands);
     //std::cout << "delta = " << delta << std::endl;
 
-    std::vector<double> C(x.size());
+    std::vector<T> C(x.size());
     computeC(C, delta, x, chebyBands);
 
     // 3.   Use an eigenvalue solver on each subinterval to find the
     //      local extrema that are located inside the frequency bands
-    std::vector<double> chebyNodes(Nmax + 1u);
+    std::vector<T> chebyNodes(Nmax + 1u);
     generateEquidistantNodes(chebyNodes, Nmax);
     applyCos(chebyNodes, chebyNodes);
 
 
-    std::vector<std::pair<double, double>> potentialExtrema;
-    std::vector<double> pEx;
-    double extremaErrorValueLeft;
-    double extremaErrorValueRight;
-    double extremaErrorValue;
-    computeError(extremaErrorValue, chebyBands[0].start,
-            delta, x, C, w, chebyBands);
-    potentialExtrema.push_back(std::make_pair(
+    // the error values at the subinterval boundaries are shared by the
+    // neighbouring subintervals, the band edge tests and the candidate
+    // extrema pass, so they are computed only once
+    std::vector<T> boundaries;
+    std::vector<std::size_t> boundaryIndex(2u * subIntervals.size());
+    for (std::size_t i = 0u; i < subIntervals.size(); ++i)
+    {
+        if (boundaries.empty() || boundaries.back() != subIntervals[i].first)
+            boundaries.push_back(subIntervals[i].first);
+        boundaryIndex[2u * i] = boundaries.size() - 1u;
+        boundaries.push_back(subIntervals[i].second);
+        boundaryIndex[2u * i + 1u] = boundaries.size() - 1u;
+    }
+    std::vector<T> boundaryErrors(boundaries.size());
+    parallelTasks(boundaries.size(), [&](std::size_t i) {
+        computeError(boundaryErrors[i], boundaries[i],
+                delta, x, C, w, chebyBands);
+    }, boundaryBlockSize);
+    auto edgeError = [&](T& value, T& t) {
+        auto it = std::find(boundaries.begin(), boundaries.end(), t);
+        if (it != boundaries.end())
+            value = boundaryErrors[it - boundaries.begin()];
+        else
+            computeError(value, t, delta, x, C, w, chebyBands);
+    };
+
+    auto lessThan = [](const std::pair<T, T>& lhs,
+                       const std::pair<T, T>& rhs) {
+        return lhs.first < rhs.first;
+    };
+
+    // the band edge candidates (in increasing order)
+    std::vector<std::pair<T, T>> edgeExtrema;
+    T extremaErrorValueLeft;
+    T extremaErrorValueRight;
+    T extremaErrorValue;
+    edgeError(extremaErrorValue, chebyBands[0].start);
+    edgeExtrema.push_back(std::make_pair(
             chebyBands[0].start, extremaErrorValue));
 
 
     for (std::size_t i = 0u; i < chebyBands.size() - 1; ++i)
     {
-        computeError(extremaErrorValueLeft, chebyBands[i].stop,
-                delta, x, C, w, chebyBands);
-        computeError(extremaErrorValueRight, chebyBands[i + 1].start,
-                delta, x, C, w, chebyBands);
-        bool sgnLeft = std::signbit(extremaErrorValueLeft);
-        bool sgnRight = std::signbit(extremaErrorValueRight);
+        edgeError(extremaErrorValueLeft, chebyBands[i].stop);
+        edgeError(extremaErrorValueRight, chebyBands[i + 1].start);
+        bool sgnLeft = signbit(extremaErrorValueLeft);
+        bool sgnRight = signbit(extremaErrorValueRight);
         if (sgnLeft != sgnRight) {
-            potentialExtrema.push_back(std::make_pair(
+            edgeExtrema.push_back(std::make_pair(
                     chebyBands[i].stop, extremaErrorValueLeft));
-            potentialExtrema.push_back(std::make_pair(
+            edgeExtrema.push_back(std::make_pair(
                     chebyBands[i + 1].start, extremaErrorValueRight));
         } else {
-            double abs1 = fabs(extremaErrorValueLeft);
-            double abs2 = fabs(extremaErrorValueRight);
+            T abs1 = fabs(extremaErrorValueLeft);
+            T abs2 = fabs(extremaErrorValueRight);
             if(abs1 > abs2)
-                potentialExtrema.push_back(std::make_pair(
+                edgeExtrema.push_back(std::make_pair(
                         chebyBands[i].stop, extremaErrorValueLeft));
             else
-                potentialExtrema.push_back(std::make_pair(
+                edgeExtrema.push_back(std::make_pair(
                         chebyBands[i + 1].start, extremaErrorValueRight));
         }
     }
-    computeError(extremaErrorValue,
-            chebyBands[chebyBands.size() - 1].stop,
-            delta, x, C, w, chebyBands);
-    potentialExtrema.push_back(std::make_pair(
+    edgeError(extremaErrorValue, chebyBands[chebyBands.size() - 1].stop);
+    edgeExtrema.push_back(std::make_pair(
             chebyBands[chebyBands.size() - 1].stop,
             extremaErrorValue));
 
 
-    std::vector<std::vector<double>> pExs(subIntervals.size());
+    // the candidates of each subinterval (its boundaries and the local
+    // extrema of the error inside it) are evaluated in parallel and stored
+    // in their own slot, in increasing order
+    std::vector<std::vector<std::pair<T, T>>> candidates(subIntervals.size());
 
-    #pragma omp parallel for
-    for (std::size_t i = 0u; i < subIntervals.size(); ++i)
-    {
+    parallelTasks(subIntervals.size(), [&](std::size_t i) {
 
         // find the Chebyshev nodes scaled to the current subinterval
-        std::vector<double> siCN(Nmax + 1u);
+        std::vector<T> siCN(Nmax + 1u);
         changeOfVariable(siCN, chebyNodes, subIntervals[i].first,
                 subIntervals[i].second);
 
         // compute the Chebyshev interpolation function values on the
         // current subinterval
-        std::vector<double> fx(Nmax + 1u);
-        for (std::size_t j = 0u; j < fx.size(); ++j)
-        {
-            computeError(fx[j], siCN[j], delta, x, C, w,
-                    chebyBands);
-
-        }
+        // (the end nodes usually coincide with the subinterval boundaries)
+        std::vector<T> fx(Nmax + 1u);
+        computeError(fx.data() + 1u, siCN.data() + 1u, Nmax - 1u,
+                delta, x, C, w, chebyBands);
+        if (siCN[0u] == subIntervals[i].second)
+            fx[0u] = boundaryErrors[boundaryIndex[2u * i + 1u]];
+        else
+            computeError(fx[0u], siCN[0u], delta, x, C, w, chebyBands);
+        if (siCN[Nmax] == subIntervals[i].first)
+            fx[Nmax] = boundaryErrors[boundaryIndex[2u * i]];
+        else
+            computeError(fx[Nmax], siCN[Nmax], delta, x, C, w, chebyBands);
 
         // compute the values of the CI coefficients and those of its
         // derivative
-        std::vector<double> chebyCoeffs(Nmax + 1u);
+        std::vector<T> chebyCoeffs(Nmax + 1u);
         generateChebyshevCoefficients(chebyCoeffs, fx, Nmax);
-        std::vector<double> derivCoeffs(Nmax);
+        std::vector<T> derivCoeffs(Nmax);
         derivativeCoefficients2ndKind(derivCoeffs, chebyCoeffs);
 
         // solve the corresponding eigenvalue problem and determine the
         // local extrema situated in the current subinterval
-        MatrixXd Cm(Nmax - 1u, Nmax - 1u);
+        MatrixXT<T> Cm(Nmax - 1u, Nmax - 1u);
         generateColleagueMatrix2ndKind(Cm, derivCoeffs);
 
-        std::vector<double> eigenRoots;
-        VectorXcd roots;
-        determineEigenvalues(roots, Cm);
-        getRealValues(eigenRoots, roots, a, b);
+        std::vector<T> eigenRoots;
+        determineRealEigenvalues(eigenRoots, Cm, a, b);
         changeOfVariable(eigenRoots, eigenRoots,
                 subIntervals[i].first, subIntervals[i].second);
-        for (std::size_t j = 0u; j < eigenRoots.size(); ++j)
-            pExs[i].push_back(eigenRoots[j]);
-        pExs[i].push_back(subIntervals[i].first);
-        pExs[i].push_back(subIntervals[i].second);
-    }
 
-    for(std::size_t i = 0u; i < pExs.size(); ++i)
-        for(std::size_t j = 0u; j < pExs[i].size(); ++j)
-            pEx.push_back(pExs[i][j]);
+        std::vector<T> rootErrors;
+        computeError(rootErrors, eigenRoots, delta, x, C, w, chebyBands);
 
-    std::size_t startingOffset = potentialExtrema.size();
-    potentialExtrema.resize(potentialExtrema.size() + pEx.size());
-    #pragma omp parallel for
-    for(std::size_t i = 0u; i < pEx.size(); ++i)
-    {
-        double valBuffer;
-        computeError(valBuffer, pEx[i],
-                delta, x, C, w, chebyBands);
-        potentialExtrema[startingOffset + i] = std::make_pair(pEx[i], valBuffer);
-    }
-
-    // sort list of potential extrema in increasing order
-    std::sort(potentialExtrema.begin(), potentialExtrema.end(),
-            [](const std::pair<double, double>& lhs,
-               const std::pair<double, double>& rhs) {
-                return lhs.first < rhs.first;
-            });
+        std::vector<std::pair<T, T>>& slot = candidates[i];
+        slot.reserve(eigenRoots.size() + 2u);
+        std::size_t k = boundaryIndex[2u * i];
+        slot.push_back(std::make_pair(boundaries[k], boundaryErrors[k]));
+        for (std::size_t j = 0u; j < eigenRoots.size(); ++j)
+            slot.push_back(std::make_pair(eigenRoots[j], rootErrors[j]));
+        k = boundaryIndex[2u * i + 1u];
+        slot.push_back(std::make_pair(boundaries[k], boundaryErrors[k]));
+    });
+
+    // the subintervals are consecutive, so concatenating the slots gives an
+    // ordered list, which is then merged with the band edge candidates
+    std::size_t candidateCount = 0u;
+    for (std::size_t i = 0u; i < candidates.size(); ++i)
+        candidateCount += candidates[i].size();
+    std::vector<std::pair<T, T>> intervalExtrema;
+    intervalExtrema.reserve(candidateCount);
+    for (std::size_t i = 0u; i < candidates.size(); ++i)
+        intervalExtrema.insert(intervalExtrema.end(),
+                candidates[i].begin(), candidates[i].end());
+    std::vector<std::pair<T, T>> potentialExtrema(
+            edgeExtrema.size() + intervalExtrema.size());
+    std::merge(edgeExtrema.begin(), edgeExtrema.end(),
+            intervalExtrema.begin(), intervalExtrema.end(),
+            potentialExtrema.begin(), lessThan);
+    // the change of variable can round a local extremum just outside of its
+    // subinterval, in which case the list has to be fully sorted
+    if (!std::is_sorted(potentialExtrema.begin(), potentialExtrema.end(),
+                lessThan))
+        std::sort(potentialExtrema.begin(), potentialExtrema.end(), lessThan);
 
     eigenExtrema.clear();
     std::size_t extremaIt = 0u;
-    std::vector<std::pair<double, double>> alternatingExtrema;
-    double minError = INT_MAX;
-    double maxError = INT_MIN;
-    double absError;
+    std::vector<std::pair<T, T>> alternatingExtrema;
+    T minError = INT_MAX;
+    T maxError = INT_MIN;
+    T absError;
 
     while (extremaIt < potentialExtrema.size())
     {
-        std::pair<double, double> maxErrorPoint;
+        std::pair<T, T> maxErrorPoint;
         maxErrorPoint = potentialExtrema[extremaIt];
         while(extremaIt < potentialExtrema.size() - 1 &&
-            (std::signbit(maxErrorPoint.second) ==
-             std::signbit(potentialExtrema[extremaIt + 1].second)))
+            (signbit(maxErrorPoint.second) ==
+             signbit(potentialExtrema[extremaIt + 1].second)))
         {
             ++extremaIt;
             if (fabs(maxErrorPoint.second) < fabs(potentialExtrema[extremaIt].second))
@@ -1975,7 +2361,7 @@ void findEigenExtrema(double& convergenceOrder,
         alternatingExtrema.push_back(maxErrorPoint);
         ++extremaIt;
     }
-    std::vector<std::pair<double, double>> bufferExtrema;
+    std::vector<std::pair<T, T>> bufferExtrema;
     //std::cout << "Alternating extrema: " << x.size() << " | "
     //    << alternatingExtrema.size() << std::endl;
 
@@ -1994,7 +2380,7 @@ void findEigenExtrema(double& convergenceOrder,
         {
             if(remSuperfluous == 1u)
             {
-                std::vector<double> x1, x2;
+                std::vector<T> x1, x2;
                 x1.push_back(alternatingExtrema[0u].first);
                 for(std::size_t i{1u}; i < alternatingExtrema.size() - 1; ++i)
                 {
@@ -2002,7 +2388,7 @@ void findEigenExtrema(double& convergenceOrder,
                     x2.push_back(alternatingExtrema[i].first);
                 }
                 x2.push_back(alternatingExtrema[alternatingExtrema.size() - 1u].first);
-                double delta1, delta2;
+                T delta1, delta2;
                 computeDelta(delta1, x1, chebyBands);
                 computeDelta(delta2, x2, chebyBands);
                 delta1 = fabsl(delta1);
@@ -2017,8 +2403,8 @@ void findEigenExtrema(double& convergenceOrder,
             }
             else
             {
-                double abs1 = fabs(alternatingExtrema[0].second);
-                double abs2 = fabs(alternatingExtrema[alternatingExtrema.size() - 1].second);
+                T abs1 = fabs(alternatingExtrema[0].second);
+                T abs2 = fabs(alternatingExtrema[alternatingExtrema.size() - 1].second);
                 std::size_t sIndex = 0u;
                 if (abs1 < abs2)
                     sIndex = 1u;
@@ -2033,9 +2419,9 @@ void findEigenExtrema(double& convergenceOrder,
         while (alternatingExtrema.size() > x.size())
         {
             std::size_t toRemoveIndex = 0u;
-            double minValToRemove = fminl(fabsl(alternatingExtrema[0].second),
+            T minValToRemove = fminl(fabsl(alternatingExtrema[0].second),
                                               fabsl(alternatingExtrema[1].second));
-            double removeBuffer;
+            T removeBuffer;
             for (std::size_t i{1u}; i < alternatingExtrema.size() - 1; ++i)
             {
                 removeBuffer = fminl(fabsl(alternatingExtrema[i].second),
@@ -2100,24 +2486,26 @@ void findEigenExtrema(double& convergenceOrder,
 // pertaining to the reference x and the frequency bands (i.e. the
 // number of reference values inside each band) is given at the
 // beginning of the execution
-PMOutputD exchange(std::vector<double>& x,
-        std::vector<BandD>& chebyBands, double eps,
+template <typename T>
+PMOutputT<T> exchange(std::vector<T>& x,
+        std::vector<BandT<T>>& chebyBands, T eps,
         int Nmax)
 {
-    PMOutputD output;
+    using std::isnan;
+    PMOutputT<T> output;
 
     std::size_t degree = x.size() - 2u;
     std::sort(x.begin(), x.end(),
-            [](const double& lhs,
-               const double& rhs) {
+            [](const T& lhs,
+               const T& rhs) {
                 return lhs < rhs;
             });
-    std::vector<double> startX{x};
+    std::vector<T> startX{x};
     std::cout.precision(20);
 
     output.Q = 1;
     output.iter = 0u;
-    //double lastDelta = 1.0;
+    //T lastDelta = 1.0;
     do {
         ++output.iter;
         //std::cout << "*********ITERATION " << output.iter << " **********\n";
@@ -2131,7 +2519,7 @@ PMOutputD exchange(std::vector<double>& x,
         //std::cout << "*********ITERATION " << output.iter << " **********\n";
     } while (output.Q > eps && output.iter <= 100u);
 
-    if(std::isnan(output.delta) || std::isnan(output.Q))
+    if(isnan(output.delta) || isnan(output.Q))
         std::cerr << "The exchange algorithm did not converge.\n"
             << "TRIGGER: numerical instability\n"
             << "POSSIBLE CAUSES: poor starting reference and/or "
@@ -2145,21 +2533,19 @@ PMOutputD exchange(std::vector<double>& x,
 
 
     output.h.resize(degree + 1u);
-    std::vector<double> finalC(output.x.size());
-    std::vector<double> finalAlpha(output.x.size());
+    std::vector<T> finalC(output.x.size());
+    std::vector<T> finalAlpha(output.x.size());
     barycentricWeights(finalAlpha, output.x);
-    double finalDelta = output.delta;
+    T finalDelta = output.delta;
     output.delta = fabsl(output.delta);
     //std::cout << "MINIMAX delta = " << output.delta << std::endl;
     computeC(finalC, finalDelta, output.x, chebyBands);
-    std::vector<double> finalChebyNodes(degree + 1);
+    std::vector<T> finalChebyNodes(degree + 1);
     generateEquidistantNodes(finalChebyNodes, degree);
     applyCos(finalChebyNodes, finalChebyNodes);
-    std::vector<double> fv(degree + 1);
+    std::vector<T> fv(degree + 1);
 
-    for (std::size_t i{0u}; i < fv.size(); ++i)
-        computeApprox(fv[i], finalChebyNodes[i], output.x,
-                finalC, finalAlpha);
+    computeApprox(fv, finalChebyNodes, output.x, finalC, finalAlpha);
 
     generateChebyshevCoefficients(output.h, fv, degree);
 
@@ -2168,14 +2554,15 @@ PMOutputD exchange(std::vector<double>& x,
 
 
 // type I&II filters
-PMOutputD firpm(std::size_t n,
-        std::vector<double>const& f,
-        std::vector<double>const& a,
-        std::vector<double>const& w,
-        double eps,
+template <typename T>
+PMOutputT<T> firpm(std::size_t n,
+        std::vector<T>const& f,
+        std::vector<T>const& a,
+        std::vector<T>const& w,
+        T eps,
         int Nmax)
 {
-    std::vector<double> h;
+    std::vector<T> h;
     if( n % 2 != 0)
     {
         if((f[f.size() - 1u] == 1) && (a[a.size() - 1u] != 0))
@@ -2187,27 +2574,27 @@ PMOutputD firpm(std::size_t n,
         } else {
             std::size_t degree = n / 2u;
             // TODO: error checking code
-            std::vector<BandD> freqBands(w.size());
-            std::vector<BandD> chebyBands;
+            std::vector<BandT<T>> freqBands(w.size());
+            std::vector<BandT<T>> chebyBands;
             for(std::size_t i{0u}; i < freqBands.size(); ++i)
             {
-                freqBands[i].start = M_PI * f[2u * i];
+                freqBands[i].start = constPi<T>() * f[2u * i];
                 if(i < freqBands.size() - 1u)
-                    freqBands[i].stop  = M_PI * f[2u * i + 1u];
+                    freqBands[i].stop  = constPi<T>() * f[2u * i + 1u];
                 else
                 {
                     if(f[2u * i + 1u] == 1.0)
                     {
                         if(f[2u * i] < 0.9999)
-                            freqBands[i].stop = M_PI * 0.9999;
+                            freqBands[i].stop = constPi<T>() * 0.9999;
                         else
-                            freqBands[i].stop = M_PI * ((f[2u * i] + 1) / 2);
+                            freqBands[i].stop = constPi<T>() * ((f[2u * i] + 1) / 2);
                     }
                     else
-                        freqBands[i].stop  = M_PI * f[2u * i + 1u];
+                        freqBands[i].stop  = constPi<T>() * f[2u * i + 1u];
                 }
                 freqBands[i].space = BandSpace::FREQ;
-                freqBands[i].amplitude = [=](BandSpace bSpace, double x) -> double
+                freqBands[i].amplitude = [=](BandSpace bSpace, T x) -> T
                 {
                     if (a[2u * i] != a[2u * i + 1u]) {
                         if(bSpace == BandSpace::CHEBY)
@@ -2221,7 +2608,7 @@ PMOutputD firpm(std::size_t n,
                     else
                         return a[2u * i] / sqrt((x + 1) / 2);
                 };
-                freqBands[i].weight = [=](BandSpace bSpace, double x) -> double
+                freqBands[i].weight = [=](BandSpace bSpace, T x) -> T
                 {
                     if (bSpace == BandSpace::FREQ)
                         return cos(x / 2) * w[i];
@@ -2229,14 +2616,14 @@ PMOutputD firpm(std::size_t n,
                         return sqrt((x + 1) / 2) * w[i];
                 };
             }
-            std::vector<double> omega(degree + 2u);
-            std::vector<double> x(degree + 2u);
+            std::vector<T> omega(degree + 2u);
+            std::vector<T> x(degree + 2u);
             initUniformExtremas(omega, freqBands);
             applyCos(x, omega);
             bandConversion(chebyBands, freqBands, ConversionDirection::FROMFREQ);
 
 
-            PMOutputD output = exchange(x, chebyBands, eps, Nmax);
+            PMOutputT<T> output = exchange(x, chebyBands, eps, Nmax);
 
             h.resize(n + 1u);
             h[0] = h[n] = output.h[degree] / 4;
@@ -2251,42 +2638,30 @@ PMOutputD firpm(std::size_t n,
 
     std::size_t degree = n / 2u;
     // TODO: error checking code
-    std::vector<BandD> freqBands(w.size());
-    std::vector<BandD> chebyBands;
+    std::vector<BandT<T>> freqBands(w.size());
+    std::vector<BandT<T>> chebyBands;
     for(std::size_t i{0u}; i < freqBands.size(); ++i)
     {
-        freqBands[i].start = M_PI * f[2u * i];
-        freqBands[i].stop  = M_PI * f[2u * i + 1u];
+        freqBands[i].start = constPi<T>() * f[2u * i];
+        freqBands[i].stop  = constPi<T>() * f[2u * i + 1u];
         freqBands[i].space = BandSpace::FREQ;
-        freqBands[i].amplitude = [=](BandSpace bSpace, double x) -> double
-        {
-            if (a[2u * i] != a[2u * i + 1u]) {
-                if(bSpace == BandSpace::CHEBY)
-                    x = acosl(x);
-                return ((x - freqBands[i].start) * a[2u * i + 1u] -
-                        (x - freqBands[i].stop) * a[2u * i]) /
-                        (freqBands[i].stop - freqBands[i].start);
-            }
-            return a[2u * i];
-        };
-        freqBands[i].weight = [=](BandSpace bSpace, double x) -> double
-        {
-            return w[i];
-        };
+        setAmplitude(freqBands[i], linearResponse(freqBands[i].start,
+                    freqBands[i].stop, a[2u * i], a[2u * i + 1u]));
+        setWeight(freqBands[i], constantResponse(w[i]));
     }
 
-    std::vector<double> omega(degree + 2u);
-    std::vector<double> x(degree + 2u);
+    std::vector<T> omega(degree + 2u);
+    std::vector<T> x(degree + 2u);
     initUniformExtremas(omega, freqBands);
     applyCos(x, omega);
     bandConversion(chebyBands, freqBands, ConversionDirection::FROMFREQ);
 
-    double finalDelta;
-    std::vector<double> coeffs;
-    std::vector<double> finalExtrema;
-    double convergenceOrder;
+    T finalDelta;
+    std::vector<T> coeffs;
+    std::vector<T> finalExtrema;
+    T convergenceOrder;
 
-    PMOutputD output = exchange(x, chebyBands, eps, Nmax);
+    PMOutputT<T> output = exchange(x, chebyBands, eps, Nmax);
 
     h.resize(n + 1u);
     h[degree] = output.h[0];
@@ -2298,17 +2673,18 @@ PMOutputD firpm(std::size_t n,
 }
 
 
-PMOutputD firpmRS(std::size_t n,
-        std::vector<double>const& f,
-        std::vector<double>const& a,
-        std::vector<double>const& w,
-        double eps,
+template <typename T>
+PMOutputT<T> firpmRS(std::size_t n,
+        std::vector<T>const& f,
+        std::vector<T>const& a,
+        std::vector<T>const& w,
+        T eps,
         std::size_t depth,
         int Nmax,
         RootSolver root)
 {
     if (depth == 0u) return firpm(n, f, a, w, eps, Nmax);
-    std::vector<double> h;
+    std::vector<T> h;
     if( n % 2 != 0)
     {
         if((f[f.size() - 1u] == 1) && (a[a.size() - 1u] != 0))
@@ -2320,27 +2696,27 @@ PMOutputD firpmRS(std::size_t n,
         } else {
             std::size_t degree = n / 2u;
             // TODO: error checking code
-            std::vector<BandD> freqBands(w.size());
-            std::vector<BandD> chebyBands;
+            std::vector<BandT<T>> freqBands(w.size());
+            std::vector<BandT<T>> chebyBands;
             for(std::size_t i{0u}; i < freqBands.size(); ++i)
             {
-                freqBands[i].start = M_PI * f[2u * i];
+                freqBands[i].start = constPi<T>() * f[2u * i];
                 if(i < freqBands.size() - 1u)
-                    freqBands[i].stop  = M_PI * f[2u * i + 1u];
+                    freqBands[i].stop  = constPi<T>() * f[2u * i + 1u];
                 else
                 {
                     if(f[2u * i + 1u] == 1.0)
                     {
                         if(f[2u * i] < 0.9999)
-                            freqBands[i].stop = M_PI * 0.9999;
+                            freqBands[i].stop = constPi<T>() * 0.9999;
                         else
-                            freqBands[i].stop = M_PI * ((f[2u * i] + 1) / 2);
+                            freqBands[i].stop = constPi<T>() * ((f[2u * i] + 1) / 2);
                     }
                     else
-                        freqBands[i].stop  = M_PI * f[2u * i + 1u];
+                        freqBands[i].stop  = constPi<T>() * f[2u * i + 1u];
                 }
                 freqBands[i].space = BandSpace::FREQ;
-                freqBands[i].amplitude = [=](BandSpace bSpace, double x) -> double
+                freqBands[i].amplitude = [=](BandSpace bSpace, T x) -> T
                 {
                     if (a[2u * i] != a[2u * i + 1u]) {
                         if(bSpace == BandSpace::CHEBY)
@@ -2354,7 +2730,7 @@ PMOutputD firpmRS(std::size_t n,
                     else
                         return a[2u * i] / sqrt((x + 1) / 2);
                 };
-                freqBands[i].weight = [=](BandSpace bSpace, double x) -> double
+                freqBands[i].weight = [=](BandSpace bSpace, T x) -> T
                 {
                     if (bSpace == BandSpace::FREQ)
                         return cos(x / 2) * w[i];
@@ -2370,9 +2746,9 @@ PMOutputD firpmRS(std::size_t n,
                 scaledDegrees[i] = scaledDegrees[i + 1] / 2;
             }
 
-            std::vector<double> omega(scaledDegrees[0] + 2u);
-            std::vector<double> x(scaledDegrees[0] + 2u);
-            PMOutputD output;
+            std::vector<T> omega(scaledDegrees[0] + 2u);
+            std::vector<T> x(scaledDegrees[0] + 2u);
+            PMOutputT<T> output;
             if(root == RootSolver::UNIFORM) {
                 initUniformExtremas(omega, freqBands);
                 applyCos(x, omega);
@@ -2380,18 +2756,8 @@ PMOutputD firpmRS(std::size_t n,
                 output = exchange(x, chebyBands, eps, Nmax);
 
             } else {
-                std::function<double(double)> weightFunction = [=](double x) -> double
-                {
-                    for(std::size_t i = 0u; i < chebyBands.size(); ++i)
-                        if(chebyBands[i].start <= x && x <= chebyBands[i].stop)
-                            return chebyBands[i].weight(BandSpace::CHEBY, x);
-                };
-                std::vector<double> wam;
-                generateWAM(wam, chebyBands, degree);
-                MatrixXd A;
-                generateVandermondeMatrix(A, degree + 1u, wam, weightFunction);
-                std::vector<double> afpX;
-                AFPPM(afpX, A, wam);
+                std::vector<T> afpX;
+                afpReference(afpX, chebyBands, degree);
                 bandCountPM(chebyBands, afpX);
 
                 output = exchange(afpX, chebyBands, eps, Nmax);
@@ -2420,28 +2786,16 @@ PMOutputD firpmRS(std::size_t n,
 
     std::size_t degree = n / 2u;
     // TODO: error checking code
-    std::vector<BandD> freqBands(w.size());
-    std::vector<BandD> chebyBands;
+    std::vector<BandT<T>> freqBands(w.size());
+    std::vector<BandT<T>> chebyBands;
     for(std::size_t i{0u}; i < freqBands.size(); ++i)
     {
-        freqBands[i].start = M_PI * f[2u * i];
-        freqBands[i].stop  = M_PI * f[2u * i + 1u];
+        freqBands[i].start = constPi<T>() * f[2u * i];
+        freqBands[i].stop  = constPi<T>() * f[2u * i + 1u];
         freqBands[i].space = BandSpace::FREQ;
-        freqBands[i].amplitude = [=](BandSpace bSpace, double x) -> double
-        {
-            if (a[2u * i] != a[2u * i + 1u]) {
-                if(bSpace == BandSpace::CHEBY)
-                    x = acosl(x);
-                return ((x - freqBands[i].start) * a[2u * i + 1u] -
-                        (x - freqBands[i].stop) * a[2u * i]) /
-                        (freqBands[i].stop - freqBands[i].start);
-            }
-            return a[2u * i];
-        };
-        freqBands[i].weight = [=](BandSpace bSpace, double x) -> double
-        {
-            return w[i];
-        };
+        setAmplitude(freqBands[i], linearResponse(freqBands[i].start,
+                    freqBands[i].stop, a[2u * i], a[2u * i + 1u]));
+        setWeight(freqBands[i], constantResponse(w[i]));
     }
 
     std::vector<std::size_t> scaledDegrees(depth + 1u);
@@ -2451,9 +2805,9 @@ PMOutputD firpmRS(std::size_t n,
         scaledDegrees[i] = scaledDegrees[i + 1] / 2;
     }
 
-    std::vector<double> omega(scaledDegrees[0] + 2u);
-    std::vector<double> x(scaledDegrees[0] + 2u);
-    PMOutputD output;
+    std::vector<T> omega(scaledDegrees[0] + 2u);
+    std::vector<T> x(scaledDegrees[0] + 2u);
+    PMOutputT<T> output;
     if(root == RootSolver::UNIFORM) {
         initUniformExtremas(omega, freqBands);
         applyCos(x, omega);
@@ -2461,18 +2815,8 @@ PMOutputD firpmRS(std::size_t n,
         output = exchange(x, chebyBands, eps, Nmax);
 
     } else {
-        std::function<double(double)> weightFunction = [=](double x) -> double
-        {
-            for(std::size_t i = 0u; i < chebyBands.size(); ++i)
-                if(chebyBands[i].start <= x && x <= chebyBands[i].stop)
-                    return chebyBands[i].weight(BandSpace::CHEBY, x);
-        };
-        std::vector<double> wam;
-        generateWAM(wam, chebyBands, degree);
-        MatrixXd A;
-        generateVandermondeMatrix(A, degree + 1u, wam, weightFunction);
-        std::vector<double> afpX;
-        AFPPM(afpX, A, wam);
+        std::vector<T> afpX;
+        afpReference(afpX, chebyBands, degree);
         bandCountPM(chebyBands, afpX);
 
         output = exchange(afpX, chebyBands, eps, Nmax);
@@ -2498,26 +2842,27 @@ PMOutputD firpmRS(std::size_t n,
 }
 
 // type III & IV filters
-PMOutputD firpm(std::size_t n,
-        std::vector<double>const& f,
-        std::vector<double>const& a,
-        std::vector<double>const& w,
+template <typename T>
+PMOutputT<T> firpm(std::size_t n,
+        std::vector<T>const& f,
+        std::vector<T>const& a,
+        std::vector<T>const& w,
         ftype type,
-        double eps,
+        T eps,
         int Nmax)
 {
-    PMOutputD output;
-    std::vector<double> h;
+    PMOutputT<T> output;
+    std::vector<T> h;
     switch(type) {
         case ftype::FIR_DIFFERENTIATOR :
             {
                 std::size_t degree = n / 2u;
                 // TODO: error checking code
-                 std::vector<double> fn = f;
+                 std::vector<T> fn = f;
 
-                std::vector<BandD> freqBands(w.size());
-                std::vector<BandD> chebyBands;
-                double scaleFactor = a[1] / (f[1] * M_PI);
+                std::vector<BandT<T>> freqBands(w.size());
+                std::vector<BandT<T>> chebyBands;
+                T scaleFactor = a[1] / (f[1] * constPi<T>());
                 if(n % 2 == 0) // Type III
                 {
                     if(f[0u] == 0.0l)
@@ -2535,10 +2880,10 @@ PMOutputD firpm(std::size_t n,
                             fn[f.size() - 1u] = 0.9999l;
                     }
                     --degree;
-                    freqBands[0].start = M_PI * fn[0u];
-                    freqBands[0].stop  = M_PI * fn[1u];
+                    freqBands[0].start = constPi<T>() * fn[0u];
+                    freqBands[0].stop  = constPi<T>() * fn[1u];
                     freqBands[0].space = BandSpace::FREQ;
-                    freqBands[0].weight = [w](BandSpace bSpace, double x) -> double
+                    freqBands[0].weight = [w](BandSpace bSpace, T x) -> T
                     {
                         if(bSpace == BandSpace::FREQ)
                         {
@@ -2549,7 +2894,7 @@ PMOutputD firpm(std::size_t n,
                             return (sqrt(1.0l - x * x) / acos(x)) * w[0u];
                         }
                     };
-                    freqBands[0].amplitude = [scaleFactor](BandSpace bSpace, double x) -> double
+                    freqBands[0].amplitude = [scaleFactor](BandSpace bSpace, T x) -> T
                     {
                         if(bSpace == BandSpace::FREQ)
                         {
@@ -2562,10 +2907,10 @@ PMOutputD firpm(std::size_t n,
                     };
                     for(std::size_t i{1u}; i < freqBands.size(); ++i)
                     {
-                        freqBands[i].start = M_PI * fn[2u * i];
-                        freqBands[i].stop  = M_PI * fn[2u * i + 1u];
+                        freqBands[i].start = constPi<T>() * fn[2u * i];
+                        freqBands[i].stop  = constPi<T>() * fn[2u * i + 1u];
                         freqBands[i].space = BandSpace::FREQ;
-                        freqBands[i].weight = [w, i](BandSpace bSpace, double x) -> double
+                        freqBands[i].weight = [w, i](BandSpace bSpace, T x) -> T
                         {
                             if(bSpace == BandSpace::FREQ)
                             {
@@ -2577,18 +2922,8 @@ PMOutputD firpm(std::size_t n,
                             }
 
                         };
-                        freqBands[i].amplitude = [freqBands, a, i](BandSpace bSpace, double x) -> double
-                        {
-                            if (a[2u * i] != a[2u * i + 1u]) {
-                                if(bSpace == BandSpace::CHEBY)
-                                    x = acos(x);
-                                return ((x - freqBands[i].start) * a[2u * i + 1u] -
-                                        (x - freqBands[i].stop) * a[2u * i]) /
-                                        (freqBands[i].stop - freqBands[i].start);
-                            }
-                            return a[2u * i];
-
-                        };
+                        setAmplitude(freqBands[i], linearResponse(freqBands[i].start,
+                                    freqBands[i].stop, a[2u * i], a[2u * i + 1u]));
 
                     }
 
@@ -2601,10 +2936,10 @@ PMOutputD firpm(std::size_t n,
                             fn[0u] = 0.00001l;
                     }
 
-                    freqBands[0].start = M_PI * fn[0u];
-                    freqBands[0].stop  = M_PI * fn[1u];
+                    freqBands[0].start = constPi<T>() * fn[0u];
+                    freqBands[0].stop  = constPi<T>() * fn[1u];
                     freqBands[0].space = BandSpace::FREQ;
-                    freqBands[0].weight = [w](BandSpace bSpace, double x) -> double
+                    freqBands[0].weight = [w](BandSpace bSpace, T x) -> T
                     {
                         if(bSpace == BandSpace::FREQ)
                         {
@@ -2615,7 +2950,7 @@ PMOutputD firpm(std::size_t n,
                             return (sin(acos(x) / 2) / acos(x)) * w[0u];
                         }
                     };
-                    freqBands[0].amplitude = [scaleFactor](BandSpace bSpace, double x) -> double
+                    freqBands[0].amplitude = [scaleFactor](BandSpace bSpace, T x) -> T
                     {
                         if(bSpace == BandSpace::FREQ)
                         {
@@ -2628,10 +2963,10 @@ PMOutputD firpm(std::size_t n,
                     };
                     for(std::size_t i{1u}; i < freqBands.size(); ++i)
                     {
-                        freqBands[i].start = M_PI * fn[2u * i];
-                        freqBands[i].stop  = M_PI * fn[2u * i + 1u];
+                        freqBands[i].start = constPi<T>() * fn[2u * i];
+                        freqBands[i].stop  = constPi<T>() * fn[2u * i + 1u];
                         freqBands[i].space = BandSpace::FREQ;
-                        freqBands[i].weight = [w,i](BandSpace bSpace, double x) -> double
+                        freqBands[i].weight = [w,i](BandSpace bSpace, T x) -> T
                         {
                             if(bSpace == BandSpace::FREQ)
                             {
@@ -2643,25 +2978,15 @@ PMOutputD firpm(std::size_t n,
                             }
 
                         };
-                        freqBands[i].amplitude = [freqBands, a, i](BandSpace bSpace, double x) -> double
-                        {
-                            if (a[2u * i] != a[2u * i + 1u]) {
-                                if(bSpace == BandSpace::CHEBY)
-                                    x = acos(x);
-                                return ((x - freqBands[i].start) * a[2u * i + 1u] -
-                                        (x - freqBands[i].stop) * a[2u * i]) /
-                                        (freqBands[i].stop - freqBands[i].start);
-                            }
-                            return a[2u * i];
-
-                        };
+                        setAmplitude(freqBands[i], linearResponse(freqBands[i].start,
+                                    freqBands[i].stop, a[2u * i], a[2u * i + 1u]));
 
                     }
 
                 }
 
-                std::vector<double> omega(degree + 2u);
-                std::vector<double> x(degree + 2u);
+                std::vector<T> omega(degree + 2u);
+                std::vector<T> x(degree + 2u);
                 initUniformExtremas(omega, freqBands);
                 applyCos(x, omega);
                 bandConversion(chebyBands, freqBands, ConversionDirection::FROMFREQ);
@@ -2702,10 +3027,10 @@ PMOutputD firpm(std::size_t n,
         default : // FIR_HILBERT
             {
                 std::size_t degree = n / 2u;
-                std::vector<double> fn = f;
+                std::vector<T> fn = f;
                 // TODO: error checking code
-                std::vector<BandD> freqBands(w.size());
-                std::vector<BandD> chebyBands;
+                std::vector<BandT<T>> freqBands(w.size());
+                std::vector<BandT<T>> chebyBands;
                 if(n % 2 == 0) // Type III
                 {
                     --degree;
@@ -2726,10 +3051,10 @@ PMOutputD firpm(std::size_t n,
 
                     for(std::size_t i{0u}; i < freqBands.size(); ++i)
                     {
-                        freqBands[i].start = M_PI * fn[2u * i];
-                        freqBands[i].stop  = M_PI * fn[2u * i + 1u];
+                        freqBands[i].start = constPi<T>() * fn[2u * i];
+                        freqBands[i].stop  = constPi<T>() * fn[2u * i + 1u];
                         freqBands[i].space = BandSpace::FREQ;
-                        freqBands[i].amplitude = [=](BandSpace bSpace, double x) -> double
+                        freqBands[i].amplitude = [=](BandSpace bSpace, T x) -> T
                         {
                             if(bSpace == BandSpace::CHEBY)
                                 x = acosl(x);
@@ -2741,7 +3066,7 @@ PMOutputD firpm(std::size_t n,
                             }
                             return a[2u * i] / sin(x);
                         };
-                        freqBands[i].weight = [=](BandSpace bSpace, double x) -> double
+                        freqBands[i].weight = [=](BandSpace bSpace, T x) -> T
                         {
                             if(bSpace == BandSpace::FREQ)
                                 return w[i] * sin(x);
@@ -2759,10 +3084,10 @@ PMOutputD firpm(std::size_t n,
                     }
                     for(std::size_t i{0u}; i < freqBands.size(); ++i)
                     {
-                        freqBands[i].start = M_PI * fn[2u * i];
-                        freqBands[i].stop  = M_PI * fn[2u * i + 1u];
+                        freqBands[i].start = constPi<T>() * fn[2u * i];
+                        freqBands[i].stop  = constPi<T>() * fn[2u * i + 1u];
                         freqBands[i].space = BandSpace::FREQ;
-                        freqBands[i].amplitude = [=](BandSpace bSpace, double x) -> double
+                        freqBands[i].amplitude = [=](BandSpace bSpace, T x) -> T
                         {
                             if(bSpace == BandSpace::CHEBY)
                                 x = acos(x);
@@ -2774,7 +3099,7 @@ PMOutputD firpm(std::size_t n,
                             }
                             return a[2u * i] / sin(x / 2);
                         };
-                        freqBands[i].weight = [=](BandSpace bSpace, double x) -> double
+                        freqBands[i].weight = [=](BandSpace bSpace, T x) -> T
                         {
                             if(bSpace == BandSpace::FREQ)
                                 return w[i] * sin(x / 2);
@@ -2786,8 +3111,8 @@ PMOutputD firpm(std::size_t n,
                         };
                     }
                 }
-                std::vector<double> omega(degree + 2u);
-                std::vector<double> x(degree + 2u);
+                std::vector<T> omega(degree + 2u);
+                std::vector<T> x(degree + 2u);
                 initUniformExtremas(omega, freqBands);
                 applyCos(x, omega);
                 bandConversion(chebyBands, freqBands, ConversionDirection::FROMFREQ);
@@ -2830,29 +3155,30 @@ PMOutputD firpm(std::size_t n,
 }
 
 
-PMOutputD firpmRS(std::size_t n,
-        std::vector<double>const& f,
-        std::vector<double>const& a,
-        std::vector<double>const& w,
+template <typename T>
+PMOutputT<T> firpmRS(std::size_t n,
+        std::vector<T>const& f,
+        std::vector<T>const& a,
+        std::vector<T>const& w,
         ftype type,
-        double eps,
+        T eps,
         std::size_t depth,
         int Nmax,
         RootSolver root)
 {
     if (depth == 0u) return firpm(n, f, a, w, type, eps, Nmax);
-    PMOutputD output;
-    std::vector<double> h;
+    PMOutputT<T> output;
+    std::vector<T> h;
     switch(type) {
         case ftype::FIR_DIFFERENTIATOR :
             {
                 std::size_t degree = n / 2u;
                 // TODO: error checking code
-                std::vector<double> fn = f;
+                std::vector<T> fn = f;
 
-                std::vector<BandD> freqBands(w.size());
-                std::vector<BandD> chebyBands;
-                double scaleFactor = a[1] / (f[1] * M_PI);
+                std::vector<BandT<T>> freqBands(w.size());
+                std::vector<BandT<T>> chebyBands;
+                T scaleFactor = a[1] / (f[1] * constPi<T>());
                 if(n % 2 == 0) // Type III
                 {
                     if(f[0u] == 0.0l)
@@ -2870,10 +3196,10 @@ PMOutputD firpmRS(std::size_t n,
                             fn[f.size() - 1u] = 0.9999l;
                     }
                     --degree;
-                    freqBands[0].start = M_PI * fn[0u];
-                    freqBands[0].stop  = M_PI * fn[1u];
+                    freqBands[0].start = constPi<T>() * fn[0u];
+                    freqBands[0].stop  = constPi<T>() * fn[1u];
                     freqBands[0].space = BandSpace::FREQ;
-                    freqBands[0].weight = [w](BandSpace bSpace, double x) -> double
+                    freqBands[0].weight = [w](BandSpace bSpace, T x) -> T
                     {
                         if(bSpace == BandSpace::FREQ)
                         {
@@ -2884,7 +3210,7 @@ PMOutputD firpmRS(std::size_t n,
                             return (sqrt(1.0l - x * x) / acos(x)) * w[0u];
                         }
                     };
-                    freqBands[0].amplitude = [scaleFactor](BandSpace bSpace, double x) -> double
+                    freqBands[0].amplitude = [scaleFactor](BandSpace bSpace, T x) -> T
                     {
                         if(bSpace == BandSpace::FREQ)
                         {
@@ -2897,10 +3223,10 @@ PMOutputD firpmRS(std::size_t n,
                     };
                     for(std::size_t i{1u}; i < freqBands.size(); ++i)
                     {
-                        freqBands[i].start = M_PI * fn[2u * i];
-                        freqBands[i].stop  = M_PI * fn[2u * i + 1u];
+                        freqBands[i].start = constPi<T>() * fn[2u * i];
+                        freqBands[i].stop  = constPi<T>() * fn[2u * i + 1u];
                         freqBands[i].space = BandSpace::FREQ;
-                        freqBands[i].weight = [w, i](BandSpace bSpace, double x) -> double
+                        freqBands[i].weight = [w, i](BandSpace bSpace, T x) -> T
                         {
                             if(bSpace == BandSpace::FREQ)
                             {
@@ -2912,18 +3238,8 @@ PMOutputD firpmRS(std::size_t n,
                             }
 
                         };
-                        freqBands[i].amplitude = [freqBands, a, i](BandSpace bSpace, double x) -> double
-                        {
-                            if (a[2u * i] != a[2u * i + 1u]) {
-                                if(bSpace == BandSpace::CHEBY)
-                                    x = acos(x);
-                                return ((x - freqBands[i].start) * a[2u * i + 1u] -
-                                        (x - freqBands[i].stop) * a[2u * i]) /
-                                        (freqBands[i].stop - freqBands[i].start);
-                            }
-                            return a[2u * i];
-
-                        };
+                        setAmplitude(freqBands[i], linearResponse(freqBands[i].start,
+                                    freqBands[i].stop, a[2u * i], a[2u * i + 1u]));
 
                     }
 
@@ -2936,10 +3252,10 @@ PMOutputD firpmRS(std::size_t n,
                             fn[0u] = 0.00001l;
                     }
 
-                    freqBands[0].start = M_PI * fn[0u];
-                    freqBands[0].stop  = M_PI * fn[1u];
+                    freqBands[0].start = constPi<T>() * fn[0u];
+                    freqBands[0].stop  = constPi<T>() * fn[1u];
                     freqBands[0].space = BandSpace::FREQ;
-                    freqBands[0].weight = [w](BandSpace bSpace, double x) -> double
+                    freqBands[0].weight = [w](BandSpace bSpace, T x) -> T
                     {
                         if(bSpace == BandSpace::FREQ)
                         {
@@ -2950,7 +3266,7 @@ PMOutputD firpmRS(std::size_t n,
                             return (sin(acos(x) / 2) / acos(x)) * w[0u];
                         }
                     };
-                    freqBands[0].amplitude = [scaleFactor](BandSpace bSpace, double x) -> double
+                    freqBands[0].amplitude = [scaleFactor](BandSpace bSpace, T x) -> T
                     {
                         if(bSpace == BandSpace::FREQ)
                         {
@@ -2963,10 +3279,10 @@ PMOutputD firpmRS(std::size_t n,
                     };
                     for(std::size_t i{1u}; i < freqBands.size(); ++i)
                     {
-                        freqBands[i].start = M_PI * fn[2u * i];
-                        freqBands[i].stop  = M_PI * fn[2u * i + 1u];
+                        freqBands[i].start = constPi<T>() * fn[2u * i];
+                        freqBands[i].stop  = constPi<T>() * fn[2u * i + 1u];
                         freqBands[i].space = BandSpace::FREQ;
-                        freqBands[i].weight = [w,i](BandSpace bSpace, double x) -> double
+                        freqBands[i].weight = [w,i](BandSpace bSpace, T x) -> T
                         {
                             if(bSpace == BandSpace::FREQ)
                             {
@@ -2978,18 +3294,8 @@ PMOutputD firpmRS(std::size_t n,
                             }
 
                         };
-                        freqBands[i].amplitude = [freqBands, a, i](BandSpace bSpace, double x) -> double
-                        {
-                            if (a[2u * i] != a[2u * i + 1u]) {
-                                if(bSpace == BandSpace::CHEBY)
-                                    x = acos(x);
-                                return ((x - freqBands[i].start) * a[2u * i + 1u] -
-                                        (x - freqBands[i].stop) * a[2u * i]) /
-                                        (freqBands[i].stop - freqBands[i].start);
-                            }
-                            return a[2u * i];
-
-                        };
+                        setAmplitude(freqBands[i], linearResponse(freqBands[i].start,
+                                    freqBands[i].stop, a[2u * i], a[2u * i + 1u]));
 
                     }
 
@@ -3002,9 +3308,9 @@ PMOutputD firpmRS(std::size_t n,
                 scaledDegrees[i] = scaledDegrees[i + 1] / 2;
             }
 
-            std::vector<double> omega(scaledDegrees[0] + 2u);
-            std::vector<double> x(scaledDegrees[0] + 2u);
-            PMOutputD output;
+            std::vector<T> omega(scaledDegrees[0] + 2u);
+            std::vector<T> x(scaledDegrees[0] + 2u);
+            PMOutputT<T> output;
             if(root == RootSolver::UNIFORM) {
                 initUniformExtremas(omega, freqBands);
                 applyCos(x, omega);
@@ -3012,18 +3318,8 @@ PMOutputD firpmRS(std::size_t n,
                 output = exchange(x, chebyBands, eps, Nmax);
 
             } else {
-                std::function<double(double)> weightFunction = [=](double x) -> double
-                {
-                    for(std::size_t i = 0u; i < chebyBands.size(); ++i)
-                        if(chebyBands[i].start <= x && x <= chebyBands[i].stop)
-                            return chebyBands[i].weight(BandSpace::CHEBY, x);
-                };
-                std::vector<double> wam;
-                generateWAM(wam, chebyBands, degree);
-                MatrixXd A;
-                generateVandermondeMatrix(A, degree + 1u, wam, weightFunction);
-                std::vector<double> afpX;
-                AFPPM(afpX, A, wam);
+                std::vector<T> afpX;
+                afpReference(afpX, chebyBands, degree);
                 bandCountPM(chebyBands, afpX);
 
                 output = exchange(afpX, chebyBands, eps, Nmax);
@@ -3072,10 +3368,10 @@ PMOutputD firpmRS(std::size_t n,
         default : // FIR_HILBERT
             {
                 std::size_t degree = n / 2u;
-                std::vector<double> fn = f;
+                std::vector<T> fn = f;
                 // TODO: error checking code
-                std::vector<BandD> freqBands(w.size());
-                std::vector<BandD> chebyBands;
+                std::vector<BandT<T>> freqBands(w.size());
+                std::vector<BandT<T>> chebyBands;
                 if(n % 2 == 0) // Type III
                 {
                     --degree;
@@ -3096,10 +3392,10 @@ PMOutputD firpmRS(std::size_t n,
 
                     for(std::size_t i{0u}; i < freqBands.size(); ++i)
                     {
-                        freqBands[i].start = M_PI * fn[2u * i];
-                        freqBands[i].stop  = M_PI * fn[2u * i + 1u];
+                        freqBands[i].start = constPi<T>() * fn[2u * i];
+                        freqBands[i].stop  = constPi<T>() * fn[2u * i + 1u];
                         freqBands[i].space = BandSpace::FREQ;
-                        freqBands[i].amplitude = [=](BandSpace bSpace, double x) -> double
+                        freqBands[i].amplitude = [=](BandSpace bSpace, T x) -> T
                         {
                             if(bSpace == BandSpace::CHEBY)
                                 x = acosl(x);
@@ -3111,7 +3407,7 @@ PMOutputD firpmRS(std::size_t n,
                             }
                             return a[2u * i] / sin(x);
                         };
-                        freqBands[i].weight = [=](BandSpace bSpace, double x) -> double
+                        freqBands[i].weight = [=](BandSpace bSpace, T x) -> T
                         {
                             if(bSpace == BandSpace::FREQ)
                                 return w[i] * sin(x);
@@ -3129,10 +3425,10 @@ PMOutputD firpmRS(std::size_t n,
                     }
                     for(std::size_t i{0u}; i < freqBands.size(); ++i)
                     {
-                        freqBands[i].start = M_PI * fn[2u * i];
-                        freqBands[i].stop  = M_PI * fn[2u * i + 1u];
+                        freqBands[i].start = constPi<T>() * fn[2u * i];
+                        freqBands[i].stop  = constPi<T>() * fn[2u * i + 1u];
                         freqBands[i].space = BandSpace::FREQ;
-                        freqBands[i].amplitude = [=](BandSpace bSpace, double x) -> double
+                        freqBands[i].amplitude = [=](BandSpace bSpace, T x) -> T
                         {
                             if(bSpace == BandSpace::CHEBY)
                                 x = acos(x);
@@ -3144,7 +3440,7 @@ PMOutputD firpmRS(std::size_t n,
                             }
                             return a[2u * i] / sin(x / 2);
                         };
-                        freqBands[i].weight = [=](BandSpace bSpace, double x) -> double
+                        freqBands[i].weight = [=](BandSpace bSpace, T x) -> T
                         {
                             if(bSpace == BandSpace::FREQ)
                                 return w[i] * sin(x / 2);
@@ -3166,9 +3462,9 @@ PMOutputD firpmRS(std::size_t n,
                     scaledDegrees[i] = scaledDegrees[i + 1] / 2;
                 }
 
-                std::vector<double> omega(scaledDegrees[0] + 2u);
-                std::vector<double> x(scaledDegrees[0] + 2u);
-                PMOutputD output;
+                std::vector<T> omega(scaledDegrees[0] + 2u);
+                std::vector<T> x(scaledDegrees[0] + 2u);
+                PMOutputT<T> output;
                 if(root == RootSolver::UNIFORM) {
                     initUniformExtremas(omega, freqBands);
                     applyCos(x, omega);
@@ -3176,18 +3472,8 @@ PMOutputD firpmRS(std::size_t n,
                     output = exchange(x, chebyBands, eps, Nmax);
 
                 } else {
-                    std::function<double(double)> weightFunction = [=](double x) -> double
-                    {
-                        for(std::size_t i = 0u; i < chebyBands.size(); ++i)
-                            if(chebyBands[i].start <= x && x <= chebyBands[i].stop)
-                                return chebyBands[i].weight(BandSpace::CHEBY, x);
-                    };
-                    std::vector<double> wam;
-                    generateWAM(wam, chebyBands, degree);
-                    MatrixXd A;
-                    generateVandermondeMatrix(A, degree + 1u, wam, weightFunction);
-                    std::vector<double> afpX;
-                    AFPPM(afpX, A, wam);
+                    std::vector<T> afpX;
+                    afpReference(afpX, chebyBands, degree);
                     bandCountPM(chebyBands, afpX);
 
                     output = exchange(afpX, chebyBands, eps, Nmax);
@@ -3241,14 +3527,15 @@ PMOutputD firpmRS(std::size_t n,
 
 
 // type I&II filters
-PMOutputD firpmAFPPM(std::size_t n,
-        std::vector<double>const& f,
-        std::vector<double>const& a,
-        std::vector<double>const& w,
-        double eps,
+template <typename T>
+PMOutputT<T> firpmAFP(std::size_t n,
+        std::vector<T>const& f,
+        std::vector<T>const& a,
+        std::vector<T>const& w,
+        T eps,
         int Nmax)
 {
-    std::vector<double> h;
+    std::vector<T> h;
     if( n % 2 != 0)
     {
         if((f[f.size() - 1u] == 1) && (a[a.size() - 1u] != 0))
@@ -3260,27 +3547,27 @@ PMOutputD firpmAFPPM(std::size_t n,
         } else {
             std::size_t degree = n / 2u;
             // TODO: error checking code
-            std::vector<BandD> freqBands(w.size());
-            std::vector<BandD> chebyBands;
+            std::vector<BandT<T>> freqBands(w.size());
+            std::vector<BandT<T>> chebyBands;
             for(std::size_t i{0u}; i < freqBands.size(); ++i)
             {
-                freqBands[i].start = M_PI * f[2u * i];
+                freqBands[i].start = constPi<T>() * f[2u * i];
                 if(i < freqBands.size() - 1u)
-                    freqBands[i].stop  = M_PI * f[2u * i + 1u];
+                    freqBands[i].stop  = constPi<T>() * f[2u * i + 1u];
                 else
                 {
                     if(f[2u * i + 1u] == 1.0)
                     {
                         if(f[2u * i] < 0.9999)
-                            freqBands[i].stop = M_PI * 0.9999;
+                            freqBands[i].stop = constPi<T>() * 0.9999;
                         else
-                            freqBands[i].stop = M_PI * ((f[2u * i] + 1) / 2);
+                            freqBands[i].stop = constPi<T>() * ((f[2u * i] + 1) / 2);
                     }
                     else
-                        freqBands[i].stop  = M_PI * f[2u * i + 1u];
+                        freqBands[i].stop  = constPi<T>() * f[2u * i + 1u];
                 }
                 freqBands[i].space = BandSpace::FREQ;
-                freqBands[i].amplitude = [=](BandSpace bSpace, double x) -> double
+                freqBands[i].amplitude = [=](BandSpace bSpace, T x) -> T
                 {
                     if (a[2u * i] != a[2u * i + 1u]) {
                         if(bSpace == BandSpace::CHEBY)
@@ -3294,7 +3581,7 @@ PMOutputD firpmAFPPM(std::size_t n,
                     else
                         return a[2u * i] / sqrt((x + 1) / 2);
                 };
-                freqBands[i].weight = [=](BandSpace bSpace, double x) -> double
+                freqBands[i].weight = [=](BandSpace bSpace, T x) -> T
                 {
                     if (bSpace == BandSpace::FREQ)
                         return cos(x / 2) * w[i];
@@ -3303,22 +3590,12 @@ PMOutputD firpmAFPPM(std::size_t n,
                 };
             }
             bandConversion(chebyBands, freqBands, ConversionDirection::FROMFREQ);
-            std::function<double(double)> weightFunction = [=](double x) -> double
-            {
-                for(std::size_t i = 0u; i < chebyBands.size(); ++i)
-                    if(chebyBands[i].start <= x && x <= chebyBands[i].stop)
-                        return chebyBands[i].weight(BandSpace::CHEBY, x);
-            };
-            std::vector<double> wam;
-            generateWAM(wam, chebyBands, degree);
-            MatrixXd A;
-            generateVandermondeMatrix(A, degree + 1u, wam, weightFunction);
-            std::vector<double> afpX;
-            AFPPM(afpX, A, wam);
+            std::vector<T> afpX;
+            afpReference(afpX, chebyBands, degree);
             bandCountPM(chebyBands, afpX);
 
 
-            PMOutputD output = exchange(afpX, chebyBands, eps, Nmax);
+            PMOutputT<T> output = exchange(afpX, chebyBands, eps, Nmax);
 
             h.resize(n + 1u);
             h[0] = h[n] = output.h[degree] / 4;
@@ -3333,53 +3610,31 @@ PMOutputD firpmAFPPM(std::size_t n,
 
     std::size_t degree = n / 2u;
     // TODO: error checking code
-    std::vector<BandD> freqBands(w.size());
-    std::vector<BandD> chebyBands;
+    std::vector<BandT<T>> freqBands(w.size());
+    std::vector<BandT<T>> chebyBands;
     for(std::size_t i{0u}; i < freqBands.size(); ++i)
     {
-        freqBands[i].start = M_PI * f[2u * i];
-        freqBands[i].stop  = M_PI * f[2u * i + 1u];
+        freqBands[i].start = constPi<T>() * f[2u * i];
+        freqBands[i].stop  = constPi<T>() * f[2u * i + 1u];
         freqBands[i].space = BandSpace::FREQ;
-        freqBands[i].amplitude = [=](BandSpace bSpace, double x) -> double
-        {
-            if (a[2u * i] != a[2u * i + 1u]) {
-                if(bSpace == BandSpace::CHEBY)
-                    x = acosl(x);
-                return ((x - freqBands[i].start) * a[2u * i + 1u] -
-                        (x - freqBands[i].stop) * a[2u * i]) /
-                        (freqBands[i].stop - freqBands[i].start);
-            }
-            return a[2u * i];
-        };
-        freqBands[i].weight = [=](BandSpace bSpace, double x) -> double
-        {
-            return w[i];
-        };
+        setAmplitude(freqBands[i], linearResponse(freqBands[i].start,
+                    freqBands[i].stop, a[2u * i], a[2u * i + 1u]));
+        setWeight(freqBands[i], constantResponse(w[i]));
     }
 
     bandConversion(chebyBands, freqBands, ConversionDirection::FROMFREQ);
-    std::function<double(double)> weightFunction = [=](double x) -> double
-    {
-        for(std::size_t i = 0u; i < chebyBands.size(); ++i)
-            if(chebyBands[i].start <= x && x <= chebyBands[i].stop)
-                return chebyBands[i].weight(BandSpace::CHEBY, x);
-    };
-    std::vector<double> wam;
-    generateWAM(wam, chebyBands, degree);
-    MatrixXd A;
-    generateVandermondeMatrix(A, degree + 1u, wam, weightFunction);
-    std::vector<double> afpX;
-    AFPPM(afpX, A, wam);
+    std::vector<T> afpX;
+    afpReference(afpX, chebyBands, degree);
     bandCountPM(chebyBands, afpX);
 
 
 
-    double finalDelta;
-    std::vector<double> coeffs;
-    std::vector<double> finalExtrema;
-    double convergenceOrder;
+    T finalDelta;
+    std::vector<T> coeffs;
+    std::vector<T> finalExtrema;
+    T convergenceOrder;
 
-    PMOutputD output = exchange(afpX, chebyBands, eps, Nmax);
+    PMOutputT<T> output = exchange(afpX, chebyBands, eps, Nmax);
 
     h.resize(n + 1u);
     h[degree] = output.h[0];
@@ -3391,26 +3646,27 @@ PMOutputD firpmAFPPM(std::size_t n,
 }
 
 // type III & IV filters
-PMOutputD firpmAFPPM(std::size_t n,
-        std::vector<double>const& f,
-        std::vector<double>const& a,
-        std::vector<double>const& w,
+template <typename T>
+PMOutputT<T> firpmAFP(std::size_t n,
+        std::vector<T>const& f,
+        std::vector<T>const& a,
+        std::vector<T>const& w,
         ftype type,
-        double eps,
+        T eps,
         int Nmax)
 {
-    PMOutputD output;
-    std::vector<double> h;
+    PMOutputT<T> output;
+    std::vector<T> h;
     switch(type) {
         case ftype::FIR_DIFFERENTIATOR :
             {
                 std::size_t degree = n / 2u;
                 // TODO: error checking code
-                 std::vector<double> fn = f;
+                 std::vector<T> fn = f;
 
-                std::vector<BandD> freqBands(w.size());
-                std::vector<BandD> chebyBands;
-                double scaleFactor = a[1] / (f[1] * M_PI);
+                std::vector<BandT<T>> freqBands(w.size());
+                std::vector<BandT<T>> chebyBands;
+                T scaleFactor = a[1] / (f[1] * constPi<T>());
                 if(n % 2 == 0) // Type III
                 {
                     if(f[0u] == 0.0l)
@@ -3428,10 +3684,10 @@ PMOutputD firpmAFPPM(std::size_t n,
                             fn[f.size() - 1u] = 0.9999l;
                     }
                     --degree;
-                    freqBands[0].start = M_PI * fn[0u];
-                    freqBands[0].stop  = M_PI * fn[1u];
+                    freqBands[0].start = constPi<T>() * fn[0u];
+                    freqBands[0].stop  = constPi<T>() * fn[1u];
                     freqBands[0].space = BandSpace::FREQ;
-                    freqBands[0].weight = [w](BandSpace bSpace, double x) -> double
+                    freqBands[0].weight = [w](BandSpace bSpace, T x) -> T
                     {
                         if(bSpace == BandSpace::FREQ)
                         {
@@ -3442,7 +3698,7 @@ PMOutputD firpmAFPPM(std::size_t n,
                             return (sqrt(1.0l - x * x) / acos(x)) * w[0u];
                         }
                     };
-                    freqBands[0].amplitude = [scaleFactor](BandSpace bSpace, double x) -> double
+                    freqBands[0].amplitude = [scaleFactor](BandSpace bSpace, T x) -> T
                     {
                         if(bSpace == BandSpace::FREQ)
                         {
@@ -3455,10 +3711,10 @@ PMOutputD firpmAFPPM(std::size_t n,
                     };
                     for(std::size_t i{1u}; i < freqBands.size(); ++i)
                     {
-                        freqBands[i].start = M_PI * fn[2u * i];
-                        freqBands[i].stop  = M_PI * fn[2u * i + 1u];
+                        freqBands[i].start = constPi<T>() * fn[2u * i];
+                        freqBands[i].stop  = constPi<T>() * fn[2u * i + 1u];
                         freqBands[i].space = BandSpace::FREQ;
-                        freqBands[i].weight = [w, i](BandSpace bSpace, double x) -> double
+                        freqBands[i].weight = [w, i](BandSpace bSpace, T x) -> T
                         {
                             if(bSpace == BandSpace::FREQ)
                             {
@@ -3470,18 +3726,8 @@ PMOutputD firpmAFPPM(std::size_t n,
                             }
 
                         };
-                        freqBands[i].amplitude = [freqBands, a, i](BandSpace bSpace, double x) -> double
-                        {
-                            if (a[2u * i] != a[2u * i + 1u]) {
-                                if(bSpace == BandSpace::CHEBY)
-                                    x = acos(x);
-                                return ((x - freqBands[i].start) * a[2u * i + 1u] -
-                                        (x - freqBands[i].stop) * a[2u * i]) /
-                                        (freqBands[i].stop - freqBands[i].start);
-                            }
-                            return a[2u * i];
-
-                        };
+                        setAmplitude(freqBands[i], linearResponse(freqBands[i].start,
+                                    freqBands[i].stop, a[2u * i], a[2u * i + 1u]));
 
                     }
 
@@ -3494,10 +3740,10 @@ PMOutputD firpmAFPPM(std::size_t n,
                             fn[0u] = 0.00001l;
                     }
 
-                    freqBands[0].start = M_PI * fn[0u];
-                    freqBands[0].stop  = M_PI * fn[1u];
+                    freqBands[0].start = constPi<T>() * fn[0u];
+                    freqBands[0].stop  = constPi<T>() * fn[1u];
                     freqBands[0].space = BandSpace::FREQ;
-                    freqBands[0].weight = [w](BandSpace bSpace, double x) -> double
+                    freqBands[0].weight = [w](BandSpace bSpace, T x) -> T
                     {
                         if(bSpace == BandSpace::FREQ)
                         {
@@ -3508,7 +3754,7 @@ PMOutputD firpmAFPPM(std::size_t n,
                             return (sin(acos(x) / 2) / acos(x)) * w[0u];
                         }
                     };
-                    freqBands[0].amplitude = [scaleFactor](BandSpace bSpace, double x) -> double
+                    freqBands[0].amplitude = [scaleFactor](BandSpace bSpace, T x) -> T
                     {
                         if(bSpace == BandSpace::FREQ)
                         {
@@ -3521,10 +3767,10 @@ PMOutputD firpmAFPPM(std::size_t n,
                     };
                     for(std::size_t i{1u}; i < freqBands.size(); ++i)
                     {
-                        freqBands[i].start = M_PI * fn[2u * i];
-                        freqBands[i].stop  = M_PI * fn[2u * i + 1u];
+                        freqBands[i].start = constPi<T>() * fn[2u * i];
+                        freqBands[i].stop  = constPi<T>() * fn[2u * i + 1u];
                         freqBands[i].space = BandSpace::FREQ;
-                        freqBands[i].weight = [w,i](BandSpace bSpace, double x) -> double
+                        freqBands[i].weight = [w,i](BandSpace bSpace, T x) -> T
                         {
                             if(bSpace == BandSpace::FREQ)
                             {
@@ -3536,36 +3782,16 @@ PMOutputD firpmAFPPM(std::size_t n,
                             }
 
                         };
-                        freqBands[i].amplitude = [freqBands, a, i](BandSpace bSpace, double x) -> double
-                        {
-                            if (a[2u * i] != a[2u * i + 1u]) {
-                                if(bSpace == BandSpace::CHEBY)
-                                    x = acos(x);
-                                return ((x - freqBands[i].start) * a[2u * i + 1u] -
-                                        (x - freqBands[i].stop) * a[2u * i]) /
-                                        (freqBands[i].stop - freqBands[i].start);
-                            }
-                            return a[2u * i];
-
-                        };
+                        setAmplitude(freqBands[i], linearResponse(freqBands[i].start,
+                                    freqBands[i].stop, a[2u * i], a[2u * i + 1u]));
 
                     }
 
                 }
 
                 bandConversion(chebyBands, freqBands, ConversionDirection::FROMFREQ);
-                std::function<double(double)> weightFunction = [=](double x) -> double
-                {
-                    for(std::size_t i = 0u; i < chebyBands.size(); ++i)
-                        if(chebyBands[i].start <= x && x <= chebyBands[i].stop)
-                            return chebyBands[i].weight(BandSpace::CHEBY, x);
-                };
-                std::vector<double> wam;
-                generateWAM(wam, chebyBands, degree);
-                MatrixXd A;
-                generateVandermondeMatrix(A, degree + 1u, wam, weightFunction);
-                std::vector<double> afpX;
-                AFPPM(afpX, A, wam);
+                std::vector<T> afpX;
+                afpReference(afpX, chebyBands, degree);
                 bandCountPM(chebyBands, afpX);
 
 
@@ -3605,10 +3831,10 @@ PMOutputD firpmAFPPM(std::size_t n,
         default : // FIR_HILBERT
             {
                 std::size_t degree = n / 2u;
-                std::vector<double> fn = f;
+                std::vector<T> fn = f;
                 // TODO: error checking code
-                std::vector<BandD> freqBands(w.size());
-                std::vector<BandD> chebyBands;
+                std::vector<BandT<T>> freqBands(w.size());
+                std::vector<BandT<T>> chebyBands;
                 if(n % 2 == 0) // Type III
                 {
                     --degree;
@@ -3629,10 +3855,10 @@ PMOutputD firpmAFPPM(std::size_t n,
 
                     for(std::size_t i{0u}; i < freqBands.size(); ++i)
                     {
-                        freqBands[i].start = M_PI * fn[2u * i];
-                        freqBands[i].stop  = M_PI * fn[2u * i + 1u];
+                        freqBands[i].start = constPi<T>() * fn[2u * i];
+                        freqBands[i].stop  = constPi<T>() * fn[2u * i + 1u];
                         freqBands[i].space = BandSpace::FREQ;
-                        freqBands[i].amplitude = [=](BandSpace bSpace, double x) -> double
+                        freqBands[i].amplitude = [=](BandSpace bSpace, T x) -> T
                         {
                             if(bSpace == BandSpace::CHEBY)
                                 x = acosl(x);
@@ -3644,7 +3870,7 @@ PMOutputD firpmAFPPM(std::size_t n,
                             }
                             return a[2u * i] / sin(x);
                         };
-                        freqBands[i].weight = [=](BandSpace bSpace, double x) -> double
+                        freqBands[i].weight = [=](BandSpace bSpace, T x) -> T
                         {
                             if(bSpace == BandSpace::FREQ)
                                 return w[i] * sin(x);
@@ -3662,10 +3888,10 @@ PMOutputD firpmAFPPM(std::size_t n,
                     }
                     for(std::size_t i{0u}; i < freqBands.size(); ++i)
                     {
-                        freqBands[i].start = M_PI * fn[2u * i];
-                        freqBands[i].stop  = M_PI * fn[2u * i + 1u];
+                        freqBands[i].start = constPi<T>() * fn[2u * i];
+                        freqBands[i].stop  = constPi<T>() * fn[2u * i + 1u];
                         freqBands[i].space = BandSpace::FREQ;
-                        freqBands[i].amplitude = [=](BandSpace bSpace, double x) -> double
+                        freqBands[i].amplitude = [=](BandSpace bSpace, T x) -> T
                         {
                             if(bSpace == BandSpace::CHEBY)
                                 x = acos(x);
@@ -3677,7 +3903,7 @@ PMOutputD firpmAFPPM(std::size_t n,
                             }
                             return a[2u * i] / sin(x / 2);
                         };
-                        freqBands[i].weight = [=](BandSpace bSpace, double x) -> double
+                        freqBands[i].weight = [=](BandSpace bSpace, T x) -> T
                         {
                             if(bSpace == BandSpace::FREQ)
                                 return w[i] * sin(x / 2);
@@ -3690,18 +3916,8 @@ PMOutputD firpmAFPPM(std::size_t n,
                     }
                 }
                 bandConversion(chebyBands, freqBands, ConversionDirection::FROMFREQ);
-                std::function<double(double)> weightFunction = [=](double x) -> double
-                {
-                    for(std::size_t i = 0u; i < chebyBands.size(); ++i)
-                        if(chebyBands[i].start <= x && x <= chebyBands[i].stop)
-                            return chebyBands[i].weight(BandSpace::CHEBY, x);
-                };
-                std::vector<double> wam;
-                generateWAM(wam, chebyBands, degree);
-                MatrixXd A;
-                generateVandermondeMatrix(A, degree + 1u, wam, weightFunction);
-                std::vector<double> afpX;
-                AFPPM(afpX, A, wam);
+                std::vector<T> afpX;
+                afpReference(afpX, chebyBands, degree);
                 bandCountPM(chebyBands, afpX);
 
 
@@ -3741,3 +3957,391 @@ PMOutputD firpmAFPPM(std::size_t n,
     output.h = h;
     return output;
 }
+
+// maps a reference onto a reference of (almost) any other size: the number
+// of points inside each band is scaled proportionally and the new points are
+// obtained by linear interpolation of the positions of the old ones, as a
+// function of their index, which preserves the distribution of the points
+// (unlike referenceScaling, it is not restricted to doubling the size)
+template <typename T>
+static void resampleReference(std::vector<T>& newX,
+        std::vector<BandT<T>>& newChebyBands,
+        std::vector<BandT<T>>& newFreqBands, std::size_t newXSize,
+        std::vector<T>& x, std::vector<BandT<T>>& chebyBands)
+{
+    std::vector<std::size_t> newDistribution(chebyBands.size());
+    std::size_t total = 0u;
+    for(std::size_t i{0u}; i < chebyBands.size(); ++i)
+    {
+        newDistribution[i] = (chebyBands[i].extremas * newXSize
+                + x.size() / 2u) / x.size();
+        if(chebyBands[i].extremas > 0u && newDistribution[i] == 0u)
+            newDistribution[i] = 1u;
+        total += newDistribution[i];
+    }
+    // correct the rounding errors on the largest bands
+    while(total != newXSize)
+    {
+        std::size_t largest = std::max_element(newDistribution.begin(),
+                newDistribution.end()) - newDistribution.begin();
+        if(total < newXSize) {
+            ++newDistribution[largest];
+            ++total;
+        } else {
+            --newDistribution[largest];
+            --total;
+        }
+    }
+
+    newX.clear();
+    std::size_t offset = 0u;
+    for(std::size_t i{0u}; i < chebyBands.size(); ++i)
+    {
+        std::size_t oldCount = chebyBands[i].extremas;
+        std::size_t newCount = newDistribution[i];
+        if(newCount == 1u)
+            newX.push_back(x[offset + (oldCount - 1u) / 2u]);
+        else if(oldCount < 2u)
+        {
+            // nothing to interpolate, so the points are spread uniformly
+            // inside the band
+            T step = (chebyBands[i].stop - chebyBands[i].start) / (newCount - 1u);
+            for(std::size_t j{0u}; j < newCount; ++j)
+                newX.push_back(chebyBands[i].start + step * j);
+        }
+        else
+        {
+            for(std::size_t j{0u}; j < newCount; ++j)
+            {
+                // position j * (oldCount - 1) / (newCount - 1) in the old
+                // reference of the band
+                std::size_t index = j * (oldCount - 1u) / (newCount - 1u);
+                std::size_t rem = j * (oldCount - 1u) % (newCount - 1u);
+                if(rem == 0u)
+                    newX.push_back(x[offset + index]);
+                else
+                    newX.push_back(x[offset + index] +
+                            (x[offset + index + 1u] - x[offset + index])
+                            * T(rem) / (newCount - 1u));
+            }
+        }
+        offset += oldCount;
+    }
+
+    for(std::size_t i{0u}; i < chebyBands.size(); ++i)
+    {
+        newFreqBands[chebyBands.size() - 1u - i].extremas = newDistribution[i];
+        newChebyBands[i].extremas = newDistribution[i];
+    }
+}
+
+// minimum order search (type I filters)
+template <typename T>
+PMOutputT<T> firpmMinOrder(std::vector<T>const& f,
+        std::vector<T>const& a,
+        std::vector<T>const& w,
+        T targetDelta,
+        std::size_t nStart,
+        std::size_t nMax,
+        T eps,
+        int Nmax)
+{
+    using std::isnan;
+    std::vector<BandT<T>> freqBands(w.size());
+    std::vector<BandT<T>> chebyBands;
+    for(std::size_t i{0u}; i < freqBands.size(); ++i)
+    {
+        freqBands[i].start = constPi<T>() * f[2u * i];
+        freqBands[i].stop  = constPi<T>() * f[2u * i + 1u];
+        freqBands[i].space = BandSpace::FREQ;
+        setAmplitude(freqBands[i], linearResponse(freqBands[i].start,
+                    freqBands[i].stop, a[2u * i], a[2u * i + 1u]));
+        setWeight(freqBands[i], constantResponse(w[i]));
+    }
+    bandConversion(chebyBands, freqBands, ConversionDirection::FROMFREQ);
+
+    // a design of a given degree, either started from the uniform
+    // initialization or from the reference of another degree (the extrema
+    // counts of the bands correspond to output.x)
+    struct Design {
+        std::size_t degree;
+        PMOutputT<T> output;
+        std::vector<BandT<T>> chebyBands;
+        std::vector<BandT<T>> freqBands;
+        bool meetsTarget;
+    };
+    auto evaluate = [&](Design& design) {
+        design.meetsTarget = !isnan(design.output.delta)
+            && !isnan(design.output.Q) && design.output.Q <= eps
+            && design.output.delta <= targetDelta;
+    };
+    auto coldStart = [&](std::size_t degree) -> Design {
+        Design design{degree, PMOutputT<T>(), chebyBands, freqBands, false};
+        std::vector<T> omega(degree + 2u);
+        std::vector<T> x(degree + 2u);
+        initUniformExtremas(omega, design.freqBands);
+        applyCos(x, omega);
+        bandConversion(design.chebyBands, design.freqBands,
+                ConversionDirection::FROMFREQ);
+        design.output = exchange(x, design.chebyBands, eps, Nmax);
+        evaluate(design);
+        return design;
+    };
+    // the doubling steps use reference scaling, the other ones resample the
+    // reference; if the warm started exchange does not converge, the design
+    // is started again from scratch
+    auto warmStart = [&](std::size_t degree, Design& from) -> Design {
+        Design design{degree, PMOutputT<T>(), from.chebyBands,
+            from.freqBands, false};
+        std::vector<T> x;
+        if(degree == 2u * from.degree)
+            referenceScaling(x, design.chebyBands, design.freqBands,
+                    degree + 2u, from.output.x, from.chebyBands,
+                    from.freqBands);
+        else
+            resampleReference(x, design.chebyBands, design.freqBands,
+                    degree + 2u, from.output.x, from.chebyBands);
+        design.output = exchange(x, design.chebyBands, eps, Nmax);
+        if(isnan(design.output.Q) || design.output.Q > eps)
+            return coldStart(degree);
+        evaluate(design);
+        return design;
+    };
+
+    // bracket the minimum degree between a design that does not meet the
+    // target (lo) and one that does (hi)
+    std::size_t minDegree = 2u * w.size();
+    std::size_t maxDegree = std::max(nMax / 2u, minDegree);
+    Design hi = coldStart(std::min(std::max(nStart / 2u, minDegree),
+                maxDegree));
+    Design lo = hi;
+    if(hi.meetsTarget)
+    {
+        while(lo.meetsTarget && lo.degree > minDegree)
+        {
+            hi = lo;
+            lo = warmStart(std::max(lo.degree / 2u, minDegree), hi);
+        }
+        if(lo.meetsTarget)
+            hi = lo;
+    } else {
+        while(!hi.meetsTarget && hi.degree < maxDegree)
+        {
+            lo = hi;
+            hi = warmStart(std::min(2u * lo.degree, maxDegree), lo);
+        }
+        if(!hi.meetsTarget)
+            std::cerr << "Warning: the target error cannot be reached with "
+                << "a filter of order " << 2u * maxDegree << std::endl;
+    }
+
+    // bisection on the degree (each design starts from the closest one of
+    // the bracket)
+    if(hi.meetsTarget && !lo.meetsTarget)
+    {
+        while(hi.degree - lo.degree > 1u)
+        {
+            std::size_t degree = (lo.degree + hi.degree) / 2u;
+            Design mid = warmStart(degree,
+                    (degree - lo.degree <= hi.degree - degree) ? lo : hi);
+            if(mid.meetsTarget)
+                hi = mid;
+            else
+                lo = mid;
+        }
+    }
+
+    PMOutputT<T> output = hi.output;
+    std::size_t degree = hi.degree;
+    std::size_t n = 2u * degree;
+    std::vector<T> h(n + 1u);
+    h[degree] = output.h[0];
+    for(std::size_t i{0u}; i < degree; ++i)
+        h[i] = h[n - i] = output.h[degree - i] / 2u;
+    output.h = h;
+    return output;
+}
+
+template <typename T>
+void firpmBatch(std::vector<PMOutputT<T>>& outputs,
+        std::vector<PMSpecT<T>>const& specs,
+        std::size_t threads)
+{
+    outputs.resize(specs.size());
+    runTasks(specs.size(), [&](std::size_t i) {
+        PMSpecT<T> const& spec = specs[i];
+        outputs[i] = firpmRS(spec.N, spec.f, spec.a, spec.w, spec.epsT,
+                spec.depth, spec.Nmax, spec.root);
+    }, threads);
+}
+
+#define PM_INSTANTIATE(T)                                                     \
+    template void initUniformExtremas<T>(std::vector<T>&,                    \
+            std::vector<BandT<T>>&);                                         \
+    template void referenceScaling<T>(std::vector<T>&,                       \
+            std::vector<BandT<T>>&, std::vector<BandT<T>>&, std::size_t,     \
+            std::vector<T>&, std::vector<BandT<T>>&,                         \
+            std::vector<BandT<T>>&);                                         \
+    template PMOutputT<T> exchange<T>(std::vector<T>&,                       \
+            std::vector<BandT<T>>&, T, int);                                 \
+    template PMOutputT<T> firpm<T>(std::size_t, std::vector<T> const&,       \
+            std::vector<T> const&, std::vector<T> const&, T, int);           \
+    template PMOutputT<T> firpmRS<T>(std::size_t, std::vector<T> const&,     \
+            std::vector<T> const&, std::vector<T> const&, T, std::size_t,    \
+            int, RootSolver);                                                \
+    template PMOutputT<T> firpmAFP<T>(std::size_t, std::vector<T> const&,    \
+            std::vector<T> const&, std::vector<T> const&, T, int);           \
+    template PMOutputT<T> firpm<T>(std::size_t, std::vector<T> const&,       \
+            std::vector<T> const&, std::vector<T> const&, ftype, T, int);    \
+    template PMOutputT<T> firpmRS<T>(std::size_t, std::vector<T> const&,     \
+            std::vector<T> const&, std::vector<T> const&, ftype, T,          \
+            std::size_t, int, RootSolver);                                   \
+    template PMOutputT<T> firpmAFP<T>(std::size_t, std::vector<T> const&,    \
+            std::vector<T> const&, std::vector<T> const&, ftype, T, int);    \
+    template PMOutputT<T> firpmMinOrder<T>(std::vector<T> const&,            \
+            std::vector<T> const&, std::vector<T> const&, T, std::size_t,    \
+            std::size_t, T, int);                                            \
+    template void firpmBatch<T>(std::vector<PMOutputT<T>>&,                  \
+            std::vector<PMSpecT<T>> const&, std::size_t);
+
+PM_INSTANTIATE(double)
+PM_INSTANTIATE(dd::ddreal)
+
+// non-template versions, which allow conversions of their arguments
+#define PM_FORWARD(T)                                                         \
+    PMOutputT<T> firpm(std::size_t N, std::vector<T> const& f,               \
+            std::vector<T> const& a, std::vector<T> const& w, T epsT,        \
+            int Nmax)                                                        \
+    {                                                                        \
+        return firpm<T>(N, f, a, w, epsT, Nmax);                             \
+    }                                                                        \
+    PMOutputT<T> firpmRS(std::size_t N, std::vector<T> const& f,             \
+            std::vector<T> const& a, std::vector<T> const& w, T epsT,        \
+            std::size_t depth, int Nmax, RootSolver root)                    \
+    {                                                                        \
+        return firpmRS<T>(N, f, a, w, epsT, depth, Nmax, root);              \
+    }                                                                        \
+    PMOutputT<T> firpmAFP(std::size_t N, std::vector<T> const& f,            \
+            std::vector<T> const& a, std::vector<T> const& w, T epsT,        \
+            int Nmax)                                                        \
+    {                                                                        \
+        return firpmAFP<T>(N, f, a, w, epsT, Nmax);                          \
+    }                                                                        \
+    PMOutputT<T> firpm(std::size_t N, std::vector<T> const& f,               \
+            std::vector<T> const& a, std::vector<T> const& w, ftype type,    \
+            T epsT, int Nmax)                                                \
+    {                                                                        \
+        return firpm<T>(N, f, a, w, type, epsT, Nmax);                       \
+    }                                                                        \
+    PMOutputT<T> firpmRS(std::size_t N, std::vector<T> const& f,             \
+            std::vector<T> const& a, std::vector<T> const& w, ftype type,    \
+            T epsT, std::size_t depth, int Nmax, RootSolver root)            \
+    {                                                                        \
+        return firpmRS<T>(N, f, a, w, type, epsT, depth, Nmax, root);        \
+    }                                                                        \
+    PMOutputT<T> firpmAFP(std::size_t N, std::vector<T> const& f,            \
+            std::vector<T> const& a, std::vector<T> const& w, ftype type,    \
+            T epsT, int Nmax)                                                \
+    {                                                                        \
+        return firpmAFP<T>(N, f, a, w, type, epsT, Nmax);                    \
+    }
+
+PM_FORWARD(double)
+PM_FORWARD(dd::ddreal)
+
+static ResponseModelT<double> toDoubleModel(ResponseModel const &model) {
+  ResponseModelT<double> out;
+  out.type = model.type;
+  for (auto &it : model.coeffs)
+    out.coeffs.push_back(it.toDouble());
+  return out;
+}
+
+// converts the band information to double precision (the ideal response and
+// the weight function are still evaluated with MPFR when they do not have an
+// analytic description)
+static void toDoubleBands(std::vector<BandD> &out, std::vector<Band> &in) {
+  out.resize(in.size());
+  for (std::size_t i = 0u; i < in.size(); ++i) {
+    std::function<mpfr::mpreal(BandSpace, mpfr::mpreal)> amplitude =
+        in[i].amplitude;
+    std::function<mpfr::mpreal(BandSpace, mpfr::mpreal)> weight =
+        in[i].weight;
+    out[i].space = in[i].space;
+    out[i].start = in[i].start.toDouble();
+    out[i].stop = in[i].stop.toDouble();
+    out[i].extremas = in[i].extremas;
+    if (in[i].amplitudeModel.type != FUNCTION)
+      setAmplitude(out[i], toDoubleModel(in[i].amplitudeModel));
+    else
+      out[i].amplitude = [amplitude](BandSpace space, double x) -> double {
+        return amplitude(space, mpfr::mpreal(x)).toDouble();
+      };
+    if (in[i].weightModel.type != FUNCTION)
+      setWeight(out[i], toDoubleModel(in[i].weightModel));
+    else
+      out[i].weight = [weight](BandSpace space, double x) -> double {
+        return weight(space, mpfr::mpreal(x)).toDouble();
+      };
+  }
+}
+
+PMOutput exchangeMixed(std::vector<mpfr::mpreal> &x,
+                       std::vector<Band> &chebyBands, mpfr::mpreal eps,
+                       int Nmax, mp_prec_t prec) {
+  using mpfr::mpreal;
+  ScopedPrecision guard(prec);
+
+  std::vector<BandD> chebyBandsD;
+  toDoubleBands(chebyBandsD, chebyBands);
+  std::vector<double> xD(x.size());
+  for (std::size_t i = 0u; i < x.size(); ++i)
+    xD[i] = x[i].toDouble();
+  std::sort(xD.begin(), xD.end());
+
+  // double precision phase: it stops at convergence, when the convergence
+  // parameter no longer decreases once the iterations are close to
+  // convergence (i.e. the rounding errors dominate) or when an iteration
+  // fails, in which case its result is discarded
+  double epsD = std::max(eps.toDouble(), 1e-12);
+  double Q = 1.0;
+  double lastQ, delta;
+  std::size_t iterD = 0u;
+  std::vector<double> newX;
+  std::vector<std::size_t> counts(chebyBandsD.size());
+  do {
+    lastQ = Q;
+    for (std::size_t i = 0u; i < chebyBandsD.size(); ++i)
+      counts[i] = chebyBandsD[i].extremas;
+    findEigenExtrema(Q, delta, newX, xD, chebyBandsD, Nmax);
+    if (std::isnan(Q) || std::isnan(delta) || Q > 1.0) {
+      for (std::size_t i = 0u; i < chebyBandsD.size(); ++i)
+        chebyBandsD[i].extremas = counts[i];
+      break;
+    }
+    ++iterD;
+    xD = newX;
+  } while (Q > epsD && (Q < lastQ || lastQ > 1e-3) && iterD <= 100u);
+
+  // MPFR phase, starting from the reference computed in double precision
+  // (the reference points located on the band edges are mapped back to the
+  // exact edges)
+  std::vector<mpreal> startX(x);
+  if (iterD > 0u) {
+    for (std::size_t i = 0u; i < xD.size(); ++i) {
+      startX[i] = xD[i];
+      for (std::size_t j = 0u; j < chebyBandsD.size(); ++j) {
+        if (xD[i] == chebyBandsD[j].start)
+          startX[i] = chebyBands[j].start;
+        else if (xD[i] == chebyBandsD[j].stop)
+          startX[i] = chebyBands[j].stop;
+      }
+    }
+    for (std::size_t i = 0u; i < chebyBands.size(); ++i)
+      chebyBands[i].extremas = chebyBandsD[i].extremas;
+  }
+  PMOutput output = exchange(startX, chebyBands, eps, Nmax, prec);
+  output.iter += iterD;
+
+  return output;
+}
@@ -1,5 +1,6 @@
 #include "filter/roots.h"
 #include "filter/pm.h"
+#include "filter/scheduler.h"
 #include <algorithm>
 #include <iomanip>
 #include <cstdlib>
@@ -7,14 +8,15 @@
 
 int maxDegree = 8;
 int intervalDensity = 16;
+// the degree from which the adaptive interpolants are built
+int minDegree = 4;
 
 int gridDensity = 16;
 
 void generateGridPoints(std::vector<mpfr::mpreal> &grid, std::size_t degree,
                         std::vector<Band> &freqBands, mpfr_prec_t prec) {
   using mpfr::mpreal;
-  mpfr_prec_t prevPrec = mpreal::get_default_prec();
-  mpreal::set_default_prec(prec);
+  ScopedPrecision guard(prec);
 
   mpfr::mpreal increment = mpfr::const_pi();
   increment /= (degree * gridDensity);
@@ -27,15 +29,12 @@ void generateGridPoints(std::vector<mpfr::mpreal> &grid, std::size_t degree,
     grid[grid.size() - 1] = freqBands[bandIndex].stop;
     ++bandIndex;
   }
-
-  mpreal::set_default_prec(prevPrec);
 }
 
 void uniformSplit(std::vector<Interval> &subIntervals, const std::size_t N,
                   std::vector<Band> &chebyBands, mpfr_prec_t prec) {
   using mpfr::mpreal;
-  mpfr_prec_t prevPrec = mpreal::get_default_prec();
-  mpreal::set_default_prec(prec);
+  ScopedPrecision guard(prec);
 
   mpreal totalSize = 0;
   for (std::size_t i = 0u; i < chebyBands.size(); ++i)
@@ -58,8 +57,6 @@ void uniformSplit(std::vector<Interval> &subIntervals, const std::size_t N,
 
   //for(auto& it : subIntervals)
   //  std::cout << "[" << it.first << ", " << it.second << "];\n";
-
-  mpreal::set_default_prec(prevPrec);
 }
 
 void getError(mpfr::mpreal &error, std::vector<Band> &chebyBands,
@@ -74,8 +71,7 @@ void computeDenseNorm(mpfr::mpreal &normValue, std::vector<Band> &chebyBands,
                       std::vector<mpfr::mpreal> &a,
                       std::vector<mpfr::mpreal> &grid, mpfr_prec_t prec) {
   using mpfr::mpreal;
-  mpfr_prec_t prevPrec = mpreal::get_default_prec();
-  mpreal::set_default_prec(prec);
+  ScopedPrecision guard(prec);
 
   mpfr::mpreal currentMax, currentValue;
   normValue = 0;
@@ -86,8 +82,59 @@ void computeDenseNorm(mpfr::mpreal &normValue, std::vector<Band> &chebyBands,
     if (currentMax > normValue)
       normValue = currentMax;
   }
+}
 
-  mpreal::set_default_prec(prevPrec);
+// Computes the Chebyshev coefficients of an interpolant of the error on a
+// subinterval, whose degree is chosen adaptively. chebyNodes holds the
+// nodes cos(j * pi / n) for the largest degree n allowed. Since these nodes
+// are nested, the degree is doubled starting from minDegree, reusing the
+// error values already computed, until the two highest order coefficients
+// are negligible with respect to the largest one (i.e. below it by a factor
+// of 2^(2p/3), p being the working precision) or the degree reaches n. The
+// degree of the interpolant is chebyCoeffs.size() - 1 on exit.
+static void adaptiveInterpolation(std::vector<mpfr::mpreal> &chebyCoeffs,
+                                  std::vector<mpfr::mpreal> &chebyNodes,
+                                  Interval &subInterval,
+                                  std::vector<Band> &chebyBands,
+                                  std::vector<mpfr::mpreal> &a,
+                                  mpfr_prec_t prec) {
+  std::size_t maxSize = chebyNodes.size() - 1u;
+  std::vector<mpfr::mpreal> siCN(maxSize + 1u);
+  changeOfVariable(siCN, chebyNodes, subInterval.first, subInterval.second);
+
+  std::size_t n = std::min((std::size_t)minDegree, maxSize);
+  if (maxSize % n != 0u)
+    n = maxSize;
+  std::size_t stride = maxSize / n;
+  std::vector<mpfr::mpreal> fx(maxSize + 1u);
+  for (std::size_t j = 0u; j <= maxSize; j += stride)
+    getError(fx[j], chebyBands, siCN[j], a, prec);
+
+  mpfr::mpreal tol =
+      mpfr::ldexp(mpfr::mpreal(1, prec), -(mp_exp_t)(2u * prec / 3u));
+  std::vector<mpfr::mpreal> fv;
+  while (true) {
+    fv.resize(n + 1u);
+    for (std::size_t j = 0u; j <= n; ++j)
+      fv[j] = fx[j * stride];
+    chebyCoeffs.resize(n + 1u);
+    generateChebyshevCoefficients(chebyCoeffs, fv, n, prec);
+    if (n == maxSize)
+      return;
+    mpfr::mpreal scale = 0;
+    for (auto &it : chebyCoeffs)
+      scale = mpfr::max(scale, mpfr::abs(it));
+    if (mpfr::max(mpfr::abs(chebyCoeffs[n - 1u]), mpfr::abs(chebyCoeffs[n])) <=
+        tol * scale)
+      return;
+
+    std::size_t oldStride = stride;
+    n = (maxSize % (2u * n) == 0u) ? 2u * n : maxSize;
+    stride = maxSize / n;
+    for (std::size_t j = 0u; j <= maxSize; j += stride)
+      if (j % oldStride != 0u)
+        getError(fx[j], chebyBands, siCN[j], a, prec);
+  }
 }
 
 void findEigenZeros(std::vector<mpfr::mpreal> &a,
@@ -97,8 +144,7 @@ void findEigenZeros(std::vector<mpfr::mpreal> &a,
                     std::vector<Band> &chebyBands,
                     mpfr_prec_t prec) {
   using mpfr::mpreal;
-  mpfr_prec_t prevPrec = mpreal::get_default_prec();
-  mpreal::set_default_prec(prec);
+  ScopedPrecision guard(prec);
   mpfr::mpreal ia = -1;
   mpfr::mpreal ib = 1;
 
@@ -129,31 +175,23 @@ void findEigenZeros(std::vector<mpfr::mpreal> &a,
   applyCos(chebyNodes, chebyNodes);
 
   std::vector<std::vector<mpfr::mpreal>> intervalZeros(subIntervals.size());
-  #pragma omp parallel for
-  for (std::size_t i = 0u; i < subIntervals.size(); ++i) {
-    std::vector<mpfr::mpreal> siCN(maxSize + 1);
-    changeOfVariable(siCN, chebyNodes, subIntervals[i].first,
-                     subIntervals[i].second);
-
-    std::vector<mpfr::mpreal> fx(maxSize + 1);
-    for (std::size_t j = 0u; j < fx.size(); ++j)
-      getError(fx[j], chebyBands, siCN[j], a, prec);
-
-    std::vector<mpfr::mpreal> chebyCoeffs(maxSize + 1);
-    generateChebyshevCoefficients(chebyCoeffs, fx, maxSize, prec);
-
-    MatrixXq Cm(maxDegree, maxDegree);
+  parallelTasks(subIntervals.size(), [&](std::size_t i) {
+    ScopedPrecision threadGuard(prec);
+    std::vector<mpfr::mpreal> chebyCoeffs;
+    adaptiveInterpolation(chebyCoeffs, chebyNodes, subIntervals[i],
+                          chebyBands, a, prec);
+    std::size_t n = chebyCoeffs.size() - 1u;
+
+    MatrixXq Cm(n, n);
     generateColleagueMatrix1stKind(Cm, chebyCoeffs, true, prec);
     std::vector<mpfr::mpreal> eigenRoots;
-    VectorXcq roots;
-    determineEigenvalues(roots, Cm);
-    getRealValues(eigenRoots, roots, ia, ib);
+    determineRealEigenvalues(eigenRoots, Cm, ia, ib);
     changeOfVariable(eigenRoots, eigenRoots, subIntervals[i].first,
                    subIntervals[i].second);
     for (std::size_t j = 0u; j < eigenRoots.size(); ++j)
     intervalZeros[i].push_back(eigenRoots[j]);
 
-  }
+  });
   for (std::size_t i = 0u; i < intervalZeros.size(); ++i)
     for (std::size_t j = 0u; j < intervalZeros[i].size(); ++j)
       zeros.push_back(intervalZeros[i][j]);
@@ -163,7 +201,6 @@ void findEigenZeros(std::vector<mpfr::mpreal> &a,
               return lhs < rhs;
             });
 
-  mpreal::set_default_prec(prevPrec);
 
 }
 
@@ -173,8 +210,7 @@ void findEigenZeros(std::vector<mpfr::mpreal> &a,
                     std::vector<Band> &freqBands, std::vector<Band> &chebyBands,
                     mpfr_prec_t prec) {
   using mpfr::mpreal;
-  mpfr_prec_t prevPrec = mpreal::get_default_prec();
-  mpreal::set_default_prec(prec);
+  ScopedPrecision guard(prec);
   mpfr::mpreal ia = -1;
   mpfr::mpreal ib = 1;
 
@@ -186,36 +222,28 @@ void findEigenZeros(std::vector<mpfr::mpreal> &a,
   applyCos(chebyNodes, chebyNodes);
 
   std::vector<std::vector<mpfr::mpreal>> intervalZeros(subIntervals.size());
-#pragma omp parallel for
-  for (std::size_t i = 0u; i < subIntervals.size(); ++i) {
-    std::vector<mpfr::mpreal> siCN(maxDegree + 1);
-    changeOfVariable(siCN, chebyNodes, subIntervals[i].first,
-                     subIntervals[i].second);
-
-    std::vector<mpfr::mpreal> fx(maxDegree + 1);
-    for (std::size_t j = 0u; j < fx.size(); ++j)
-      getError(fx[j], chebyBands, siCN[j], a, prec);
-
-    std::vector<mpfr::mpreal> chebyCoeffs(maxDegree + 1);
-    generateChebyshevCoefficients(chebyCoeffs, fx, maxDegree, prec);
+  parallelTasks(subIntervals.size(), [&](std::size_t i) {
+    ScopedPrecision threadGuard(prec);
+    std::vector<mpfr::mpreal> chebyCoeffs;
+    adaptiveInterpolation(chebyCoeffs, chebyNodes, subIntervals[i],
+                          chebyBands, a, prec);
+    std::size_t n = chebyCoeffs.size() - 1u;
 
     // zero-free subinterval testing
     mpfr::mpreal B0 = 0;
     for (std::size_t j = 1u; j < chebyCoeffs.size(); ++j)
       B0 += mpfr::abs(chebyCoeffs[j]);
     if (B0 >= mpfr::abs(chebyCoeffs[0])) {
-      MatrixXq Cm(maxDegree, maxDegree);
+      MatrixXq Cm(n, n);
       generateColleagueMatrix1stKind(Cm, chebyCoeffs, true, prec);
       std::vector<mpfr::mpreal> eigenRoots;
-      VectorXcq roots;
-      determineEigenvalues(roots, Cm);
-      getRealValues(eigenRoots, roots, ia, ib);
+      determineRealEigenvalues(eigenRoots, Cm, ia, ib);
       changeOfVariable(eigenRoots, eigenRoots, subIntervals[i].first,
                        subIntervals[i].second);
       for (std::size_t j = 0u; j < eigenRoots.size(); ++j)
         intervalZeros[i].push_back(eigenRoots[j]);
     }
-  }
+  });
   for (std::size_t i = 0u; i < intervalZeros.size(); ++i)
     for (std::size_t j = 0u; j < intervalZeros[i].size(); ++j)
       zeros.push_back(intervalZeros[i][j]);
@@ -224,8 +252,6 @@ void findEigenZeros(std::vector<mpfr::mpreal> &a,
             [](const mpfr::mpreal &lhs, const mpfr::mpreal &rhs) {
               return lhs < rhs;
             });
-
-  mpreal::set_default_prec(prevPrec);
 }
 
 void findEigenExtremas(std::vector<mpfr::mpreal> &a,
@@ -233,8 +259,7 @@ void findEigenExtremas(std::vector<mpfr::mpreal> &a,
                        std::vector<Band> &freqBands,
                        std::vector<Band> &chebyBands, mpfr_prec_t prec) {
   using mpfr::mpreal;
-  mpfr_prec_t prevPrec = mpreal::get_default_prec();
-  mpreal::set_default_prec(prec);
+  ScopedPrecision guard(prec);
   mpfr::mpreal ia = -1;
   mpfr::mpreal ib = 1;
 
@@ -256,19 +281,13 @@ void findEigenExtremas(std::vector<mpfr::mpreal> &a,
 
   std::vector<std::vector<std::pair<mpfr::mpreal, mpfr::mpreal>>>
       intervalExtremas(subIntervals.size());
-#pragma omp parallel for
-  for (std::size_t i = 0u; i < subIntervals.size(); ++i) {
-    std::vector<mpfr::mpreal> siCN(maxDegree + 1);
-    changeOfVariable(siCN, chebyNodes, subIntervals[i].first,
-                     subIntervals[i].second);
-
-    std::vector<mpfr::mpreal> fx(maxDegree + 1);
-    for (std::size_t j = 0u; j < fx.size(); ++j)
-      getError(fx[j], chebyBands, siCN[j], a, prec);
-
-    std::vector<mpfr::mpreal> chebyCoeffs(maxDegree + 1);
-    generateChebyshevCoefficients(chebyCoeffs, fx, maxDegree, prec);
-    std::vector<mpfr::mpreal> derivCoeffs(maxDegree);
+  parallelTasks(subIntervals.size(), [&](std::size_t i) {
+    ScopedPrecision threadGuard(prec);
+    std::vector<mpfr::mpreal> chebyCoeffs;
+    adaptiveInterpolation(chebyCoeffs, chebyNodes, subIntervals[i],
+                          chebyBands, a, prec);
+    std::size_t n = chebyCoeffs.size() - 1u;
+    std::vector<mpfr::mpreal> derivCoeffs(n);
     derivativeCoefficients1stKind(derivCoeffs, chebyCoeffs);
 
     // zero-free subinterval testing
@@ -276,12 +295,10 @@ void findEigenExtremas(std::vector<mpfr::mpreal> &a,
     for (std::size_t j = 1u; j < derivCoeffs.size(); ++j)
       B0 += mpfr::abs(derivCoeffs[j]);
     if (B0 >= mpfr::abs(derivCoeffs[0])) {
-      MatrixXq Cm(maxDegree - 1, maxDegree - 1);
+      MatrixXq Cm(n - 1u, n - 1u);
       generateColleagueMatrix1stKind(Cm, derivCoeffs, true, prec);
       std::vector<mpfr::mpreal> eigenRoots;
-      VectorXcq roots;
-      determineEigenvalues(roots, Cm);
-      getRealValues(eigenRoots, roots, ia, ib);
+      determineRealEigenvalues(eigenRoots, Cm, ia, ib);
       changeOfVariable(eigenRoots, eigenRoots, subIntervals[i].first,
                        subIntervals[i].second);
       for (std::size_t j = 0u; j < eigenRoots.size(); ++j) {
@@ -289,7 +306,7 @@ void findEigenExtremas(std::vector<mpfr::mpreal> &a,
         intervalExtremas[i].push_back(std::make_pair(eigenRoots[j], B0));
       }
     }
-  }
+  });
   for (std::size_t i = 0u; i < intervalExtremas.size(); ++i)
     for (std::size_t j = 0u; j < intervalExtremas[i].size(); ++j)
       pExtremas.push_back(intervalExtremas[i][j]);
@@ -339,8 +356,6 @@ void findEigenExtremas(std::vector<mpfr::mpreal> &a,
     extremas.push_back(maxErrorPoint.first);
     ++extremaIt;
   }
-
-  mpreal::set_default_prec(prevPrec);
 }
 
 void computeNorm(std::pair<mpfr::mpreal, mpfr::mpreal> &norm,
@@ -349,8 +364,7 @@ void computeNorm(std::pair<mpfr::mpreal, mpfr::mpreal> &norm,
                  std::vector<Band> &chebyBands, mpfr_prec_t prec) {
 
   using mpfr::mpreal;
-  mpfr_prec_t prevPrec = mpreal::get_default_prec();
-  mpreal::set_default_prec(prec);
+  ScopedPrecision guard(prec);
   mpfr::mpreal ia = -1;
   mpfr::mpreal ib = 1;
 
@@ -376,19 +390,13 @@ void computeNorm(std::pair<mpfr::mpreal, mpfr::mpreal> &norm,
 
   std::vector<std::vector<std::pair<mpfr::mpreal, mpfr::mpreal>>>
       intervalExtremas(subIntervals.size());
-#pragma omp parallel for
-  for (std::size_t i = 0u; i < subIntervals.size(); ++i) {
-    std::vector<mpfr::mpreal> siCN(maxDegree + 1);
-    changeOfVariable(siCN, chebyNodes, subIntervals[i].first,
-                     subIntervals[i].second);
-
-    std::vector<mpfr::mpreal> fx(maxDegree + 1);
-    for (std::size_t j = 0u; j < fx.size(); ++j)
-      getError(fx[j], chebyBands, siCN[j], a, prec);
-
-    std::vector<mpfr::mpreal> chebyCoeffs(maxDegree + 1);
-    generateChebyshevCoefficients(chebyCoeffs, fx, maxDegree, prec);
-    std::vector<mpfr::mpreal> derivCoeffs(maxDegree);
+  parallelTasks(subIntervals.size(), [&](std::size_t i) {
+    ScopedPrecision threadGuard(prec);
+    std::vector<mpfr::mpreal> chebyCoeffs;
+    adaptiveInterpolation(chebyCoeffs, chebyNodes, subIntervals[i],
+                          chebyBands, a, prec);
+    std::size_t n = chebyCoeffs.size() - 1u;
+    std::vector<mpfr::mpreal> derivCoeffs(n);
     derivativeCoefficients1stKind(derivCoeffs, chebyCoeffs);
 
     // zero-free subinterval testing
@@ -396,12 +404,10 @@ void computeNorm(std::pair<mpfr::mpreal, mpfr::mpreal> &norm,
     for (std::size_t j = 1u; j < derivCoeffs.size(); ++j)
       B0 += mpfr::abs(derivCoeffs[j]);
     if (B0 >= mpfr::abs(derivCoeffs[0])) {
-      MatrixXq Cm(maxDegree - 1, maxDegree - 1);
+      MatrixXq Cm(n - 1u, n - 1u);
       generateColleagueMatrix1stKind(Cm, derivCoeffs, true, prec);
       std::vector<mpfr::mpreal> eigenRoots;
-      VectorXcq roots;
-      determineEigenvalues(roots, Cm);
-      getRealValues(eigenRoots, roots, ia, ib);
+      determineRealEigenvalues(eigenRoots, Cm, ia, ib);
       changeOfVariable(eigenRoots, eigenRoots, subIntervals[i].first,
                        subIntervals[i].second);
       for (std::size_t j = 0u; j < eigenRoots.size(); ++j) {
@@ -409,7 +415,7 @@ void computeNorm(std::pair<mpfr::mpreal, mpfr::mpreal> &norm,
         intervalExtremas[i].push_back(std::make_pair(eigenRoots[j], B0));
       }
     }
-  }
+  });
   for (std::size_t i = 0u; i < intervalExtremas.size(); ++i)
     for (std::size_t j = 0u; j < intervalExtremas[i].size(); ++j)
       pExtremas.push_back(intervalExtremas[i][j]);
@@ -488,18 +494,67 @@ void computeDenseNorm(double &normValue, std::vector<BandD> &chebyBands,
                       std::vector<double> &a,
                       std::vector<double> &grid) {
 
-  double currentMax, currentValue;
+  std::vector<double> x(grid.size());
+  std::vector<double> values;
+  for (std::size_t i = 0u; i < grid.size(); ++i)
+    x[i] = cos(grid[i]);
+  evaluateClenshaw(values, a, x);
+
+  double currentMax, D, W;
   normValue = 0;
-  for (auto &it : grid) {
-    currentValue = cos(it);
-    getError(currentMax, chebyBands, currentValue, a);
-    currentMax = fabs(currentMax);
+  for (std::size_t i = 0u; i < x.size(); ++i) {
+    computeIdealResponseAndWeight(D, W, x[i], chebyBands);
+    currentMax = fabs(W * (D - values[i]));
     if (currentMax > normValue)
       normValue = currentMax;
   }
 
 }
 
+// double precision version of the adaptive interpolation (see above)
+static void adaptiveInterpolation(std::vector<double> &chebyCoeffs,
+                                  std::vector<double> &chebyNodes,
+                                  IntervalD &subInterval,
+                                  std::vector<BandD> &chebyBands,
+                                  std::vector<double> &a) {
+  std::size_t maxSize = chebyNodes.size() - 1u;
+  std::vector<double> siCN(maxSize + 1u);
+  changeOfVariable(siCN, chebyNodes, subInterval.first, subInterval.second);
+
+  std::size_t n = std::min((std::size_t)minDegree, maxSize);
+  if (maxSize % n != 0u)
+    n = maxSize;
+  std::size_t stride = maxSize / n;
+  std::vector<double> fx(maxSize + 1u);
+  for (std::size_t j = 0u; j <= maxSize; j += stride)
+    getError(fx[j], chebyBands, siCN[j], a);
+
+  double tol = ldexp(1.0, -2 * std::numeric_limits<double>::digits / 3);
+  std::vector<double> fv;
+  while (true) {
+    fv.resize(n + 1u);
+    for (std::size_t j = 0u; j <= n; ++j)
+      fv[j] = fx[j * stride];
+    chebyCoeffs.resize(n + 1u);
+    generateChebyshevCoefficients(chebyCoeffs, fv, n);
+    if (n == maxSize)
+      return;
+    double scale = 0;
+    for (auto &it : chebyCoeffs)
+      scale = std::max(scale, fabs(it));
+    if (std::max(fabs(chebyCoeffs[n - 1u]), fabs(chebyCoeffs[n])) <=
+        tol * scale)
+      return;
+
+    std::size_t oldStride = stride;
+    n = (maxSize % (2u * n) == 0u) ? 2u * n : maxSize;
+    stride = maxSize / n;
+    for (std::size_t j = 0u; j <= maxSize; j += stride)
+      if (j % oldStride != 0u)
+        getError(fx[j], chebyBands, siCN[j], a);
+  }
+}
+
 void findEigenZeros(std::vector<double> &a,
                     std::vector<double> &zeros,
                     std::vector<BandD> &freqBands, std::vector<BandD> &chebyBands)
@@ -515,36 +570,27 @@ void findEigenZeros(std::vector<double> &a,
   applyCos(chebyNodes, chebyNodes);
 
   std::vector<std::vector<double>> intervalZeros(subIntervals.size());
-#pragma omp parallel for
-  for (std::size_t i = 0u; i < subIntervals.size(); ++i) {
-    std::vector<double> siCN(maxDegree + 1);
-    changeOfVariable(siCN, chebyNodes, subIntervals[i].first,
-                     subIntervals[i].second);
-
-    std::vector<double> fx(maxDegree + 1);
-    for (std::size_t j = 0u; j < fx.size(); ++j)
-      getError(fx[j], chebyBands, siCN[j], a);
-
-    std::vector<double> chebyCoeffs(maxDegree + 1);
-    generateChebyshevCoefficients(chebyCoeffs, fx, maxDegree);
+  parallelTasks(subIntervals.size(), [&](std::size_t i) {
+    std::vector<double> chebyCoeffs;
+    adaptiveInterpolation(chebyCoeffs, chebyNodes, subIntervals[i],
+                          chebyBands, a);
+    std::size_t n = chebyCoeffs.size() - 1u;
 
     // zero-free subinterval testing
     double B0 = 0;
     for (std::size_t j = 1u; j < chebyCoeffs.size(); ++j)
       B0 += fabs(chebyCoeffs[j]);
     if (B0 >= fabs(chebyCoeffs[0])) {
-      MatrixXd Cm(maxDegree, maxDegree);
+      MatrixXd Cm(n, n);
       generateColleagueMatrix1stKind(Cm, chebyCoeffs, true);
       std::vector<double> eigenRoots;
-      VectorXcd roots;
-      determineEigenvalues(roots, Cm);
-      getRealValues(eigenRoots, roots, ia, ib);
+      determineRealEigenvalues(eigenRoots, Cm, ia, ib);
       changeOfVariable(eigenRoots, eigenRoots, subIntervals[i].first,
                        subIntervals[i].second);
       for (std::size_t j = 0u; j < eigenRoots.size(); ++j)
         intervalZeros[i].push_back(eigenRoots[j]);
     }
-  }
+  });
   for (std::size_t i = 0u; i < intervalZeros.size(); ++i)
     for (std::size_t j = 0u; j < intervalZeros[i].size(); ++j)
       zeros.push_back(intervalZeros[i][j]);
@@ -820,31 +866,21 @@ void findEigenZeros(std::vector<double> &a,
   applyCos(chebyNodes, chebyNodes);
 
   std::vector<std::vector<double>> intervalZeros(subIntervals.size());
-  #pragma omp parallel for
-  for (std::size_t i = 0u; i < subIntervals.size(); ++i) {
-
-    std::vector<double> siCN(maxSize + 1);
-    changeOfVariable(siCN, chebyNodes, subIntervals[i].first,
-                     subIntervals[i].second);
-
-    std::vector<double> fx(maxSize + 1);
-    for (std::size_t j = 0u; j < fx.size(); ++j)
-      getError(fx[j], chebyBands, siCN[j], a);
-
-    std::vector<double> chebyCoeffs(maxSize + 1);
-    generateChebyshevCoefficients(chebyCoeffs, fx, maxSize);
+  parallelTasks(subIntervals.size(), [&](std::size_t i) {
+    std::vector<double> chebyCoeffs;
+    adaptiveInterpolation(chebyCoeffs, chebyNodes, subIntervals[i],
+                          chebyBands, a);
+    std::size_t n = chebyCoeffs.size() - 1u;
 
-      MatrixXd Cm(maxSize, maxSize);
+      MatrixXd Cm(n, n);
       generateColleagueMatrix1stKind(Cm, chebyCoeffs, true);
       std::vector<double> eigenRoots;
-      VectorXcd roots;
-      determineEigenvalues(roots, Cm);
-      getRealValues(eigenRoots, roots, ia, ib);
+      determineRealEigenvalues(eigenRoots, Cm, ia, ib);
       changeOfVariable(eigenRoots, eigenRoots, subIntervals[i].first,
                        subIntervals[i].second);
       for (std::size_t j = 0u; j < eigenRoots.size(); ++j)
         intervalZeros[i].push_back(eigenRoots[j]);
-  }
+  });
   for (std::size_t i = 0u; i < intervalZeros.size(); ++i)
     for (std::size_t j = 0u; j < intervalZeros[i].size(); ++j)
       zeros.push_back(intervalZeros[i][j]);
@@ -892,19 +928,12 @@ void findEigenExtremas(std::vector<double> &a,
 
   std::vector<std::vector<std::pair<double, double>>>
       intervalExtremas(subIntervals.size());
-  #pragma omp parallel for
-  for (std::size_t i = 0u; i < subIntervals.size(); ++i) {
-    std::vector<double> siCN(maxDegree + 1);
-    changeOfVariable(siCN, chebyNodes, subIntervals[i].first,
-                     subIntervals[i].second);
-
-    std::vector<double> fx(maxDegree + 1);
-    for (std::size_t j = 0u; j < fx.size(); ++j)
-      getError(fx[j], chebyBands, siCN[j], a);
-
-    std::vector<double> chebyCoeffs(maxDegree + 1);
-    generateChebyshevCoefficients(chebyCoeffs, fx, maxDegree);
-    std::vector<double> derivCoeffs(maxDegree);
+  parallelTasks(subIntervals.size(), [&](std::size_t i) {
+    std::vector<double> chebyCoeffs;
+    adaptiveInterpolation(chebyCoeffs, chebyNodes, subIntervals[i],
+                          chebyBands, a);
+    std::size_t n = chebyCoeffs.size() - 1u;
+    std::vector<double> derivCoeffs(n);
     derivativeCoefficients1stKind(derivCoeffs, chebyCoeffs);
 
     // zero-free subinterval testing
@@ -912,12 +941,10 @@ void findEigenExtremas(std::vector<double> &a,
     for (std::size_t j = 1u; j < derivCoeffs.size(); ++j)
       B0 += fabs(derivCoeffs[j]);
     if (B0 >= fabs(derivCoeffs[0])) {
-      MatrixXd Cm(maxDegree - 1, maxDegree - 1);
+      MatrixXd Cm(n - 1u, n - 1u);
       generateColleagueMatrix1stKind(Cm, derivCoeffs, true);
       std::vector<double> eigenRoots;
-      VectorXcd roots;
-      determineEigenvalues(roots, Cm);
-      getRealValues(eigenRoots, roots, ia, ib);
+      determineRealEigenvalues(eigenRoots, Cm, ia, ib);
       changeOfVariable(eigenRoots, eigenRoots, subIntervals[i].first,
                        subIntervals[i].second);
       for (std::size_t j = 0u; j < eigenRoots.size(); ++j) {
@@ -925,7 +952,7 @@ void findEigenExtremas(std::vector<double> &a,
         intervalExtremas[i].push_back(std::make_pair(eigenRoots[j], B0));
       }
     }
-  }
+  });
   for (std::size_t i = 0u; i < intervalExtremas.size(); ++i)
     for (std::size_t j = 0u; j < intervalExtremas[i].size(); ++j)
       pExtremas.push_back(intervalExtremas[i][j]);
@@ -1009,19 +1036,12 @@ void computeNorm(std::pair<double, double> &norm,
 
   std::vector<std::vector<std::pair<double, double>>>
       intervalExtremas(subIntervals.size());
-#pragma omp parallel for
-  for (std::size_t i = 0u; i < subIntervals.size(); ++i) {
-    std::vector<double> siCN(maxDegree + 1);
-    changeOfVariable(siCN, chebyNodes, subIntervals[i].first,
-                     subIntervals[i].second);
-
-    std::vector<double> fx(maxDegree + 1);
-    for (std::size_t j = 0u; j < fx.size(); ++j)
-      getError(fx[j], chebyBands, siCN[j], a);
-
-    std::vector<double> chebyCoeffs(maxDegree + 1);
-    generateChebyshevCoefficients(chebyCoeffs, fx, maxDegree);
-    std::vector<double> derivCoeffs(maxDegree);
+  parallelTasks(subIntervals.size(), [&](std::size_t i) {
+    std::vector<double> chebyCoeffs;
+    adaptiveInterpolation(chebyCoeffs, chebyNodes, subIntervals[i],
+                          chebyBands, a);
+    std::size_t n = chebyCoeffs.size() - 1u;
+    std::vector<double> derivCoeffs(n);
     derivativeCoefficients1stKind(derivCoeffs, chebyCoeffs);
 
     // zero-free subinterval testing
@@ -1029,12 +1049,10 @@ void computeNorm(std::pair<double, double> &norm,
     for (std::size_t j = 1u; j < derivCoeffs.size(); ++j)
       B0 += fabs(derivCoeffs[j]);
     if (B0 >= fabs(derivCoeffs[0])) {
-      MatrixXd Cm(maxDegree - 1, maxDegree - 1);
+      MatrixXd Cm(n - 1u, n - 1u);
       generateColleagueMatrix1stKind(Cm, derivCoeffs, true);
       std::vector<double> eigenRoots;
-      VectorXcd roots;
-      determineEigenvalues(roots, Cm);
-      getRealValues(eigenRoots, roots, ia, ib);
+      determineRealEigenvalues(eigenRoots, Cm, ia, ib);
       changeOfVariable(eigenRoots, eigenRoots, subIntervals[i].first,
                        subIntervals[i].second);
       for (std::size_t j = 0u; j < eigenRoots.size(); ++j) {
@@ -1042,7 +1060,7 @@ void computeNorm(std::pair<double, double> &norm,
         intervalExtremas[i].push_back(std::make_pair(eigenRoots[j], B0));
       }
     }
-  }
+  });
   for (std::size_t i = 0u; i < intervalExtremas.size(); ++i)
     for (std::size_t j = 0u; j < intervalExtremas[i].size(); ++j)
       pExtremas.push_back(intervalExtremas[i][j]);
@@ -0,0 +1,21 @@
+#include "filter/scheduler.h"
+
+void runTasks(std::size_t count,
+              std::function<void(std::size_t)> const &task,
+              std::size_t threads) {
+  if (omp_get_level() > 0) {
+    parallelTasks(count, task);
+    return;
+  }
+  if (threads == 0u)
+    threads = omp_get_max_threads();
+  // a single thread creates the tasks, the whole team (including the
+  // creating thread, once it is done) executes them
+#pragma omp parallel num_threads((int)threads)
+#pragma omp single
+  {
+#pragma omp taskloop grainsize(1)
+    for (std::size_t i = 0u; i < count; ++i)
+      task(i);
+  }
+}
@@ -0,0 +1,14 @@
+#include "filter/workspace.h"
+
+ScopedPrecision::ScopedPrecision(mp_prec_t prec)
+    : prevPrec(mpfr::mpreal::get_default_prec()) {
+  mpfr::mpreal::set_default_prec(prec);
+}
+
+ScopedPrecision::~ScopedPrecision() {
+  mpfr::mpreal::set_default_prec(prevPrec);
+}
+
+MPWorkspace::MPWorkspace(mp_prec_t prec)
+    : prec(prec), num(0, prec), denom(0, prec), buff(0, prec), D(0, prec),
+      W(0, prec), bn(0, prec), bn1(0, prec), bn2(0, prec) {}
@@ -1,9 +1,11 @@
 #include "filter/afp.h"
 #include "filter/band.h"
 #include "filter/barycentric.h"
+#include "filter/cache.h"
 #include "filter/cheby.h"
 #include "filter/conv.h"
 #include "filter/eigenvalue.h"
+#include "filter/fpminimax.h"
 #include "filter/plotting.h"
 #include "filter/pm.h"
 #include "filter/roots.h"
@@ -11,7 +13,16 @@
 #include "gtest/gtest.h"
 #include <algorithm>
 #include <chrono>
+#include <dirent.h>
 #include <fstream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <omp.h>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
 #include <vector>
 
 using namespace std::chrono;
@@ -416,3 +427,1345 @@ TEST(quantization_test, E125_21) {
   testLatticeBasedQuantization({0.02, 0.42, 0.52, 0.98}, {1.0, 0.0},
         {1.0, 1.0}, degree, scalingFactor);
 }
+
+TEST(cheby_test, BatchedClenshaw) {
+
+  std::vector<double> p(63);
+  for (std::size_t i{0u}; i < p.size(); ++i)
+    p[i] = cos(0.37 * i) / (i + 1);
+
+  std::vector<double> x(1001);
+  for (std::size_t i{0u}; i < x.size(); ++i)
+    x[i] = cos(M_PI * i / (x.size() - 1));
+
+  std::vector<double> values;
+  evaluateClenshaw(values, p, x);
+  ASSERT_EQ(values.size(), x.size());
+  for (std::size_t i{0u}; i < x.size(); ++i) {
+    double expected;
+    evaluateClenshaw(expected, p, x[i]);
+    ASSERT_EQ(values[i], expected);
+  }
+}
+
+TEST(barycentric_test, BatchedEvaluation) {
+  std::vector<double> x(64), C(64), w(64);
+  for (std::size_t i{0u}; i < x.size(); ++i) {
+    x[i] = cos(M_PI * (i + 0.5) / x.size());
+    C[i] = sin(3.0 * x[i]) + x[i];
+  }
+  barycentricWeights(w, x);
+
+  // the evaluation points include all the reference points
+  std::vector<double> t(x);
+  for (std::size_t i{0u}; i <= 200u; ++i)
+    t.push_back(cos(M_PI * i / 200.0));
+  std::vector<double> values;
+  computeApprox(values, t, x, C, w);
+  ASSERT_EQ(values.size(), t.size());
+  for (std::size_t i{0u}; i < t.size(); ++i) {
+    if (i < x.size()) {
+      ASSERT_EQ(values[i], C[i]);
+    } else {
+      double num = 0.0, denom = 0.0;
+      for (std::size_t j{0u}; j < x.size(); ++j) {
+        num += w[j] * C[j] / (t[i] - x[j]);
+        denom += w[j] / (t[i] - x[j]);
+      }
+      ASSERT_LT(fabs(values[i] - num / denom), 1e-12);
+    }
+  }
+}
+
+TEST(band_test, AnalyticResponses) {
+  // the same bands, described analytically and through callbacks only
+  std::vector<BandD> analytic(3), generic(3);
+  std::vector<std::vector<double>> poly{{1.0, -0.5, 0.25}, {2.0, 3.0}};
+  for (std::size_t i{0u}; i < analytic.size(); ++i) {
+    analytic[i].space = BandSpace::FREQ;
+    analytic[i].start = 1.0 * i;
+    analytic[i].stop = 1.0 * i + 0.8;
+  }
+  setAmplitude(analytic[0], polynomialResponse(poly[0]));
+  setAmplitude(analytic[1], linearResponse(1.0, 1.8, 0.5, -0.25));
+  setAmplitude(analytic[2], constantResponse(3.0));
+  setWeight(analytic[0], constantResponse(2.0));
+  setWeight(analytic[1], polynomialResponse(poly[1]));
+  setWeight(analytic[2], linearResponse(2.0, 2.8, 1.0, 4.0));
+  for (std::size_t i{0u}; i < analytic.size(); ++i) {
+    generic[i] = analytic[i];
+    generic[i].amplitudeModel = ResponseModelT<double>();
+    generic[i].weightModel = ResponseModelT<double>();
+  }
+  ASSERT_EQ(analytic[0].weightModel.type, CONSTANT);
+  ASSERT_EQ(generic[0].weightModel.type, FUNCTION);
+
+  std::vector<BandD> chebyAnalytic, chebyGeneric;
+  bandConversion(chebyAnalytic, analytic, ConversionDirection::FROMFREQ);
+  bandConversion(chebyGeneric, generic, ConversionDirection::FROMFREQ);
+  for (std::size_t i{0u}; i <= 280u; ++i) {
+    double omega = 0.01 * i;
+    double D1 = -1.0, W1 = -1.0, D2 = -1.0, W2 = -1.0;
+    computeIdealResponseAndWeight(D1, W1, omega, analytic);
+    computeIdealResponseAndWeight(D2, W2, omega, generic);
+    ASSERT_EQ(D1, D2);
+    ASSERT_EQ(W1, W2);
+    double x = cos(omega);
+    computeIdealResponseAndWeight(D1, W1, x, chebyAnalytic);
+    computeIdealResponseAndWeight(D2, W2, x, chebyGeneric);
+    ASSERT_EQ(D1, D2);
+    ASSERT_EQ(W1, W2);
+  }
+  double D = -1.0, W = -1.0;
+  computeIdealResponseAndWeight(D, W, 0.9, analytic);
+  ASSERT_EQ(D, -1.0);
+  computeIdealResponseAndWeight(D, W, 1.0, analytic);
+  ASSERT_EQ(D, 0.5);
+  ASSERT_EQ(W, 5.0);
+}
+
+TEST(afp_test, PivotedQRSelection) {
+  std::size_t degree = 150u;
+  std::vector<BandD> chebyBands(2);
+  chebyBands[0].start = -1.0;
+  chebyBands[0].stop = 0.3;
+  chebyBands[1].start = 0.5;
+  chebyBands[1].stop = 1.0;
+  std::vector<double> mesh;
+  chebyMeshGeneration(mesh, chebyBands, degree);
+  std::function<double(double)> weight = [](double x) -> double {
+    return (x < 0.4) ? 1.0 : 10.0;
+  };
+  MatrixXd A;
+  generateAFPMatrix(A, degree + 1u, mesh, weight);
+
+  // the selection has to follow the pivoting of an unblocked factorization
+  Eigen::ColPivHouseholderQR<MatrixXd> qr(A);
+  for (std::size_t blockSize : {1u, 8u, 32u}) {
+    std::vector<std::size_t> pivots;
+    pivotedQRSelection(pivots, A, blockSize);
+    ASSERT_EQ(pivots.size(), (std::size_t)qr.rank());
+    for (std::size_t i{0u}; i < pivots.size(); ++i)
+      ASSERT_EQ(pivots[i], (std::size_t)qr.colsPermutation().indices()(i));
+  }
+}
+
+TEST(afp_test, CachedReference) {
+  std::vector<double> f{0.0, 0.4, 0.5, 1.0};
+  std::vector<double> a{1.0, 1.0, 0.0, 0.0};
+  std::vector<double> w{1.0, 10.0};
+
+  clearAFPCache();
+  PMOutputD output = firpmAFP<double>(80u, f, a, w, 1e-4);
+  PMOutputD cached = firpmAFP<double>(80u, f, a, w, 1e-4);
+  clearAFPCache();
+  PMOutputD recomputed = firpmAFP<double>(80u, f, a, w, 1e-4);
+
+  ASSERT_LT(output.Q, 1e-4);
+  ASSERT_EQ(cached.h.size(), output.h.size());
+  ASSERT_EQ(recomputed.h.size(), output.h.size());
+  for (std::size_t i{0u}; i < output.h.size(); ++i) {
+    ASSERT_EQ(cached.h[i], output.h[i]);
+    ASSERT_EQ(recomputed.h[i], output.h[i]);
+  }
+}
+
+TEST(pm_test, DoubleDoubleFirpm) {
+  using mpfr::mpreal;
+  using dd::ddreal;
+
+  PMOutputDD outputDD = firpm(100, std::vector<ddreal>{0.0, 0.4, 0.5, 1.0},
+        std::vector<ddreal>{1.0, 1.0, 0.0, 0.0},
+        std::vector<ddreal>{1.0, 10.0}, ddreal(1e-6));
+  PMOutput output = firpm(100, std::vector<mpreal>{0.0, 0.4, 0.5, 1.0},
+        std::vector<mpreal>{1.0, 1.0, 0.0, 0.0},
+        std::vector<mpreal>{1.0, 10.0}, mpreal(1e-6));
+
+  ASSERT_LT(outputDD.Q, 1e-6);
+  ASSERT_EQ(outputDD.h.size(), output.h.size());
+  mpreal deltaDD = mpreal(outputDD.delta.hi) + outputDD.delta.lo;
+  ASSERT_LT(mpfr::abs(deltaDD - output.delta) / output.delta, 1e-5);
+  for (std::size_t i{0u}; i < output.h.size(); ++i) {
+    mpreal hDD = mpreal(outputDD.h[i].hi) + outputDD.h[i].lo;
+    ASSERT_LT(mpfr::abs(hDD - output.h[i]), 1e-8);
+  }
+}
+
+TEST(pm_test, MixedPrecisionExchange) {
+  using mpfr::mpreal;
+  mpfr_prec_t prevPrec = mpreal::get_default_prec();
+  mpreal::set_default_prec(165ul);
+  mpreal pi = mpfr::const_pi();
+
+  std::vector<Band> freqBands(2);
+  freqBands[0].start = 0;
+  freqBands[0].stop = pi * 0.4;
+  freqBands[1].start = pi * 0.5;
+  freqBands[1].stop = pi;
+  for (std::size_t i{0u}; i < freqBands.size(); ++i) {
+    freqBands[i].space = BandSpace::FREQ;
+    freqBands[i].amplitude = [=](BandSpace, mpreal) -> mpreal {
+      return (i == 0u) ? 1 : 0;
+    };
+    freqBands[i].weight = [=](BandSpace, mpreal) -> mpreal {
+      return (i == 0u) ? 1 : 10;
+    };
+  }
+
+  std::size_t degree = 100u;
+  std::vector<mpreal> omega(degree + 2u);
+  std::vector<mpreal> x(degree + 2u);
+  initUniformExtremas(omega, freqBands);
+  applyCos(x, omega);
+  std::vector<Band> chebyBands, chebyBandsMixed;
+  bandConversion(chebyBands, freqBands, ConversionDirection::FROMFREQ);
+  bandConversion(chebyBandsMixed, freqBands, ConversionDirection::FROMFREQ);
+  std::vector<mpreal> xMixed(x);
+
+  PMOutput output = exchange(x, chebyBands, 1e-8);
+  PMOutput outputMixed = exchangeMixed(xMixed, chebyBandsMixed, 1e-8);
+
+  ASSERT_LT(outputMixed.Q, 1e-8);
+  ASSERT_EQ(outputMixed.h.size(), output.h.size());
+  ASSERT_LT(mpfr::abs(outputMixed.delta - output.delta) / output.delta, 1e-7);
+  for (std::size_t i{0u}; i < output.h.size(); ++i)
+    ASSERT_LT(mpfr::abs(outputMixed.h[i] - output.h[i]), 1e-10);
+
+  mpreal::set_default_prec(prevPrec);
+}
+
+TEST(pm_test, NewtonExchange) {
+  using mpfr::mpreal;
+  mpfr_prec_t prevPrec = mpreal::get_default_prec();
+  mpreal::set_default_prec(165ul);
+  mpreal pi = mpfr::const_pi();
+
+  std::vector<Band> freqBands(2);
+  freqBands[0].start = 0;
+  freqBands[0].stop = pi * 0.4;
+  freqBands[1].start = pi * 0.5;
+  freqBands[1].stop = pi;
+  for (std::size_t i{0u}; i < freqBands.size(); ++i) {
+    freqBands[i].space = BandSpace::FREQ;
+    freqBands[i].amplitude = [=](BandSpace, mpreal) -> mpreal {
+      return (i == 0u) ? 1 : 0;
+    };
+    freqBands[i].weight = [=](BandSpace, mpreal) -> mpreal {
+      return (i == 0u) ? 1 : 10;
+    };
+  }
+
+  std::size_t degree = 100u;
+  std::vector<mpreal> omega(degree + 2u);
+  std::vector<mpreal> x(degree + 2u);
+  initUniformExtremas(omega, freqBands);
+  applyCos(x, omega);
+  std::vector<Band> chebyBands, chebyBandsNewton;
+  bandConversion(chebyBands, freqBands, ConversionDirection::FROMFREQ);
+  bandConversion(chebyBandsNewton, freqBands, ConversionDirection::FROMFREQ);
+  std::vector<mpreal> xNewton(x);
+
+  PMOutput output = exchange(x, chebyBands, 1e-10);
+  PMOutput outputNewton = exchangeNewton(xNewton, chebyBandsNewton, 1e-10);
+
+  ASSERT_LT(outputNewton.Q, 1e-10);
+  ASSERT_EQ(outputNewton.h.size(), output.h.size());
+  ASSERT_LT(mpfr::abs(outputNewton.delta - output.delta) / output.delta, 1e-8);
+  for (std::size_t i{0u}; i < output.h.size(); ++i)
+    ASSERT_LT(mpfr::abs(outputNewton.h[i] - output.h[i]), 1e-10);
+
+  mpreal::set_default_prec(prevPrec);
+}
+
+TEST(pm_test, MinimumOrderSearch) {
+  std::vector<double> f{0.0, 0.4, 0.5, 1.0};
+  std::vector<double> a{1.0, 1.0, 0.0, 0.0};
+  std::vector<double> w{1.0, 10.0};
+
+  // the target is the error of the order 90 filter, so that the search has
+  // to bracket it from the default starting order
+  PMOutputD reference = firpm(90, f, a, w, 1e-6);
+  PMOutputD output = firpmMinOrder(f, a, w, reference.delta * (1 + 1e-4),
+                                   32u, 2000u, 1e-6);
+
+  ASSERT_EQ(output.h.size(), 91u);
+  ASSERT_LT(output.delta, reference.delta * (1 + 1e-4));
+  for (std::size_t i{0u}; i < output.h.size(); ++i)
+    ASSERT_LT(std::fabs(output.h[i] - reference.h[i]), 1e-7);
+
+  PMOutputD previous = firpm(88, f, a, w, 1e-6);
+  ASSERT_GT(previous.delta, reference.delta * (1 + 1e-4));
+
+  // the same order is found when the search starts above it
+  PMOutputD downward = firpmMinOrder(f, a, w, reference.delta * (1 + 1e-4),
+                                     400u, 2000u, 1e-6);
+  ASSERT_EQ(downward.h.size(), 91u);
+  ASSERT_LT(downward.delta, reference.delta * (1 + 1e-4));
+}
+
+// builds the quantization context of a type I lowpass filter designed by
+// firpm with passband [0, 0.4pi] (weight 1) and stopband [0.5pi, pi]
+// (weight 10)
+void initLowpassContext(QuantizationContext &context, PMOutput &output,
+                        mp_prec_t prec) {
+  using mpfr::mpreal;
+  std::size_t degree = output.h.size() / 2u;
+  std::vector<mpreal> chebyA(degree + 1u);
+  chebyA[0] = output.h[degree];
+  for (std::size_t i{1u}; i <= degree; ++i)
+    chebyA[i] = output.h[degree - i] * 2;
+
+  std::vector<Band> freqBands(2), chebyBands;
+  mpreal pi = mpfr::const_pi(prec);
+  freqBands[0].start = mpreal(0, prec);
+  freqBands[0].stop = pi * mpreal(0.4, prec);
+  freqBands[1].start = pi * mpreal(0.5, prec);
+  freqBands[1].stop = pi;
+  for (std::size_t i{0u}; i < 2u; ++i) {
+    freqBands[i].space = BandSpace::FREQ;
+    setAmplitude(freqBands[i], constantResponse(mpreal(i == 0u ? 1 : 0, prec)));
+    setWeight(freqBands[i], constantResponse(mpreal(i == 0u ? 1 : 10, prec)));
+  }
+  bandConversion(chebyBands, freqBands, ConversionDirection::FROMFREQ, prec);
+  std::vector<mpreal> points = output.x;
+  std::vector<mpreal> weights(points.size());
+  for (std::size_t i{0u}; i < points.size(); ++i) {
+    mpreal D(0, prec);
+    weights[i] = mpreal(1, prec);
+    computeIdealResponseAndWeight(D, weights[i], points[i], chebyBands);
+  }
+  std::vector<mpreal> fixedA;
+  initQuantizationContext(context, chebyA, fixedA, points, freqBands,
+                          weights, prec);
+}
+
+// designs the lowpass filter of initLowpassContext with firpm (order N,
+// i.e. N + 1 taps) and builds its quantization context
+void designLowpassContext(QuantizationContext &context, PMOutput &output,
+                          std::size_t N, mp_prec_t prec) {
+  using mpfr::mpreal;
+  std::vector<mpreal> f{mpreal(0, prec), mpreal(0.4, prec), mpreal(0.5, prec),
+                        mpreal(1, prec)};
+  std::vector<mpreal> a{mpreal(1, prec), mpreal(1, prec), mpreal(0, prec),
+                        mpreal(0, prec)};
+  std::vector<mpreal> w{mpreal(1, prec), mpreal(10, prec)};
+  output = firpm(N, f, a, w, mpreal(0.0001, prec), 4, prec);
+  initLowpassContext(context, output, prec);
+}
+
+// Chebyshev coefficients of (x - r) * p, p being given by its Chebyshev
+// coefficients (x * T_k = (T_{k+1} + T_{|k-1|}) / 2)
+template <typename T>
+std::vector<T> multiplyByRoot(std::vector<T> const &p, T const &r) {
+  std::vector<T> q(p.size() + 1u, T(0));
+  for (std::size_t k{0u}; k < p.size(); ++k) {
+    q[k] -= r * p[k];
+    if (k == 0u) {
+      q[1] += p[0];
+    } else {
+      q[k + 1u] += T(0.5) * p[k];
+      q[k - 1u] += T(0.5) * p[k];
+    }
+  }
+  return q;
+}
+
+// compares determineRealEigenvalues with the general eigenvalue solver on
+// colleague matrices of polynomials with known roots: a few complex
+// conjugate pairs away from the real axis, one real root outside [-1,1] and
+// the other ones spread inside it
+template <typename T>
+void checkRealEigenvalues(std::size_t n, T const &tolerance,
+                          std::mt19937 &gen) {
+  using std::abs;
+  std::uniform_real_distribution<double> jitter(-0.02, 0.02);
+  std::uniform_real_distribution<double> center(-0.8, 0.8);
+  std::uniform_real_distribution<double> spread(0.3, 0.6);
+  std::size_t pairs = n / 4u;
+  std::size_t count = n - 2u * pairs;
+
+  std::vector<T> p{T(1)};
+  std::vector<T> expected;
+  p = multiplyByRoot(p, T(1.3));
+  for (std::size_t k{1u}; k < count; ++k) {
+    double r = -0.9 + 1.8 * (k - 0.5) / (count - 1u) + jitter(gen);
+    expected.push_back(T(r));
+    p = multiplyByRoot(p, T(r));
+  }
+  for (std::size_t k{0u}; k < pairs; ++k) {
+    // (x - c)^2 + d^2 = x * x * p - 2c * x * p + (c^2 + d^2) * p
+    double c = center(gen), d = spread(gen);
+    std::vector<T> xp = multiplyByRoot(p, T(0));
+    std::vector<T> xxp = multiplyByRoot(xp, T(0));
+    for (std::size_t i{0u}; i < xxp.size(); ++i) {
+      if (i < xp.size())
+        xxp[i] -= T(2 * c) * xp[i];
+      if (i < p.size())
+        xxp[i] += (T(c) * T(c) + T(d) * T(d)) * p[i];
+    }
+    p = xxp;
+  }
+  ASSERT_EQ(p.size(), n + 1u);
+  std::sort(expected.begin(), expected.end());
+
+  T a = -1, b = 1;
+  MatrixXT<T> C(n, n);
+  generateColleagueMatrix1stKind(C, p, true);
+  std::vector<T> values;
+  determineRealEigenvalues(values, C, a, b);
+
+  VectorXcT<T> eigenvalues;
+  determineEigenvalues(eigenvalues, C);
+  std::vector<T> reference;
+  getRealValues(reference, eigenvalues, a, b);
+
+  ASSERT_EQ(values.size(), expected.size());
+  ASSERT_EQ(reference.size(), expected.size());
+  for (std::size_t i{0u}; i < values.size(); ++i) {
+    ASSERT_LT(abs(values[i] - reference[i]), tolerance);
+    ASSERT_LT(abs(values[i] - expected[i]), tolerance);
+  }
+}
+
+TEST(eigenvalue_test, RealEigenvalues) {
+  mpfr::mpreal::set_default_prec(165ul);
+  std::mt19937 gen(2024u);
+  // the fixed-size matrices and a dynamic one
+  for (std::size_t n : {3u, 4u, 7u, 8u, 15u, 16u, 20u}) {
+    SCOPED_TRACE(n);
+    checkRealEigenvalues<double>(n, 1e-8, gen);
+    checkRealEigenvalues<dd::ddreal>(n, dd::ddreal(1e-22), gen);
+    checkRealEigenvalues<mpfr::mpreal>(n, mpfr::mpreal("1e-35"), gen);
+  }
+}
+
+TEST(roots_test, AdaptiveInterpolation) {
+  using mpfr::mpreal;
+  mp_prec_t prec = 165ul;
+  PMOutput output;
+  QuantizationContext context;
+  designLowpassContext(context, output, 60u, prec);
+
+  // the interpolants stop at a lower degree on most subintervals, the norm
+  // has to remain consistent with the minimax error and with a dense grid
+  std::pair<mpreal, mpreal> norm;
+  std::vector<std::pair<mpreal, mpreal>> bandNorms(context.chebyBands.size());
+  computeNorm(norm, bandNorms, context.freeA, context.freqBands,
+              context.chebyBands, prec);
+  ASSERT_GE(norm.second, output.delta * (1 - 1e-10));
+  ASSERT_LT(norm.second, output.delta * (1 + 1e-3));
+
+  std::vector<mpreal> grid;
+  generateGridPoints(grid, context.freeA.size(), context.freqBands, prec);
+  mpreal denseNorm;
+  computeDenseNorm(denseNorm, context.chebyBands, context.freeA, grid, prec);
+  ASSERT_GE(norm.second, denseNorm * (1 - 1e-10));
+
+  std::vector<mpreal> extremas;
+  findEigenExtremas(context.freeA, extremas, context.freqBands,
+                    context.chebyBands, prec);
+  ASSERT_GE(extremas.size(), context.freeA.size() + 1u);
+}
+
+TEST(thread_test, ConcurrentDesigns) {
+  using mpfr::mpreal;
+  ASSERT_TRUE(mpfr_buildopt_tls_p() != 0);
+  mp_prec_t callerPrec = mpreal::get_default_prec();
+
+  // every call carries its own precision, so the concurrent and the
+  // sequential runs have to produce bitwise identical results
+  std::vector<mp_prec_t> precs{100ul, 165ul, 200ul, 256ul};
+  auto design = [](mp_prec_t prec) {
+    std::vector<mpreal> f{mpreal(0, prec), mpreal(0.4, prec),
+                          mpreal(0.5, prec), mpreal(1, prec)};
+    std::vector<mpreal> a{mpreal(1, prec), mpreal(1, prec),
+                          mpreal(0, prec), mpreal(0, prec)};
+    std::vector<mpreal> w{mpreal(1, prec), mpreal(10, prec)};
+    return firpm(30u, f, a, w, mpreal(0.0001, prec), 4, prec);
+  };
+  std::vector<PMOutput> sequential(precs.size());
+  for (std::size_t i{0u}; i < precs.size(); ++i)
+    sequential[i] = design(precs[i]);
+  ASSERT_EQ(mpreal::get_default_prec(), callerPrec);
+
+  std::vector<PMOutput> concurrent(precs.size());
+  std::vector<std::thread> workers;
+  for (std::size_t i{0u}; i < precs.size(); ++i)
+    workers.emplace_back([&, i] { concurrent[i] = design(precs[i]); });
+  for (auto &it : workers)
+    it.join();
+  for (std::size_t i{0u}; i < precs.size(); ++i) {
+    ASSERT_EQ(concurrent[i].iter, sequential[i].iter);
+    ASSERT_EQ(concurrent[i].delta, sequential[i].delta);
+    ASSERT_EQ(concurrent[i].h.size(), sequential[i].h.size());
+    for (std::size_t j{0u}; j < sequential[i].h.size(); ++j) {
+      ASSERT_EQ(concurrent[i].h[j], sequential[i].h[j]);
+      ASSERT_EQ(concurrent[i].h[j].get_prec(), precs[i]);
+    }
+  }
+
+  // quantizations of the same design for several word lengths, sharing
+  // one context
+  mp_prec_t prec = 165ul;
+  QuantizationContext context;
+  initLowpassContext(context, sequential[1], prec);
+  ASSERT_EQ(mpreal::get_default_prec(), callerPrec);
+
+  std::vector<long> bits{8, 9, 10, 11};
+  auto quantize = [&](QuantizationResult &result, long b) {
+    mpreal scalingFactor = mpfr::ldexp(mpreal(1, prec), b);
+    fpminimaxWithNeighborhoodSearchDiscrete(result, context, scalingFactor);
+  };
+  std::vector<QuantizationResult> sequentialQ(bits.size());
+  for (std::size_t i{0u}; i < bits.size(); ++i)
+    quantize(sequentialQ[i], bits[i]);
+  ASSERT_EQ(mpreal::get_default_prec(), callerPrec);
+
+  std::vector<QuantizationResult> concurrentQ(bits.size());
+  workers.clear();
+  for (std::size_t i{0u}; i < bits.size(); ++i)
+    workers.emplace_back([&, i] { quantize(concurrentQ[i], bits[i]); });
+  for (auto &it : workers)
+    it.join();
+  for (std::size_t i{0u}; i < bits.size(); ++i) {
+    ASSERT_EQ(concurrentQ[i].finalError, sequentialQ[i].finalError);
+    ASSERT_EQ(concurrentQ[i].lllError, sequentialQ[i].lllError);
+    ASSERT_EQ(concurrentQ[i].coefficients, sequentialQ[i].coefficients);
+  }
+
+  std::vector<QuantizationJob> jobs(bits.size());
+  for (std::size_t i{0u}; i < bits.size(); ++i) {
+    jobs[i].context = &context;
+    jobs[i].scalingFactor = mpfr::ldexp(mpreal(1, prec), bits[i]);
+  }
+  std::vector<QuantizationResult> batchQ;
+  quantizeBatch(batchQ, jobs, 3u);
+  ASSERT_EQ(batchQ.size(), bits.size());
+  for (std::size_t i{0u}; i < bits.size(); ++i) {
+    ASSERT_EQ(batchQ[i].finalError, sequentialQ[i].finalError);
+    ASSERT_EQ(batchQ[i].coefficients, sequentialQ[i].coefficients);
+  }
+}
+
+TEST(thread_test, SingleJobBatch) {
+  using mpfr::mpreal;
+  mp_prec_t prec = 165ul;
+  PMOutput output;
+  QuantizationContext context;
+  designLowpassContext(context, output, 60u, prec);
+  mpreal scalingFactor = mpfr::ldexp(mpreal(1, prec), 10);
+
+  QuantizationResult direct;
+  fpminimaxWithNeighborhoodSearchDiscrete(direct, context, scalingFactor);
+
+  // the only job of the batch spreads its neighborhood search over the
+  // threads of the pool, which does not change its result
+  std::vector<QuantizationJob> jobs(1);
+  jobs[0].context = &context;
+  jobs[0].scalingFactor = scalingFactor;
+  std::vector<QuantizationResult> results;
+  quantizeBatch(results, jobs, 4u);
+  ASSERT_EQ(results.size(), 1u);
+  ASSERT_EQ(results[0].stats.counter(Counter::CANDIDATES),
+            direct.stats.counter(Counter::CANDIDATES));
+  ASSERT_GT(results[0].stats.counter(Counter::CANDIDATES), 0u);
+  ASSERT_EQ(results[0].finalError, direct.finalError);
+  ASSERT_EQ(results[0].coefficients, direct.coefficients);
+}
+
+TEST(thread_test, QuantizationSweep) {
+  using mpfr::mpreal;
+  mp_prec_t prec = 165ul;
+  PMOutput output;
+  QuantizationContext context;
+  designLowpassContext(context, output, 40u, prec);
+
+  std::vector<mpreal> scalingFactors;
+  for (long bits{7}; bits <= 11; ++bits)
+    scalingFactors.push_back(mpfr::ldexp(mpreal(1, prec), bits));
+
+  // each word length of the sweep gives the result of its own call
+  std::vector<QuantizationMethod> methods{QuantizationMethod::NEIGHBORHOOD,
+                                          QuantizationMethod::MINIMAX,
+                                          QuantizationMethod::FULL};
+  for (auto method : methods) {
+    std::vector<QuantizationResult> results;
+    quantizeSweep(results, context, scalingFactors, method);
+    ASSERT_EQ(results.size(), scalingFactors.size());
+    for (std::size_t i{0u}; i < scalingFactors.size(); ++i) {
+      QuantizationResult reference;
+      switch (method) {
+      case QuantizationMethod::MINIMAX:
+        fpminimaxWithNeighborhoodSearchDiscreteMinimax(reference, context,
+                                                       scalingFactors[i]);
+        break;
+      case QuantizationMethod::FULL:
+        fpminimaxWithNeighborhoodSearchDiscreteFull(reference, context,
+                                                    scalingFactors[i]);
+        break;
+      default:
+        fpminimaxWithNeighborhoodSearchDiscrete(reference, context,
+                                                scalingFactors[i]);
+        break;
+      }
+      ASSERT_EQ(results[i].scalingFactor, scalingFactors[i]);
+      ASSERT_EQ(results[i].bits, reference.bits);
+      ASSERT_EQ(results[i].bits, 7l + (long)i);
+      ASSERT_EQ(results[i].naiveError, reference.naiveError);
+      ASSERT_EQ(results[i].lllError, reference.lllError);
+      ASSERT_EQ(results[i].finalError, reference.finalError);
+      ASSERT_EQ(results[i].coefficients, reference.coefficients);
+    }
+  }
+}
+
+TEST(thread_test, BatchDesigns) {
+  using mpfr::mpreal;
+
+  // many small designs and a larger one share the same pool
+  std::vector<PMSpecD> specs;
+  for (std::size_t i{0u}; i < 24u; ++i) {
+    PMSpecD spec;
+    spec.N = 20u + 2u * (i % 6u);
+    double pass = 0.2 + 0.02 * (i / 6u);
+    spec.f = {0.0, pass, pass + 0.1, 1.0};
+    spec.a = {1.0, 1.0, 0.0, 0.0};
+    spec.w = {1.0, 10.0};
+    specs.push_back(spec);
+  }
+  specs[5].N = 200u;
+  specs[5].depth = 1u;
+  std::vector<PMOutputD> outputs;
+  firpmBatch(outputs, specs, 4u);
+  ASSERT_EQ(outputs.size(), specs.size());
+  for (std::size_t i{0u}; i < specs.size(); ++i) {
+    PMOutputD reference = firpmRS(specs[i].N, specs[i].f, specs[i].a,
+                                  specs[i].w, specs[i].epsT, specs[i].depth);
+    ASSERT_EQ(outputs[i].iter, reference.iter);
+    ASSERT_EQ(outputs[i].delta, reference.delta);
+    ASSERT_EQ(outputs[i].h, reference.h);
+  }
+
+  std::vector<PMSpec> mpSpecs(2);
+  for (std::size_t i{0u}; i < mpSpecs.size(); ++i) {
+    mpSpecs[i].N = 40u + 20u * i;
+    mpSpecs[i].f = {0.0, 0.4, 0.5, 1.0};
+    mpSpecs[i].a = {1.0, 1.0, 0.0, 0.0};
+    mpSpecs[i].w = {1.0, 10.0};
+    mpSpecs[i].prec = 128ul + 64ul * i;
+  }
+  std::vector<PMOutput> mpOutputs;
+  firpmBatch(mpOutputs, mpSpecs);
+  for (std::size_t i{0u}; i < mpSpecs.size(); ++i) {
+    PMOutput reference =
+        firpm(mpSpecs[i].N, mpSpecs[i].f, mpSpecs[i].a, mpSpecs[i].w,
+              mpSpecs[i].epsT, mpSpecs[i].Nmax, mpSpecs[i].prec);
+    ASSERT_EQ(mpOutputs[i].delta, reference.delta);
+    ASSERT_EQ(mpOutputs[i].h, reference.h);
+  }
+}
+
+TEST(quantization_test, BranchAndBoundSearch) {
+  using mpfr::mpreal;
+  mp_prec_t prec = 165ul;
+  PMOutput output;
+  QuantizationContext context;
+  designLowpassContext(context, output, 40u, prec);
+  mpreal scalingFactor = mpfr::ldexp(mpreal(1, prec), 9);
+
+  QuantizationResult result;
+  fpminimaxWithBranchAndBound(result, context, scalingFactor);
+  ASSERT_LE(result.finalError, result.lllError);
+  ASSERT_GT(result.stats.counter(Counter::SEARCH_NODES), 0u);
+  // the reported error is the one of the returned coefficients
+  std::vector<double> coeffs(result.coefficients.size());
+  for (std::size_t i{0u}; i < coeffs.size(); ++i)
+    coeffs[i] = result.coefficients[i].toDouble();
+  double norm;
+  std::vector<double> bandNorms(context.chebyBands.size());
+  computeDenseNorm(norm, bandNorms, context.grid, coeffs);
+  ASSERT_EQ(norm, result.finalError);
+
+  // a wider search contains the previous one
+  context.search.vectors = 12u;
+  context.search.radius = 2;
+  QuantizationResult wide;
+  fpminimaxWithBranchAndBound(wide, context, scalingFactor);
+  ASSERT_LE(wide.finalError, result.finalError * (1 + 1e-12));
+
+  // each of the two searches stops shortly after its node budget
+  context.search.maxNodes = 50u;
+  QuantizationResult bounded;
+  fpminimaxWithBranchAndBound(bounded, context, scalingFactor);
+  ASSERT_LE(bounded.finalError, bounded.lllError);
+  ASSERT_LE(bounded.stats.counter(Counter::SEARCH_NODES),
+            2u * (50u + omp_get_max_threads()));
+}
+
+// instrumentation sink accumulating all the events it receives
+class RecordingSink : public InstrumentationSink {
+public:
+  RecordingSink() : messages(0u) {}
+  void phase(Phase phase, double ms) {
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.time(phase) += ms;
+    ++calls[phase];
+  }
+  void counter(Counter counter, std::size_t value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.counter(counter) += value;
+  }
+  void message(std::string const &) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++messages;
+  }
+  QuantizationStats stats;
+  std::map<Phase, std::size_t> calls;
+  std::size_t messages;
+
+private:
+  std::mutex mutex;
+};
+
+TEST(instrumentation_test, CustomSink) {
+  using mpfr::mpreal;
+  mp_prec_t prec = 165ul;
+  mpreal scalingFactor = mpfr::ldexp(mpreal(1, prec), 9);
+
+  InstrumentationSink *previous = getInstrumentationSink();
+  RecordingSink sink;
+  setInstrumentationSink(&sink);
+  ASSERT_EQ(getInstrumentationSink(), &sink);
+  PMOutput output;
+  QuantizationContext context;
+  designLowpassContext(context, output, 40u, prec);
+  QuantizationResult result;
+  fpminimaxWithNeighborhoodSearchDiscrete(result, context, scalingFactor);
+  recordMessage("done");
+  {
+    // without statistics, the timer only reports to the sink
+    ScopedTimer timer(nullptr, Phase::GRID_BUILD);
+  }
+  setInstrumentationSink(previous);
+  ASSERT_EQ(getInstrumentationSink(), previous);
+
+  // the sink saw every phase of the context construction and of the
+  // quantization, and the same counts as the statistics of the result
+  QuantizationStats total = context.stats;
+  total.merge(result.stats);
+  for (Phase phase : {Phase::GRID_BUILD, Phase::BASIS_BUILD,
+                      Phase::REDUCTION, Phase::NEIGHBORHOOD_SEARCH}) {
+    ASSERT_GT(sink.calls[phase], 0u);
+    ASSERT_GE(sink.stats.time(phase), total.time(phase) * (1 - 1e-12));
+  }
+  // the context construction and the timer without statistics
+  ASSERT_EQ(sink.calls[Phase::GRID_BUILD], 2u);
+  for (Counter counter : {Counter::CANDIDATES, Counter::NORM_EVALUATIONS,
+                          Counter::SEARCH_NODES})
+    ASSERT_EQ(sink.stats.counter(counter), total.counter(counter));
+  ASSERT_GT(sink.stats.counter(Counter::CANDIDATES), 0u);
+  ASSERT_GT(sink.stats.counter(Counter::NORM_EVALUATIONS), 0u);
+  ASSERT_GE(sink.messages, 1u);
+
+  // nothing reaches the sink once it is removed
+  std::size_t candidates = sink.stats.counter(Counter::CANDIDATES);
+  recordCount(nullptr, Counter::CANDIDATES, 5u);
+  ASSERT_EQ(sink.stats.counter(Counter::CANDIDATES), candidates);
+
+  // the stream sink writes the names of the phases and counters
+  std::ostringstream stream;
+  StreamSink streamSink(stream);
+  setInstrumentationSink(&streamSink);
+  recordPhase(nullptr, Phase::REDUCTION, 1.5);
+  recordCount(nullptr, Counter::CANDIDATES, 3u);
+  setInstrumentationSink(previous);
+  ASSERT_NE(stream.str().find(phaseName(Phase::REDUCTION)),
+            std::string::npos);
+  ASSERT_NE(stream.str().find(counterName(Counter::CANDIDATES)),
+            std::string::npos);
+}
+
+TEST(instrumentation_test, MergeStats) {
+  QuantizationStats first, second;
+  recordPhase(&first, Phase::REDUCTION, 2.0);
+  recordCount(&first, Counter::CANDIDATES, 7u);
+  recordCount(&first, Counter::NORM_EVALUATIONS);
+  recordPhase(&second, Phase::REDUCTION, 3.0);
+  recordPhase(&second, Phase::BASIS_BUILD, 1.0);
+  recordCount(&second, Counter::CANDIDATES, 5u);
+  recordCount(&second, Counter::SEARCH_NODES, 2u);
+
+  first.merge(second);
+  ASSERT_EQ(first.time(Phase::REDUCTION), 5.0);
+  ASSERT_EQ(first.time(Phase::BASIS_BUILD), 1.0);
+  ASSERT_EQ(first.time(Phase::GRID_BUILD), 0.0);
+  ASSERT_EQ(first.counter(Counter::CANDIDATES), 12u);
+  ASSERT_EQ(first.counter(Counter::NORM_EVALUATIONS), 1u);
+  ASSERT_EQ(first.counter(Counter::SEARCH_NODES), 2u);
+  // the merged statistics are left untouched
+  ASSERT_EQ(second.counter(Counter::CANDIDATES), 5u);
+}
+
+TEST(quantization_test, ReductionMethods) {
+  using mpfr::mpreal;
+  mp_prec_t prec = 165ul;
+  PMOutput output;
+  QuantizationContext context;
+  designLowpassContext(context, output, 40u, prec);
+  mpreal scalingFactor = mpfr::ldexp(mpreal(1, prec), 9);
+
+  std::vector<ReductionMethod> methods{
+      ReductionMethod::LLL_WRAPPER, ReductionMethod::LLL_PROVED,
+      ReductionMethod::LLL_FAST, ReductionMethod::LLL_HEURISTIC,
+      ReductionMethod::BKZ};
+  for (auto method : methods) {
+    context.reduction.method = method;
+    QuantizationResult result;
+    fpminimaxWithNeighborhoodSearchDiscrete(result, context, scalingFactor);
+    ASSERT_GT(result.stats.time(Phase::REDUCTION), 0.0);
+    ASSERT_LE(result.finalError, result.lllError);
+    ASSERT_LE(result.lllError, result.naiveError);
+  }
+
+  // a limited number of BKZ tours still gives a usable basis
+  context.reduction.method = ReductionMethod::BKZ;
+  context.reduction.blockSize = 4;
+  context.reduction.autoAbort = false;
+  context.reduction.maxLoops = 1;
+  QuantizationResult result;
+  fpminimaxWithNeighborhoodSearchDiscrete(result, context, scalingFactor);
+  ASSERT_LE(result.finalError, result.lllError);
+  ASSERT_LE(result.lllError, result.naiveError);
+}
+
+// squared distance between the lattice vector of coordinates c (with respect
+// to the rows of basis) and t
+long latticeDistance(std::vector<long> const &c,
+                     std::vector<std::vector<long>> const &basis,
+                     std::vector<long> const &t) {
+  long distance = 0;
+  for (std::size_t j{0u}; j < t.size(); ++j) {
+    long diff = -t[j];
+    for (std::size_t i{0u}; i < c.size(); ++i)
+      diff += c[i] * basis[i][j];
+    distance += diff * diff;
+  }
+  return distance;
+}
+
+TEST(lattice_test, BabaiNearestPlane) {
+  // a diagonally dominant basis whose rows are mixed by unimodular
+  // operations, then LLL-reduced
+  const int n = 4;
+  std::mt19937 gen(42u);
+  std::uniform_int_distribution<long> entry(-10, 10);
+  fplll::ZZ_mat<mpz_t> basis(n, n);
+  for (int i{0}; i < n; ++i)
+    for (int j{0}; j < n; ++j)
+      mpz_set_si(basis(i, j).getData(), entry(gen) + (i == j ? 40 : 0));
+  for (int k{0}; k < 2 * n; ++k)
+    for (int j{0}; j < n; ++j)
+      mpz_addmul_ui(basis(k % n, j).getData(),
+                    basis((k + 1) % n, j).getData(), 3u);
+  fplll::lllReduction(basis, 0.99, 0.51, fplll::LM_WRAPPER);
+
+  std::vector<std::vector<long>> b(n, std::vector<long>(n));
+  Eigen::MatrixXd bT(n, n);
+  for (int i{0}; i < n; ++i)
+    for (int j{0}; j < n; ++j) {
+      b[i][j] = mpz_get_si(basis(i, j).getData());
+      bT(j, i) = (double)b[i][j];
+    }
+
+  // brute force closest vector, searched around the real coordinates of t
+  auto closest = [&](std::vector<long> const &t) {
+    Eigen::VectorXd target(n);
+    for (int j{0}; j < n; ++j)
+      target(j) = (double)t[j];
+    Eigen::VectorXd x = bT.fullPivLu().solve(target);
+    std::vector<long> c(n), best;
+    long bestDistance = -1;
+    const long radius = 3;
+    std::size_t count = 1u;
+    for (int i{0}; i < n; ++i)
+      count *= 2u * radius + 1u;
+    for (std::size_t k{0u}; k < count; ++k) {
+      std::size_t index = k;
+      for (int i{0}; i < n; ++i) {
+        c[i] = std::lround(x(i)) - radius + (long)(index % (2u * radius + 1u));
+        index /= 2u * radius + 1u;
+      }
+      long distance = latticeDistance(c, b, t);
+      if (bestDistance < 0 || distance < bestDistance) {
+        bestDistance = distance;
+        best = c;
+      }
+    }
+    return best;
+  };
+
+  std::uniform_int_distribution<long> coordinate(-20, 20);
+  std::uniform_int_distribution<long> noise(-3, 3);
+  std::uniform_int_distribution<long> point(-2000, 2000);
+  for (std::size_t k{0u}; k < 40u; ++k) {
+    std::vector<long> c(n), t(n, 0);
+    if (k < 20u) {
+      // a lattice point plus a small perturbation, which is within the
+      // correct rounding radius of the nearest plane algorithm
+      for (int i{0}; i < n; ++i)
+        c[i] = coordinate(gen);
+      for (int j{0}; j < n; ++j) {
+        for (int i{0}; i < n; ++i)
+          t[j] += c[i] * b[i][j];
+        t[j] += noise(gen);
+      }
+    } else {
+      for (int j{0}; j < n; ++j)
+        t[j] = point(gen);
+    }
+    std::vector<mpz_class> target(n);
+    for (int j{0}; j < n; ++j)
+      target[j] = t[j];
+    std::vector<mpz_class> coords;
+    ASSERT_TRUE(babaiNearestPlane(coords, basis, target));
+    ASSERT_EQ(coords.size(), (std::size_t)n);
+    std::vector<long> babai(n);
+    for (int i{0}; i < n; ++i)
+      babai[i] = coords[i].get_si();
+
+    std::vector<long> best = closest(t);
+    long babaiDistance = latticeDistance(babai, b, t);
+    long bestDistance = latticeDistance(best, b, t);
+    ASSERT_LE(bestDistance, babaiDistance);
+    if (k < 20u) {
+      ASSERT_EQ(babai, c);
+      ASSERT_EQ(best, c);
+    } else {
+      ASSERT_LE(babaiDistance, (1l << n) * bestDistance);
+    }
+  }
+
+  // linearly dependent rows are detected (instead of dividing by a zero
+  // Gram-Schmidt norm)
+  fplll::ZZ_mat<mpz_t> dependent(3, n);
+  for (int j{0}; j < n; ++j) {
+    mpz_set(dependent(0, j).getData(), basis(0, j).getData());
+    mpz_set(dependent(1, j).getData(), basis(1, j).getData());
+    mpz_add(dependent(2, j).getData(), basis(0, j).getData(),
+            basis(1, j).getData());
+  }
+  std::vector<mpz_class> target(n, mpz_class(7)), coords;
+  ASSERT_FALSE(babaiNearestPlane(coords, dependent, target));
+  ASSERT_TRUE(coords.empty());
+}
+
+TEST(quantization_test, EmbeddedSecondTarget) {
+  using mpfr::mpreal;
+  mp_prec_t prec = 165ul;
+  PMOutput output;
+  QuantizationContext context;
+  designLowpassContext(context, output, 40u, prec);
+  mpreal scalingFactor = mpfr::ldexp(mpreal(1, prec), 9);
+
+  // the second kernel target is solved with a second embedding and
+  // reduction by default, and with a nearest plane rounding on request
+  ASSERT_FALSE(context.reduction.nearestPlane);
+  for (bool nearestPlane : {false, true}) {
+    context.reduction.nearestPlane = nearestPlane;
+    QuantizationResult result;
+    fpminimaxWithNeighborhoodSearchDiscrete(result, context, scalingFactor);
+    ASSERT_LE(result.finalError, result.lllError);
+    ASSERT_LE(result.finalError, result.naiveError);
+  }
+}
+
+TEST(grid_test, IndexedGrid) {
+  using mpfr::mpreal;
+  mp_prec_t prec = 200ul;
+  mpfr_prec_t prevPrec = mpreal::get_default_prec();
+  mpreal::set_default_prec(prec);
+  mpreal pi = mpfr::const_pi();
+
+  // a band with a callback and a band with analytic functions
+  std::vector<Band> freqBands(2);
+  freqBands[0].start = 0;
+  freqBands[0].stop = pi * 0.4;
+  freqBands[1].start = pi * 0.5;
+  freqBands[1].stop = pi;
+  for (auto &it : freqBands)
+    it.space = BandSpace::FREQ;
+  freqBands[0].amplitude = [](BandSpace, mpreal omega) -> mpreal {
+    return 1 - omega / 10;
+  };
+  setWeight(freqBands[0], constantResponse(mpreal(1)));
+  setAmplitude(freqBands[1], constantResponse(mpreal(0)));
+  setWeight(freqBands[1], linearResponse(freqBands[1].start,
+                                         freqBands[1].stop, mpreal(10),
+                                         mpreal(20)));
+
+  std::size_t degree = 60u;
+  Grid grid;
+  generateGrid(grid, degree, freqBands, 16u, prec);
+  double increment = (pi / (degree * 16u)).toDouble();
+
+  ASSERT_EQ(grid.bandOffsets.size(), 3u);
+  ASSERT_EQ(grid.bandIndices[0], 1u);
+  ASSERT_EQ(grid.bandIndices[1], 0u);
+  for (std::size_t k{0u}; k < freqBands.size(); ++k) {
+    std::size_t first = grid.bandOffsets[k];
+    std::size_t last = grid.bandOffsets[k + 1u] - 1u;
+    ASSERT_EQ(grid.omega[first], freqBands[k].start.toDouble());
+    ASSERT_EQ(grid.omega[last], freqBands[k].stop.toDouble());
+    ASSERT_GT(grid.omega[last] - grid.omega[last - 1u], 0.0);
+    ASSERT_LE(grid.omega[last] - grid.omega[last - 1u], increment);
+    for (std::size_t i{first + 1u}; i < last; ++i)
+      ASSERT_NEAR(grid.omega[i] - grid.omega[i - 1u], increment, 4e-15);
+    for (std::size_t i{first}; i <= last; ++i) {
+      mpreal omega = grid.omega[i];
+      if (i == first)
+        omega = freqBands[k].start;
+      if (i == last)
+        omega = freqBands[k].stop;
+      ASSERT_NEAR(grid.x[i], mpfr::cos(omega).toDouble(), 1e-15);
+      mpreal D = freqBands[k].amplitude(BandSpace::FREQ, omega);
+      mpreal W = freqBands[k].weight(BandSpace::FREQ, omega);
+      ASSERT_NEAR(grid.D[i], D.toDouble(), 1e-14);
+      ASSERT_NEAR(grid.W[i], W.toDouble(), 1e-13);
+    }
+  }
+
+  mpreal::set_default_prec(prevPrec);
+}
+
+TEST(grid_test, AdaptiveNorm) {
+  using mpfr::mpreal;
+  mp_prec_t prec = 165ul;
+  PMOutput output;
+  QuantizationContext context;
+  designLowpassContext(context, output, 60u, prec);
+
+  // naively rounded coefficients, whose error is no longer equiripple
+  std::vector<double> coeffs(context.freeA.size());
+  std::vector<mpreal> mpCoeffs(coeffs.size());
+  for (std::size_t i{0u}; i < coeffs.size(); ++i) {
+    coeffs[i] = std::round(context.freeA[i].toDouble() * 512) / 512;
+    mpCoeffs[i] = coeffs[i];
+  }
+  std::pair<mpreal, mpreal> exactNorm;
+  std::vector<std::pair<mpreal, mpreal>> exactBandNorms(
+      context.chebyBands.size());
+  computeNorm(exactNorm, exactBandNorms, mpCoeffs, context.freqBands,
+              context.chebyBands, prec);
+
+  double denseNorm, norm, peakNorm, certifiedNorm;
+  std::vector<double> denseBandNorms(context.chebyBands.size());
+  std::vector<double> bandNorms(context.chebyBands.size());
+  computeDenseNorm(denseNorm, denseBandNorms, context.grid, coeffs);
+
+  // the refinement finds the grid maxima
+  AdaptiveNormOptions options;
+  options.peaks = false;
+  computeAdaptiveNorm(norm, bandNorms, context.grid, coeffs, options);
+  ASSERT_LE(norm, denseNorm);
+  ASSERT_GT(norm, denseNorm * (1 - 1e-3));
+  for (std::size_t k{0u}; k < bandNorms.size(); ++k)
+    ASSERT_LE(bandNorms[k], denseBandNorms[k]);
+
+  // the peaks between the grid points are closer to the exact norm (the
+  // responses are constant on each band)
+  options.peaks = true;
+  computeAdaptiveNorm(peakNorm, bandNorms, context.grid, coeffs, options);
+  ASSERT_GE(peakNorm, norm);
+  ASSERT_LE(peakNorm, exactNorm.second.toDouble() * (1 + 1e-10));
+
+  options.certify = true;
+  computeAdaptiveNorm(certifiedNorm, bandNorms, context.grid, coeffs, options);
+  ASSERT_EQ(certifiedNorm, std::max(peakNorm, denseNorm));
+  for (std::size_t k{0u}; k < bandNorms.size(); ++k)
+    ASSERT_GE(bandNorms[k], denseBandNorms[k]);
+
+  ASSERT_FALSE(computeAdaptiveNorm(norm, bandNorms, context.grid, coeffs,
+                                   options, denseNorm / 2));
+  ASSERT_GT(norm, denseNorm / 2);
+
+  // the quantization routines use the same evaluator for all their norms
+  context.adaptiveNorm = true;
+  mpreal scalingFactor = mpfr::ldexp(mpreal(1, prec), 9);
+  QuantizationResult result;
+  fpminimaxWithBranchAndBound(result, context, scalingFactor);
+  std::vector<double> resultCoeffs(result.coefficients.size());
+  for (std::size_t i{0u}; i < resultCoeffs.size(); ++i)
+    resultCoeffs[i] = result.coefficients[i].toDouble();
+  computeDenseNorm(denseNorm, denseBandNorms, context.grid, resultCoeffs);
+  ASSERT_GE(result.finalError, denseNorm);
+}
+
+TEST(grid_test, CombinationNorm) {
+  using mpfr::mpreal;
+  mp_prec_t prec = 165ul;
+  PMOutput output;
+  QuantizationContext context;
+  designLowpassContext(context, output, 40u, prec);
+
+  std::vector<double> coeffs(context.freeA.size());
+  for (std::size_t i{0u}; i < coeffs.size(); ++i)
+    coeffs[i] = std::round(context.freeA[i].toDouble() * 512) / 512;
+
+  // unit steps on a few coefficients (as in the neighborhood searches) and
+  // a dense direction
+  std::vector<std::vector<double>> directions;
+  for (std::size_t k : {0u, 1u, 7u, 20u}) {
+    directions.emplace_back(coeffs.size(), 0.0);
+    directions.back()[k] = 1.0 / 512;
+  }
+  std::mt19937 gen(42u);
+  std::uniform_real_distribution<double> step(-1.0 / 512, 1.0 / 512);
+  directions.emplace_back(coeffs.size());
+  for (auto &it : directions.back())
+    it = step(gen);
+
+  std::vector<double> error;
+  computeGridError(error, context.grid, coeffs);
+  GridResponse responses;
+  computeGridResponse(responses, context.grid, directions);
+  ASSERT_EQ(responses.points, context.grid.size());
+  ASSERT_EQ(responses.count, directions.size());
+
+  // the tabulated combinations match the norms of the combined polynomials
+  std::vector<double> bandNorms(context.chebyBands.size());
+  for (std::size_t i{0u}; i < directions.size(); ++i)
+    for (std::size_t j{0u}; j < directions.size(); ++j)
+      for (double c1 : {-1.0, 1.0})
+        for (double c2 : {-1.0, 1.0}) {
+          std::vector<double> combined = coeffs;
+          for (std::size_t k{0u}; k < combined.size(); ++k)
+            combined[k] += c1 * directions[i][k] + c2 * directions[j][k];
+          double denseNorm, norm;
+          computeDenseNorm(denseNorm, bandNorms, context.grid, combined);
+          ASSERT_TRUE(computeCombinationNorm(
+              norm, error, responses, i, c1, j, c2,
+              std::numeric_limits<double>::infinity()));
+          ASSERT_NEAR(norm, denseNorm, denseNorm * 1e-10);
+
+          // the evaluation is abandoned once the bound is exceeded
+          double boundedNorm;
+          ASSERT_TRUE(computeCombinationNorm(boundedNorm, error, responses,
+                                             i, c1, j, c2, norm));
+          ASSERT_EQ(boundedNorm, norm);
+          ASSERT_FALSE(computeCombinationNorm(boundedNorm, error, responses,
+                                              i, c1, j, c2, norm / 2));
+          ASSERT_GT(boundedNorm, norm / 2);
+          ASSERT_LE(boundedNorm, norm);
+        }
+}
+
+TEST(grid_test, SpectralNorm) {
+  using mpfr::mpreal;
+  mp_prec_t prec = 165ul;
+  PMOutput output;
+  QuantizationContext context;
+  designLowpassContext(context, output, 60u, prec);
+
+  SpectralGrid grid;
+  generateSpectralGrid(grid, context.freeA.size(), context.freqBands, 16u,
+                       prec);
+  ASSERT_GE(grid.size, 16u * context.freeA.size());
+  ASSERT_EQ(grid.lattice.size(), grid.indices.size());
+  ASSERT_EQ(grid.edges.size(), 2u * context.freqBands.size());
+
+  // a few roundings of the coefficients
+  std::vector<std::vector<double>> candidates(70u);
+  for (std::size_t k{0u}; k < candidates.size(); ++k) {
+    double scale = std::ldexp(1.0, (int)(6u + k % 10u));
+    candidates[k].resize(context.freeA.size());
+    for (std::size_t i{0u}; i < candidates[k].size(); ++i)
+      candidates[k][i] =
+          std::round(context.freeA[i].toDouble() * scale) / scale;
+  }
+
+  std::vector<double> norms;
+  std::vector<std::vector<double>> bandNorms;
+  computeSpectralNorms(norms, bandNorms, grid, candidates);
+  ASSERT_EQ(norms.size(), candidates.size());
+  std::vector<double> latticeBandNorms(context.chebyBands.size());
+  std::vector<double> edgeBandNorms(context.chebyBands.size());
+  std::vector<double> singleBandNorms(context.chebyBands.size());
+  for (std::size_t k{0u}; k < candidates.size(); ++k) {
+    // same values as the Clenshaw evaluations on the same points
+    double latticeNorm, edgeNorm, norm;
+    computeDenseNorm(latticeNorm, latticeBandNorms, grid.lattice,
+                     candidates[k]);
+    computeDenseNorm(edgeNorm, edgeBandNorms, grid.edges, candidates[k]);
+    ASSERT_NEAR(norms[k], std::max(latticeNorm, edgeNorm), 1e-12);
+    for (std::size_t j{0u}; j < singleBandNorms.size(); ++j)
+      ASSERT_NEAR(bandNorms[k][j],
+                  std::max(latticeBandNorms[j], edgeBandNorms[j]), 1e-12);
+
+    computeSpectralNorm(norm, singleBandNorms, grid, candidates[k]);
+    ASSERT_EQ(norm, norms[k]);
+  }
+}
+
+TEST(cache_test, RoundTrip) {
+  using mpfr::mpreal;
+  char directory[] = "/tmp/fquantizer_cacheXXXXXX";
+  ASSERT_TRUE(mkdtemp(directory) != nullptr);
+  ResultCache cache(directory);
+
+  std::vector<double> f{0.0, 0.4, 0.5, 1.0};
+  std::vector<double> a{1.0, 1.0, 0.0, 0.0};
+  std::vector<double> w{1.0, 10.0};
+  CacheKey keyD = designKey(f, a, w, 40u);
+  PMOutputD outputD = firpm(40u, f, a, w, 1e-6);
+  PMOutputD cachedD;
+  ASSERT_FALSE(cache.lookup(cachedD, keyD));
+  ASSERT_TRUE(cache.store(keyD, outputD));
+  ASSERT_TRUE(cache.lookup(cachedD, keyD));
+  ASSERT_EQ(cachedD.iter, outputD.iter);
+  ASSERT_EQ(cachedD.delta, outputD.delta);
+  ASSERT_EQ(cachedD.Q, outputD.Q);
+  ASSERT_EQ(cachedD.h, outputD.h);
+  ASSERT_EQ(cachedD.x, outputD.x);
+  ASSERT_FALSE(cache.lookup(cachedD, designKey(f, a, w, 41u)));
+
+  // the MPFR values are restored exactly, with their precision
+  std::vector<mpreal> fm{0.0, 0.4, 0.5, 1.0};
+  CacheKey keyMP = designKey(fm, fm, fm, 40u, 200ul);
+  PMOutput output;
+  output.iter = 3u;
+  output.delta = mpreal(1, 200) / 3;
+  output.Q = mpreal(-0.0, 60);
+  output.h = {mpreal(-2, 1000) / 7, mpfr::ldexp(mpreal(1, 80), -5000),
+              mpreal(0, 53)};
+  output.x = {mpfr::const_pi(300)};
+  ASSERT_TRUE(cache.store(keyMP, output));
+  PMOutput cached;
+  ASSERT_TRUE(cache.lookup(cached, keyMP));
+  ASSERT_EQ(cached.iter, output.iter);
+  ASSERT_EQ(cached.h.size(), output.h.size());
+  for (std::size_t i{0u}; i < output.h.size(); ++i) {
+    ASSERT_EQ(cached.h[i], output.h[i]);
+    ASSERT_EQ(cached.h[i].get_prec(), output.h[i].get_prec());
+  }
+  ASSERT_EQ(cached.delta, output.delta);
+  ASSERT_EQ(cached.delta.get_prec(), 200);
+  ASSERT_TRUE(mpfr_signbit(cached.Q.mpfr_srcptr()) != 0);
+  ASSERT_EQ(cached.x[0], output.x[0]);
+
+  // the same key is obtained from freshly built values (the significands
+  // of the zeros are not initialized by MPFR, so they are not part of it)
+  for (std::size_t i{0u}; i < 2u; ++i) {
+    std::vector<mpreal> fresh{mpreal(0.0), mpreal(0.4), mpreal(0.5),
+                              mpreal(1.0)};
+    CacheKey freshKey = designKey(fresh, fresh, fresh, 40u, 200ul);
+    ASSERT_EQ(freshKey.bytes(), keyMP.bytes());
+    ASSERT_EQ(freshKey.hash(), keyMP.hash());
+    PMOutput freshCached;
+    ASSERT_TRUE(cache.lookup(freshCached, freshKey));
+    ASSERT_EQ(freshCached.delta, output.delta);
+  }
+
+  // special values are restored as well
+  PMOutput special;
+  special.iter = 1u;
+  special.delta = mpreal(0, 100);
+  special.Q = -mpfr::const_infinity(1, 80);
+  special.h = {mpreal(0, 300), mpfr::const_infinity(1, 64)};
+  special.x = {mpreal(1, 64)};
+  mpfr_set_nan(special.x[0].mpfr_ptr());
+  CacheKey keySpecial = designKey(fm, fm, fm, 41u, 200ul);
+  ASSERT_TRUE(cache.store(keySpecial, special));
+  PMOutput cachedSpecial;
+  ASSERT_TRUE(cache.lookup(cachedSpecial, keySpecial));
+  ASSERT_TRUE(mpfr::iszero(cachedSpecial.delta));
+  ASSERT_EQ(cachedSpecial.delta.get_prec(), 100);
+  ASSERT_TRUE(mpfr::isinf(cachedSpecial.Q) && cachedSpecial.Q < 0);
+  ASSERT_EQ(cachedSpecial.h.size(), 2u);
+  ASSERT_TRUE(mpfr::iszero(cachedSpecial.h[0]));
+  ASSERT_EQ(cachedSpecial.h[0].get_prec(), 300);
+  ASSERT_TRUE(mpfr::isinf(cachedSpecial.h[1]) && cachedSpecial.h[1] > 0);
+  ASSERT_TRUE(mpfr::isnan(cachedSpecial.x[0]));
+
+  QuantizationResult result;
+  result.scalingFactor = 256;
+  result.bits = 8;
+  result.naiveError = 0.5;
+  result.lllError = 0.25;
+  result.finalError = 0.125;
+  result.coefficients = {mpreal(3) / 256, mpreal(-5) / 256};
+  QuantizationContext context;
+  context.prec = 200ul;
+  CacheKey keyQ = quantizationKey(keyMP, result.scalingFactor,
+                                  QuantizationMethod::NEIGHBORHOOD, context);
+  ASSERT_TRUE(cache.store(keyQ, result));
+  QuantizationResult cachedResult;
+  ASSERT_FALSE(cache.lookup(cachedResult,
+                            quantizationKey(keyMP, 512,
+                                            QuantizationMethod::NEIGHBORHOOD,
+                                            context)));
+  // the results of the other methods and options are kept apart
+  ASSERT_FALSE(cache.lookup(cachedResult,
+                            quantizationKey(keyMP, result.scalingFactor,
+                                            QuantizationMethod::FULL,
+                                            context)));
+  QuantizationContext other = context;
+  other.search.radius = 2;
+  ASSERT_FALSE(cache.lookup(cachedResult,
+                            quantizationKey(keyMP, result.scalingFactor,
+                                            QuantizationMethod::NEIGHBORHOOD,
+                                            other)));
+  other = context;
+  other.reduction.method = ReductionMethod::BKZ;
+  ASSERT_FALSE(cache.lookup(cachedResult,
+                            quantizationKey(keyMP, result.scalingFactor,
+                                            QuantizationMethod::NEIGHBORHOOD,
+                                            other)));
+  other = context;
+  other.adaptiveNorm = true;
+  ASSERT_FALSE(cache.lookup(cachedResult,
+                            quantizationKey(keyMP, result.scalingFactor,
+                                            QuantizationMethod::NEIGHBORHOOD,
+                                            other)));
+  other = context;
+  other.fixedA = {mpreal(1, 200) / 4};
+  ASSERT_FALSE(cache.lookup(cachedResult,
+                            quantizationKey(keyMP, result.scalingFactor,
+                                            QuantizationMethod::NEIGHBORHOOD,
+                                            other)));
+  ASSERT_TRUE(cache.lookup(cachedResult, keyQ));
+  ASSERT_EQ(cachedResult.bits, 8);
+  ASSERT_EQ(cachedResult.finalError, 0.125);
+  ASSERT_EQ(cachedResult.coefficients.size(), 2u);
+  ASSERT_EQ(cachedResult.coefficients[1], result.coefficients[1]);
+
+  // the entries are found by another store opened on the same directory
+  ResultCache reopened(directory);
+  ASSERT_TRUE(reopened.lookup(cachedD, keyD));
+  ASSERT_TRUE(reopened.lookup(cachedResult, keyQ));
+
+  // truncated entries are not used (every file of the directory is cut,
+  // whatever the naming of the entries)
+  DIR *dir = opendir(directory);
+  ASSERT_TRUE(dir != nullptr);
+  std::size_t entries = 0u;
+  while (dirent *file = readdir(dir)) {
+    std::string name = file->d_name;
+    if (name == "." || name == "..")
+      continue;
+    ASSERT_EQ(truncate((std::string(directory) + "/" + name).c_str(), 16), 0);
+    ++entries;
+  }
+  closedir(dir);
+  ASSERT_GE(entries, 4u);
+  ASSERT_FALSE(cache.lookup(cachedD, keyD));
+  ASSERT_FALSE(cache.lookup(cached, keyMP));
+  ASSERT_FALSE(cache.lookup(cachedResult, keyQ));
+
+  // and a new store replaces them
+  ASSERT_TRUE(cache.store(keyQ, result));
+  ASSERT_TRUE(cache.lookup(cachedResult, keyQ));
+  ASSERT_EQ(cachedResult.finalError, 0.125);
+
+  std::system((std::string("rm -rf ") + directory).c_str());
+}
+